@@ -0,0 +1,324 @@
+#include "AttemptLimiter.h"
+#include "EventLogger.h"
+#include "TimeBase.h"
+#include <Preferences.h>
+#include <esp_attr.h>
+
+// Preferences namespace and keys for the lockout levels
+#define LIMIT_NAMESPACE "otplimit"
+#define LIMIT_PREF_VERSION "ver"
+#define LIMIT_PREF_LEVELS "levels"
+#define LIMIT_LEVELS_VERSION 1
+
+#define LIMIT_STATE_MAGIC 0x4C4D5431  // "LMT1", bump when LimiterState changes
+#define LIMIT_MAX_LEVEL 16
+
+// Failure times are millis() of the current boot, oldest first
+struct LimiterSlot {
+    char tag[AUTH_TAG_LEN];                        // Empty = free; unused for the device slot
+    uint8_t level;                                 // Lockouts since the last accepted code
+    bool locked;
+    uint8_t failureCount;
+    uint32_t failureMs[LIMIT_DEVICE_MAX_FAILURES];
+    uint32_t lockedUntilMs;
+    uint16_t blocked;                              // Attempts refused during the current lockout
+};
+
+struct LimiterState {
+    uint32_t magic;
+    uint16_t bootId;
+    LimiterSlot device;
+    LimiterSlot tags[LIMIT_TRACKED_TAGS];
+};
+
+// What goes to NVS, written only when a lockout starts or ends or a code clears the levels
+struct StoredLevel {
+    char tag[AUTH_TAG_LEN];
+    uint8_t level;
+    bool locked;
+};
+
+// Only touched on core 1 (processNanoCommand, network results and loop())
+RTC_NOINIT_ATTR static LimiterState limiterState;
+
+static unsigned long lockoutDuration(uint8_t level) {
+    unsigned long duration = LIMIT_BASE_LOCKOUT_MS;
+    for (uint8_t i = 1; i < level && duration < LIMIT_MAX_LOCKOUT_MS; i++) {
+        duration *= 2;
+    }
+    return min(duration, LIMIT_MAX_LOCKOUT_MS);
+}
+
+static void startLockout(LimiterSlot& slot, uint32_t now) {
+    slot.locked = true;
+    slot.lockedUntilMs = now + lockoutDuration(slot.level);
+    slot.failureCount = 0;
+    slot.blocked = 0;
+}
+
+static bool lockoutActive(const LimiterSlot& slot, uint32_t now) {
+    return slot.locked && (int32_t)(slot.lockedUntilMs - now) > 0;
+}
+
+static void saveLevels() {
+    StoredLevel levels[LIMIT_TRACKED_TAGS + 1];
+    memset(levels, 0, sizeof(levels));
+    uint8_t count = 0;
+
+    // Device first, with an empty tag
+    levels[count].level = limiterState.device.level;
+    levels[count++].locked = limiterState.device.locked;
+    for (int i = 0; i < LIMIT_TRACKED_TAGS; i++) {
+        const LimiterSlot& slot = limiterState.tags[i];
+        if (slot.tag[0] != '\0' && slot.level > 0) {
+            memcpy(levels[count].tag, slot.tag, AUTH_TAG_LEN);
+            levels[count].level = slot.level;
+            levels[count++].locked = slot.locked;
+        }
+    }
+
+    Preferences limitPrefs;
+    if (!limitPrefs.begin(LIMIT_NAMESPACE, false)) {
+        Serial.println(F("❌ Failed to access preferences for OTP lockouts"));
+        return;
+    }
+    limitPrefs.putUChar(LIMIT_PREF_VERSION, LIMIT_LEVELS_VERSION);
+    limitPrefs.putBytes(LIMIT_PREF_LEVELS, levels, sizeof(StoredLevel) * count);
+    limitPrefs.end();
+}
+
+// Power-on or a corrupted RTC block: rebuild from the levels in NVS
+static void restoreLevels() {
+    memset(&limiterState, 0, sizeof(limiterState));
+    limiterState.magic = LIMIT_STATE_MAGIC;
+
+    Preferences limitPrefs;
+    if (!limitPrefs.begin(LIMIT_NAMESPACE, true)) {
+        return;
+    }
+    StoredLevel levels[LIMIT_TRACKED_TAGS + 1];
+    size_t length = 0;
+    if (limitPrefs.getUChar(LIMIT_PREF_VERSION, 0) == LIMIT_LEVELS_VERSION) {
+        length = limitPrefs.getBytes(LIMIT_PREF_LEVELS, levels, sizeof(levels));
+    }
+    limitPrefs.end();
+
+    size_t count = length / sizeof(StoredLevel);
+    for (size_t i = 0; i < count; i++) {
+        LimiterSlot& slot = i == 0 ? limiterState.device : limiterState.tags[i - 1];
+        memcpy(slot.tag, levels[i].tag, AUTH_TAG_LEN);
+        slot.tag[AUTH_TAG_LEN - 1] = '\0';
+        slot.level = min(levels[i].level, (uint8_t)LIMIT_MAX_LEVEL);
+        slot.locked = levels[i].locked;
+    }
+}
+
+// Soft reset: millis() started again, so stored times mean nothing any more
+static void rebaseSlot(LimiterSlot& slot) {
+    for (uint8_t i = 0; i < slot.failureCount; i++) {
+        slot.failureMs[i] = 0; // Count them as failing at boot
+    }
+}
+
+void AttemptLimiter::load() {
+    bool valid = limiterState.magic == LIMIT_STATE_MAGIC &&
+                 limiterState.device.failureCount <= LIMIT_DEVICE_MAX_FAILURES;
+    for (int i = 0; valid && i < LIMIT_TRACKED_TAGS; i++) {
+        valid = limiterState.tags[i].failureCount <= LIMIT_TAG_MAX_FAILURES &&
+                limiterState.tags[i].tag[AUTH_TAG_LEN - 1] == '\0';
+    }
+
+    if (!valid) {
+        restoreLevels();
+    } else if (limiterState.bootId != currentBootId()) {
+        rebaseSlot(limiterState.device);
+        for (int i = 0; i < LIMIT_TRACKED_TAGS; i++) {
+            rebaseSlot(limiterState.tags[i]);
+        }
+    }
+    limiterState.bootId = currentBootId();
+
+    // A lockout that was running when the board went down starts over
+    uint32_t now = millis();
+    bool anyLocked = false;
+    if (limiterState.device.locked) {
+        startLockout(limiterState.device, now);
+        anyLocked = true;
+    }
+    for (int i = 0; i < LIMIT_TRACKED_TAGS; i++) {
+        if (limiterState.tags[i].locked) {
+            startLockout(limiterState.tags[i], now);
+            anyLocked = true;
+        }
+    }
+    if (anyLocked) {
+        Serial.println(F("🔒 OTP lockout restored after restart"));
+    }
+}
+
+static LimiterSlot* findSlot(const char* userTag) {
+    for (int i = 0; i < LIMIT_TRACKED_TAGS; i++) {
+        if (strcmp(limiterState.tags[i].tag, userTag) == 0) {
+            return &limiterState.tags[i];
+        }
+    }
+    return nullptr;
+}
+
+// A free slot, else the one with no lockout history and the oldest last failure;
+// nullptr when every slot is locked out (the device slot still counts the attempt)
+static LimiterSlot* claimSlot(const char* userTag) {
+    LimiterSlot* slot = findSlot(userTag);
+    if (slot != nullptr) {
+        return slot;
+    }
+
+    LimiterSlot* candidate = nullptr;
+    for (int i = 0; i < LIMIT_TRACKED_TAGS; i++) {
+        LimiterSlot& entry = limiterState.tags[i];
+        if (entry.tag[0] == '\0') {
+            candidate = &entry;
+            break;
+        }
+        if (entry.level > 0 || entry.locked) {
+            continue;
+        }
+        uint32_t lastFailure = entry.failureCount > 0 ? entry.failureMs[entry.failureCount - 1] : 0;
+        uint32_t candidateLast = (candidate != nullptr && candidate->failureCount > 0)
+                                     ? candidate->failureMs[candidate->failureCount - 1] : 0;
+        if (candidate == nullptr || (int32_t)(lastFailure - candidateLast) < 0) {
+            candidate = &entry;
+        }
+    }
+
+    if (candidate != nullptr) {
+        memset(candidate, 0, sizeof(LimiterSlot));
+        strncpy(candidate->tag, userTag, AUTH_TAG_LEN - 1);
+    }
+    return candidate;
+}
+
+static void pruneWindow(LimiterSlot& slot, uint32_t now) {
+    uint8_t keep = 0;
+    for (uint8_t i = 0; i < slot.failureCount; i++) {
+        if (now - slot.failureMs[i] < LIMIT_WINDOW_MS) {
+            slot.failureMs[keep++] = slot.failureMs[i];
+        }
+    }
+    slot.failureCount = keep;
+}
+
+// Add a failure; true if it reached the limit and a lockout started
+static bool addFailure(LimiterSlot& slot, uint8_t maxFailures, uint32_t now) {
+    pruneWindow(slot, now);
+    if (slot.failureCount >= maxFailures) {
+        memmove(slot.failureMs, slot.failureMs + 1, sizeof(uint32_t) * (maxFailures - 1));
+        slot.failureCount = maxFailures - 1;
+    }
+    slot.failureMs[slot.failureCount++] = now;
+
+    if (slot.failureCount < maxFailures) {
+        return false;
+    }
+    if (slot.level < LIMIT_MAX_LEVEL) {
+        slot.level++;
+    }
+    startLockout(slot, now);
+    return true;
+}
+
+static void logLockout(const char* userTag, int failures, unsigned long durationMs) {
+    EventRecord event = makeEvent(EVT_OTP_LOCKOUT);
+    SET_EVENT_TEXT(event.tag, userTag);
+    event.total = failures;
+    snprintf(event.detail, sizeof(event.detail), "%lu", durationMs / 1000);
+    logEvent(event);
+
+    Serial.print(F("🔒 OTP attempts locked out for "));
+    Serial.print(durationMs / 1000);
+    Serial.print(F(" s, tag "));
+    Serial.println(userTag[0] != '\0' ? userTag : "(all)");
+}
+
+// One event per lockout for everything refused while it ran
+static void finishLockout(LimiterSlot& slot, const char* userTag, uint32_t now) {
+    if (!slot.locked || lockoutActive(slot, now)) {
+        return;
+    }
+    slot.locked = false;
+    saveLevels();
+    if (slot.blocked > 0) {
+        EventRecord event = makeEvent(EVT_OTP_ATTEMPTS_BLOCKED);
+        SET_EVENT_TEXT(event.tag, userTag);
+        event.total = slot.blocked;
+        logEvent(event);
+    }
+    slot.blocked = 0;
+}
+
+bool AttemptLimiter::allow(const char* userTag, unsigned long& retryInMs) {
+    uint32_t now = millis();
+    LimiterSlot* slot = findSlot(userTag);
+    finishLockout(limiterState.device, "", now);
+    if (slot != nullptr) {
+        finishLockout(*slot, slot->tag, now);
+    }
+
+    retryInMs = 0;
+    if (lockoutActive(limiterState.device, now)) {
+        retryInMs = limiterState.device.lockedUntilMs - now;
+        if (limiterState.device.blocked < UINT16_MAX) {
+            limiterState.device.blocked++;
+        }
+    }
+    if (slot != nullptr && lockoutActive(*slot, now)) {
+        retryInMs = max(retryInMs, (unsigned long)(slot->lockedUntilMs - now));
+        if (slot->blocked < UINT16_MAX) {
+            slot->blocked++;
+        }
+    }
+    return retryInMs == 0;
+}
+
+void AttemptLimiter::recordResult(const char* userTag, bool verified) {
+    uint32_t now = millis();
+
+    if (verified) {
+        // An accepted code clears the escalation for the tag and the device
+        LimiterSlot* slot = findSlot(userTag);
+        bool hadLevels = limiterState.device.level > 0 || (slot != nullptr && slot->level > 0);
+        limiterState.device.failureCount = 0;
+        limiterState.device.level = 0;
+        if (slot != nullptr) {
+            memset(slot, 0, sizeof(LimiterSlot));
+        }
+        if (hadLevels) {
+            saveLevels();
+        }
+        return;
+    }
+
+    bool levelsChanged = false;
+    if (addFailure(limiterState.device, LIMIT_DEVICE_MAX_FAILURES, now)) {
+        logLockout("", LIMIT_DEVICE_MAX_FAILURES, limiterState.device.lockedUntilMs - now);
+        levelsChanged = true;
+    }
+
+    LimiterSlot* slot = claimSlot(userTag);
+    if (slot != nullptr && addFailure(*slot, LIMIT_TAG_MAX_FAILURES, now)) {
+        logLockout(slot->tag, LIMIT_TAG_MAX_FAILURES, slot->lockedUntilMs - now);
+        levelsChanged = true;
+    }
+
+    if (levelsChanged) {
+        saveLevels();
+    }
+}
+
+void AttemptLimiter::service() {
+    uint32_t now = millis();
+    finishLockout(limiterState.device, "", now);
+    for (int i = 0; i < LIMIT_TRACKED_TAGS; i++) {
+        finishLockout(limiterState.tags[i], limiterState.tags[i].tag, now);
+    }
+}
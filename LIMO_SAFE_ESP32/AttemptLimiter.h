@@ -0,0 +1,38 @@
+#ifndef ATTEMPT_LIMITER_H
+#define ATTEMPT_LIMITER_H
+
+#include <Arduino.h>
+#include "AuthorizedUsers.h"
+
+// Local limit on OTP attempts, checked on core 1 before a code reaches the
+// network task. Failures are counted in a sliding window per user tag and for
+// the whole device; reaching the limit locks the tag (or every tag) out for a
+// period that doubles with each lockout until a code is accepted.
+//
+// Window state lives in RTC memory and survives a soft reset; lockout levels
+// are also kept in NVS. After any restart a tag that was locked out starts its
+// lockout again, so resetting the board never shortens one.
+#define LIMIT_WINDOW_MS 300000UL            // Sliding window for counting failures
+#define LIMIT_TAG_MAX_FAILURES 5            // Per tag within the window
+#define LIMIT_DEVICE_MAX_FAILURES 12        // All tags together, catches tag spraying
+#define LIMIT_BASE_LOCKOUT_MS 30000UL       // First lockout; doubles with each level
+#define LIMIT_MAX_LOCKOUT_MS 3600000UL
+#define LIMIT_TRACKED_TAGS 8
+
+class AttemptLimiter {
+public:
+    // Restore window state and lockout levels (call once in setup, after initTimeBase)
+    static void load();
+
+    // False while the tag or the device is locked out; the refusal is counted
+    // for the summary event instead of being logged on its own
+    static bool allow(const char* userTag, unsigned long& retryInMs);
+
+    // Outcome of an attempt that allow() let through
+    static void recordResult(const char* userTag, bool verified);
+
+    // Log the summary of lockouts that have expired - call from loop()
+    static void service();
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include "AuthorizedUsers.h"
+#include "TotpVerifier.h"
+#include "RtdbCache.h"
+#include "DevicePaths.h"
+#include <Preferences.h>
+
+// Preferences namespace and keys for the table
+#define AUTH_NAMESPACE "authusers"
+#define AUTH_PREF_VERSION "ver"
+#define AUTH_PREF_SYNCED "synced"
+#define AUTH_PREF_COUNT "count"
+#define AUTH_PREF_TABLE "table"
+#define AUTH_TABLE_VERSION 1
+
+// Only touched from the network task once it is running
+static AuthorizedUser table[AUTH_MAX_USERS];
+static uint8_t tableCount = 0;
+static bool tableSynced = false;
+
+static int indexOfTag(const String& userTag) {
+    for (int i = 0; i < tableCount; i++) {
+        if (userTag.equals(table[i].tag)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool saveTable() {
+    Preferences authPrefs;
+    if (!authPrefs.begin(AUTH_NAMESPACE, false)) {
+        Serial.println(F("❌ Failed to access preferences for user table"));
+        return false;
+    }
+    authPrefs.putUChar(AUTH_PREF_VERSION, AUTH_TABLE_VERSION);
+    authPrefs.putBool(AUTH_PREF_SYNCED, tableSynced);
+    authPrefs.putUChar(AUTH_PREF_COUNT, tableCount);
+    authPrefs.putBytes(AUTH_PREF_TABLE, table, sizeof(AuthorizedUser) * tableCount);
+    authPrefs.end();
+    return true;
+}
+
+// Set or replace one entry; a changed userId drops the cached role
+static bool upsertEntry(const String& userTag, const String& userId, UserRole role) {
+    if (userTag.length() == 0 || userTag.length() >= AUTH_TAG_LEN ||
+        userId.length() == 0 || userId.length() >= AUTH_USER_ID_LEN) {
+        Serial.println(F("⚠️ Ignoring malformed registered user entry"));
+        return false;
+    }
+    
+    int index = indexOfTag(userTag);
+    if (index < 0) {
+        if (tableCount >= AUTH_MAX_USERS) {
+            Serial.println(F("⚠️ User table full, entry not cached"));
+            return false;
+        }
+        index = tableCount++;
+        memset(&table[index], 0, sizeof(AuthorizedUser));
+        strncpy(table[index].tag, userTag.c_str(), AUTH_TAG_LEN - 1);
+    } else if (!userId.equals(table[index].userId)) {
+        memset(table[index].userId, 0, AUTH_USER_ID_LEN);
+        table[index].role = ROLE_UNKNOWN;
+    } else if (role == ROLE_UNKNOWN || role == table[index].role) {
+        return false; // Nothing new
+    }
+    
+    strncpy(table[index].userId, userId.c_str(), AUTH_USER_ID_LEN - 1);
+    if (role != ROLE_UNKNOWN) {
+        table[index].role = role;
+    }
+    return true;
+}
+
+static bool removeEntry(const String& userTag) {
+    int index = indexOfTag(userTag);
+    if (index < 0) {
+        return false;
+    }
+    table[index] = table[--tableCount];
+    return true;
+}
+
+// False only when the table is full and the tag is not in it
+static bool entryFits(const String& userTag) {
+    return tableCount < AUTH_MAX_USERS || indexOfTag(userTag) >= 0;
+}
+
+void AuthorizedUsers::load() {
+    Preferences authPrefs;
+    if (!authPrefs.begin(AUTH_NAMESPACE, true)) {
+        return;
+    }
+    
+    if (authPrefs.getUChar(AUTH_PREF_VERSION, 0) == AUTH_TABLE_VERSION) {
+        uint8_t storedCount = authPrefs.getUChar(AUTH_PREF_COUNT, 0);
+        if (storedCount <= AUTH_MAX_USERS &&
+            authPrefs.getBytes(AUTH_PREF_TABLE, table, sizeof(table)) == sizeof(AuthorizedUser) * storedCount) {
+            tableCount = storedCount;
+            tableSynced = authPrefs.getBool(AUTH_PREF_SYNCED, false);
+        }
+    }
+    authPrefs.end();
+    
+    Serial.print(F("👥 Authorised users cached: "));
+    Serial.print(tableCount);
+    Serial.println(tableSynced ? "" : " (not synced yet)");
+}
+
+bool AuthorizedUsers::isSynced() {
+    return tableSynced;
+}
+
+size_t AuthorizedUsers::count() {
+    return tableCount;
+}
+
+const AuthorizedUser* AuthorizedUsers::find(const String& userTag) {
+    int index = indexOfTag(userTag);
+    return index < 0 ? nullptr : &table[index];
+}
+
+bool AuthorizedUsers::addUser(const String& userTag, const String& userId, UserRole role) {
+    if (!upsertEntry(userTag, userId, role)) {
+        return false;
+    }
+    return saveTable();
+}
+
+bool AuthorizedUsers::setRole(const String& userTag, UserRole role) {
+    int index = indexOfTag(userTag);
+    if (index < 0 || table[index].role == role) {
+        return false;
+    }
+    table[index].role = role;
+    return saveTable();
+}
+
+void AuthorizedUsers::onStreamEvent(FirebaseData& stream) {
+    String path = stream.dataPath();   // "/" or "/<tag>"
+    String type = stream.dataType();
+    bool wasSynced = tableSynced;
+    bool fitted = true;    // Every registered user has an entry
+    bool changed = false;
+    
+    if (path == "/") {
+        // A "put" at the root is a full snapshot (sent again on every reconnect);
+        // a "patch" changes only the children it names, null ones being deleted
+        bool snapshot = stream.eventType() == "put";
+        AuthorizedUser previous[AUTH_MAX_USERS];
+        uint8_t previousCount = tableCount;
+        memcpy(previous, table, sizeof(table));
+        
+        if (snapshot) {
+            tableCount = 0;
+        }
+        
+        if (type == "json") {
+            FirebaseJson& json = stream.jsonObject();
+            size_t len = json.iteratorBegin();
+            for (size_t i = 0; i < len; i++) {
+                FirebaseJson::IteratorValue value = json.valueAt(i);
+                if (value.depth != 0) {
+                    continue;
+                }
+                if (value.type == FirebaseJson::JSON_NULL) {
+                    removeEntry(value.key);
+                    continue;
+                }
+                String userId = value.value;
+                userId.replace("\"", "");
+                
+                // Keep roles we already know for unchanged entries
+                UserRole role = ROLE_UNKNOWN;
+                for (int j = 0; j < previousCount; j++) {
+                    if (value.key.equals(previous[j].tag) && userId.equals(previous[j].userId)) {
+                        role = previous[j].role;
+                        break;
+                    }
+                }
+                fitted = entryFits(value.key) && fitted;
+                upsertEntry(value.key, userId, role);
+            }
+            json.iteratorEnd();
+        }
+        
+        changed = tableCount != previousCount ||
+                  memcmp(previous, table, sizeof(AuthorizedUser) * tableCount) != 0;
+        if (snapshot) {
+            tableSynced = fitted;
+        }
+    } else {
+        String userTag = path.substring(1);
+        if (type == "null") {
+            changed = removeEntry(userTag);
+        } else if (type == "string") {
+            fitted = entryFits(userTag);
+            changed = upsertEntry(userTag, stream.stringData(), ROLE_UNKNOWN);
+        }
+    }
+    
+    // Users the table has no room for can only be checked against the cloud,
+    // until a snapshot that fits (stream reconnect) marks it synced again
+    if (!fitted) {
+        tableSynced = false;
+        Serial.println(F("⚠️ More registered users than the table holds, checking the cloud"));
+    }
+    changed = changed || tableSynced != wasSynced;
+    
+    if (changed) {
+        saveTable();
+        RtdbCache::invalidate(devicePaths.registeredUsers);
+        TotpVerifier::requestSync(); // Drop secrets of users who are gone
+        Serial.print(F("👥 Authorised user table updated: "));
+        Serial.println(tableCount);
+    }
+}
+
+UserRole AuthorizedUsers::parseRole(const String& role) {
+    if (role == "admin") {
+        return ROLE_ADMIN;
+    }
+    if (role == "user") {
+        return ROLE_USER;
+    }
+    return ROLE_UNKNOWN;
+}
+
+const char* AuthorizedUsers::roleName(UserRole role) {
+    return role == ROLE_ADMIN ? "admin" : "user";
+}
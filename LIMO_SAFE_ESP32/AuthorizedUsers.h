@@ -0,0 +1,49 @@
+#ifndef AUTHORIZED_USERS_H
+#define AUTHORIZED_USERS_H
+
+#include <Arduino.h>
+#include <Firebase_ESP_Client.h>
+
+// Local copy of devices/<id>/registeredUsers (tag -> userId) plus each user's role,
+// persisted in NVS and kept current by the registeredUsers stream
+#define AUTH_MAX_USERS 16
+#define AUTH_TAG_LEN 4
+#define AUTH_USER_ID_LEN 36
+
+enum UserRole : uint8_t {
+    ROLE_UNKNOWN,   // Registered, role not fetched yet
+    ROLE_USER,
+    ROLE_ADMIN
+};
+
+struct AuthorizedUser {
+    char tag[AUTH_TAG_LEN];
+    char userId[AUTH_USER_ID_LEN];
+    UserRole role;
+};
+
+class AuthorizedUsers {
+public:
+    // Restore the table from NVS (call once in setup)
+    static void load();
+    
+    // True once the table holds every user of the last cloud snapshot; false
+    // before the first one and while there are more users than AUTH_MAX_USERS
+    static bool isSynced();
+    static size_t count();
+    
+    // Returns nullptr if the tag is not registered to this device
+    static const AuthorizedUser* find(const String& userTag);
+    
+    // Local updates after our own cloud writes
+    static bool addUser(const String& userTag, const String& userId, UserRole role);
+    static bool setRole(const String& userTag, UserRole role);
+    
+    // Stream callback for devices/<id>/registeredUsers
+    static void onStreamEvent(FirebaseData& stream);
+    
+    static UserRole parseRole(const String& role);
+    static const char* roleName(UserRole role);
+};
+
+#endif
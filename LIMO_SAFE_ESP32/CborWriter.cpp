@@ -0,0 +1,142 @@
+#include "CborWriter.h"
+
+// Major types, pre-shifted
+#define CBOR_UNSIGNED 0x00
+#define CBOR_NEGATIVE 0x20
+#define CBOR_TEXT 0x60
+#define CBOR_FALSE 0xF4
+#define CBOR_TRUE 0xF5
+#define CBOR_ARRAY_INDEFINITE 0x9F
+#define CBOR_MAP_INDEFINITE 0xBF
+#define CBOR_BREAK 0xFF
+
+CborWriter::CborWriter(uint8_t* buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity) {
+    reset();
+}
+
+void CborWriter::reset() {
+    used = 0;
+    depth = 0;
+    overflow = capacity == 0;
+}
+
+void CborWriter::put(uint8_t byte) {
+    if (overflow || used + 1 > capacity) {
+        overflow = true;
+        return;
+    }
+    buffer[used++] = byte;
+}
+
+void CborWriter::putRaw(const void* data, size_t length) {
+    if (overflow || used + length > capacity) {
+        overflow = true;
+        return;
+    }
+    memcpy(buffer + used, data, length);
+    used += length;
+}
+
+// Initial byte plus the shortest big-endian argument that holds the value
+void CborWriter::putHead(uint8_t major, unsigned long long argument) {
+    if (argument < 24) {
+        put(major | (uint8_t)argument);
+        return;
+    }
+    uint8_t size = argument <= 0xFF ? 1 : argument <= 0xFFFF ? 2 : argument <= 0xFFFFFFFFULL ? 4 : 8;
+    put(major | (size == 1 ? 24 : size == 2 ? 25 : size == 4 ? 26 : 27));
+    for (int shift = (size - 1) * 8; shift >= 0; shift -= 8) {
+        put((uint8_t)(argument >> shift));
+    }
+}
+
+void CborWriter::open(uint8_t head) {
+    if (depth >= CBOR_WRITER_MAX_DEPTH) {
+        overflow = true;
+        return;
+    }
+    put(head);
+    depth++;
+}
+
+CborWriter& CborWriter::beginMap() {
+    open(CBOR_MAP_INDEFINITE);
+    return *this;
+}
+
+CborWriter& CborWriter::beginMap(uint8_t key) {
+    putHead(CBOR_UNSIGNED, key);
+    return beginMap();
+}
+
+CborWriter& CborWriter::beginArray() {
+    open(CBOR_ARRAY_INDEFINITE);
+    return *this;
+}
+
+CborWriter& CborWriter::beginArray(uint8_t key) {
+    putHead(CBOR_UNSIGNED, key);
+    return beginArray();
+}
+
+CborWriter& CborWriter::end() {
+    if (depth == 0) {
+        overflow = true;
+        return *this;
+    }
+    put(CBOR_BREAK);
+    depth--;
+    return *this;
+}
+
+CborWriter& CborWriter::value(bool value) {
+    put(value ? CBOR_TRUE : CBOR_FALSE);
+    return *this;
+}
+
+CborWriter& CborWriter::value(long long value) {
+    if (value < 0) {
+        putHead(CBOR_NEGATIVE, (unsigned long long)(-1 - value));
+    } else {
+        putHead(CBOR_UNSIGNED, (unsigned long long)value);
+    }
+    return *this;
+}
+
+CborWriter& CborWriter::value(unsigned long long value) {
+    putHead(CBOR_UNSIGNED, value);
+    return *this;
+}
+
+CborWriter& CborWriter::value(const char* value) {
+    size_t length = strlen(value);
+    putHead(CBOR_TEXT, length);
+    putRaw(value, length);
+    return *this;
+}
+
+CborWriter& CborWriter::field(uint8_t key, bool value) {
+    putHead(CBOR_UNSIGNED, key);
+    return this->value(value);
+}
+
+CborWriter& CborWriter::field(uint8_t key, int value) {
+    putHead(CBOR_UNSIGNED, key);
+    return this->value((long long)value);
+}
+
+CborWriter& CborWriter::field(uint8_t key, long long value) {
+    putHead(CBOR_UNSIGNED, key);
+    return this->value(value);
+}
+
+CborWriter& CborWriter::field(uint8_t key, unsigned long long value) {
+    putHead(CBOR_UNSIGNED, key);
+    return this->value(value);
+}
+
+CborWriter& CborWriter::field(uint8_t key, const char* value) {
+    putHead(CBOR_UNSIGNED, key);
+    return this->value(value);
+}
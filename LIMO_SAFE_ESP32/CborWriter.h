@@ -0,0 +1,65 @@
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <Arduino.h>
+
+#define CBOR_WRITER_MAX_DEPTH 8
+
+// Streaming CBOR (RFC 8949) into a caller-owned buffer, the binary twin of
+// JsonWriter. Maps and arrays are indefinite-length, so members can be skipped
+// without counting them first; map keys are small integers defined by each
+// schema in DevicePayloads.h. On overflow the writer stops and ok() turns false.
+class CborWriter {
+public:
+    CborWriter(uint8_t* buffer, size_t capacity);
+
+    void reset();
+
+    CborWriter& beginMap();
+    CborWriter& beginMap(uint8_t key);
+    CborWriter& beginArray();
+    CborWriter& beginArray(uint8_t key);
+    CborWriter& end();
+
+    // Array items
+    CborWriter& value(bool value);
+    CborWriter& value(long long value);
+    CborWriter& value(unsigned long long value);
+    CborWriter& value(const char* value);
+
+    // Map members
+    CborWriter& field(uint8_t key, bool value);
+    CborWriter& field(uint8_t key, int value);
+    CborWriter& field(uint8_t key, long long value);
+    CborWriter& field(uint8_t key, unsigned long long value);
+    CborWriter& field(uint8_t key, const char* value);
+
+    const uint8_t* data() const { return buffer; }
+    size_t length() const { return used; }
+    bool ok() const { return !overflow && depth == 0; }
+
+private:
+    uint8_t* buffer;
+    size_t capacity;
+    size_t used;
+    uint8_t depth;
+    bool overflow;
+
+    void put(uint8_t byte);
+    void putRaw(const void* data, size_t length);
+    void putHead(uint8_t major, unsigned long long argument);
+    void open(uint8_t head);
+};
+
+// Writer with its own storage; size is fixed at compile time
+template <size_t N>
+class StaticCborWriter : public CborWriter {
+public:
+    StaticCborWriter() : CborWriter(storage, N) {}
+    static constexpr size_t capacity() { return N; }
+
+private:
+    uint8_t storage[N];
+};
+
+#endif
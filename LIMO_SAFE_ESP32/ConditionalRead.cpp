@@ -0,0 +1,39 @@
+#include "ConditionalRead.h"
+#include "ConnectionHealth.h"
+
+ConditionalNode::ConditionalNode() : valid(false), present(false) {
+    etag[0] = '\0';
+}
+
+ConditionalReadResult ConditionalNode::read(const char* path) {
+    if (!valid) {
+        etag[0] = '\0';
+    }
+
+    String body;
+    char parsedTag[RTDB_ETAG_LEN];
+    strcpy(parsedTag, etag);
+    unsigned long started = millis();
+    int status = rtdbGet(path, etag, sizeof(etag), body);
+    bool ok = status == 200;
+    recordHttpOutcome(status, ok, started);
+
+    if (!ok) {
+        return READ_FAILED;
+    }
+    if (parsedTag[0] != '\0' && strcmp(parsedTag, etag) == 0) {
+        return READ_UNCHANGED;
+    }
+
+    value.clear();
+    present = body != "null";
+    if (present && body.startsWith("{")) {
+        value.setJsonData(body);
+    }
+    valid = true;
+    return READ_CHANGED;
+}
+
+void ConditionalNode::forget() {
+    etag[0] = '\0';
+}
@@ -0,0 +1,39 @@
+#ifndef CONDITIONAL_READ_H
+#define CONDITIONAL_READ_H
+
+#include <Arduino.h>
+#include <Firebase_ESP_Client.h>
+#include "RtdbRest.h"
+
+// A polled RTDB node with the ETag of the body it was parsed from. The body is
+// downloaded on every read; when its ETag is the one already parsed, the
+// parsed value is reused as it is and the caller can skip its comparison.
+enum ConditionalReadResult {
+    READ_FAILED,
+    READ_CHANGED,     // New body, json() re-parsed
+    READ_UNCHANGED    // Same ETag, json() still current
+};
+
+class ConditionalNode {
+public:
+    ConditionalNode();
+
+    // Network task only
+    ConditionalReadResult read(const char* path);
+
+    FirebaseJson& json() { return value; }
+    bool hasValue() const { return valid; }
+    bool exists() const { return valid && present; }   // false for a null node
+
+    // json() was edited locally (e.g. from a stream event) and no longer matches
+    // the ETag; the next read parses the body again
+    void forget();
+
+private:
+    char etag[RTDB_ETAG_LEN];
+    FirebaseJson value;
+    bool valid;
+    bool present;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "ConnectionHealth.h"
+#include "FirebaseHandler.h"
+#include "DevicePaths.h"
+#include "RtdbRest.h"
+#include <WiFi.h>
+#include <Preferences.h>
+
+// Preferences namespace and keys for the per-device health settings
+#define HEALTH_NAMESPACE "health"
+#define HEALTH_PREF_PROBE_IDLE "probeIdle"
+#define HEALTH_PREF_THRESHOLD "threshold"
+
+// Cheap read used only when real traffic can't tell us anything
+#define HEALTH_PROBE_PATH "/status/pingTest"
+
+HealthConfig healthConfig = {
+    HEALTH_PROBE_IDLE_MS,
+    HEALTH_FAILURE_THRESHOLD
+};
+
+static ConnectionStats stats = {};
+static unsigned long lastProbeMs = 0;
+
+static bool isValidHealthConfig(const HealthConfig& cfg) {
+    return cfg.probeIdleMs >= HEALTH_MIN_PROBE_IDLE_MS && cfg.failureThreshold > 0;
+}
+
+void loadHealthConfig() {
+    Preferences healthPrefs;
+    if (healthPrefs.begin(HEALTH_NAMESPACE, true)) {
+        HealthConfig stored;
+        stored.probeIdleMs = healthPrefs.getUInt(HEALTH_PREF_PROBE_IDLE, HEALTH_PROBE_IDLE_MS);
+        stored.failureThreshold = healthPrefs.getUChar(HEALTH_PREF_THRESHOLD, HEALTH_FAILURE_THRESHOLD);
+        healthPrefs.end();
+
+        if (isValidHealthConfig(stored)) {
+            healthConfig = stored;
+        } else {
+            Serial.println(F("⚠️ Stored health config invalid, using defaults"));
+        }
+    }
+}
+
+bool saveHealthConfig(const HealthConfig& cfg) {
+    if (!isValidHealthConfig(cfg)) {
+        Serial.println(F("❌ Rejected invalid health configuration"));
+        return false;
+    }
+
+    Preferences healthPrefs;
+    if (!healthPrefs.begin(HEALTH_NAMESPACE, false)) {
+        Serial.println(F("❌ Failed to access preferences for health config"));
+        return false;
+    }
+    healthPrefs.putUInt(HEALTH_PREF_PROBE_IDLE, cfg.probeIdleMs);
+    healthPrefs.putUChar(HEALTH_PREF_THRESHOLD, cfg.failureThreshold);
+    healthPrefs.end();
+
+    healthConfig = cfg;
+    return true;
+}
+
+// Pull devices/<id>/config/health once at boot; only written back when it differs
+bool syncHealthConfigFromFirebase() {
+    if (!isFirebaseReady()) {
+        return false;
+    }
+
+    unsigned long started = millis();
+    bool ok = Firebase.RTDB.getJSON(&fbdo, devicePaths.healthConfig);
+    recordFirebaseOutcome(fbdo, ok, started);
+    if (!ok) {
+        return false; // No override configured for this device
+    }
+
+    FirebaseJson* json = fbdo.jsonObjectPtr();
+    if (json == nullptr) {
+        return false;
+    }
+
+    HealthConfig remote = healthConfig;
+    FirebaseJsonData data;
+    if (json->get(data, "probeIdleMs") && data.success) remote.probeIdleMs = data.intValue;
+    if (json->get(data, "failureThreshold") && data.success) remote.failureThreshold = data.intValue;
+
+    if (remote.probeIdleMs == healthConfig.probeIdleMs &&
+        remote.failureThreshold == healthConfig.failureThreshold) {
+        return true;
+    }
+
+    if (!saveHealthConfig(remote)) {
+        return false;
+    }
+
+    Serial.println(F("✅ Connection health config updated from Firebase"));
+    return true;
+}
+
+// A request that got an HTTP answer proved the link works, even if the answer was an error
+static bool reachedServer(int httpCode, bool ok) {
+    if (ok) {
+        return true;
+    }
+    return httpCode > 0 && httpCode < 500;
+}
+
+static bool reachedServer(FirebaseData& data, bool ok) {
+    return reachedServer(data.httpCode(), ok);
+}
+
+void recordFirebaseOutcome(FirebaseData& data, bool ok, unsigned long startedMs) {
+    recordHttpOutcome(data.httpCode(), ok, startedMs);
+}
+
+void recordHttpOutcome(int httpCode, bool ok, unsigned long startedMs) {
+    if (httpCode == RTDB_REST_ERROR_DEADLINE) {
+        return;  // Our budget ran out, which says nothing about the link
+    }
+
+    unsigned long now = millis();
+    stats.lastActivityMs = now;
+    stats.lastHttpCode = httpCode;
+
+    if (!reachedServer(httpCode, ok)) {
+        stats.failures++;
+        if (stats.consecutiveFailures < 255) {
+            stats.consecutiveFailures++;
+        }
+        return;
+    }
+
+    stats.successes++;
+    stats.consecutiveFailures = 0;
+    stats.lastSuccessMs = now;
+
+    // Smooth latency with the usual 1/8 gain
+    uint32_t latency = now - startedMs;
+    if (stats.smoothedLatencyMs == 0) {
+        stats.smoothedLatencyMs = latency;
+    } else {
+        stats.smoothedLatencyMs += ((int32_t)latency - (int32_t)stats.smoothedLatencyMs) / 8;
+    }
+}
+
+// Stream keep-alives arrive from the server, so they count as traffic without a latency sample
+void recordStreamAlive() {
+    unsigned long now = millis();
+    stats.lastActivityMs = now;
+    stats.lastSuccessMs = now;
+    stats.consecutiveFailures = 0;
+}
+
+void resetConnectionHealth() {
+    stats.consecutiveFailures = 0;
+    stats.lastActivityMs = millis();
+}
+
+bool isConnectionHealthy() {
+    return WiFi.isConnected() && stats.consecutiveFailures < healthConfig.failureThreshold;
+}
+
+// Probe only when real traffic is silent or failing
+bool connectionProbeDue() {
+    unsigned long now = millis();
+
+    if (stats.consecutiveFailures > 0) {
+        return now - lastProbeMs >= HEALTH_FAILURE_PROBE_MS;
+    }
+    return now - stats.lastActivityMs >= healthConfig.probeIdleMs;
+}
+
+bool probeFirebaseConnection() {
+    lastProbeMs = millis();
+    stats.probes++;
+
+    if (!Firebase.ready()) {
+        return false;
+    }
+
+    unsigned long started = millis();
+    bool ok = Firebase.RTDB.getShallowData(&fbdo, HEALTH_PROBE_PATH);
+    recordFirebaseOutcome(fbdo, ok, started);
+
+    return reachedServer(fbdo, ok);
+}
+
+const ConnectionStats& getConnectionStats() {
+    return stats;
+}
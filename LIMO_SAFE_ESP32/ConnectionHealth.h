@@ -0,0 +1,48 @@
+#ifndef CONNECTION_HEALTH_H
+#define CONNECTION_HEALTH_H
+
+#include <Arduino.h>
+#include <Firebase_ESP_Client.h>
+
+// Defaults, overridable per device (NVS or Firebase config/health)
+#define HEALTH_PROBE_IDLE_MS       60000UL  // Probe after this long without any real request
+#define HEALTH_FAILURE_THRESHOLD   3        // Consecutive transport failures before going offline
+#define HEALTH_FAILURE_PROBE_MS    5000UL   // Probe spacing while requests are failing
+#define HEALTH_MIN_PROBE_IDLE_MS   5000UL   // Lowest accepted idle probe interval
+
+struct HealthConfig {
+    uint32_t probeIdleMs;
+    uint8_t failureThreshold;
+};
+
+struct ConnectionStats {
+    uint32_t successes;
+    uint32_t failures;
+    uint32_t probes;
+    uint8_t consecutiveFailures;
+    uint32_t smoothedLatencyMs;   // EWMA over successful requests
+    unsigned long lastSuccessMs;
+    unsigned long lastActivityMs;
+    int lastHttpCode;
+};
+
+extern HealthConfig healthConfig;
+
+// Configuration
+void loadHealthConfig();
+bool saveHealthConfig(const HealthConfig& cfg);
+bool syncHealthConfigFromFirebase();
+
+// Feed the outcome of a real request; startedMs is millis() taken before the call
+void recordFirebaseOutcome(FirebaseData& data, bool ok, unsigned long startedMs);
+void recordHttpOutcome(int httpCode, bool ok, unsigned long startedMs);
+void recordStreamAlive();
+void resetConnectionHealth();
+
+// Derived state, network task only
+bool isConnectionHealthy();
+bool connectionProbeDue();
+bool probeFirebaseConnection();
+const ConnectionStats& getConnectionStats();
+
+#endif
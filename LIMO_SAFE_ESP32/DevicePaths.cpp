@@ -0,0 +1,66 @@
+#include "DevicePaths.h"
+#include "FirebaseHandler.h"
+#include <stdarg.h>
+
+DevicePaths devicePaths = {};
+
+// snprintf into a fixed buffer; a truncated path is never used
+static bool formatPath(char* out, size_t size, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(out, size, format, args);
+    va_end(args);
+    if (written < 0 || (size_t)written >= size) {
+        out[0] = '\0';
+        return false;
+    }
+    return true;
+}
+
+bool buildDevicePaths(const char* deviceId) {
+    memset(&devicePaths, 0, sizeof(devicePaths));
+    if (deviceId == nullptr || deviceId[0] == '\0' || strlen(deviceId) > DEVICE_ID_MAX_LEN) {
+        Serial.println(F("❌ Device ID missing or too long for RTDB paths"));
+        return false;
+    }
+
+    // Longest node fits by construction: 8 + 32 + 17 < DEVICE_PATH_LEN
+    formatPath(devicePaths.root, DEVICE_PATH_LEN, "%s%s", DEVICE_PATH, deviceId);
+
+    const char* root = devicePaths.root;
+    formatPath(devicePaths.status, DEVICE_PATH_LEN, "%s/status", root);
+    formatPath(devicePaths.statusOnline, DEVICE_PATH_LEN, "%s/status/online", root);
+    formatPath(devicePaths.wifi, DEVICE_PATH_LEN, "%s%s", root, WIFI_NODE);
+    formatPath(devicePaths.wifiConnected, DEVICE_PATH_LEN, "%s%s/connected", root, WIFI_NODE);
+    formatPath(devicePaths.registeredUsers, DEVICE_PATH_LEN, "%s%s", root, REGISTERED_USERS_NODE);
+    formatPath(devicePaths.fingerprint, DEVICE_PATH_LEN, "%s/fingerprint", root);
+    formatPath(devicePaths.logs, DEVICE_PATH_LEN, "%s/logs", root);
+    formatPath(devicePaths.logSummaries, DEVICE_PATH_LEN, "%s/logSummaries", root);
+    formatPath(devicePaths.diagnostics, DEVICE_PATH_LEN, "%s/diagnostics", root);
+    formatPath(devicePaths.otpIndex, DEVICE_PATH_LEN, "%s/otpIndex", root);
+    formatPath(devicePaths.cadenceConfig, DEVICE_PATH_LEN, "%s/config/telemetry", root);
+    formatPath(devicePaths.healthConfig, DEVICE_PATH_LEN, "%s/config/health", root);
+    formatPath(devicePaths.logConfig, DEVICE_PATH_LEN, "%s/config/logs", root);
+    formatPath(devicePaths.otpConfig, DEVICE_PATH_LEN, "%s/config/otp", root);
+    formatPath(devicePaths.totpProvision, DEVICE_PATH_LEN, "%s/totpProvision", root);
+    return true;
+}
+
+bool devicePathsReady() {
+    return devicePaths.root[0] != '\0';
+}
+
+bool formatChildPath(char* out, size_t size, const char* base, const char* key) {
+    return formatPath(out, size, "%s/%s", base, key);
+}
+
+bool formatUserDevicePath(char* out, size_t size, const char* userId, const char* leaf) {
+    if (!devicePathsReady() || userId == nullptr || userId[0] == '\0') {
+        out[0] = '\0';
+        return false;
+    }
+
+    // The device ID is the tail of devicePaths.root, after "devices/"
+    const char* id = devicePaths.root + strlen(DEVICE_PATH);
+    return formatPath(out, size, "%s%s/registeredDevices/%s/%s", USERS_PATH, userId, id, leaf);
+}
@@ -0,0 +1,46 @@
+#ifndef DEVICE_PATHS_H
+#define DEVICE_PATHS_H
+
+#include <Arduino.h>
+
+// RTDB paths. Device-scoped paths are formatted once, as soon as deviceId is
+// known; per-user and per-id paths are formatted into caller stack buffers.
+// Nothing here allocates.
+
+#define DEVICE_ID_MAX_LEN   32    // MAC-derived IDs are 12 chars
+#define DEVICE_PATH_LEN     64    // "devices/" + id + longest node below
+#define CHILD_PATH_LEN      96    // Device path plus one key (tag, id, ...)
+#define USER_PATH_LEN       160   // users/<uid>/registeredDevices/<id>/<leaf>
+
+struct DevicePaths {
+    char root[DEVICE_PATH_LEN];               // devices/<id>
+    char status[DEVICE_PATH_LEN];             // devices/<id>/status
+    char statusOnline[DEVICE_PATH_LEN];       // devices/<id>/status/online
+    char wifi[DEVICE_PATH_LEN];               // devices/<id>/wifi
+    char wifiConnected[DEVICE_PATH_LEN];      // devices/<id>/wifi/connected
+    char registeredUsers[DEVICE_PATH_LEN];    // devices/<id>/registeredUsers
+    char fingerprint[DEVICE_PATH_LEN];        // devices/<id>/fingerprint
+    char logs[DEVICE_PATH_LEN];               // devices/<id>/logs
+    char logSummaries[DEVICE_PATH_LEN];       // devices/<id>/logSummaries
+    char diagnostics[DEVICE_PATH_LEN];        // devices/<id>/diagnostics
+    char otpIndex[DEVICE_PATH_LEN];           // devices/<id>/otpIndex
+    char cadenceConfig[DEVICE_PATH_LEN];      // devices/<id>/config/telemetry
+    char healthConfig[DEVICE_PATH_LEN];       // devices/<id>/config/health
+    char logConfig[DEVICE_PATH_LEN];          // devices/<id>/config/logs
+    char otpConfig[DEVICE_PATH_LEN];          // devices/<id>/config/otp
+    char totpProvision[DEVICE_PATH_LEN];      // devices/<id>/totpProvision
+};
+
+extern DevicePaths devicePaths;
+
+// Fill devicePaths for this device; false (and paths left empty) if the ID is too long
+bool buildDevicePaths(const char* deviceId);
+bool devicePathsReady();
+
+// <base>/<key>, e.g. devices/<id>/registeredUsers/<tag>; false if it didn't fit
+bool formatChildPath(char* out, size_t size, const char* base, const char* key);
+
+// users/<uid>/registeredDevices/<this device>/<leaf>
+bool formatUserDevicePath(char* out, size_t size, const char* userId, const char* leaf);
+
+#endif
@@ -0,0 +1,208 @@
+#include "DevicePayloads.h"
+
+bool writeStatusPayload(StatusPayload& out, bool isOnline, bool isLocked, bool isSecure, unsigned long long timestamp) {
+    out.reset();
+    out.beginObject()
+        .field("online", isOnline)
+        .field("locked", isLocked)
+        .field("secure", isSecure)
+        .field("timestamp", timestamp)
+    .endObject();
+    return out.ok();
+}
+
+bool writeBootPayload(BootPayload& out, const char* deviceId, unsigned long long timestamp) {
+    out.reset();
+    out.beginObject()
+        .field("id", deviceId)
+        .field("status/online", true)
+        .field("status/locked", false)
+        .field("status/secure", false)
+        .field("status/timestamp", timestamp)
+        .field("wifi/connected", true)
+    .endObject();
+    return out.ok();
+}
+
+void beginEventBatch(EventBatchPayload& out) {
+    out.reset();
+    out.beginObject();
+}
+
+void writeEventPayload(EventBatchPayload& out, const char* pushId, const char* eventName,
+                       const EventRecord& event, bool rebased, unsigned long long timestamp,
+                       const char* flagKey, const char* detailKey) {
+    out.beginObject(pushId);
+    out.field("event", eventName);
+    if (rebased) {
+        out.field("timestamp", timestamp);
+    } else {
+        out.serverTimestamp("timestamp");
+    }
+
+    if (flagKey != nullptr && event.flag != EVENT_UNSET) {
+        out.field(flagKey, event.flag == 1);
+    }
+    if (event.fingerprintId != EVENT_UNSET) {
+        out.field("fingerprintId", (int)event.fingerprintId);
+    }
+    if (event.total != EVENT_UNSET) {
+        out.field("total", (int)event.total);
+    }
+    if (event.success != EVENT_UNSET) {
+        out.field("success", (int)event.success);
+    }
+    if (event.userId[0] != '\0') {
+        out.field("userId", event.userId);
+    }
+    if (event.tag[0] != '\0') {
+        out.field("tag", event.tag);
+    }
+    if (event.detail[0] != '\0' && detailKey != nullptr) {
+        out.field(detailKey, event.detail);
+    }
+    out.endObject();
+}
+
+bool endEventBatch(EventBatchPayload& out) {
+    out.endObject();
+    return out.ok();
+}
+
+void writeLogSummary(JsonWriter& out, const char* key, const LogSummary& summary) {
+    out.beginObject(key);
+    out.field("records", (long long)summary.records);
+    if (summary.first != 0) {
+        out.field("first", summary.first);
+        out.field("last", summary.last);
+    }
+    out.beginObject("events");
+    for (uint8_t type = 0; type < EVT_COUNT; type++) {
+        if (summary.counts[type] > 0) {
+            out.field(eventTypeName((EventType)type), (int)summary.counts[type]);
+        }
+    }
+    out.endObject();
+    if (summary.other > 0) {
+        out.field("other", (int)summary.other);
+    }
+    if (summary.tamperEpisodes > 0) {
+        out.beginObject("tamper")
+            .field("episodes", (int)summary.tamperEpisodes)
+            .field("first", summary.tamperFirst)
+            .field("last", summary.tamperLast)
+        .endObject();
+    }
+    out.endObject();
+}
+
+bool writeFingerprintPayload(FingerprintPayload& out, const char* userId, int fingerprintId) {
+    char idKey[16];
+    snprintf(idKey, sizeof(idKey), "ids/%d", fingerprintId);
+
+    out.reset();
+    out.beginObject()
+        .field(userId, "registered")
+        .field(idKey, userId)
+    .endObject();
+    return out.ok();
+}
+
+bool writeDiagnosticsPayload(DiagnosticsPayload& out, const DiagnosticsSnapshot& snapshot) {
+    out.reset();
+    out.beginObject()
+        .field("latencyMs", (long long)snapshot.latencyMs)
+        .field("successes", (long long)snapshot.successes)
+        .field("failures", (long long)snapshot.failures)
+        .field("probes", (long long)snapshot.probes)
+        .field("lastHttpCode", snapshot.lastHttpCode)
+        .field("uploadRate", snapshot.uploadRate)
+        .field("droppedSecurity", (long long)snapshot.droppedSecurity)
+        .field("droppedAudit", (long long)snapshot.droppedAudit)
+        .field("droppedDiagnostics", (long long)snapshot.droppedDiagnostics)
+        .field("freeHeap", (long long)snapshot.freeHeap)
+        .field("uptimeSec", (long long)snapshot.uptimeSec)
+        .serverTimestamp("timestamp");
+
+    // Which reconnect steps are doing the work, and how long they take
+    out.beginObject("reconnect");
+    for (uint8_t tier = 0; tier < RECONNECT_TIER_COUNT; tier++) {
+        const ReconnectTierStats& stats = getReconnectStats((ReconnectTier)tier);
+        if (stats.attempts == 0) {
+            continue;
+        }
+        out.beginObject(reconnectTierName((ReconnectTier)tier))
+            .field("attempts", (long long)stats.attempts)
+            .field("successes", (long long)stats.successes)
+            .field("lastMs", (long long)stats.lastDurationMs)
+        .endObject();
+    }
+    out.endObject();
+    out.endObject();
+    return out.ok();
+}
+
+bool writeStatusCbor(StatusCbor& out, bool isOnline, bool isLocked, bool isSecure, unsigned long long timestamp) {
+    out.reset();
+    out.beginMap()
+        .field(STATUS_CBOR_VERSION, CBOR_SCHEMA_VERSION)
+        .field(STATUS_CBOR_ONLINE, isOnline)
+        .field(STATUS_CBOR_LOCKED, isLocked)
+        .field(STATUS_CBOR_SECURE, isSecure)
+        .field(STATUS_CBOR_TIMESTAMP, timestamp)
+    .end();
+    return out.ok();
+}
+
+void beginEventBatchCbor(EventBatchCbor& out, const char* pushIdSuffix) {
+    out.reset();
+    out.beginMap()
+        .field(BATCH_CBOR_VERSION, CBOR_SCHEMA_VERSION)
+        .field(BATCH_CBOR_PUSH_SUFFIX, pushIdSuffix)
+        .beginArray(BATCH_CBOR_EVENTS);
+}
+
+void writeEventCbor(EventBatchCbor& out, const EventRecord& event, bool rebased, unsigned long long timestamp,
+                    bool hasFlag) {
+    out.beginMap();
+    out.field(EVENT_CBOR_CODE, (int)event.type);
+    out.field(EVENT_CBOR_SEQ, (unsigned long long)event.seq);
+    if (rebased) {
+        out.field(EVENT_CBOR_TIME, timestamp);
+    }
+    if (!rebased || event.keyTimeMs != timestamp) {
+        out.field(EVENT_CBOR_KEY_TIME, (unsigned long long)event.keyTimeMs);
+    }
+    if (event.undated) {
+        out.field(EVENT_CBOR_UNDATED, true);
+    }
+
+    if (hasFlag && event.flag != EVENT_UNSET) {
+        out.field(EVENT_CBOR_FLAG, event.flag == 1);
+    }
+    if (event.fingerprintId != EVENT_UNSET) {
+        out.field(EVENT_CBOR_FINGERPRINT_ID, (int)event.fingerprintId);
+    }
+    if (event.total != EVENT_UNSET) {
+        out.field(EVENT_CBOR_TOTAL, (int)event.total);
+    }
+    if (event.success != EVENT_UNSET) {
+        out.field(EVENT_CBOR_SUCCESS, (int)event.success);
+    }
+    if (event.userId[0] != '\0') {
+        out.field(EVENT_CBOR_USER_ID, event.userId);
+    }
+    if (event.tag[0] != '\0') {
+        out.field(EVENT_CBOR_TAG, event.tag);
+    }
+    if (event.detail[0] != '\0') {
+        out.field(EVENT_CBOR_DETAIL, event.detail);
+    }
+    out.end();
+}
+
+bool endEventBatchCbor(EventBatchCbor& out) {
+    out.end();  // Events
+    out.end();
+    return out.ok();
+}
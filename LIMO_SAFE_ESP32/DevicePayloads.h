@@ -0,0 +1,248 @@
+#ifndef DEVICE_PAYLOADS_H
+#define DEVICE_PAYLOADS_H
+
+#include <Arduino.h>
+#include "JsonWriter.h"
+#include "CborWriter.h"
+#include "EventLogger.h"
+#include "DevicePaths.h"
+#include "LogRollup.h"
+#include "ReconnectLadder.h"
+
+// Outbound payload schemas. Each writer emits a fixed set of fields, and the
+// worst-case size of each schema is computed here so that an undersized buffer
+// fails the build instead of truncating at runtime.
+
+// Worst-case encoded sizes
+#define JSON_KEY(k)            (sizeof(k) - 1 + 3)      // "k":
+#define JSON_BOOL_MAX          5
+#define JSON_INT_MAX           11                        // -2147483648
+#define JSON_UINT64_MAX        20
+#define JSON_STRING_MAX(n)     (2 + 6 * (n))              // Every char as \u00XX
+#define JSON_LITERAL_MAX(n)    (2 + (n))                  // Fixed ASCII names, never escaped
+#define JSON_FIXED_MAX         19                        // -999999999999999.99
+#define JSON_SERVER_TS_MAX     19                        // {".sv":"timestamp"}
+
+// PATCH devices/<id>/status: {"online":..,"locked":..,"secure":..,"timestamp":..}
+// Flat, so a PATCH leaves other children of status untouched
+constexpr size_t STATUS_PAYLOAD_MAX =
+    2 +
+    JSON_KEY("online") + JSON_BOOL_MAX + 1 +
+    JSON_KEY("locked") + JSON_BOOL_MAX + 1 +
+    JSON_KEY("secure") + JSON_BOOL_MAX + 1 +
+    JSON_KEY("timestamp") + JSON_UINT64_MAX;
+#define STATUS_PAYLOAD_BUFFER 96
+
+// PATCH devices/<id> at boot, as multi-path keys so nothing else under the
+// device is read or replaced: {"id":..,"status/online":..,..,"wifi/connected":true}
+constexpr size_t BOOT_PAYLOAD_MAX =
+    2 +
+    JSON_KEY("id") + JSON_STRING_MAX(DEVICE_ID_MAX_LEN) + 1 +
+    JSON_KEY("status/online") + JSON_BOOL_MAX + 1 +
+    JSON_KEY("status/locked") + JSON_BOOL_MAX + 1 +
+    JSON_KEY("status/secure") + JSON_BOOL_MAX + 1 +
+    JSON_KEY("status/timestamp") + JSON_UINT64_MAX + 1 +
+    JSON_KEY("wifi/connected") + JSON_BOOL_MAX;
+#define BOOT_PAYLOAD_BUFFER 384
+
+// One record under devices/<id>/logs, sized with the longest name, flag and detail keys
+constexpr size_t EVENT_PAYLOAD_MAX =
+    1 + JSON_KEY("yyyy-mm-dd/12345678901234567890") + 2 +
+    JSON_KEY("event") + JSON_LITERAL_MAX(40) + 1 +
+    JSON_KEY("timestamp") + JSON_UINT64_MAX + 1 +
+    JSON_KEY("verified") + JSON_BOOL_MAX + 1 +
+    JSON_KEY("fingerprintId") + JSON_INT_MAX + 1 +
+    JSON_KEY("total") + JSON_INT_MAX + 1 +
+    JSON_KEY("success") + JSON_INT_MAX + 1 +
+    JSON_KEY("userId") + JSON_STRING_MAX(EVENT_USER_ID_LEN - 1) + 1 +
+    JSON_KEY("tag") + JSON_STRING_MAX(EVENT_TAG_LEN - 1) + 1 +
+    JSON_KEY("attempted_otp") + JSON_STRING_MAX(EVENT_DETAIL_LEN - 1);
+constexpr size_t EVENT_BATCH_PAYLOAD_MAX = 2 + EVENT_BATCH_SIZE * EVENT_PAYLOAD_MAX;
+#define EVENT_BATCH_PAYLOAD_BUFFER 5376
+
+// One day under devices/<id>/logSummaries:
+// {"records":..,"first":..,"last":..,"events":{"<name>":n,..},"other":..,"tamper":{..}}
+constexpr size_t LOG_SUMMARY_MAX =
+    2 +
+    JSON_KEY("records") + JSON_INT_MAX + 1 +
+    JSON_KEY("first") + JSON_UINT64_MAX + 1 +
+    JSON_KEY("last") + JSON_UINT64_MAX + 1 +
+    JSON_KEY("events") + 2 + EVT_COUNT * (JSON_LITERAL_MAX(40) + 1 + JSON_INT_MAX + 1) +
+    JSON_KEY("other") + JSON_INT_MAX + 1 +
+    JSON_KEY("tamper") + 2 +
+        JSON_KEY("episodes") + JSON_INT_MAX + 1 +
+        JSON_KEY("first") + JSON_UINT64_MAX + 1 +
+        JSON_KEY("last") + JSON_UINT64_MAX;
+
+// PATCH devices/<id>: the summary plus the shard, or a page of flat records, set to null
+constexpr size_t LOG_FOLD_PAYLOAD_MAX =
+    2 + JSON_KEY("logSummaries/yyyy-mm-dd") + LOG_SUMMARY_MAX + 1 +
+    LOG_LEGACY_PAGE * (JSON_KEY("logs/12345678901234567890") + 4 + 1);
+#define LOG_FOLD_PAYLOAD_BUFFER 2048
+
+// PATCH devices/<id>/logSummaries: {"<day>":null,..}
+constexpr size_t LOG_PRUNE_PAYLOAD_MAX = 2 + LOG_PRUNE_PER_PASS * (JSON_KEY("yyyy-mm-dd") + 4 + 1);
+#define LOG_PRUNE_PAYLOAD_BUFFER 192
+
+// PATCH devices/<id>/fingerprint: {"<userId>":"registered","ids/<fpId>":"<userId>"}
+#define FP_USER_ID_MAX 32
+constexpr size_t FINGERPRINT_PAYLOAD_MAX =
+    2 + JSON_STRING_MAX(FP_USER_ID_MAX) + 1 + JSON_LITERAL_MAX(10) + 1 +
+    JSON_LITERAL_MAX(4 + 11) + 1 + JSON_STRING_MAX(FP_USER_ID_MAX);
+#define FINGERPRINT_PAYLOAD_BUFFER 480
+
+// PATCH devices/<id>/diagnostics: counters, the upload rate, and a reconnect
+// object with {"attempts","successes","lastMs"} for each tier that was tried
+struct DiagnosticsSnapshot {
+    uint32_t latencyMs;
+    uint32_t successes;
+    uint32_t failures;
+    uint32_t probes;
+    int lastHttpCode;
+    float uploadRate;
+    uint32_t droppedSecurity;
+    uint32_t droppedAudit;
+    uint32_t droppedDiagnostics;
+    uint32_t freeHeap;
+    uint32_t uptimeSec;
+};
+
+#define RECONNECT_TIER_NAME_MAX 11              // "credentials"
+constexpr size_t DIAGNOSTICS_TIER_MAX =
+    JSON_KEY("") + RECONNECT_TIER_NAME_MAX + 2 +
+    JSON_KEY("attempts") + JSON_INT_MAX + 1 +
+    JSON_KEY("successes") + JSON_INT_MAX + 1 +
+    JSON_KEY("lastMs") + JSON_INT_MAX;
+constexpr size_t DIAGNOSTICS_PAYLOAD_MAX =
+    2 +
+    JSON_KEY("latencyMs") + JSON_INT_MAX + 1 +
+    JSON_KEY("successes") + JSON_INT_MAX + 1 +
+    JSON_KEY("failures") + JSON_INT_MAX + 1 +
+    JSON_KEY("probes") + JSON_INT_MAX + 1 +
+    JSON_KEY("lastHttpCode") + JSON_INT_MAX + 1 +
+    JSON_KEY("uploadRate") + JSON_FIXED_MAX + 1 +
+    JSON_KEY("droppedSecurity") + JSON_INT_MAX + 1 +
+    JSON_KEY("droppedAudit") + JSON_INT_MAX + 1 +
+    JSON_KEY("droppedDiagnostics") + JSON_INT_MAX + 1 +
+    JSON_KEY("freeHeap") + JSON_INT_MAX + 1 +
+    JSON_KEY("uptimeSec") + JSON_INT_MAX + 1 +
+    JSON_KEY("timestamp") + JSON_SERVER_TS_MAX + 1 +
+    JSON_KEY("reconnect") + 2 + RECONNECT_TIER_COUNT * (DIAGNOSTICS_TIER_MAX + 1);
+#define DIAGNOSTICS_PAYLOAD_BUFFER 1024
+
+static_assert(STATUS_PAYLOAD_MAX < STATUS_PAYLOAD_BUFFER, "status payload buffer too small");
+static_assert(BOOT_PAYLOAD_MAX < BOOT_PAYLOAD_BUFFER, "boot payload buffer too small");
+static_assert(EVENT_BATCH_PAYLOAD_MAX < EVENT_BATCH_PAYLOAD_BUFFER, "event batch buffer too small");
+static_assert(LOG_FOLD_PAYLOAD_MAX < LOG_FOLD_PAYLOAD_BUFFER, "log fold buffer too small");
+static_assert(LOG_PRUNE_PAYLOAD_MAX < LOG_PRUNE_PAYLOAD_BUFFER, "log prune buffer too small");
+static_assert(FINGERPRINT_PAYLOAD_MAX < FINGERPRINT_PAYLOAD_BUFFER, "fingerprint payload buffer too small");
+static_assert(DIAGNOSTICS_PAYLOAD_MAX < DIAGNOSTICS_PAYLOAD_BUFFER, "diagnostics payload buffer too small");
+
+// Compact schemas, for transports that carry CBOR (MQTT). Each is an
+// indefinite-length map keyed by the small integers below, so a key costs one
+// byte and unset fields are left out; tools/limo_cbor.py expands them back into
+// the JSON written above. Keys may be added, never renumbered or reused.
+#define CBOR_SCHEMA_VERSION 1
+
+// Status: {0: version, 1: online, 2: locked, 3: secure, 4: timestamp}
+enum StatusCborKey : uint8_t {
+    STATUS_CBOR_VERSION,
+    STATUS_CBOR_ONLINE,
+    STATUS_CBOR_LOCKED,
+    STATUS_CBOR_SECURE,
+    STATUS_CBOR_TIMESTAMP
+};
+
+// Log batch: {0: version, 1: push ID suffix, 2: [event, ..]}
+enum EventBatchCborKey : uint8_t {
+    BATCH_CBOR_VERSION,
+    BATCH_CBOR_PUSH_SUFFIX,
+    BATCH_CBOR_EVENTS
+};
+
+// One event. The record key <day>/<push ID> is rebuilt from the batch's push ID
+// suffix, seq and the key time (TIME when KEY_TIME is absent); the day is the
+// UTC day of the key time unless undated is set.
+enum EventCborKey : uint8_t {
+    EVENT_CBOR_CODE,            // EventType
+    EVENT_CBOR_SEQ,
+    EVENT_CBOR_TIME,            // Epoch ms; absent: the server's timestamp
+    EVENT_CBOR_KEY_TIME,        // Epoch ms of the push ID, unless it equals TIME
+    EVENT_CBOR_UNDATED,         // true: LOG_UNDATED_SHARD
+    EVENT_CBOR_FLAG,            // Stored under the type's flag key (locked, secure, ..)
+    EVENT_CBOR_FINGERPRINT_ID,
+    EVENT_CBOR_TOTAL,
+    EVENT_CBOR_SUCCESS,
+    EVENT_CBOR_USER_ID,
+    EVENT_CBOR_TAG,
+    EVENT_CBOR_DETAIL           // Stored under the type's detail key (ssid, reason, ..)
+};
+
+// Worst-case encoded sizes; keys are all below 24, so one byte each
+#define CBOR_MEMBER(v)         (1 + (v))
+#define CBOR_BOOL_MAX          1
+#define CBOR_INT16_MAX         3
+#define CBOR_UINT32_MAX        5
+#define CBOR_UINT64_MAX        9
+#define CBOR_TEXT_MAX(n)       (2 + (n))                 // n < 256
+
+constexpr size_t STATUS_CBOR_MAX =
+    2 +
+    CBOR_MEMBER(1) +
+    3 * CBOR_MEMBER(CBOR_BOOL_MAX) +
+    CBOR_MEMBER(CBOR_UINT64_MAX);
+#define STATUS_CBOR_BUFFER 32
+
+constexpr size_t EVENT_CBOR_MAX =
+    2 +
+    CBOR_MEMBER(2) +
+    CBOR_MEMBER(CBOR_UINT32_MAX) +
+    2 * CBOR_MEMBER(CBOR_UINT64_MAX) +
+    2 * CBOR_MEMBER(CBOR_BOOL_MAX) +
+    3 * CBOR_MEMBER(CBOR_INT16_MAX) +
+    CBOR_MEMBER(CBOR_TEXT_MAX(EVENT_USER_ID_LEN - 1)) +
+    CBOR_MEMBER(CBOR_TEXT_MAX(EVENT_TAG_LEN - 1)) +
+    CBOR_MEMBER(CBOR_TEXT_MAX(EVENT_DETAIL_LEN - 1));
+constexpr size_t EVENT_BATCH_CBOR_MAX =
+    2 + CBOR_MEMBER(1) + CBOR_MEMBER(CBOR_TEXT_MAX(4)) + 1 + 2 + EVENT_BATCH_SIZE * EVENT_CBOR_MAX;
+#define EVENT_BATCH_CBOR_BUFFER 1024
+
+static_assert(STATUS_CBOR_MAX <= STATUS_CBOR_BUFFER, "status CBOR buffer too small");
+static_assert(EVENT_BATCH_CBOR_MAX <= EVENT_BATCH_CBOR_BUFFER, "event batch CBOR buffer too small");
+
+typedef StaticJsonWriter<STATUS_PAYLOAD_BUFFER> StatusPayload;
+typedef StaticJsonWriter<BOOT_PAYLOAD_BUFFER> BootPayload;
+typedef StaticJsonWriter<EVENT_BATCH_PAYLOAD_BUFFER> EventBatchPayload;
+typedef StaticJsonWriter<LOG_FOLD_PAYLOAD_BUFFER> LogFoldPayload;
+typedef StaticJsonWriter<LOG_PRUNE_PAYLOAD_BUFFER> LogPrunePayload;
+typedef StaticJsonWriter<FINGERPRINT_PAYLOAD_BUFFER> FingerprintPayload;
+typedef StaticJsonWriter<DIAGNOSTICS_PAYLOAD_BUFFER> DiagnosticsPayload;
+typedef StaticCborWriter<STATUS_CBOR_BUFFER> StatusCbor;
+typedef StaticCborWriter<EVENT_BATCH_CBOR_BUFFER> EventBatchCbor;
+
+bool writeStatusPayload(StatusPayload& out, bool isOnline, bool isLocked, bool isSecure, unsigned long long timestamp);
+bool writeBootPayload(BootPayload& out, const char* deviceId, unsigned long long timestamp);
+
+// Open/close the batch object around writeEventPayload() calls
+void beginEventBatch(EventBatchPayload& out);
+void writeEventPayload(EventBatchPayload& out, const char* pushId, const char* eventName,
+                       const EventRecord& event, bool rebased, unsigned long long timestamp,
+                       const char* flagKey, const char* detailKey);
+bool endEventBatch(EventBatchPayload& out);
+
+// Write a summary as the member key of an open object
+void writeLogSummary(JsonWriter& out, const char* key, const LogSummary& summary);
+
+bool writeFingerprintPayload(FingerprintPayload& out, const char* userId, int fingerprintId);
+
+bool writeDiagnosticsPayload(DiagnosticsPayload& out, const DiagnosticsSnapshot& snapshot);
+
+bool writeStatusCbor(StatusCbor& out, bool isOnline, bool isLocked, bool isSecure, unsigned long long timestamp);
+
+// Open/close the batch around writeEventCbor() calls
+void beginEventBatchCbor(EventBatchCbor& out, const char* pushIdSuffix);
+void writeEventCbor(EventBatchCbor& out, const EventRecord& event, bool rebased, unsigned long long timestamp,
+                    bool hasFlag);
+bool endEventBatchCbor(EventBatchCbor& out);
+
+#endif
@@ -0,0 +1,118 @@
+#include "DeviceStreams.h"
+#include "FirebaseHandler.h"
+#include "FingerprintSensor.h"
+#include "ConnectionHealth.h"
+#include "AuthorizedUsers.h"
+#include "DevicePaths.h"
+
+// Retry interval for streams that failed to open or dropped
+const unsigned long STREAM_RETRY_INTERVAL = 10000;
+
+// The library needs one FirebaseData per streamed path, separate from fbdo
+FirebaseData fingerprintStream;
+FirebaseData wifiStream;
+FirebaseData registeredUsersStream;
+
+struct DeviceStream {
+    const char* path;            // Entry in devicePaths, filled in by setupFirebase()
+    FirebaseData* data;
+    StreamChangeCallback onChange;
+    bool active;
+    unsigned long lastBeginAttempt;
+};
+
+DeviceStream deviceStreams[STREAM_COUNT] = {
+    { devicePaths.fingerprint,     &fingerprintStream,     onFingerprintStreamEvent,        false, 0 },
+    { devicePaths.wifi,            &wifiStream,            onWiFiStreamEvent,               false, 0 },
+    { devicePaths.registeredUsers, &registeredUsersStream, AuthorizedUsers::onStreamEvent,  false, 0 }
+};
+
+static bool beginDeviceStream(DeviceStream& s) {
+    s.lastBeginAttempt = millis();
+
+    // Events are small; keep the TLS buffers well below the fbdo sizes
+    s.data->setBSSLBufferSize(2048, 512);
+    s.data->setResponseSize(2048);
+
+    if (!Firebase.RTDB.beginStream(s.data, s.path)) {
+        Serial.print(F("❌ Stream failed for "));
+        Serial.print(s.path);
+        Serial.print(F(": "));
+        Serial.println(s.data->errorReason());
+        s.active = false;
+        return false;
+    }
+
+    Serial.print(F("📡 Streaming "));
+    Serial.println(s.path);
+    s.active = true;
+    return true;
+}
+
+void beginDeviceStreams() {
+    if (!devicePathsReady() || !isFirebaseReady()) {
+        return;
+    }
+
+    for (int i = 0; i < STREAM_COUNT; i++) {
+        if (!deviceStreams[i].active) {
+            beginDeviceStream(deviceStreams[i]);
+        }
+    }
+}
+
+// Reads pending events on every stream and dispatches them to the owning module
+void handleDeviceStreams() {
+    if (!devicePathsReady() || !isFirebaseReady()) {
+        return;
+    }
+
+    unsigned long currentMillis = millis();
+
+    for (int i = 0; i < STREAM_COUNT; i++) {
+        DeviceStream& s = deviceStreams[i];
+
+        if (!s.active) {
+            if (currentMillis - s.lastBeginAttempt >= STREAM_RETRY_INTERVAL) {
+                beginDeviceStream(s);
+            }
+            continue;
+        }
+
+        unsigned long started = millis();
+        if (!Firebase.RTDB.readStream(s.data)) {
+            recordFirebaseOutcome(*s.data, false, started);
+            Serial.print(F("⚠️ Stream read error: "));
+            Serial.println(s.data->errorReason());
+            Firebase.RTDB.endStream(s.data);
+            s.active = false;
+            continue;
+        }
+
+        // Library reconnects on keep-alive timeout; poll fallbacks cover the gap
+        if (s.data->streamTimeout()) {
+            Serial.println(F("⚠️ Stream timeout, resuming"));
+            continue;
+        }
+
+        if (s.data->streamAvailable()) {
+            recordStreamAlive();
+            if (s.onChange != nullptr) {
+                s.onChange(*s.data);
+            }
+        }
+    }
+}
+
+void stopDeviceStreams() {
+    for (int i = 0; i < STREAM_COUNT; i++) {
+        if (deviceStreams[i].active) {
+            Firebase.RTDB.endStream(deviceStreams[i].data);
+            deviceStreams[i].active = false;
+        }
+    }
+}
+
+bool isDeviceStreamActive(DeviceStreamId id) {
+    return id < STREAM_COUNT && deviceStreams[id].active;
+}
@@ -0,0 +1,23 @@
+#ifndef DEVICE_STREAMS_H
+#define DEVICE_STREAMS_H
+
+#include <Arduino.h>
+#include <Firebase_ESP_Client.h>
+
+// Device nodes kept in sync through RTDB server-sent event streams
+enum DeviceStreamId {
+    STREAM_FINGERPRINT,      // devices/<id>/fingerprint - enroll/delete/reset commands
+    STREAM_WIFI,             // devices/<id>/wifi - credentials pushed from the app
+    STREAM_REGISTERED_USERS, // devices/<id>/registeredUsers - tag -> userId for OTP checks
+    STREAM_COUNT
+};
+
+// Change callback, invoked from the network task with the stream's FirebaseData holding the event
+typedef void (*StreamChangeCallback)(FirebaseData& stream);
+
+void beginDeviceStreams();
+void handleDeviceStreams();
+void stopDeviceStreams();
+bool isDeviceStreamActive(DeviceStreamId id);
+
+#endif
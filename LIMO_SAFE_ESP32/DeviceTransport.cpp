@@ -0,0 +1,35 @@
+#include "DeviceTransport.h"
+#include "MqttTransport.h"
+#include "RtdbRest.h"
+
+class RtdbTransport : public DeviceTransport {
+public:
+    const char* name() const override { return "rtdb"; }
+    bool isUp() override { return true; }
+
+    // Every RTDB write is acknowledged, whatever was asked for
+    bool update(const char* path, const JsonWriter& payload, TransportQos) override {
+        return rtdbUpdate(path, payload, &lastStatus);
+    }
+
+    // A client error other than auth, timeout or rate limiting, which say
+    // nothing about the payload
+    bool rejected() const override {
+        return lastStatus >= 400 && lastStatus < 500 && lastStatus != 401 && lastStatus != 403 &&
+               lastStatus != 408 && lastStatus != 429;
+    }
+
+private:
+    int lastStatus = 0;
+};
+
+static RtdbTransport rtdb;
+
+DeviceTransport& rtdbTransport() {
+    return rtdb;
+}
+
+DeviceTransport& uploadTransport() {
+    DeviceTransport& mqtt = mqttTransport();
+    return mqtt.isUp() ? mqtt : rtdb;
+}
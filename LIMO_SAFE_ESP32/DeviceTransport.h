@@ -0,0 +1,45 @@
+#ifndef DEVICE_TRANSPORT_H
+#define DEVICE_TRANSPORT_H
+
+#include <Arduino.h>
+#include "JsonWriter.h"
+#include "CborWriter.h"
+
+// Where the logger, the status shadow and diagnostics send their writes. RTDB
+// REST is always there; MQTT takes over while its broker session is up, and a
+// bridge on the other side merges each message into RTDB (tools/mqtt_bridge.py).
+//
+// A write merges a JSON object of child paths into a node under devices/<id>,
+// exactly like an RTDB multi-path PATCH. A transport that carriesCbor() also
+// takes the compact schemas of DevicePayloads.h for logs and status, which the
+// other side expands into the same JSON.
+
+// What a write needs from the transport
+enum TransportQos : uint8_t {
+    TRANSPORT_LATEST,    // Superseded by the next write (status); may be lost with the link
+    TRANSPORT_RELIABLE   // Acknowledged before success is reported (log records)
+};
+
+class DeviceTransport {
+public:
+    virtual const char* name() const = 0;
+    virtual bool isUp() = 0;
+
+    // path is a devicePaths entry; true once the write was accepted
+    virtual bool update(const char* path, const JsonWriter& payload, TransportQos qos) = 0;
+
+    // The last failed update() was refused for what it carried (e.g. HTTP 400);
+    // sending the same payload again will not help
+    virtual bool rejected() const { return false; }
+
+    virtual bool carriesCbor() const { return false; }
+    virtual bool updateCbor(const char*, const CborWriter&, TransportQos) { return false; }
+};
+
+// Plain RTDB REST (rtdbUpdate)
+DeviceTransport& rtdbTransport();
+
+// MQTT when it is configured and connected, RTDB otherwise. Network task only.
+DeviceTransport& uploadTransport();
+
+#endif
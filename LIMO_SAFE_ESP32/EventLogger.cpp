@@ -0,0 +1,402 @@
+#include "EventLogger.h"
+#include "FirebaseHandler.h"
+#include "DevicePaths.h"
+#include "TimeBase.h"
+#include "ConnectionHealth.h"
+#include "DevicePayloads.h"
+#include "RtdbRest.h"
+#include "LogRollup.h"
+#include "DeviceTransport.h"
+#include <esp_attr.h>
+#include <esp_system.h>
+
+// Stored "event" names, indexed by EventType
+static const char* const EVENT_NAMES[EVT_COUNT] = {
+    "lock",
+    "security",
+    "wifi_connected",
+    "otp_format_invalid",
+    "otp_verification_failed",
+    "otp_verified",
+    "unauthorized_user_attempt",
+    "first_user_registration_failed",
+    "fingerprint_authentication_success",
+    "fingerprint_authentication_failed",
+    "fingerprint_enrolled",
+    "fingerprint_enrollment_failed",
+    "user_fingerprints_deleted",
+    "user_fingerprints_delete_partial",
+    "fingerprint_delete_no_fingerprints",
+    "multiple_fingerprints_deleted",
+    "all_fingerprints_deleted",
+    "otp_lockout",
+    "otp_attempts_blocked"
+};
+
+const char* eventTypeName(EventType type) {
+    return type < EVT_COUNT ? EVENT_NAMES[type] : "";
+}
+
+EventType eventTypeFromName(const char* name) {
+    for (uint8_t type = 0; type < EVT_COUNT; type++) {
+        if (strcmp(EVENT_NAMES[type], name) == 0) {
+            return (EventType)type;
+        }
+    }
+    return EVT_COUNT;
+}
+
+// Key used for the flag field, nullptr if the type has none
+static const char* flagKeyFor(EventType type) {
+    switch (type) {
+        case EVT_LOCK:           return "locked";
+        case EVT_SECURITY:       return "secure";
+        case EVT_FP_ALL_DELETED: return "success";
+        default:                 return nullptr;
+    }
+}
+
+// Key used for the detail field
+static const char* detailKeyFor(EventType type) {
+    switch (type) {
+        case EVT_WIFI_CONNECTED:       return "ssid";
+        case EVT_OTP_FORMAT_INVALID:   return "attempted_otp";
+        case EVT_FP_ENROLLMENT_FAILED: return "reason";
+        case EVT_OTP_LOCKOUT:          return "lockout_seconds";
+        default:                       return "detail";
+    }
+}
+
+// Security-critical events (tamper, unlocks, access attempts) go out before audit records
+UploadClass uploadClassFor(EventType type) {
+    switch (type) {
+        case EVT_LOCK:
+        case EVT_SECURITY:
+        case EVT_OTP_FORMAT_INVALID:
+        case EVT_OTP_VERIFICATION_FAILED:
+        case EVT_OTP_VERIFIED:
+        case EVT_OTP_LOCKOUT:
+        case EVT_OTP_ATTEMPTS_BLOCKED:
+        case EVT_UNAUTHORIZED_USER:
+        case EVT_FP_AUTH_SUCCESS:
+        case EVT_FP_AUTH_FAILED:
+            return UPLOAD_SECURITY;
+        default:
+            return UPLOAD_AUDIT;
+    }
+}
+
+// Ring buffers in RTC memory so queued events survive a crash or soft restart
+#define EVENT_QUEUE_MAGIC 0x45564C34  // "EVL4", bump when EventRecord or the layout changes
+
+struct EventQueue {
+    uint32_t magic;
+    uint32_t nextSeq;
+    char keySuffix[5];          // Random part of the push IDs, for as long as seq counts on
+    uint8_t head[EVENT_RING_COUNT];
+    uint8_t count[EVENT_RING_COUNT];
+    uint16_t dropped[EVENT_RING_COUNT];
+    EventRecord securityRecords[EVENT_SECURITY_QUEUE_SIZE];
+    EventRecord auditRecords[EVENT_AUDIT_QUEUE_SIZE];
+};
+
+RTC_NOINIT_ATTR static EventQueue eventQueue;
+static portMUX_TYPE eventQueueMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const uint8_t RING_CAPACITY[EVENT_RING_COUNT] = {
+    EVENT_SECURITY_QUEUE_SIZE,
+    EVENT_AUDIT_QUEUE_SIZE
+};
+
+static EventRecord* ringRecords(uint8_t ring) {
+    return ring == UPLOAD_SECURITY ? eventQueue.securityRecords : eventQueue.auditRecords;
+}
+
+// Dead-letter step: a batch the server keeps refusing is resent one record at
+// a time up to its last seq, and a single record refused as often is dropped,
+// so one bad record can't hold back its class (or the classes below it)
+static uint8_t rejectCount[EVENT_RING_COUNT];
+static bool isolating[EVENT_RING_COUNT];
+static uint32_t isolateThrough[EVENT_RING_COUNT];
+
+// How long after boot uploads wait for the clock before falling back to server timestamps
+#define EVENT_SYNC_GRACE_US (120LL * 1000000LL)
+
+static const char PUSH_CHARS[] = "-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz";
+
+void initEventLogger() {
+    bool valid = eventQueue.magic == EVENT_QUEUE_MAGIC;
+    for (uint8_t ring = 0; valid && ring < EVENT_RING_COUNT; ring++) {
+        valid = eventQueue.head[ring] < RING_CAPACITY[ring] &&
+                eventQueue.count[ring] <= RING_CAPACITY[ring];
+    }
+
+    if (!valid) {
+        memset(&eventQueue, 0, sizeof(eventQueue));
+        eventQueue.magic = EVENT_QUEUE_MAGIC;
+
+        // seq starts over, so keys from before can only be told apart by the suffix
+        uint32_t r = esp_random();
+        for (int i = 0; i < 4; i++) {
+            eventQueue.keySuffix[i] = PUSH_CHARS[(r >> (i * 6)) & 0x3F];
+        }
+        eventQueue.keySuffix[4] = '\0';
+    } else if (pendingEventCount() > 0) {
+        Serial.print(F("📋 Restored queued events: "));
+        Serial.println(pendingEventCount());
+    }
+}
+
+EventRecord makeEvent(EventType type) {
+    EventRecord event;
+    memset(&event, 0, sizeof(event));
+    event.monoUs = monotonicMicros();
+    event.bootId = currentBootId();
+    event.type = type;
+    event.flag = EVENT_UNSET;
+    event.fingerprintId = EVENT_UNSET;
+    event.total = EVENT_UNSET;
+    event.success = EVENT_UNSET;
+    return event;
+}
+
+void setEventText(char* field, size_t size, const String& text) {
+    strncpy(field, text.c_str(), size - 1);
+    field[size - 1] = '\0';
+}
+
+bool logEvent(const EventRecord& event) {
+    if (event.type >= EVT_COUNT) {
+        return false;
+    }
+
+    uint8_t ring = uploadClassFor(event.type);
+    uint8_t capacity = RING_CAPACITY[ring];
+    EventRecord* records = ringRecords(ring);
+    bool overwritten = false;
+
+    portENTER_CRITICAL(&eventQueueMux);
+    if (eventQueue.count[ring] == capacity) {
+        // Full: drop the oldest record of this class only
+        eventQueue.head[ring] = (eventQueue.head[ring] + 1) % capacity;
+        eventQueue.count[ring]--;
+        eventQueue.dropped[ring]++;
+        overwritten = true;
+    }
+    uint8_t tail = (eventQueue.head[ring] + eventQueue.count[ring]) % capacity;
+    records[tail] = event;
+    records[tail].seq = eventQueue.nextSeq++;
+    eventQueue.count[ring]++;
+    portEXIT_CRITICAL(&eventQueueMux);
+
+    if (overwritten) {
+        Serial.println(ring == UPLOAD_SECURITY ?
+            F("⚠️ Security event queue full! Overwriting oldest entry.") :
+            F("⚠️ Audit event queue full! Overwriting oldest entry."));
+    }
+    return true;
+}
+
+bool logEvent(EventType type, const String& userId, const String& tag) {
+    EventRecord event = makeEvent(type);
+    SET_EVENT_TEXT(event.userId, userId);
+    SET_EVENT_TEXT(event.tag, tag);
+    return logEvent(event);
+}
+
+bool logFlagEvent(EventType type, bool flag) {
+    EventRecord event = makeEvent(type);
+    event.flag = flag ? 1 : 0;
+    return logEvent(event);
+}
+
+size_t pendingEventCount(UploadClass uploadClass) {
+    if (uploadClass >= EVENT_RING_COUNT) {
+        return 0;
+    }
+    portENTER_CRITICAL(&eventQueueMux);
+    size_t count = eventQueue.count[uploadClass];
+    portEXIT_CRITICAL(&eventQueueMux);
+    return count;
+}
+
+size_t pendingEventCount() {
+    return pendingEventCount(UPLOAD_SECURITY) + pendingEventCount(UPLOAD_AUDIT);
+}
+
+uint16_t droppedEventCount(UploadClass uploadClass) {
+    return uploadClass < EVENT_RING_COUNT ? eventQueue.dropped[uploadClass] : 0;
+}
+
+// Firebase-style push ID: 8 time chars keep keys in order, then the queue's random part + sequence
+static void makePushId(const EventRecord& event, char out[21]) {
+    uint64_t t = event.keyTimeMs;
+    for (int i = 7; i >= 0; i--) {
+        out[i] = PUSH_CHARS[t & 0x3F];
+        t >>= 6;
+    }
+    memcpy(out + 8, eventQueue.keySuffix, 4);
+    uint64_t seq = event.seq;
+    for (int i = 19; i >= 12; i--) {
+        out[i] = PUSH_CHARS[seq & 0x3F];
+        seq >>= 6;
+    }
+    out[20] = '\0';
+}
+
+bool pushIdTime(const char* pushId, unsigned long long& timeMs) {
+    timeMs = 0;
+    for (int i = 0; i < 8; i++) {
+        const char* digit = pushId[i] != '\0' ? strchr(PUSH_CHARS, pushId[i]) : nullptr;
+        if (digit == nullptr) {
+            return false;
+        }
+        timeMs = timeMs * 64 + (digit - PUSH_CHARS);
+    }
+    return true;
+}
+
+// When an event happened
+struct EventTimes {
+    bool rebased;                   // false: the server's timestamp stands in
+    unsigned long long timestamp;
+};
+
+static EventTimes eventTimes(const EventRecord& event) {
+    // Rebase the monotonic stamp; events from a boot that never synced get the server's time
+    EventTimes times;
+    times.timestamp = 0;
+    times.rebased = monotonicToEpochMillis(event.bootId, event.monoUs, times.timestamp);
+    return times;
+}
+
+// Fix the record key <day>/<pushId> on the first attempt, so a retried batch -
+// even after a resync moved the offset or a soft reset - writes the same keys.
+// The day is unknown until some boot has synced.
+static void fixEventKey(EventRecord& event) {
+    if (event.keyed) {
+        return;
+    }
+    EventTimes times = eventTimes(event);
+    event.keyTimeMs = times.rebased ? times.timestamp : epochMillis();
+    event.undated = !times.rebased && !isEpochValid();
+    event.keyed = true;
+}
+
+static void appendEvent(EventBatchPayload& batch, const EventRecord& event) {
+    EventTimes times = eventTimes(event);
+    char pushId[21];
+    makePushId(event, pushId);
+    char day[LOG_DAY_LEN];
+    if (event.undated) {
+        strcpy(day, LOG_UNDATED_SHARD);
+    } else {
+        formatLogDay(event.keyTimeMs, day);
+    }
+    char key[LOG_DAY_LEN + 21];
+    snprintf(key, sizeof(key), "%s/%s", day, pushId);
+
+    writeEventPayload(batch, key, EVENT_NAMES[event.type], event, times.rebased, times.timestamp,
+                      flagKeyFor(event.type), detailKeyFor(event.type));
+}
+
+// Same record in the compact schema; the bridge rebuilds the key and field names
+static void appendEventCbor(EventBatchCbor& batch, const EventRecord& event) {
+    EventTimes times = eventTimes(event);
+    writeEventCbor(batch, event, times.rebased, times.timestamp, flagKeyFor(event.type) != nullptr);
+}
+
+// Upload up to EVENT_BATCH_SIZE records of one class in one multi-path update
+UploadResult processEventQueue(UploadClass uploadClass) {
+    if (uploadClass >= EVENT_RING_COUNT) {
+        return UPLOAD_IDLE;
+    }
+
+    // Shortly after boot, hold audit records for NTP so they get real timestamps;
+    // security events go out at once and fall back to the server's time
+    if (uploadClass == UPLOAD_AUDIT && !isEpochValid() && monotonicMicros() < EVENT_SYNC_GRACE_US) {
+        return UPLOAD_IDLE;
+    }
+
+    uint8_t ring = uploadClass;
+    uint8_t capacity = RING_CAPACITY[ring];
+    EventRecord* records = ringRecords(ring);
+    EventRecord batchRecords[EVENT_BATCH_SIZE];
+    uint8_t batchCount = 0;
+    uint8_t batchLimit = isolating[ring] ? 1 : EVENT_BATCH_SIZE;
+
+    // Copy the oldest records out so producers can keep logging during the upload
+    portENTER_CRITICAL(&eventQueueMux);
+    while (batchCount < batchLimit && batchCount < eventQueue.count[ring]) {
+        EventRecord& record = records[(eventQueue.head[ring] + batchCount) % capacity];
+        fixEventKey(record);
+        batchRecords[batchCount] = record;
+        batchCount++;
+    }
+    portEXIT_CRITICAL(&eventQueueMux);
+
+    if (batchCount == 0) {
+        return UPLOAD_IDLE;
+    }
+
+    // Serialized straight into a static buffer, no heap
+    DeviceTransport& transport = uploadTransport();
+    bool sent;
+    if (transport.carriesCbor()) {
+        static EventBatchCbor batch;
+        beginEventBatchCbor(batch, eventQueue.keySuffix);
+        for (uint8_t i = 0; i < batchCount; i++) {
+            appendEventCbor(batch, batchRecords[i]);
+        }
+        endEventBatchCbor(batch);
+        sent = transport.updateCbor(devicePaths.logs, batch, TRANSPORT_RELIABLE);
+    } else {
+        static EventBatchPayload batch;
+        beginEventBatch(batch);
+        for (uint8_t i = 0; i < batchCount; i++) {
+            appendEvent(batch, batchRecords[i]);
+        }
+        endEventBatch(batch);
+        sent = transport.update(devicePaths.logs, batch, TRANSPORT_RELIABLE);
+    }
+    uint32_t lastSent = batchRecords[batchCount - 1].seq;
+    if (!sent) {
+        // A link failure is retried as is; only refusals lead to the dead-letter step
+        if (!transport.rejected() || ++rejectCount[ring] < EVENT_MAX_REJECTS) {
+            return UPLOAD_FAILED;
+        }
+        rejectCount[ring] = 0;
+        if (batchCount > 1) {
+            isolating[ring] = true;
+            isolateThrough[ring] = lastSent;
+            Serial.println(F("⚠️ Log batch refused, resending it one record at a time"));
+            return UPLOAD_FAILED;
+        }
+        Serial.println(F("🗑️ Log record refused by the server, dropped"));
+    }
+    rejectCount[ring] = 0;
+
+    // Drop what we sent (or gave up on); records overwritten meanwhile are simply
+    // no longer at the head
+    portENTER_CRITICAL(&eventQueueMux);
+    while (eventQueue.count[ring] > 0 &&
+           (int32_t)(records[eventQueue.head[ring]].seq - lastSent) <= 0) {
+        eventQueue.head[ring] = (eventQueue.head[ring] + 1) % capacity;
+        eventQueue.count[ring]--;
+    }
+    if (!sent) {
+        eventQueue.dropped[ring]++;
+    }
+    if (isolating[ring] && (eventQueue.count[ring] == 0 ||
+        (int32_t)(records[eventQueue.head[ring]].seq - isolateThrough[ring]) > 0)) {
+        isolating[ring] = false;
+    }
+    portEXIT_CRITICAL(&eventQueueMux);
+
+    if (!sent) {
+        return UPLOAD_FAILED;
+    }
+    Serial.print(F("✅ Uploaded log events: "));
+    Serial.println(batchCount);
+    return UPLOAD_OK;
+}
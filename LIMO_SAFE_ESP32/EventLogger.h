@@ -0,0 +1,91 @@
+#ifndef EVENT_LOGGER_H
+#define EVENT_LOGGER_H
+
+#include <Arduino.h>
+#include "UploadScheduler.h"
+
+// Events written to devices/<id>/logs/<day>. The names in EventLogger.cpp are the
+// "event" values the app sees; keep the two lists in the same order. The numbers
+// are the event codes of the compact (CBOR) schema, also known to
+// tools/limo_cbor.py: add new types at the end, never renumber.
+enum EventType : uint8_t {
+    EVT_LOCK = 0,                     // flag = locked
+    EVT_SECURITY = 1,                 // flag = secure
+    EVT_WIFI_CONNECTED = 2,           // detail = SSID
+    EVT_OTP_FORMAT_INVALID = 3,       // detail = attempted code
+    EVT_OTP_VERIFICATION_FAILED = 4,  // tag
+    EVT_OTP_VERIFIED = 5,             // userId, tag
+    EVT_UNAUTHORIZED_USER = 6,        // tag, userId if known
+    EVT_FIRST_USER_REGISTRATION_FAILED = 7, // userId, tag
+    EVT_FP_AUTH_SUCCESS = 8,          // fingerprintId, userId if mapped
+    EVT_FP_AUTH_FAILED = 9,
+    EVT_FP_ENROLLED = 10,             // userId, fingerprintId
+    EVT_FP_ENROLLMENT_FAILED = 11,    // userId, detail = reason
+    EVT_FP_USER_DELETED = 12,         // userId, total, success
+    EVT_FP_USER_DELETE_PARTIAL = 13,  // userId, total, success
+    EVT_FP_DELETE_NO_FINGERPRINTS = 14, // userId
+    EVT_FP_MULTIPLE_DELETED = 15,     // userId, total, success
+    EVT_FP_ALL_DELETED = 16,          // userId, flag = success
+    EVT_OTP_LOCKOUT = 17,             // tag (empty = whole device), total = failures, detail = seconds
+    EVT_OTP_ATTEMPTS_BLOCKED = 18,    // tag (empty = whole device), total = attempts refused
+    EVT_COUNT
+};
+
+// Per-class rings, kept across soft resets while offline
+#define EVENT_SECURITY_QUEUE_SIZE 20
+#define EVENT_AUDIT_QUEUE_SIZE 12
+#define EVENT_RING_COUNT 2       // UPLOAD_SECURITY and UPLOAD_AUDIT
+#define EVENT_BATCH_SIZE 8       // Records per multi-path upload
+#define EVENT_MAX_REJECTS 3      // Refusals before a batch is split, then before a record is dropped
+#define EVENT_USER_ID_LEN 32
+#define EVENT_TAG_LEN 4
+#define EVENT_DETAIL_LEN 33
+
+#define EVENT_UNSET -1
+
+// Fixed-size record; unused numeric fields are EVENT_UNSET, unused text is empty
+struct EventRecord {
+    int64_t monoUs;              // monotonicMicros() when logged, rebased to epoch on upload
+    uint64_t keyTimeMs;          // Push ID time, fixed by the first upload attempt
+    uint32_t seq;
+    uint16_t bootId;
+    EventType type;
+    int8_t flag;
+    int16_t fingerprintId;
+    int16_t total;
+    int16_t success;
+    bool keyed;                  // keyTimeMs and undated are set; retries reuse the key
+    bool undated;                // Filed under LOG_UNDATED_SHARD
+    char userId[EVENT_USER_ID_LEN];
+    char tag[EVENT_TAG_LEN];
+    char detail[EVENT_DETAIL_LEN];
+};
+
+// Restore records that survived a soft reset (call once in setup)
+void initEventLogger();
+
+// Build a record stamped with the current time
+EventRecord makeEvent(EventType type);
+void setEventText(char* field, size_t size, const String& text);
+#define SET_EVENT_TEXT(field, text) setEventText(field, sizeof(field), text)
+
+// Enqueue and return immediately; safe from any task
+bool logEvent(const EventRecord& event);
+bool logEvent(EventType type, const String& userId = "", const String& tag = "");
+bool logFlagEvent(EventType type, bool flag);
+
+// Stored "event" name of a type, and back; EVT_COUNT for a name this firmware doesn't know
+const char* eventTypeName(EventType type);
+EventType eventTypeFromName(const char* name);
+
+// Epoch ms encoded in the first 8 chars of a push ID; false if it isn't one
+bool pushIdTime(const char* pushId, unsigned long long& timeMs);
+
+// Upload one batch of a class (network task)
+UploadClass uploadClassFor(EventType type);
+UploadResult processEventQueue(UploadClass uploadClass);
+size_t pendingEventCount(UploadClass uploadClass);
+size_t pendingEventCount();
+uint16_t droppedEventCount(UploadClass uploadClass);
+
+#endif
@@ -3,48 +3,82 @@
 #include "WiFiSetup.h"
 #include "FirebaseHandler.h"
 #include "RGBLed.h"
+#include "DeviceStreams.h"
+#include "ConnectionHealth.h"
+#include "EventLogger.h"
+#include "DevicePayloads.h"
+#include "RtdbRest.h"
+#include "DevicePaths.h"
+#include "RtdbCache.h"
+#include "JsonScanner.h"
+#include "RtdbFlow.h"
 
 // Define pins for fingerprint sensor (adjust if necessary)
 
 HardwareSerial FingerSerial(2);  // Use UART2
 Adafruit_Fingerprint finger = Adafruit_Fingerprint(&FingerSerial);
 
-// Firebase data cache to reduce redundant queries
-struct {
-    unsigned long lastRefreshTime = 0;
-    const unsigned long CACHE_TIMEOUT = 5000; // 5 seconds cache validity
-    FirebaseJson fingerprintMappings;
-    bool isValid = false;
-    
-    bool needsRefresh() {
-        return !isValid || (millis() - lastRefreshTime > CACHE_TIMEOUT);
+// devices/<id>/fingerprint is read through RtdbCache and scanned in place, never parsed into a DOM.
+// The stream keeps it current; while the stream is down it is read again every few seconds.
+#define FP_CACHE_POLL_TTL_MS 5000UL
+#define FP_CACHE_STREAM_TTL_MS 600000UL
+#define FP_USER_ARRAY_TTL_MS 60000UL   // users/<uid>/registeredDevices/<id>/fingerprint, only we write it
+#define FP_COMMAND_SCAN_MAX 4           // Commands collected per scan of the node
+
+static const String* fingerprintNode() {
+    // Without a connection, keep using what we have
+    if (!isFirebaseReady()) {
+        return RtdbCache::peek(devicePaths.fingerprint);
     }
     
-    void refresh() {
-        // Only refresh if Firebase is ready
-        if (!isFirebaseReady()) {
-            return;
+    unsigned long ttl = isDeviceStreamActive(STREAM_FINGERPRINT) ? FP_CACHE_STREAM_TTL_MS : FP_CACHE_POLL_TTL_MS;
+    const String* body = RtdbCache::get(devicePaths.fingerprint, ttl);
+    return body != nullptr ? body : RtdbCache::peek(devicePaths.fingerprint);
+}
+
+// Children of the fingerprint node holding a command ("enroll", "delete_...", "reset")
+struct PendingFingerprintCommand {
+    char userId[NET_TEXT_LEN];
+    char status[JSON_SCAN_VALUE_LEN + 1];
+};
+
+class FingerprintCommandScanner : public JsonScanner {
+public:
+    PendingFingerprintCommand found[FP_COMMAND_SCAN_MAX];
+    uint8_t count = 0;
+    
+protected:
+    bool onToken(const JsonToken& token) override {
+        if (token.depth != 1 || token.type != JSON_STRING) {
+            return true;
         }
-        
-        String mappingsPath = String(DEVICE_PATH) + deviceId + "/fingerprint";
-        
-        if (Firebase.RTDB.getJSON(&fbdo, mappingsPath.c_str())) {
-            FirebaseJson* json = fbdo.jsonObjectPtr();
-            if (json != nullptr) {
-                fingerprintMappings = *json;
-                isValid = true;
-                lastRefreshTime = millis();
-            }
+        if (strcmp(token.text, "enroll") != 0 && strcmp(token.text, "reset") != 0 &&
+            strncmp(token.text, "delete_", 7) != 0) {
+            return true;
         }
+        strncpy(found[count].userId, token.key, NET_TEXT_LEN - 1);
+        found[count].userId[NET_TEXT_LEN - 1] = '\0';
+        strcpy(found[count].status, token.text);
+        return ++count < FP_COMMAND_SCAN_MAX;
     }
-    
-    FirebaseJson* getData() {
-        if (needsRefresh()) {
-            refresh();
-        }
-        return isValid ? &fingerprintMappings : nullptr;
+};
+
+// A user's fingerprint IDs for this device, through the cache
+static bool readUserFingerprints(const char* userFingerprintPath, FirebaseJsonArray& fingerprintArray) {
+    const String* body = RtdbCache::get(userFingerprintPath, FP_USER_ARRAY_TTL_MS);
+    if (body == nullptr || !body->startsWith("[")) {
+        return false;
     }
-} firebaseCache;
+    return fingerprintArray.setJsonArrayData(*body);
+}
+
+// Set by the fingerprint stream when the node changes, consumed by checkForCommands()
+bool fingerprintCommandsPending = false;
+
+// Network task: a command was handed to core 1 and its result has not come back yet
+volatile bool fingerprintCommandInFlight = false;
+unsigned long fingerprintCommandStartTime = 0;
+const unsigned long FP_COMMAND_TIMEOUT = 180000;        // Give up on a lost result after 3 minutes
 
 // State variables
 bool fingerprintEnrollmentInProgress = false;
@@ -55,7 +89,7 @@ EnrollmentState enrollmentState = ENROLL_IDLE;
 unsigned long enrollmentStateStartTime = 0;
 unsigned long lastCommandCheck = 0;
 const unsigned long ENROLLMENT_STATE_TIMEOUT = 30000;   // 30 seconds timeout
-const unsigned long COMMAND_CHECK_INTERVAL = 10000;     // 10 seconds between command checks
+const unsigned long COMMAND_CHECK_INTERVAL = 10000;     // 10 seconds between polls (stream down only)
 
 // Enrollment variables
 int currentEnrollmentId = -1;
@@ -63,9 +97,15 @@ String currentEnrollmentUserId = "";
 
 // Delete command variables
 bool deleteCommandPending = false;
-int fingerprintToDelete = -1;  // -1 means delete all, -2 means multiple, positive number is specific ID
+FingerprintCommand deleteCommand = FP_CMD_DELETE_IDS;
+bool deleteUserHasFingerprints = false;
 std::vector<int> fingerprints_to_delete;
 
+// Copy a user ID into a queue message
+static void copyNetText(char* dest, const String& text) {
+    strncpy(dest, text.c_str(), NET_TEXT_LEN - 1);
+}
+
 void initializeFingerprint() {
     FingerSerial.begin(57600, SERIAL_8N1, 32, 33);
     
@@ -79,32 +119,35 @@ void initializeFingerprint() {
     finger.setSecurityLevel(3);
 }
 
-// Log authentication events to Firebase
-void logAuthenticationEvent(bool success, int fingerprintId = -1) {
-    if (!isFirebaseReady()) {
-        return;
-    }
-    
-    FirebaseJson logEntry;
-    logEntry.set("timestamp", isTimeSynchronized());
-    logEntry.set("event", success ? "fingerprint_authentication_success" : "fingerprint_authentication_failed");
+
+// Log authentication events (network task, where the fingerprint mappings are cached)
+void logAuthenticationEvent(bool success, int fingerprintId) {
+    EventRecord event = makeEvent(success ? EVT_FP_AUTH_SUCCESS : EVT_FP_AUTH_FAILED);
     
     if (fingerprintId > 0) {
-        logEntry.set("fingerprintId", fingerprintId);
+        event.fingerprintId = fingerprintId;
         
-        // Get userId associated with this fingerprintId
-        String mappingsPath = String(DEVICE_PATH) + deviceId + "/fingerprint/ids/" + String(fingerprintId);
-        if (Firebase.RTDB.getString(&fbdo, mappingsPath.c_str())) {
-            String userId = fbdo.stringData();
-            userId.replace("\"", ""); // Remove quotes
-            if (userId.length() > 0) {
-                logEntry.set("userId", userId);
-            }
+        // Get userId associated with this fingerprintId from the ids/<n> mapping
+        const String* node = fingerprintNode();
+        char idPath[16];
+        snprintf(idPath, sizeof(idPath), "ids/%d", fingerprintId);
+        JsonField mapping = { idPath, event.userId, sizeof(event.userId) };
+        JsonFieldExtractor extractor(&mapping, 1);
+        if (node != nullptr) {
+            extractor.scan(*node);
         }
     }
     
-    String logPath = String("devices/") + deviceId + "/logs";
-    Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry);
+    logEvent(event);
+}
+
+// Hand an authentication log to the network task so the unlock isn't held up
+static void queueAuthenticationLog(bool success, int fingerprintId = -1) {
+    NetRequest request = {};
+    request.type = NET_FP_AUTH_LOG;
+    request.flag = success;
+    request.value = fingerprintId;
+    postNetRequest(request);
 }
 
 bool authenticateUser() {
@@ -154,18 +197,14 @@ bool authenticateUser() {
                     Serial.print(F("✅ Recognized ID #")); 
                     Serial.println(finger.fingerID);
                     fingerprintState = FP_IDLE;
-                    
-                    // Log successful authentication
-                    logAuthenticationEvent(true, finger.fingerID);
-                    
-                    return true; // Authentication successful
+                    return true; // Authentication successful; logged after the unlock
                 } else {
                     fingerprintState = FP_IDLE;
                     if (!fingerprintEnrollmentInProgress) {
                         setLEDStatus(STATUS_ERROR);
                         
                         // Log failed authentication
-                        logAuthenticationEvent(false);
+                        queueAuthenticationLog(false);
                     }
                 }
             }
@@ -337,10 +376,42 @@ bool enrollFingerprint(int id) {
     }
 }
 
-// Unified function to check and process Firebase commands
+// Keep the cached fingerprint node in step with the stream and schedule a command scan
+void onFingerprintStreamEvent(FirebaseData& stream) {
+    String path = stream.dataPath();   // "/", "/<userId>" or "/ids/<n>"
+    String type = stream.dataType();
+    
+    // A full snapshot replaces the cached body; anything partial is re-read on the next scan
+    if (path == "/" && stream.eventType() == "put" && (type == "json" || type == "null")) {
+        String body = "null";
+        if (type == "json") {
+            stream.jsonObject().toString(body);
+        }
+        RtdbCache::put(devicePaths.fingerprint, body);
+    } else {
+        RtdbCache::invalidate(devicePaths.fingerprint);
+    }
+    fingerprintCommandsPending = true;
+}
+
+// Scan the fingerprint node for commands and hand the first one to core 1 (network task)
 void checkForCommands() {
-    // Don't check if enrollment is in progress or if it's too soon
-    if (enrollmentState != ENROLL_IDLE || millis() - lastCommandCheck < COMMAND_CHECK_INTERVAL) {
+    // One command at a time; core 1 reports back through a NetRequest
+    if (fingerprintCommandInFlight) {
+        if (millis() - fingerprintCommandStartTime < FP_COMMAND_TIMEOUT) {
+            return;
+        }
+        Serial.println(F("⚠️ Fingerprint command result lost, rescanning"));
+        fingerprintCommandInFlight = false;
+        fingerprintCommandsPending = true;
+    }
+    
+    // With the stream up, scan only when the node changed; otherwise poll on a timer
+    if (isDeviceStreamActive(STREAM_FINGERPRINT)) {
+        if (!fingerprintCommandsPending) {
+            return;
+        }
+    } else if (millis() - lastCommandCheck < COMMAND_CHECK_INTERVAL) {
         return;
     }
     
@@ -350,69 +421,72 @@ void checkForCommands() {
     if (!isFirebaseReady()) {
         return;
     }
+    fingerprintCommandsPending = false;
 
-    // Get the fingerprint mappings data (using cache if available)
-    FirebaseJson* json = firebaseCache.getData();
-    if (json == nullptr) {
+    // Get the fingerprint node (using cache if available) and pick out the commands
+    const String* node = fingerprintNode();
+    if (node == nullptr) {
+        return;
+    }
+    FingerprintCommandScanner scanner;
+    if (!scanner.scan(*node)) {
+        Serial.println(F("❌ Malformed fingerprint node"));
         return;
     }
 
-    // Iterate through all users in the mappings
-    size_t iterCount = json->iteratorBegin();
-    FirebaseJson::IteratorValue value;
+    NetResult command = {};
+    command.type = NET_EVENT_FP_COMMAND;
     bool commandFound = false;
+    char commandPath[CHILD_PATH_LEN] = "";  // Node to clear after the hand-off
     
-    for (size_t i = 0; i < iterCount && !commandFound; i++) {
-        value = json->valueAt(i);
-        String userId = value.key;
-        String status = value.value;
-        status.replace("\"", ""); // Remove quotes
+    for (uint8_t i = 0; i < scanner.count && !commandFound; i++) {
+        String userId = scanner.found[i].userId;
+        String status = scanner.found[i].status;
         
-        String mappingsPath = String(DEVICE_PATH) + deviceId + "/fingerprint";
-        String userPath = mappingsPath + "/" + userId;
+        char userPath[CHILD_PATH_LEN];
+        if (!formatChildPath(userPath, sizeof(userPath), devicePaths.fingerprint, userId.c_str())) {
+            continue;
+        }
         
         // Process enrollment requests
         if (status == "enroll") {
             Serial.print("📱 Fingerprint enrollment requested for user: ");
             Serial.println(userId);
             
-            // Find the next available fingerprint ID
-            int availableId = findNextAvailableId();
-            
-            if (availableId <= 0) {
-                Serial.println("❌ No available fingerprint slots!");
-                
-                // Log failure
-                FirebaseJson logEntry;
-                logEntry.set("timestamp", isTimeSynchronized());
-                logEntry.set("event", "fingerprint_enrollment_failed");
-                logEntry.set("userId", userId);
-                logEntry.set("reason", "no_available_slots");
-
-                String logPath = String("devices/") + deviceId + "/logs";
-                Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry);
-
-                Firebase.RTDB.deleteNode(&fbdo, userPath.c_str());
-                continue;
-            }
-            
-            // Start enrollment process
-            currentEnrollmentId = availableId;
-            currentEnrollmentUserId = userId;
-            enrollFingerprint(currentEnrollmentId);
+            // The node stays "enroll" until updateFingerprintStatus() records the outcome
+            command.value = FP_CMD_ENROLL;
+            copyNetText(command.text, userId);
             commandFound = true;
         }
         // Process delete_all command
         else if (status == "delete_all") {
             Serial.print("📱 Command received: Delete all fingerprints for user: ");
             Serial.println(userId);
-            deleteCommandPending = true;
-            fingerprintToDelete = -1;
-            currentEnrollmentUserId = userId;
-            fingerprints_to_delete.clear();
             
-            // Clear the command after reading
-            Firebase.RTDB.deleteNode(&fbdo, userPath.c_str());
+            command.value = FP_CMD_DELETE_USER;
+            copyNetText(command.text, userId);
+            
+            // Resolve the user's fingerprint IDs here so core 1 only touches the sensor
+            char userFingerprintPath[USER_PATH_LEN];
+            formatUserDevicePath(userFingerprintPath, sizeof(userFingerprintPath), userId.c_str(), "fingerprint");
+            FirebaseJsonArray fingerprintArray;
+            if (readUserFingerprints(userFingerprintPath, fingerprintArray)) {
+                size_t arraySize = fingerprintArray.size();
+                
+                if (arraySize > NET_MAX_IDS) {
+                    Serial.println(F("⚠️ Too many fingerprints for one command, deleting the first batch"));
+                    arraySize = NET_MAX_IDS;
+                }
+                
+                for (size_t j = 0; j < arraySize; j++) {
+                    FirebaseJsonData result;
+                    fingerprintArray.get(result, j);
+                    command.ids[command.idCount++] = result.intValue;
+                }
+                command.flag = true;
+            }
+            
+            strcpy(commandPath, userPath);  // Cleared once core 1 has the command
             commandFound = true;
         }
         // Process delete_ID or delete_ID1,ID2,ID3 format
@@ -426,7 +500,6 @@ void checkForCommands() {
             String idsToDelete = status.substring(7); // Remove "delete_" prefix
             
             // Parse comma-separated IDs
-            fingerprints_to_delete.clear();
             int commaIndex = -1;
             int startPos = 0;
             
@@ -441,139 +514,191 @@ void checkForCommands() {
                     idStr = idsToDelete.substring(startPos);
                 }
                 
-                // Convert to integer and add to our vector
-                if (idStr.length() > 0) {
+                // Convert to integer and add to the command
+                if (idStr.length() > 0 && command.idCount < NET_MAX_IDS) {
                     int id = idStr.toInt();
-                    fingerprints_to_delete.push_back(id);
+                    command.ids[command.idCount++] = id;
                     Serial.print("Added ID to delete list: ");
                     Serial.println(id);
                 }
             } while (commaIndex != -1);
             
-            if (fingerprints_to_delete.size() > 0) {
-                deleteCommandPending = true;
-                currentEnrollmentUserId = userId;
-                
-                // For backward compatibility with original code
-                fingerprintToDelete = (fingerprints_to_delete.size() == 1) ? 
-                                      fingerprints_to_delete[0] : -2; // -2 indicates multiple IDs
-                
+            if (command.idCount > 0) {
                 Serial.print("Found ");
-                Serial.print(fingerprints_to_delete.size());
+                Serial.print(command.idCount);
                 Serial.println(" fingerprint ID(s) to delete");
+                
+                command.value = FP_CMD_DELETE_IDS;
+                copyNetText(command.text, userId);
+                strcpy(commandPath, userPath);  // Cleared once core 1 has the command
+                commandFound = true;
             } else {
                 Serial.println("❌ No valid fingerprint IDs found in delete command");
+                
+                // Nothing to retry: drop the malformed command
+                Firebase.RTDB.deleteNode(&fbdo, userPath);
+                RtdbCache::invalidate(devicePaths.fingerprint);
             }
-            
-            // Clear the command after reading
-            Firebase.RTDB.deleteNode(&fbdo, userPath.c_str());
-            commandFound = true;
         }
         else if (status == "reset") {
-            String resetValue = fbdo.stringData();
-            resetValue.replace("\"", ""); // Remove quotes
             Serial.println("📱 Command received: Reset all fingerprints");
-            // Empty the fingerprint database
-                uint8_t p = finger.emptyDatabase();
-                bool success = (p == FINGERPRINT_OK);
-                
-                if (success) {
-                    Serial.println("✅ All fingerprints deleted successfully");
-                } else {
-                    Serial.println("❌ Failed to delete all fingerprints");
-                }
-                
-                // Log the reset event
-                FirebaseJson logEntry;
-                logEntry.set("timestamp", isTimeSynchronized());
-                logEntry.set("event", "all_fingerprints_deleted");
-                logEntry.set("userId", userId);
-                logEntry.set("success", success);
-                
-                String logPath = String("devices/") + deviceId + "/logs";
-                Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry);
-                
-                // Clear the command
-                String mappingsPath = String(DEVICE_PATH) + deviceId + "/fingerprint";
-                Firebase.RTDB.deleteNode(&fbdo, userPath.c_str());
-                
-                // Invalidate the cache
-                firebaseCache.isValid = false;
-                
-                // Set LED status
-                setLEDStatus(success ? STATUS_ONLINE : STATUS_ERROR);
-                return; // Stop processing other commands
-           
+            
+            command.value = FP_CMD_RESET;
+            copyNetText(command.text, userId);
+            strcpy(commandPath, userPath);  // Cleared once core 1 has the command
+            commandFound = true;
         }
     }
     
-    json->iteratorEnd();
+    if (!commandFound) {
+        return;
+    }
     
-    // If a command was found and processed, invalidate the cache
-    if (commandFound) {
-        firebaseCache.isValid = false;
+    if (!postNetResult(command)) {
+        // The node still holds the command; try again on the next pass
+        fingerprintCommandsPending = true;
+        return;
+    }
+    fingerprintCommandInFlight = true;
+    fingerprintCommandStartTime = millis();
+    
+    // Handed off, so the command can leave the node (enroll keeps it until the result)
+    if (commandPath[0] != '\0') {
+        Firebase.RTDB.deleteNode(&fbdo, commandPath);
+        RtdbCache::invalidate(devicePaths.fingerprint);
     }
 }
 
-// Function to update Firebase after enrollment completes
-void updateFingerprintStatus(bool success) {
-    if (currentEnrollmentUserId.isEmpty()) {
-        return;
+// Run the sensor side of a command from checkForCommands() (core 1)
+void onFingerprintCommand(const NetResult& command) {
+    String userId = String(command.text);
+    
+    switch (command.value) {
+        case FP_CMD_ENROLL: {
+            // Find the next available fingerprint ID
+            int availableId = findNextAvailableId();
+            
+            if (availableId <= 0) {
+                Serial.println("❌ No available fingerprint slots!");
+                
+                NetRequest request = {};
+                request.type = NET_FP_ENROLL_RESULT;
+                request.value = -1;
+                request.flag = false;
+                copyNetText(request.text, userId);
+                postNetRequest(request);
+                return;
+            }
+            
+            // Start enrollment process
+            currentEnrollmentId = availableId;
+            currentEnrollmentUserId = userId;
+            enrollFingerprint(currentEnrollmentId);
+            break;
+        }
+        
+        case FP_CMD_DELETE_USER:
+        case FP_CMD_DELETE_IDS:
+            deleteCommandPending = true;
+            deleteCommand = (FingerprintCommand)command.value;
+            deleteUserHasFingerprints = command.flag;
+            currentEnrollmentUserId = userId;
+            fingerprints_to_delete.assign(command.ids, command.ids + command.idCount);
+            break;
+        
+        case FP_CMD_RESET: {
+            // Empty the fingerprint database
+            uint8_t p = finger.emptyDatabase();
+            bool success = (p == FINGERPRINT_OK);
+            
+            if (success) {
+                Serial.println("✅ All fingerprints deleted successfully");
+            } else {
+                Serial.println("❌ Failed to delete all fingerprints");
+            }
+            
+            NetRequest request = {};
+            request.type = NET_FP_RESET_RESULT;
+            request.flag = success;
+            copyNetText(request.text, userId);
+            postNetRequest(request);
+            
+            // Set LED status
+            setLEDStatus(success ? STATUS_ONLINE : STATUS_ERROR);
+            break;
+        }
     }
+}
 
-    // Paths for Firebase updates
-    String mappingsPath = String(DEVICE_PATH) + deviceId + "/fingerprint";
-    String userPath = mappingsPath + "/" + currentEnrollmentUserId;
-    String logPath = String("devices/") + deviceId + "/logs";
+// Add a fingerprint ID to users/<uid>/registeredDevices/<id>/fingerprint. The
+// read and the write stay in one flow step, so no other flow writes in between.
+static void addUserFingerprint(const String& userId, int fingerprintId) {
+    char userDevicesPath[USER_PATH_LEN];
+    if (!formatUserDevicePath(userDevicesPath, sizeof(userDevicesPath), userId.c_str(), "fingerprint")) {
+        return;
+    }
+    
+    // Check if the user already has fingerprints registered and update
+    FirebaseJsonArray fingerprintArray;
+    readUserFingerprints(userDevicesPath, fingerprintArray);
     
+    // Add the new fingerprint ID to the array
+    fingerprintArray.add(fingerprintId);
+    Firebase.RTDB.setArray(&fbdo, userDevicesPath, &fingerprintArray);
+    RtdbCache::invalidate(userDevicesPath);
+}
+
+// Firebase side of a finished enrollment, one request per turn of the network task
+static RtdbFlow enrollmentResultFlow(String userId, int fingerprintId, bool success) {
     if (success) {
-        // Update the user's status to "registered"
-        Firebase.RTDB.setString(&fbdo, userPath.c_str(), "registered");
-        
-        // Store the fingerprint ID to user mapping for later reference
-        String idMappingPath = mappingsPath + "/ids/" + String(currentEnrollmentId);
-        Firebase.RTDB.setString(&fbdo, idMappingPath.c_str(), currentEnrollmentUserId);
+        // Mark the user "registered" and store the fingerprint ID to user mapping in one write
+        FingerprintPayload payload;
+        writeFingerprintPayload(payload, userId.c_str(), fingerprintId);
+        co_await flowCall([&] { return rtdbUpdate(devicePaths.fingerprint, payload); });
         
         // Add fingerprint ID to user's registeredDevices structure
-        String userDevicesPath = String(USERS_PATH) + currentEnrollmentUserId + "/registeredDevices/" + deviceId + "/fingerprint";
-        
-        // Check if the user already has fingerprints registered and update
-        FirebaseJsonArray fingerprintArray;
-        if (Firebase.RTDB.getArray(&fbdo, userDevicesPath.c_str())) {
-            fingerprintArray = fbdo.jsonArray();
-        }
-        
-        // Add the new fingerprint ID to the array
-        fingerprintArray.add(currentEnrollmentId);
-        Firebase.RTDB.setArray(&fbdo, userDevicesPath.c_str(), &fingerprintArray);
+        co_await flowCall([&] { addUserFingerprint(userId, fingerprintId); });
         
         Serial.print("✅ Added fingerprint ID ");
-        Serial.print(currentEnrollmentId);
+        Serial.print(fingerprintId);
         Serial.print(" to user's registered device ");
         Serial.println(deviceId);
         
         // Log successful enrollment
-        FirebaseJson logEntry;
-        logEntry.set("timestamp", isTimeSynchronized());
-        logEntry.set("event", "fingerprint_enrolled");
-        logEntry.set("userId", currentEnrollmentUserId);
-        logEntry.set("fingerprintId", currentEnrollmentId);
-        Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry);
+        EventRecord event = makeEvent(EVT_FP_ENROLLED);
+        SET_EVENT_TEXT(event.userId, userId);
+        event.fingerprintId = fingerprintId;
+        logEvent(event);
     } else {
         // Log failure
-        FirebaseJson logEntry;
-        logEntry.set("timestamp", isTimeSynchronized());
-        logEntry.set("event", "fingerprint_enrollment_failed");
-        logEntry.set("userId", currentEnrollmentUserId);
-        logEntry.set("reason", "enrollment_error");
-        Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry);
+        EventRecord event = makeEvent(EVT_FP_ENROLLMENT_FAILED);
+        SET_EVENT_TEXT(event.userId, userId);
+        SET_EVENT_TEXT(event.detail, fingerprintId < 0 ? "no_available_slots" : "enrollment_error");
+        logEvent(event);
         
         // Remove the pending enrollment request
-        Firebase.RTDB.deleteNode(&fbdo, userPath.c_str());
+        char userPath[CHILD_PATH_LEN];
+        if (formatChildPath(userPath, sizeof(userPath), devicePaths.fingerprint, userId.c_str())) {
+            co_await flowCall([&] { return Firebase.RTDB.deleteNode(&fbdo, userPath); });
+        }
     }
     
-    // Invalidate the cache since we made changes
-    firebaseCache.isValid = false;
+    // The enrollment request was cleared from the node; only now may the node
+    // be scanned for the next command
+    RtdbCache::invalidate(devicePaths.fingerprint);
+    fingerprintCommandInFlight = false;
+}
+
+// Update Firebase after enrollment completes (network task)
+// fingerprintId is -1 when the sensor had no free slot
+void updateFingerprintStatus(const String& userId, int fingerprintId, bool success) {
+    if (userId.isEmpty()) {
+        fingerprintCommandInFlight = false;
+        return;
+    }
+    if (!spawnFlow(enrollmentResultFlow(userId, fingerprintId, success), 0, "enrollment result")) {
+        fingerprintCommandInFlight = false;
+    }
 }
 
 // Process the enrollment state machine
@@ -588,8 +713,13 @@ void processEnrollment() {
         if (enrollmentState == ENROLL_IDLE && !currentEnrollmentUserId.isEmpty()) {
             fingerprintEnrollmentInProgress = false;
             
-            // Update Firebase with the enrollment result
-            updateFingerprintStatus(enrollmentResult);
+            // Let the network task update Firebase with the enrollment result
+            NetRequest request = {};
+            request.type = NET_FP_ENROLL_RESULT;
+            request.value = currentEnrollmentId;
+            request.flag = enrollmentResult;
+            copyNetText(request.text, currentEnrollmentUserId);
+            postNetRequest(request);
             
             // Reset enrollment state variables
             currentEnrollmentUserId = "";
@@ -605,10 +735,13 @@ void updateUserFingerprintArray(const String& userId, const std::vector<int>& de
         return;
     }
     
-    String userFingerprintPath = String(USERS_PATH) + userId + "/registeredDevices/" + deviceId + "/fingerprint";
+    char userFingerprintPath[USER_PATH_LEN];
+    if (!formatUserDevicePath(userFingerprintPath, sizeof(userFingerprintPath), userId.c_str(), "fingerprint")) {
+        return;
+    }
     
-    if (Firebase.RTDB.getArray(&fbdo, userFingerprintPath.c_str())) {
-        FirebaseJsonArray fingerprintArray = fbdo.jsonArray();
+    FirebaseJsonArray fingerprintArray;
+    if (readUserFingerprints(userFingerprintPath, fingerprintArray)) {
         FirebaseJsonArray newArray;
         size_t arraySize = fingerprintArray.size();
         
@@ -634,195 +767,144 @@ void updateUserFingerprintArray(const String& userId, const std::vector<int>& de
         
         // Update the array in Firebase
         if (newArray.size() > 0) {
-            Firebase.RTDB.setArray(&fbdo, userFingerprintPath.c_str(), &newArray);
+            Firebase.RTDB.setArray(&fbdo, userFingerprintPath, &newArray);
         } else {
             // If array is empty, remove it completely
-            Firebase.RTDB.deleteNode(&fbdo, userFingerprintPath.c_str());
+            Firebase.RTDB.deleteNode(&fbdo, userFingerprintPath);
         }
+        RtdbCache::invalidate(userFingerprintPath);
     }
 }
 
 // Log fingerprint deletion events to Firebase
-void logDeletionEvent(const String& eventType, const String& userId, int count, int successCount, int specificId){
-    if (!isFirebaseReady()) {
-        return;
-    }
-    
-    FirebaseJson logEntry;
-    logEntry.set("timestamp", isTimeSynchronized());
-    logEntry.set("event", eventType);
-    
-    if (!userId.isEmpty()) {
-        logEntry.set("userId", userId);
-    }
+void logDeletionEvent(EventType eventType, const String& userId, int count, int successCount) {
+    EventRecord event = makeEvent(eventType);
+    SET_EVENT_TEXT(event.userId, userId);
     
     if (count > 0) {
-        logEntry.set("total", count);
+        event.total = count;
     }
     
     if (successCount > 0) {
-        logEntry.set("success", successCount);
-    }
-    
-    if (specificId >= 0) {
-        logEntry.set("fingerprintId", specificId);
+        event.success = successCount;
     }
     
-    String logPath = String("devices/") + deviceId + "/logs";
-    Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry);
+    logEvent(event);
 }
 
-// Process pending delete commands
-void processDeleteCommands() {
-    if (!deleteCommandPending || enrollmentState != ENROLL_IDLE) {
-        return;
-    }
-    
-    String userId = currentEnrollmentUserId;
+// Firebase side of a finished delete command
+static RtdbFlow deletionResultFlow(NetRequest request) {
+    String userId = String(request.text);
     
-    // Delete all fingerprints for a specific user
-    if (fingerprintToDelete == -1) {
-        if (userId.isEmpty()) {
-            Serial.println(F("❌ No user ID specified for fingerprint deletion"));
-            deleteCommandPending = false;
-            return;
-        }
-        
-        Serial.print(F("⚠️ Executing command: Delete all fingerprints for user "));
-        Serial.println(userId);
-        
-        // Get the user's fingerprint array
-        String userFingerprintPath = String(USERS_PATH) + userId + "/registeredDevices/" + deviceId + "/fingerprint";
-        
-        if (Firebase.RTDB.getArray(&fbdo, userFingerprintPath.c_str())) {
-            FirebaseJsonArray fingerprintArray = fbdo.jsonArray();
-            size_t arraySize = fingerprintArray.size();
-            bool allSuccess = true;
-            int successCount = 0;
-            std::vector<int> deletedIds;
-            
-            Serial.print(F("Found "));
-            Serial.print(arraySize);
-            Serial.println(F(" fingerprints to delete"));
-            
-            // Delete each fingerprint in the array
-            for (size_t i = 0; i < arraySize; i++) {
-                FirebaseJsonData result;
-                fingerprintArray.get(result, i);
-                int fpId = result.intValue;
-                
-                Serial.print(F("Deleting fingerprint ID #"));
-                Serial.println(fpId);
-                
-                uint8_t p = finger.deleteModel(fpId);
-                if (p == FINGERPRINT_OK) {
-                    Serial.print(F("✅ Deleted fingerprint ID #"));
-                    Serial.println(fpId);
-                    successCount++;
-                    deletedIds.push_back(fpId);
-                } else {
-                    Serial.print(F("❌ Failed to delete fingerprint ID #"));
-                    Serial.println(fpId);
-                    allSuccess = false;
-                }
-            }
-            
+    if (request.value == FP_CMD_DELETE_USER) {
+        if (request.flag) {
             // Remove the fingerprint array from the user's registered devices
-            Firebase.RTDB.deleteNode(&fbdo, userFingerprintPath.c_str());
+            char userFingerprintPath[USER_PATH_LEN];
+            if (formatUserDevicePath(userFingerprintPath, sizeof(userFingerprintPath), userId.c_str(), "fingerprint")) {
+                co_await flowCall([&] { return Firebase.RTDB.deleteNode(&fbdo, userFingerprintPath); });
+                RtdbCache::invalidate(userFingerprintPath);
+            }
             
             // Log the event
             logDeletionEvent(
-                allSuccess ? "user_fingerprints_deleted" : "user_fingerprints_delete_partial", 
+                request.successCount == request.count ? EVT_FP_USER_DELETED : EVT_FP_USER_DELETE_PARTIAL, 
                 userId, 
-                arraySize, 
-                successCount
+                request.count, 
+                request.successCount
             );
-            
-            setLEDStatus(allSuccess ? STATUS_ONLINE : STATUS_ERROR);
         } else {
-            Serial.println(F("⚠️ No fingerprints found for this user"));
-            logDeletionEvent("fingerprint_delete_no_fingerprints", userId);
-        }
-    } 
-    // Delete specific fingerprint IDs (multiple)
-    else if (fingerprintToDelete == -2 || !fingerprints_to_delete.empty()) {
-        int deleteCount = fingerprints_to_delete.size();
-        int successCount = 0;
-        std::vector<int> deletedIds;
-        
-        Serial.print(F("⚠️ Executing command: Delete multiple fingerprint IDs ("));
-        Serial.print(deleteCount);
-        Serial.println(F(" IDs)"));
-        
-        // Process each ID in the vector
-        for (int id : fingerprints_to_delete) {
-            Serial.print(F("Attempting to delete fingerprint ID #"));
-            Serial.println(id);
-            
-            uint8_t p = finger.deleteModel(id);
-            if (p == FINGERPRINT_OK) {
-                Serial.print(F("✅ Deleted fingerprint ID #"));
-                Serial.println(id);
-                successCount++;
-                deletedIds.push_back(id);
-            } else {
-                Serial.print(F("❌ Failed to delete fingerprint ID #"));
-                Serial.println(id);
-            }
+            logDeletionEvent(EVT_FP_DELETE_NO_FINGERPRINTS, userId);
         }
-        
+    } else {
         // Update the user's fingerprint array if we have a userId
         if (!userId.isEmpty()) {
-            updateUserFingerprintArray(userId, deletedIds);
+            std::vector<int> deletedIds(request.ids, request.ids + request.idCount);
+            co_await flowCall([&] { updateUserFingerprintArray(userId, deletedIds); });
             Serial.println(F("✅ Updated user's fingerprint array"));
         }
         
         // Log the event
-        logDeletionEvent("multiple_fingerprints_deleted", userId, deleteCount, successCount);
-        
-        setLEDStatus(successCount == deleteCount ? STATUS_ONLINE : STATUS_ERROR);
-    } 
-    // Delete specific fingerprint ID (legacy single ID method)
-    else {
-        int specificId = fingerprintToDelete;
+        logDeletionEvent(EVT_FP_MULTIPLE_DELETED, userId, request.count, request.successCount);
+    }
+    fingerprintCommandInFlight = false;
+}
+
+// Record a finished delete command in Firebase (network task)
+void syncFingerprintDeletion(const NetRequest& request) {
+    if (!spawnFlow(deletionResultFlow(request), 0, "deletion result")) {
+        fingerprintCommandInFlight = false;
+    }
+}
+
+// Record a sensor reset in Firebase (network task)
+void logFingerprintReset(const String& userId, bool success) {
+    fingerprintCommandInFlight = false;
+    
+    EventRecord event = makeEvent(EVT_FP_ALL_DELETED);
+    SET_EVENT_TEXT(event.userId, userId);
+    event.flag = success ? 1 : 0;
+    logEvent(event);
+}
+
+// Process pending delete commands (core 1)
+void processDeleteCommands() {
+    if (!deleteCommandPending || enrollmentState != ENROLL_IDLE) {
+        return;
+    }
+    
+    NetRequest request = {};
+    request.type = NET_FP_DELETE_RESULT;
+    request.value = deleteCommand;
+    request.flag = deleteUserHasFingerprints;
+    request.count = fingerprints_to_delete.size();
+    copyNetText(request.text, currentEnrollmentUserId);
+    
+    if (deleteCommand == FP_CMD_DELETE_USER) {
+        Serial.print(F("⚠️ Executing command: Delete all fingerprints for user "));
+        Serial.println(currentEnrollmentUserId);
         
-        Serial.print(F("⚠️ Executing command: Delete fingerprint ID #"));
-        Serial.println(specificId);
+        if (deleteUserHasFingerprints) {
+            Serial.print(F("Found "));
+            Serial.print(request.count);
+            Serial.println(F(" fingerprints to delete"));
+        } else {
+            Serial.println(F("⚠️ No fingerprints found for this user"));
+        }
+    } else {
+        Serial.print(F("⚠️ Executing command: Delete multiple fingerprint IDs ("));
+        Serial.print(request.count);
+        Serial.println(F(" IDs)"));
+    }
+    
+    // Process each ID in the vector
+    for (int id : fingerprints_to_delete) {
+        Serial.print(F("Attempting to delete fingerprint ID #"));
+        Serial.println(id);
         
-        uint8_t p = finger.deleteModel(specificId);
+        uint8_t p = finger.deleteModel(id);
         if (p == FINGERPRINT_OK) {
             Serial.print(F("✅ Deleted fingerprint ID #"));
-            Serial.println(specificId);
-            
-            // Update the user's fingerprint array
-            if (!userId.isEmpty()) {
-                std::vector<int> deletedIds = {specificId};
-                updateUserFingerprintArray(userId, deletedIds);
-                Serial.println(F("✅ Updated user's fingerprint array"));
-            }
-            
-            // Log the event
-            logDeletionEvent("fingerprint_deleted", userId, 0, 0, specificId);
-            
-            setLEDStatus(STATUS_ONLINE);
+            Serial.println(id);
+            request.ids[request.idCount++] = id;
+            request.successCount++;
         } else {
             Serial.print(F("❌ Failed to delete fingerprint ID #"));
-            Serial.println(specificId);
-            setLEDStatus(STATUS_ERROR);
-            
-            // Log the failure
-            logDeletionEvent("fingerprint_delete_failed", userId, 0, 0, specificId);
+            Serial.println(id);
         }
     }
     
+    if (deleteCommand == FP_CMD_DELETE_IDS || deleteUserHasFingerprints) {
+        setLEDStatus(request.successCount == request.count ? STATUS_ONLINE : STATUS_ERROR);
+    }
+    
+    // Firebase bookkeeping happens on the network task
+    postNetRequest(request);
+    
     // Reset command flags
     deleteCommandPending = false;
-    fingerprintToDelete = -1;
+    deleteUserHasFingerprints = false;
     fingerprints_to_delete.clear();
     currentEnrollmentUserId = "";
-    
-    // Invalidate the cache since we made changes
-    firebaseCache.isValid = false;
 }
 
 void waitForFingerRemoval(unsigned long timeoutMillis) {
@@ -870,18 +952,16 @@ void handleFingerprint() {
             sendCommandToNano("UNLOCK");
             // Set the LED to success
             setLEDStatus(STATUS_UNLOCKED);
+            queueAuthenticationLog(true, finger.fingerID);
             delay(3000);
             setLEDStatus(isOnline ? STATUS_ONLINE : STATUS_OFFLINE);
         }
     }
     if (isOnline) {
-        // Only check Firebase commands if we're online
-        checkForCommands();
-        
         // Process enrollment if in progress
         processEnrollment();
         
         // Process delete commands if pending
         processDeleteCommands();
     }
-}
\ No newline at end of file
+}
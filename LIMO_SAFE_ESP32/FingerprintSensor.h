@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include <Adafruit_Fingerprint.h>
+#include <Firebase_ESP_Client.h>
+#include "NetworkTask.h"
+#include "EventLogger.h"
 
 enum FingerprintState {
     FP_IDLE,          // Waiting for finger
@@ -34,8 +37,17 @@ void waitForFingerRemoval(unsigned long timeoutMillis = 3000);
 int findNextAvailableId();
 void handleFingerprint();
 void updateUserFingerprintArray(const String& userId, const std::vector<int>& deletedIds);
-void logDeletionEvent(const String& eventType, const String& userId, int count = 0, int successCount = 0, int specificId = -1);
-void updateFingerprintStatus(bool success);
+void logDeletionEvent(EventType eventType, const String& userId, int count = 0, int successCount = 0);
+void onFingerprintStreamEvent(FirebaseData& stream);
+
+// Network task side: Firebase reads/writes for fingerprint commands
+void logAuthenticationEvent(bool success, int fingerprintId);
+void updateFingerprintStatus(const String& userId, int fingerprintId, bool success);
+void syncFingerprintDeletion(const NetRequest& request);
+void logFingerprintReset(const String& userId, bool success);
+
+// Core 1 side: sensor work for a command found by checkForCommands()
+void onFingerprintCommand(const NetResult& command);
 
 
 extern unsigned long lastFingerprintCheck;
@@ -5,8 +5,26 @@
 #include "NanoCommunicator.h"
 #include "RGBLed.h"
 #include "WiFiSetup.h"
+#include "DeviceStreams.h"
+#include "NetworkTask.h"
+#include "ConnectionHealth.h"
+#include "AuthorizedUsers.h"
+#include "EventLogger.h"
+#include "ReconnectLadder.h"
+#include "DevicePayloads.h"
+#include "RtdbRest.h"
+#include "DevicePaths.h"
+#include "ConditionalRead.h"
+#include "RtdbCache.h"
+#include "JsonScanner.h"
+#include "RegistrationQueue.h"
+#include "RequestDeadline.h"
+#include "RtdbFlow.h"
+#include "DeviceTransport.h"
 #include <Preferences.h>
 
+#define FIREBASE_MIN_TIMEOUT_MS 1000UL  // The library's floor for both timeouts
+
 // Firebase objects
 FirebaseData fbdo;
 FirebaseAuth auth;
@@ -39,11 +57,9 @@ bool checkFirebaseConnection() {
     static bool wasFirebaseConnected = false;
     static int firebaseFailedAttempts = 0;
     const int maxFirebaseReconnectInterval = 60000; // Max 1 minute between attempts
-    const int maxFirebaseFailedAttempts = 3; // Max failures before WiFi reset
     
     // Variables for current state
     bool wifiConnected = WiFi.isConnected();
-    bool firebaseResponsive = false;
     unsigned long currentMillis = millis();
 
     // Step 1: Check if WiFi is connected
@@ -56,79 +72,44 @@ bool checkFirebaseConnection() {
         return false;
     }
 
-    // Step 2: Use DNS ping to check internet connectivity
-    IPAddress ip;
-    bool internetAvailable = (WiFi.hostByName("8.8.8.8", ip) == 1);
-    
-    if (!internetAvailable) {
-        if (wasFirebaseConnected) {
-            Serial.println("❌ Internet not available, Firebase cannot connect");
-            setLEDStatus(STATUS_OFFLINE);
-            wasFirebaseConnected = false;
+    // Step 2: Real requests report their outcomes; probe only when they are silent or failing
+    if (Firebase.ready() && connectionProbeDue()) {
+        if (!probeFirebaseConnection()) {
+            Serial.println("❌ Firebase probe failed");
         }
-        return false;
     }
 
-    // Step 3: Verify Firebase connection if internet is available
-    if (Firebase.ready()) {
-        // Only do the ping test if we have internet
-        if (Firebase.RTDB.getInt(&fbdo, "/status/pingTest")) {
-            firebaseResponsive = true;
-            firebaseFailedAttempts = 0; // Reset failed attempts counter on success
-        } else {
-            firebaseResponsive = false;
-            Serial.println("❌ Firebase ping test failed");
-        }
-    } else {
-        firebaseResponsive = false;
-    }
+    bool firebaseResponsive = Firebase.ready() && isConnectionHealthy();
 
     // Handle connection state changes
-    bool currentlyConnected = wifiConnected && internetAvailable && firebaseResponsive;
+    bool currentlyConnected = wifiConnected && firebaseResponsive;
     if (currentlyConnected != wasFirebaseConnected) {
         if (currentlyConnected) {
             Serial.println("✅ Firebase connected");
             firebaseReconnectInterval = 2000; // Reset reconnect interval on success
             firebaseFailedAttempts = 0; // Reset failure count
+            resetReconnectLadder();
             updateDeviceStatus(true, false, false);
         } else {
             Serial.println("❌ Firebase disconnected");
             setLEDStatus(STATUS_OFFLINE);
             // Print more detailed diagnostics
-            if (!internetAvailable) {
-                Serial.println("   - Internet not available despite WiFi connection");
-            } else if (!firebaseResponsive) {
-                Serial.println("   - Firebase not responsive");
-            }
+            const ConnectionStats& health = getConnectionStats();
+            Serial.print("   - Consecutive request failures: ");
+            Serial.print(health.consecutiveFailures);
+            Serial.print(", last HTTP code: ");
+            Serial.println(health.lastHttpCode);
         }
         wasFirebaseConnected = currentlyConnected;
     }
 
     // Attempt reconnection if needed with exponential backoff
     if (!currentlyConnected && (currentMillis - lastFirebaseReconnectAttempt > firebaseReconnectInterval)) {
-        Serial.println("🔄 Attempting Firebase reconnection...");
         lastFirebaseReconnectAttempt = currentMillis;
         
-        // Full reconnection sequence
-        bool reconnectSuccess = false;
-        
-        // Step 1: Reset Firebase configuration
-        Firebase.reset(&config);
-        
-        // Step 2: Re-initialize Firebase with the current config
-        // FIXED: Removed config.cert.verify = false line as it's not a valid property
-        Firebase.begin(&config, &auth);
-        Firebase.reconnectWiFi(true);
-        
-        // Step 3: Reset buffer sizes which can help with connection issues
-        //fbdo.setBSSLBufferSize(4096, 2048); // Use larger buffers for reconnection
-        // REMOVED: setSecure() call as it's a private method in the FirebaseData class
-        
-        // Step 4: Verify the reconnection worked
-        delay(500); // Brief pause to allow connection to establish
-        if (Firebase.ready() && Firebase.RTDB.getInt(&fbdo, "/status/pingTest")) {
-            Serial.println("✅ Firebase reconnected successfully");
-            reconnectSuccess = true;
+        // Cheapest step first; a full client reset only when the lighter ones failed
+        if (attemptFirebaseReconnect()) {
+            currentlyConnected = true;
             firebaseReconnectInterval = 2000; // Reset backoff timer
             firebaseFailedAttempts = 0; // Reset failure count
             wasFirebaseConnected = true;
@@ -138,61 +119,36 @@ bool checkFirebaseConnection() {
             // Increment failed attempts counter
             firebaseFailedAttempts++;
             
-            // Implement exponential backoff with jitter
-            firebaseReconnectInterval = min(
-                (int)(firebaseReconnectInterval * 1.5 + random(500)), 
-                maxFirebaseReconnectInterval
-            );
+            // The first rungs are cheap, so retry them quickly; back off once they are exhausted
+            if (currentReconnectTier() <= RECONNECT_WIFI) {
+                firebaseReconnectInterval = 1000;
+            } else {
+                // Implement exponential backoff with jitter
+                firebaseReconnectInterval = min(
+                    (int)(firebaseReconnectInterval * 1.5 + random(500)), 
+                    maxFirebaseReconnectInterval
+                );
+            }
             
             Serial.print("❌ Firebase reconnection failed. Attempt #");
             Serial.print(firebaseFailedAttempts);
-            Serial.print(" of ");
-            Serial.print(maxFirebaseFailedAttempts);
-            Serial.print(". Next attempt in ");
-            Serial.print(firebaseReconnectInterval / 1000);
-            Serial.println(" seconds");
-            
-            // If we've failed too many times in a row, try resetting WiFi connection
-            if (firebaseFailedAttempts >= maxFirebaseFailedAttempts) {
-                Serial.println("⚠️ Too many Firebase failures. Attempting WiFi reset...");
-                firebaseFailedAttempts = 0; // Reset counter
-                
-                // Try to use default credentials as a fallback
-                String savedSSID, savedPass;
-                int failedAttempts = 0;
-                
-                // Load current WiFi credentials
-                Preferences wifiPrefs;
-                if (wifiPrefs.begin("wifi", false)) {
-                    savedSSID = wifiPrefs.getString("ssid", "");
-                    savedPass = wifiPrefs.getString("pass", "");
-                    wifiPrefs.end();
-                }
-                
-                // Check if we're already using default credentials
-                if (savedSSID == WIFI_SSID && savedPass == WIFI_PASSWORD) {
-                    Serial.println("Already using default credentials, trying full network reset");
-                    WiFi.disconnect(true);
-                    delay(1000);
-                    WiFi.reconnect();
-                } else {
-                    // Fall back to default credentials
-                    Serial.println("Attempting to connect with default credentials");
-                    updateWiFiCredentials(WIFI_SSID, WIFI_PASSWORD);
-                }
-                
-                // Reset Firebase reconnect interval
-                firebaseReconnectInterval = 5000; // A bit longer for WiFi to stabilize
-            }
+            Serial.print(". Next attempt in ms: ");
+            Serial.println(firebaseReconnectInterval);
         }
     }
 
     return currentlyConnected;
 }
 
+// The library reads these before every request; RtdbRest has its own
+void applyFirebaseTimeouts() {
+    uint32_t connect = connectTimeoutMs();
+    uint32_t response = requestTimeoutMs();
+    config.timeout.socketConnection = connect < FIREBASE_MIN_TIMEOUT_MS ? FIREBASE_MIN_TIMEOUT_MS : connect;
+    config.timeout.serverResponse = response < FIREBASE_MIN_TIMEOUT_MS ? FIREBASE_MIN_TIMEOUT_MS : response;
+}
+
 bool setupFirebase() {
-    // Enhanced timeout and connection settings
-    config.timeout.serverResponse = 30000; // 30 seconds
     Serial.println("🔥 Setting up Firebase...");
 
     // Get device ID from preferences or generate from MAC
@@ -215,6 +171,11 @@ bool setupFirebase() {
     }
     preferences.end();
 
+    // Every device-scoped path is formatted once, here
+    if (!buildDevicePaths(deviceId.c_str())) {
+        return false;
+    }
+
     // Validate Firebase configuration
     if (strlen(FIREBASE_HOST) == 0 || strlen(FIREBASE_AUTH) == 0) {
         Serial.println("❌ Firebase host or auth token not configured!");
@@ -225,43 +186,41 @@ bool setupFirebase() {
     config.database_url = FIREBASE_HOST;
     config.signer.tokens.legacy_token = FIREBASE_AUTH;
 
-    // Increase timeout and connection settings
-    config.timeout.socketConnection = 10 * 1000;  // 10 seconds socket connection timeout
-    config.timeout.serverResponse = 10 * 1000;    // 10 seconds server response timeout
+    // Connect and response timeouts come from the RTT estimate
+    applyFirebaseTimeouts();
     config.timeout.rtdbKeepAlive = 45 * 1000;     // 45 seconds keep-alive
 
-    // Initialize Firebase connection with retries
-    int initAttempts = 5;
-    unsigned long startAttemptTime = millis();
-    const unsigned long MAX_ATTEMPT_TIME = 60000;  // 1 minute total attempt time
+    // Initialize the client once; the first request does the TLS handshake and
+    // later requests reuse that keep-alive connection
+    Firebase.begin(&config, &auth);
+    Firebase.reconnectWiFi(true);
 
-    while (initAttempts > 0 && (millis() - startAttemptTime < MAX_ATTEMPT_TIME)) {
-        Firebase.reset(&config);
-        Firebase.begin(&config, &auth);
-        Firebase.reconnectWiFi(true);
+    // Apply SSL Fix for Firebase Connectivity
+    fbdo.setBSSLBufferSize(4096, 2048); // Increase SSL buffer size
+    fbdo.keepAlive(5, 5, 1);            // TCP keep-alive so idle sockets survive between requests
 
-        // Apply SSL Fix for Firebase Connectivity
-        fbdo.setBSSLBufferSize(4096, 2048); // Increase SSL buffer size
+    // Set Firebase read timeout and write limit
+    Firebase.RTDB.setReadTimeout(&fbdo, RTT_MAX_RTO_MS);  // Server-side limit, no longer than we wait
+    Firebase.RTDB.setwriteSizeLimit(&fbdo, "small"); // Use correct function name
 
-        // Set Firebase read timeout and write limit
-        Firebase.RTDB.setReadTimeout(&fbdo, 1000 * 60);  // 1-minute read timeout
-        Firebase.RTDB.setwriteSizeLimit(&fbdo, "small"); // Use correct function name
+    // Wait for the token, climbing the reconnect ladder instead of resetting every time
+    unsigned long startAttemptTime = millis();
+    unsigned long lastAttemptTime = startAttemptTime;
+    const unsigned long MAX_ATTEMPT_TIME = 60000;  // 1 minute total attempt time
+    const unsigned long ATTEMPT_INTERVAL = 2000;
 
-        // Check connection status with more detailed logging
-        if (isFirebaseReady()) {
-            Serial.println("✅ Firebase Connected Successfully!");
-            break;
+    while (!isFirebaseReady() && millis() - startAttemptTime < MAX_ATTEMPT_TIME) {
+        if (millis() - lastAttemptTime >= ATTEMPT_INTERVAL) {
+            lastAttemptTime = millis();
+            if (attemptFirebaseReconnect()) {
+                break;
+            }
         }
+        delay(100);
+    }
 
-        // Detailed error logging
-        Serial.print("🚫 Firebase Connection Error: ");
-        //Serial.println(fbdo.errorReason().c_str());
-
-        Serial.print("🔄 Firebase initialization attempt failed. Retries left: ");
-        Serial.println(initAttempts - 1);
-
-        initAttempts--;
-        delay(5000);  // Increased delay between attempts
+    if (isFirebaseReady()) {
+        Serial.println("✅ Firebase Connected Successfully!");
     }
 
     if (!isFirebaseReady()) {
@@ -273,56 +232,21 @@ bool setupFirebase() {
         return false;
     }
 
-    // Initialize device data in Firebase
-    String path = String(DEVICE_PATH) + deviceId;
-    FirebaseJson json;
-
-    // First try to get existing data
-    bool existingData = Firebase.RTDB.getJSON(&fbdo, path.c_str());
-    if (existingData) {
-        // If we got existing data, parse it
-        json = fbdo.jsonObject();
-        Serial.println("✅ Retrieved existing device data");
-    }
-
-    // Always ensure these basic fields exist
-    json.set("id", deviceId);
-    json.set("status/online", true);
-
-    // Initialize WiFi node if it doesn't exist
-    FirebaseJsonData result;
-    if (!json.get(result, "wifi")) {
-        FirebaseJson wifiJson;
-        wifiJson.set("connected", false);
-        json.set("wifi", wifiJson);
-    }
-
-    // Use updateNode instead of setJSON to preserve existing data
-    if (Firebase.RTDB.updateNode(&fbdo, path.c_str(), &json)) {
-        Serial.println("✅ Device data initialized in Firebase");
-    } else {
+    // One multi-path PATCH of the fields this device owns. Nothing under
+    // devices/<id> is read first: the write creates whatever is missing and
+    // leaves the rest (logs included) alone, so boot costs the same however
+    // much history the device has, and a retried setup writes the same values.
+    BootPayload payload;
+    writeBootPayload(payload, deviceId.c_str(), isTimeSynchronized());
+    if (!rtdbUpdate(devicePaths.root, payload)) {
         Serial.println("❌ Failed to initialize device data");
         return false;
     }
 
-    // Update device status
-    if (updateDeviceStatus(true, false, false)) {
-
-    // Now that we're connected, update WiFi status to "true"
-    String wifiPath = path + WIFI_NODE + "/connected";
-    Firebase.RTDB.setBool(&fbdo, wifiPath.c_str(), true);
+    Serial.println("✅ Device data initialized in Firebase");
     Serial.println("✅ WiFi connection status updated to 'connected'");
-    
-    // Also update online status to true
-    String onlinePath = path + "/status/online";
-    Firebase.RTDB.setBool(&fbdo, onlinePath.c_str(), true);
     Serial.println("✅ Online status updated to 'true'");
-
     return true;
-    } else {
-        Serial.println("❌ Failed to update device status");
-        return false;
-    }
 }
 
 bool updateDeviceStatus(bool isOnline, bool isLocked, bool isSecure) {
@@ -331,15 +255,18 @@ bool updateDeviceStatus(bool isOnline, bool isLocked, bool isSecure) {
         return false; 
     }
 
-    String path = String(DEVICE_PATH) + deviceId;  // Firebase path for device status
-    
-    FirebaseJson json;
-    json.set("status/online", isOnline);  // ✅ Update 'online' status
-    json.set("status/locked", isLocked);  // ✅ Update 'locked' status
-    json.set("status/secure", isSecure);  // ✅ Update 'secure' status
-    json.set("status/timestamp", isTimeSynchronized());
-
-    if (!Firebase.RTDB.updateNode(&fbdo, path.c_str(), &json)) {
+    DeviceTransport& transport = uploadTransport();
+    bool ok;
+    if (transport.carriesCbor()) {
+        StatusCbor payload;
+        writeStatusCbor(payload, isOnline, isLocked, isSecure, isTimeSynchronized());
+        ok = transport.updateCbor(devicePaths.status, payload, TRANSPORT_LATEST);
+    } else {
+        StatusPayload payload;
+        writeStatusPayload(payload, isOnline, isLocked, isSecure, isTimeSynchronized());
+        ok = transport.update(devicePaths.status, payload, TRANSPORT_LATEST);
+    }
+    if (!ok) {
         //Serial.print("❌ Failed to update device status: ");
         //Serial.println(fbdo.errorReason());
         return false;
@@ -361,14 +288,12 @@ bool updateWiFiCredentialsInFirebase(const String& ssid, const String& password)
         return false;
     }
 
-    String path = String(DEVICE_PATH) + deviceId + WIFI_NODE;
-    
     FirebaseJson wifiJson;
     wifiJson.set("ssid", ssid);
     wifiJson.set("password", password);
     wifiJson.set("lastUpdated", millis());
 
-    if (!Firebase.RTDB.updateNode(&fbdo, path.c_str(), &wifiJson)) {
+    if (!Firebase.RTDB.updateNode(&fbdo, devicePaths.wifi, &wifiJson)) {
         Serial.print("❌ Failed to update WiFi credentials: ");
         //Serial.println(fbdo.errorReason());
         return false;
@@ -379,145 +304,152 @@ bool updateWiFiCredentialsInFirebase(const String& ssid, const String& password)
 }
 
 unsigned long lastWiFiCheckTime = 0;
-const unsigned long WIFI_CHECK_INTERVAL = 30000; // Check every 30 seconds
+const unsigned long WIFI_CHECK_INTERVAL = 30000; // Poll every 30 seconds while the stream is down
 
-// Enum for WiFi check state machine
-enum WiFiCheckState {
-    CHECK_IDLE,
-    CHECK_FETCH_CREDENTIALS,
-    CHECK_COMPARE_CREDENTIALS,
-    CHECK_UPDATE_CREDENTIALS,
-    CHECK_RECONNECT
-};
+const unsigned long WIFI_CHECK_DEADLINE = 5000; // Whole check, fetch to reconnect
 
-WiFiCheckState wifiCheckState = CHECK_IDLE;
-String newSSID, newPassword;
-unsigned long stateEntryTime = 0;
+bool wifiCheckRunning = false;
+ConditionalNode wifiNode; // Polled wifi node; forgotten when credentials could not be applied
 
-bool checkPeriodicWiFiCredentials() {
-    // Time-based check to start the state machine
-    if (wifiCheckState == CHECK_IDLE) {
-        if (millis() - lastWiFiCheckTime >= WIFI_CHECK_INTERVAL) {
-            lastWiFiCheckTime = millis();
-            wifiCheckState = CHECK_FETCH_CREDENTIALS;
-            stateEntryTime = millis();
-            return false; // No action yet, just started the state machine
+// Latest credentials delivered by the wifi stream
+String streamedSSID, streamedPassword;
+bool streamedCredentialsPending = false;
+
+// Track ssid/password from stream events; other children (e.g. "connected") are ignored
+void onWiFiStreamEvent(FirebaseData& stream) {
+    String path = stream.dataPath();
+    String type = stream.dataType();
+    bool changed = false;
+    
+    if (path == "/" && type == "json") {
+        FirebaseJson& json = stream.jsonObject();
+        FirebaseJsonData data;
+        if (json.get(data, "ssid") && data.type == "string" && data.stringValue != streamedSSID) {
+            streamedSSID = data.stringValue;
+            changed = true;
         }
-        return false; // Nothing to do
+        if (json.get(data, "password") && data.type == "string" && data.stringValue != streamedPassword) {
+            streamedPassword = data.stringValue;
+            changed = true;
+        }
+    } else if (path == "/ssid" && type == "string" && stream.stringData() != streamedSSID) {
+        streamedSSID = stream.stringData();
+        changed = true;
+    } else if (path == "/password" && type == "string" && stream.stringData() != streamedPassword) {
+        streamedPassword = stream.stringData();
+        changed = true;
     }
     
-    // Timeout protection - reset state machine if stuck in any state too long
-    if (millis() - stateEntryTime > 5000) { // 5 second timeout
-        Serial.println("⚠️ WiFi check timeout, resetting state");
-        wifiCheckState = CHECK_IDLE;
-        return false;
+    if (changed) {
+        streamedCredentialsPending = true;
     }
-    
-    // State machine implementation
-    if (wifiCheckState == CHECK_FETCH_CREDENTIALS) {
-        // Non-blocking Firebase check
-        if (!isFirebaseReady()) {
-            wifiCheckState = CHECK_IDLE; // Reset on error
-            return false;
-        }
-        
-        String path = String(DEVICE_PATH) + deviceId + WIFI_NODE;
-        
-        // This is potentially blocking but hard to make non-blocking with Firebase API
-        if (!Firebase.RTDB.getJSON(&fbdo, path.c_str())) {
-            wifiCheckState = CHECK_IDLE; // Reset on error
-            return false;
-        }
-        
-        // Process Firebase response
-        FirebaseJson* json = fbdo.jsonObjectPtr();
-        if (json == nullptr) {
-            wifiCheckState = CHECK_IDLE;
-            return false;
+}
+
+// Fetch the wifi node when no credentials came with the trigger, then compare,
+// mirror, store and reconnect. Runs as an RtdbFlow, so the fetch and the write
+// each take one turn of the network task.
+static RtdbFlow wifiCredentialFlow(String newSSID, String newPassword) {
+    if (newSSID.isEmpty()) {
+        // Conditional read: an unchanged node was already compared last time
+        ConditionalReadResult read = co_await flowCall([] {
+            return isFirebaseReady() ? wifiNode.read(devicePaths.wifi) : READ_FAILED;
+        });
+        if (read != READ_CHANGED) {
+            wifiCheckRunning = false; // Error or nothing new
+            co_return;
         }
         
         // Extract credentials
         FirebaseJsonData ssidData, passwordData;
-        json->get(ssidData, "ssid");
-        json->get(passwordData, "password");
-        
-        if (ssidData.success && passwordData.success && 
-            ssidData.type == "string" && passwordData.type == "string") {
-            newSSID = ssidData.stringValue;
-            newPassword = passwordData.stringValue;
-            
-            if (newSSID.length() > 0 && newPassword.length() > 0) {
-                wifiCheckState = CHECK_COMPARE_CREDENTIALS;
-                stateEntryTime = millis();
-            } else {
-                wifiCheckState = CHECK_IDLE; // No credentials available
-            }
-        } else {
-            wifiCheckState = CHECK_IDLE; // Reset on error
+        wifiNode.json().get(ssidData, "ssid");
+        wifiNode.json().get(passwordData, "password");
+        if (!ssidData.success || !passwordData.success ||
+            ssidData.type != "string" || passwordData.type != "string") {
+            wifiCheckRunning = false;
+            co_return;
         }
-        return false;
+        newSSID = ssidData.stringValue;
+        newPassword = passwordData.stringValue;
+    }
+    if (newSSID.isEmpty() || newPassword.isEmpty()) {
+        wifiCheckRunning = false; // No credentials available
+        co_return;
     }
     
-    else if (wifiCheckState == CHECK_COMPARE_CREDENTIALS) {
-        // Compare with stored credentials - minimal blocking operation
-        Preferences wifiPrefs;
-        wifiPrefs.begin("wifi", false);
-        String currentSSID = wifiPrefs.getString("ssid", "");
-        String currentPass = wifiPrefs.getString("pass", "");
-        wifiPrefs.end();
-        
-        if (currentSSID != newSSID || currentPass != newPassword) {
-            // Different credentials, proceed with update
-            Serial.println("📡 New WiFi credentials detected");
-            wifiCheckState = CHECK_UPDATE_CREDENTIALS;
-            stateEntryTime = millis();
-        } else {
-            // Same credentials, nothing to do
-            wifiCheckState = CHECK_IDLE;
-        }
-        return false;
+    // Compare with stored credentials
+    Preferences wifiPrefs;
+    wifiPrefs.begin("wifi", false);
+    String currentSSID = wifiPrefs.getString("ssid", "");
+    String currentPass = wifiPrefs.getString("pass", "");
+    wifiPrefs.end();
+    if (currentSSID == newSSID && currentPass == newPassword) {
+        wifiCheckRunning = false; // Same credentials, nothing to do
+        co_return;
+    }
+    Serial.println("📡 New WiFi credentials detected");
+    
+    // Update Firebase with new credentials
+    bool mirrored = co_await flowCall([&] { return updateWiFiCredentialsInFirebase(newSSID, newPassword); });
+    if (!mirrored) {
+        Serial.println("❌ Failed to update WiFi credentials");
+        wifiNode.forget(); // Fetch and try again on the next poll
+        wifiCheckRunning = false;
+        co_return;
     }
     
-    else if (wifiCheckState == CHECK_UPDATE_CREDENTIALS) {
-        // Update Firebase with new credentials
-        if (updateWiFiCredentialsInFirebase(newSSID, newPassword)) {
-            // Update local storage
-            Preferences wifiPrefs;
-            wifiPrefs.begin("wifi", false);
-            wifiPrefs.putString("ssid", newSSID);
-            wifiPrefs.putString("pass", newPassword);
-            wifiPrefs.end();
-            
-            Serial.println("📡 WiFi credentials updated");
-            wifiCheckState = CHECK_RECONNECT;
-            stateEntryTime = millis();
-        } else {
-            Serial.println("❌ Failed to update WiFi credentials");
-            wifiCheckState = CHECK_IDLE;
-        }
+    // Update local storage
+    wifiPrefs.begin("wifi", false);
+    wifiPrefs.putString("ssid", newSSID);
+    wifiPrefs.putString("pass", newPassword);
+    wifiPrefs.end();
+    Serial.println("📡 WiFi credentials updated");
+    
+    Serial.println("📡 Reconnecting WiFi with new credentials...");
+    WiFi.disconnect();
+    co_await flowSleep(100); // Let the disconnect land without holding the task
+    WiFi.reconnect();
+    wifiCheckRunning = false;
+}
+
+// Start a credential check from a stream update, or from the poll timer while
+// the stream is down; returns true when one was started
+bool checkPeriodicWiFiCredentials() {
+    if (wifiCheckRunning) {
         return false;
     }
     
-    else if (wifiCheckState == CHECK_RECONNECT) {
-        // Perform WiFi reconnection - potentially blocking but necessary
-        Serial.println("📡 Reconnecting WiFi with new credentials...");
-        WiFi.disconnect();
-        delay(100); // Minimal delay to allow disconnect
-        WiFi.reconnect();
+    String ssid, password;
+    if (streamedCredentialsPending) {
+        streamedCredentialsPending = false;
         
-        // Reset state machine
-        wifiCheckState = CHECK_IDLE;
-        return true; // Signal successful credential update
+        // Credentials arrived with the event, skip the fetch step
+        if (streamedSSID.isEmpty() || streamedPassword.isEmpty()) {
+            return false;
+        }
+        ssid = streamedSSID;
+        password = streamedPassword;
+    } else if (isDeviceStreamActive(STREAM_WIFI) || millis() - lastWiFiCheckTime < WIFI_CHECK_INTERVAL) {
+        return false; // Nothing to do
+    } else {
+        lastWiFiCheckTime = millis();
     }
     
-    return false;
+    wifiCheckRunning = true;
+    if (!spawnFlow(wifiCredentialFlow(ssid, password), millis() + WIFI_CHECK_DEADLINE, "wifi check")) {
+        wifiCheckRunning = false;
+        return false;
+    }
+    return true;
 }
 
-bool verifyOTP(String receivedOTP) {
+OtpOutcome verifyOTP(String receivedOTP, unsigned long deadlineMs, void (*onAuthorized)()) {
     if (!isFirebaseReady()) {
         Serial.println("❌ Firebase not ready for OTP verification");
-        return false;
+        return OTP_UNAVAILABLE;
     }
+    
+    // Every read up to the verdict shares the user's budget
+    DeadlineScope budget(deadlineMs != 0 ? deadlineMs : millis() + OTP_DEADLINE_MS);
     String userTag = "";
     String userId = "";
     String actualOTP = "";
@@ -525,154 +457,140 @@ bool verifyOTP(String receivedOTP) {
 
     if (!OTPVerifier::validateFormat(receivedOTP, userTag, actualOTP)) {
         Serial.println("❌ Invalid OTP format");
-        setLEDStatus(STATUS_OTP_ERROR);
         
         // Log OTP format validation failure
-        FirebaseJson logEntry;
-        logEntry.set("timestamp", isTimeSynchronized());
-        logEntry.set("event", "otp_format_invalid");
-        logEntry.set("attempted_otp", receivedOTP);
+        EventRecord event = makeEvent(EVT_OTP_FORMAT_INVALID);
+        SET_EVENT_TEXT(event.detail, receivedOTP);
+        logEvent(event);
         
-        String logPath = String("devices/") + deviceId + "/logs";
-        Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry);
+        return OTP_REJECTED;
+    }
+    
+    // The local table answers registration questions once it has been synced;
+    // until then fall back to reading registeredUsers from the cloud
+    bool tableSynced = AuthorizedUsers::isSynced();
+    const AuthorizedUser* cachedUser = tableSynced ? AuthorizedUsers::find(userTag) : nullptr;
+    bool isFirstTimeDevice = tableSynced && AuthorizedUsers::count() == 0 && !hasPendingDeviceRegistration();
+    
+    if (tableSynced && cachedUser == nullptr && !isFirstTimeDevice &&
+        !hasPendingDeviceRegistration(userTag.c_str())) {
+        Serial.println("❌ User is NOT registered to this device and device already has users!");
         
-        return false;
+        // Log unauthorized user attempt
+        logEvent(EVT_UNAUTHORIZED_USER, "", userTag);
+        
+        return OTP_REJECTED;
     }
     
-    // Verify OTP and extract user details
-    if (!OTPVerifier::verifyOTPCode(fbdo, userTag, receivedOTP, userId, storedOTP)) {
-        setLEDStatus(STATUS_OTP_ERROR);
+    // Verify OTP and extract user details: the device-scoped index needs one read,
+    // otherwise a cached user skips the tag query. Devices without an index
+    // writer skip the index read entirely.
+    bool otpValid;
+    OTPIndexResult indexed = OTPVerifier::indexEnabled()
+        ? OTPVerifier::verifyIndexedOTP(deviceId, userTag, receivedOTP, userId)
+        : OTP_INDEX_MISSING;
+    if (indexed != OTP_INDEX_MISSING) {
+        otpValid = (indexed == OTP_INDEX_VALID);
         
+        // The index must agree with the registration we already trust
+        if (otpValid && cachedUser != nullptr && !userId.equals(cachedUser->userId)) {
+            Serial.println("❌ OTP index user does not match registered user");
+            otpValid = false;
+        }
+    } else if (cachedUser != nullptr) {
+        userId = cachedUser->userId;
+        otpValid = OTPVerifier::verifyOTPForUser(userId, receivedOTP, storedOTP);
+    } else {
+        otpValid = OTPVerifier::verifyOTPCode(userTag, receivedOTP, userId, storedOTP);
+    }
+    
+    if (!otpValid && budget.interrupted()) {
+        // No verdict, so no failed attempt either
+        Serial.println("⌛ OTP check ran out of time");
+        return OTP_UNAVAILABLE;
+    }
+    if (!otpValid) {
         // Log OTP verification failure
-        FirebaseJson logEntry;
-        logEntry.set("timestamp", isTimeSynchronized());
-        logEntry.set("event", "otp_verification_failed");
-        logEntry.set("user_tag", userTag);
-        
-        String logPath = String("devices/") + deviceId + "/logs";
-        Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry);
+        logEvent(EVT_OTP_VERIFICATION_FAILED, "", userTag);
         
-        return false;
+        return OTP_REJECTED;
     }
     
-    // Check if this is first-time pairing
-    bool isFirstTimeDevice = UserManager::isFirstTimeUser(fbdo, deviceId);
+    // Check if this is first-time pairing. A user already known here, or one
+    // whose registeredUsers entry is still queued, means the cloud read can
+    // simply be behind: a second tag must not get first-user rights from it.
+    if (!tableSynced && (AuthorizedUsers::count() > 0 || hasPendingDeviceRegistration())) {
+        isFirstTimeDevice = false;
+    } else if (!tableSynced) {
+        bool verified;
+        isFirstTimeDevice = UserManager::isFirstTimeUser(&verified);
+        if (!verified) {
+            // Neither first-user rights nor a rejection without knowing the answer
+            Serial.println("⌛ Registered users could not be read");
+            return OTP_UNAVAILABLE;
+        }
+    }
     Serial.print("Is first time device setup? ");
     Serial.println(isFirstTimeDevice ? "Yes" : "No");
     
-    // Check if user is registered (or register them if first time)
-    bool isUserRegistered = false;
-    
-    if (isFirstTimeDevice) {
-        // For first time users, register them to the device
-        if (!UserManager::registerUserToDevice(fbdo, deviceId, userId, userTag, true)) {
-            Serial.println("❌ Failed to register first user to device!");
-            
-            // Log user registration failure
-            FirebaseJson logEntry;
-            logEntry.set("timestamp", isTimeSynchronized());
-            logEntry.set("event", "first_user_registration_failed");
-            logEntry.set("user_id", userId);
-            logEntry.set("user_tag", userTag);
-            
-            String logPath = String("devices/") + deviceId + "/logs";
-            Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry);
-            
-            return false;
-        }
-        isUserRegistered = true; // They should be registered now
-    } else {
-        // For existing devices, check if user is already registered
-        isUserRegistered = isUserRegisteredToDevice(userTag, userId);
+    if (!isFirstTimeDevice && cachedUser == nullptr) {
+        // For existing devices, check if user is already registered; a first
+        // user whose entry has not been written yet counts as registered
+        bool isUserRegistered = hasPendingDeviceRegistration(userTag.c_str()) ||
+                                isUserRegisteredToDevice(userTag, userId);
         Serial.print("Is this user registered to device? ");
         Serial.println(isUserRegistered ? "Yes" : "No");
         
+        if (!isUserRegistered && budget.interrupted()) {
+            Serial.println("⌛ Registration check ran out of time");
+            return OTP_UNAVAILABLE;
+        }
         if (!isUserRegistered) {
             Serial.println("❌ User is NOT registered to this device and device already has users!");
             
             // Log unauthorized user attempt
-            FirebaseJson logEntry;
-            logEntry.set("timestamp", isTimeSynchronized());
-            logEntry.set("event", "unauthorized_user_attempt");
-            logEntry.set("user_tag", userTag);
-            if (userId.length() > 0) {
-                logEntry.set("user_id", userId);
-            }
-            
-            String logPath = String("devices/") + deviceId + "/logs";
-            Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry);
+            logEvent(EVT_UNAUTHORIZED_USER, userId, userTag);
             
-            return false;
+            return OTP_REJECTED;
         }
     }
     
-    // At this point, the user should be registered - verify one more time
-    if (!isUserRegisteredToDevice(userTag, userId)) {
-        Serial.println("❌ User registration verification failed!");
-        
-        // Log user verification failure
-        FirebaseJson logEntry;
-        logEntry.set("timestamp", isTimeSynchronized());
-        logEntry.set("event", "user_verification_failed");
-        logEntry.set("user_tag", userTag);
-        if (userId.length() > 0) {
-            logEntry.set("user_id", userId);
-        }
-        
-        String logPath = String("devices/") + deviceId + "/logs";
-        Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry);
-        
-        return false;
+    // A first user is only let in once its registeredUsers entry is queued;
+    // without it the next tag would be offered first-user rights as well
+    if (isFirstTimeDevice && !queueRegistration(userTag.c_str(), userId.c_str(), true, true)) {
+        Serial.println("❌ First user registration could not be queued");
+        return OTP_UNAVAILABLE;
     }
-    // Determine user role
-    String userRole = "user"; // Default role
-   
-    // Path to the user's role for this device
-    String userRolePath = String(USERS_PATH) + userId + "/registeredDevices/" + deviceId + "/role";
-   
-    // Try to get existing role
-    if (Firebase.RTDB.getString(&fbdo, userRolePath.c_str())) {
-        if (fbdo.stringData().length() > 0) {
-            // User already has a role, preserve it
-            userRole = fbdo.stringData();
-            Serial.print("ℹ️ Preserving existing user role: ");
-            Serial.println(userRole);
-        }
-    } else {
-        // Set special role for first user
-        if (isFirstTimeDevice) {
-            userRole = "admin";
-            Serial.println("ℹ️ Setting admin role for first user");
-        } else {
-            Serial.println("ℹ️ Setting default user role");
-        }
-    }
-
-    // Update user's device registration with appropriate role
-    if (!UserManager::updateUserDeviceRegistration(fbdo, userId, deviceId, userRole)) {
-        Serial.println("❌ Failed to update user device registration");
-        return false;
+    
+    // Authorised: the relay opens now, everything below is bookkeeping and
+    // runs on the RTT-derived timeouts alone
+    budget.release();
+    if (onAuthorized != nullptr) {
+        onAuthorized();
     }
-
-    // Prepare log entry for device logs
-    FirebaseJson logEntry;
-    // Use current time as timestamp
-    logEntry.set("timestamp", isTimeSynchronized());
-    logEntry.set("event", "otp_verified");
-    logEntry.set("user", userId);
-
-    // Generate a unique log key
-    String logPath = String("devices/") + deviceId + "/logs";
-    FirebaseJson *json = &logEntry;
     
-    // Use the correct push method
-    if (!Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), json)) {
-        Serial.println("❌ Failed to log OTP verification");
-        Serial.println(fbdo.errorReason().c_str());
-        // This is not a critical failure, so we'll continue
+    OTPVerifier::consumeOTP(fbdo, userTag, userId, indexed != OTP_INDEX_MISSING);
+    
+    // A first user is known locally at once; the registeredUsers entry and the
+    // role follow through the registration queue
+    if (cachedUser == nullptr) {
+        AuthorizedUsers::addUser(userTag, userId, ROLE_UNKNOWN);
+    }
+    const AuthorizedUser* entry = AuthorizedUsers::find(userTag);
+    if (!isFirstTimeDevice && (entry == nullptr || entry->role == ROLE_UNKNOWN)) {
+        // The role stays unknown locally, so a full queue is retried at the next OTP
+        if (!queueRegistration(userTag.c_str(), userId.c_str(), false, false)) {
+            Serial.println("⚠️ Role lookup not queued, retried on the next OTP");
+        }
+    } else if (!isFirstTimeDevice) {
+        Serial.print("ℹ️ Cached user role: ");
+        Serial.println(AuthorizedUsers::roleName(entry->role));
     }
+
+    // Audit entry goes out with the next log batch
+    logEvent(EVT_OTP_VERIFIED, userId, userTag);
     
-    return true;
+    return OTP_AUTHORIZED;
 }
 
 bool isUserRegisteredToDevice(String userTag, String& userId) {
@@ -681,41 +599,41 @@ bool isUserRegisteredToDevice(String userTag, String& userId) {
         return false;
     }
 
-    String path = String(DEVICE_PATH) + deviceId + REGISTERED_USERS_NODE;
-    
-    if (!Firebase.RTDB.getJSON(&fbdo, path.c_str())) {
-        // Check specific error reason
-        if (fbdo.errorReason() == "path not exist" || fbdo.errorReason() == "path not found") {
-            // This is likely a first-time setup
-            Serial.println("⚠️ Registered users node doesn't exist yet");
-            return false; // Return false, but the calling function will check isFirstTimeUser separately
-        }
-        
-        Serial.print("❌ Firebase error: ");
-        Serial.println(fbdo.errorReason());
+    const String* body = RtdbCache::get(devicePaths.registeredUsers, CACHE_TTL_REGISTRATION_MS);
+    if (body == nullptr) {
         Serial.println("❌ Failed to get registered users");
         return false;
     }
-
-    FirebaseJson* json = fbdo.jsonObjectPtr();
-    if (json == nullptr) {
-        Serial.println("❌ No registered users found");
-        return false;
+    if (!body->startsWith("{")) {
+        // This is likely a first-time setup
+        Serial.println("⚠️ Registered users node doesn't exist yet");
+        return false; // Return false, but the calling function will check isFirstTimeUser separately
     }
 
-    FirebaseJsonData data;
-    json->get(data, userTag);
-
-    if (!data.success || data.type != "string") {
+    // Stream the node looking for just this tag
+    char found[NET_TEXT_LEN];
+    JsonField field = { userTag.c_str(), found, sizeof(found) };
+    JsonFieldExtractor extractor(&field, 1);
+    extractor.scan(*body);
+    
+    if (!field.found || found[0] == '\0') {
         Serial.println("❌ User not found or invalid format");
         return false;
     }
 
-    userId = data.stringValue;
+    userId = found;
     return true;
 }
 
+// Readiness published by the network task for callers on other tasks
+volatile bool firebaseReadyFlag = false;
+
 bool isFirebaseReady() {
+    // Only the network task touches the client; everyone else reads its last answer
+    if (isNetworkTaskRunning() && !isNetworkTaskContext()) {
+        return firebaseReadyFlag;
+    }
+    
     static unsigned long lastStatusCheck = 0;
     static bool lastStatus = false;
     const unsigned long STATUS_CHECK_INTERVAL = 500; // Check at most twice per second
@@ -728,7 +646,8 @@ bool isFirebaseReady() {
     
     // Just do a simple quick check
     lastStatusCheck = currentMillis;
-    lastStatus = Firebase.ready();
+    lastStatus = Firebase.ready() && isConnectionHealthy();
+    firebaseReadyFlag = lastStatus;
     
     return lastStatus;
 }
\ No newline at end of file
@@ -25,11 +25,24 @@ extern String deviceId;
 bool checkFirebaseConnection();
 void tokenStatusCallback(TokenInfo info);
 bool setupFirebase();
+void applyFirebaseTimeouts();
 bool isFirebaseReady();
 bool updateDeviceStatus(bool isOnline, bool isLocked, bool isSecure);
 bool updateWiFiCredentialsInFirebase(const String& ssid, const String& password);
 bool checkPeriodicWiFiCredentials(); 
-bool verifyOTP(String receivedOTP);
+void onWiFiStreamEvent(FirebaseData& stream);
+
+// How verifyOTP() ended; only a rejection counts against the attempt limit
+enum OtpOutcome : uint8_t {
+    OTP_REJECTED,
+    OTP_AUTHORIZED,
+    OTP_UNAVAILABLE      // Firebase down, or no verdict before the deadline
+};
+
+// The reads that decide run under deadlineMs (a millis() value; 0 = now plus
+// OTP_DEADLINE_MS). onAuthorized runs as soon as the code is accepted, before
+// the OTP is consumed and before any registration or role bookkeeping.
+OtpOutcome verifyOTP(String receivedOTP, unsigned long deadlineMs = 0, void (*onAuthorized)() = nullptr);
 bool isUserRegisteredToDevice(String userTag, String& userId);
 
 #endif
@@ -0,0 +1,386 @@
+#include "JsonScanner.h"
+
+JsonScanner::JsonScanner() {
+    reset();
+}
+
+void JsonScanner::reset() {
+    state = SCAN_VALUE;
+    depth = 0;
+    arrayLevels = 0;
+    memset(indexes, 0, sizeof(indexes));
+    memset(keys, 0, sizeof(keys));
+    target = value;
+    targetSize = sizeof(value);
+    targetLength = 0;
+    targetTruncated = false;
+    inKey = false;
+    escape = 0;
+    codepoint = 0;
+    value[0] = '\0';
+    discard[0] = '\0';
+}
+
+const char* JsonScanner::keyAt(uint8_t level) const {
+    if (level == 0 || level > JSON_SCAN_MAX_DEPTH) {
+        return "";
+    }
+    return keys[level];
+}
+
+bool JsonScanner::pathIs(const JsonToken& token, const char* path) const {
+    if (token.depth == 0 || token.depth > JSON_SCAN_MAX_DEPTH) {
+        return false;
+    }
+    for (uint8_t level = 1; level <= token.depth; level++) {
+        const char* end = strchr(path, '/');
+        size_t length = end != nullptr ? (size_t)(end - path) : strlen(path);
+        if (strncmp(keys[level], path, length) != 0 || keys[level][length] != '\0') {
+            return false;
+        }
+        if (level == token.depth) {
+            return end == nullptr;
+        }
+        if (end == nullptr) {
+            return false;
+        }
+        path = end + 1;
+    }
+    return false;
+}
+
+bool JsonScanner::emit(JsonTokenType type, const char* text, bool truncated) {
+    JsonToken token = { type, depth, keyAt(depth), text, truncated };
+    if (!onToken(token)) {
+        state = SCAN_STOPPED;
+        return false;
+    }
+    return true;
+}
+
+bool JsonScanner::endValue() {
+    state = depth == 0 ? SCAN_DONE : SCAN_AFTER_VALUE;
+    return true;
+}
+
+void JsonScanner::setArrayKey() {
+    if (depth <= JSON_SCAN_MAX_DEPTH) {
+        snprintf(keys[depth], JSON_SCAN_KEY_LEN, "%u", (unsigned)indexes[depth]);
+        indexes[depth]++;
+    }
+}
+
+bool JsonScanner::closeContainer(char c) {
+    bool isArray = (arrayLevels >> (depth - 1)) & 1;
+    if (c != (isArray ? ']' : '}')) {
+        state = SCAN_FAILED;
+        return false;
+    }
+    depth--;
+    return endValue();
+}
+
+bool JsonScanner::beginValue(char c) {
+    if (depth > 0 && ((arrayLevels >> (depth - 1)) & 1)) {
+        setArrayKey();
+    }
+
+    if (c == '{' || c == '[') {
+        if (depth >= JSON_SCAN_MAX_NESTING) {
+            state = SCAN_FAILED;
+            return false;
+        }
+        bool isArray = c == '[';
+        if (!emit(isArray ? JSON_ARRAY : JSON_OBJECT, "", false)) {
+            return false;
+        }
+        depth++;
+        if (isArray) {
+            arrayLevels |= 1UL << (depth - 1);
+            if (depth <= JSON_SCAN_MAX_DEPTH) {
+                indexes[depth] = 0;
+            }
+        } else {
+            arrayLevels &= ~(1UL << (depth - 1));
+        }
+        state = isArray ? SCAN_VALUE_OR_END : SCAN_KEY_OR_END;
+        return true;
+    }
+
+    if (c == '"') {
+        target = value;
+        targetSize = sizeof(value);
+        targetLength = 0;
+        targetTruncated = false;
+        inKey = false;
+        state = SCAN_STRING;
+        return true;
+    }
+
+    if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n') {
+        value[0] = c;
+        targetLength = 1;
+        targetTruncated = false;
+        state = SCAN_LITERAL;
+        return true;
+    }
+
+    state = SCAN_FAILED;
+    return false;
+}
+
+bool JsonScanner::appendChar(char c) {
+    if (targetLength + 1 < targetSize) {
+        target[targetLength++] = c;
+    } else {
+        targetTruncated = true;
+    }
+    return true;
+}
+
+void JsonScanner::appendUtf8(uint16_t cp) {
+    if (cp < 0x80) {
+        appendChar((char)cp);
+    } else if (cp < 0x800) {
+        appendChar((char)(0xC0 | (cp >> 6)));
+        appendChar((char)(0x80 | (cp & 0x3F)));
+    } else if (cp >= 0xD800 && cp <= 0xDFFF) {
+        appendChar('?');  // Surrogate halves are not paired up
+    } else {
+        appendChar((char)(0xE0 | (cp >> 12)));
+        appendChar((char)(0x80 | ((cp >> 6) & 0x3F)));
+        appendChar((char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool isDelimiter(char c) {
+    return c == ',' || c == '}' || c == ']' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+static bool isNumber(const char* text) {
+    if (*text == '-') text++;
+    if (*text == '0') {
+        text++;
+    } else if (isDigit(*text)) {
+        while (isDigit(*text)) text++;
+    } else {
+        return false;
+    }
+    if (*text == '.') {
+        text++;
+        if (!isDigit(*text)) return false;
+        while (isDigit(*text)) text++;
+    }
+    if (*text == 'e' || *text == 'E') {
+        text++;
+        if (*text == '+' || *text == '-') text++;
+        if (!isDigit(*text)) return false;
+        while (isDigit(*text)) text++;
+    }
+    return *text == '\0';
+}
+
+bool JsonScanner::step(char c) {
+    if (state == SCAN_STRING || state == SCAN_KEY) {
+        if (escape == 1) {
+            escape = 0;
+            switch (c) {
+                case '"': case '\\': case '/': return appendChar(c);
+                case 'b': return appendChar('\b');
+                case 'f': return appendChar('\f');
+                case 'n': return appendChar('\n');
+                case 'r': return appendChar('\r');
+                case 't': return appendChar('\t');
+                case 'u': escape = 2; codepoint = 0; return true;
+                default: state = SCAN_FAILED; return false;
+            }
+        }
+        if (escape >= 2) {
+            int digit = hexValue(c);
+            if (digit < 0) {
+                state = SCAN_FAILED;
+                return false;
+            }
+            codepoint = (codepoint << 4) | digit;
+            if (++escape == 6) {
+                escape = 0;
+                appendUtf8(codepoint);
+            }
+            return true;
+        }
+        if (c == '\\') {
+            escape = 1;
+            return true;
+        }
+        if (c == '"') {
+            target[targetLength] = '\0';
+            if (inKey) {
+                state = SCAN_COLON;
+                return true;
+            }
+            return emit(JSON_STRING, value, targetTruncated) && endValue();
+        }
+        if ((uint8_t)c < 0x20) {
+            state = SCAN_FAILED;
+            return false;
+        }
+        return appendChar(c);
+    }
+
+    if (state == SCAN_LITERAL) {
+        if (!isDelimiter(c)) {
+            if (targetLength < JSON_SCAN_VALUE_LEN) {
+                value[targetLength++] = c;
+            } else {
+                targetTruncated = true;
+            }
+            return true;
+        }
+        value[targetLength] = '\0';
+        JsonTokenType type = JSON_NUMBER;
+        if (strcmp(value, "true") == 0 || strcmp(value, "false") == 0) {
+            type = JSON_BOOL;
+        } else if (strcmp(value, "null") == 0) {
+            type = JSON_NULL;
+        } else if (value[0] == 't' || value[0] == 'f' || value[0] == 'n' ||
+                   (!targetTruncated && !isNumber(value))) {
+            state = SCAN_FAILED;
+            return false;
+        }
+        if (!emit(type, value, targetTruncated) || !endValue()) {
+            return false;
+        }
+        // The delimiter belongs to what follows the literal
+    }
+
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+        return state != SCAN_FAILED && state != SCAN_STOPPED;
+    }
+
+    switch (state) {
+        case SCAN_VALUE:
+            return beginValue(c);
+        case SCAN_VALUE_OR_END:
+            return c == ']' ? closeContainer(c) : beginValue(c);
+        case SCAN_KEY_OR_END:
+            if (c == '}') {
+                return closeContainer(c);
+            }
+            // Fall through
+        case SCAN_KEY_START:
+            if (c != '"') {
+                break;
+            }
+            if (depth <= JSON_SCAN_MAX_DEPTH) {
+                target = keys[depth];
+                targetSize = JSON_SCAN_KEY_LEN;
+            } else {
+                target = discard;
+                targetSize = sizeof(discard);
+            }
+            targetLength = 0;
+            targetTruncated = false;
+            inKey = true;
+            state = SCAN_KEY;
+            return true;
+        case SCAN_COLON:
+            if (c != ':') {
+                break;
+            }
+            state = SCAN_VALUE;
+            return true;
+        case SCAN_AFTER_VALUE:
+            if (c == ',') {
+                state = ((arrayLevels >> (depth - 1)) & 1) ? SCAN_VALUE : SCAN_KEY_START;
+                return true;
+            }
+            if (c == '}' || c == ']') {
+                return closeContainer(c);
+            }
+            break;
+        case SCAN_STOPPED:
+            return false;
+        default:
+            break;
+    }
+
+    state = SCAN_FAILED;
+    return false;
+}
+
+bool JsonScanner::feed(const char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (!step(data[i])) {
+            return false;
+        }
+    }
+    return state != SCAN_FAILED && state != SCAN_STOPPED;
+}
+
+bool JsonScanner::finish() {
+    if (state == SCAN_LITERAL && depth == 0) {
+        step(' ');  // A bare number or literal ends with the input
+    }
+    return state == SCAN_DONE || state == SCAN_STOPPED;
+}
+
+bool JsonScanner::scan(const char* json, size_t length) {
+    reset();
+    feed(json, length);
+    return finish();
+}
+
+bool JsonChildCounter::onToken(const JsonToken& token) {
+    if (token.depth == 1 && token.type != JSON_NULL &&
+        !(nonEmptyOnly && token.type == JSON_STRING && token.text[0] == '\0')) {
+        count++;
+    }
+    return true;
+}
+
+JsonFieldExtractor::JsonFieldExtractor(JsonField* fields, uint8_t count)
+    : fields(fields), count(count), remaining(count) {
+    for (uint8_t i = 0; i < count; i++) {
+        fields[i].found = false;
+        fields[i].out[0] = '\0';
+    }
+}
+
+bool JsonFieldExtractor::onToken(const JsonToken& token) {
+    if (token.type == JSON_OBJECT || token.type == JSON_ARRAY) {
+        return true;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (!fields[i].found && pathIs(token, fields[i].path)) {
+            if (token.truncated || strlen(token.text) >= fields[i].size) {
+                continue;
+            }
+            strcpy(fields[i].out, token.text);
+            fields[i].found = true;
+            remaining--;
+        }
+    }
+    return remaining > 0;  // Nothing left to look for
+}
+
+bool JsonFirstKey::onToken(const JsonToken& token) {
+    if (token.depth != 1) {
+        return true;
+    }
+    strncpy(out, token.key, size - 1);
+    out[size - 1] = '\0';
+    found = true;
+    return false;
+}
@@ -0,0 +1,158 @@
+#ifndef JSON_SCANNER_H
+#define JSON_SCANNER_H
+
+#include <Arduino.h>
+
+// Incremental JSON tokenizer for RTDB responses. Bytes can be fed as they
+// arrive from the socket; each value is reported once with its depth and the
+// keys leading to it, so memory stays fixed however large the node is.
+// Keys are kept for the first JSON_SCAN_MAX_DEPTH levels; string values
+// longer than JSON_SCAN_VALUE_LEN are truncated (and flagged).
+#define JSON_SCAN_MAX_DEPTH 6
+#define JSON_SCAN_MAX_NESTING 32      // Deeper documents are rejected
+#define JSON_SCAN_KEY_LEN 40
+#define JSON_SCAN_VALUE_LEN 72        // Fits the 64-char OTP hashes
+
+enum JsonTokenType : uint8_t {
+    JSON_OBJECT,      // Reported when it opens
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_BOOL,
+    JSON_NULL
+};
+
+struct JsonToken {
+    JsonTokenType type;
+    uint8_t depth;          // 0 = the document, 1 = its children
+    const char* key;        // Member name, or the index inside an array; "" for the document
+    const char* text;       // Unescaped string, or the literal as written; "" for containers
+    bool truncated;
+};
+
+class JsonScanner {
+public:
+    JsonScanner();
+    virtual ~JsonScanner() {}
+
+    void reset();
+
+    // False once the input is malformed or onToken() asked to stop
+    bool feed(const char* data, size_t length);
+
+    // True when a whole document was read, or the scan stopped early on purpose
+    bool finish();
+
+    // Feed a complete buffer
+    bool scan(const char* json, size_t length);
+    bool scan(const String& json) { return scan(json.c_str(), json.length()); }
+
+    bool stopped() const { return state == SCAN_STOPPED; }
+
+    // Key of the enclosing value at a depth (1..token depth)
+    const char* keyAt(uint8_t depth) const;
+
+    // True when the token sits at path, keys joined with '/' (e.g. "ids/3")
+    bool pathIs(const JsonToken& token, const char* path) const;
+
+protected:
+    // Return false to stop scanning
+    virtual bool onToken(const JsonToken& token) = 0;
+
+private:
+    enum ScanState : uint8_t {
+        SCAN_VALUE,
+        SCAN_VALUE_OR_END,     // After '['
+        SCAN_KEY_OR_END,       // After '{'
+        SCAN_KEY_START,        // After ',' in an object
+        SCAN_KEY,
+        SCAN_COLON,
+        SCAN_STRING,
+        SCAN_LITERAL,
+        SCAN_AFTER_VALUE,
+        SCAN_DONE,
+        SCAN_STOPPED,
+        SCAN_FAILED
+    };
+
+    bool step(char c);
+    bool beginValue(char c);
+    bool emit(JsonTokenType type, const char* text, bool truncated);
+    bool closeContainer(char c);
+    bool endValue();
+    bool appendChar(char c);
+    void appendUtf8(uint16_t codepoint);
+    void setArrayKey();
+
+    ScanState state;
+    uint8_t depth;
+    uint32_t arrayLevels;              // Bit n set when level n+1 is an array
+    uint16_t indexes[JSON_SCAN_MAX_DEPTH + 1];
+    char keys[JSON_SCAN_MAX_DEPTH + 1][JSON_SCAN_KEY_LEN];
+
+    // String being read (a key or a value) and escape handling
+    char* target;
+    size_t targetSize;
+    size_t targetLength;
+    bool targetTruncated;
+    bool inKey;
+    uint8_t escape;                    // 0 none, 1 after '\\', 2..5 reading \uXXXX
+    uint16_t codepoint;
+
+    char value[JSON_SCAN_VALUE_LEN + 1];
+    char discard[1];
+};
+
+// Number of children of the document; with nonEmptyOnly, empty strings are skipped
+class JsonChildCounter : public JsonScanner {
+public:
+    explicit JsonChildCounter(bool nonEmptyOnly = false) : nonEmptyOnly(nonEmptyOnly), count(0) {}
+    int children() const { return count; }
+
+protected:
+    bool onToken(const JsonToken& token) override;
+
+private:
+    bool nonEmptyOnly;
+    int count;
+};
+
+// Copies a few values out of a document; paths as for pathIs(). A value that
+// was cut short, by the scanner or by size, counts as not found.
+struct JsonField {
+    const char* path;
+    char* out;
+    size_t size;
+    bool found = false;
+};
+
+class JsonFieldExtractor : public JsonScanner {
+public:
+    JsonFieldExtractor(JsonField* fields, uint8_t count);
+    bool allFound() const { return remaining == 0; }
+
+protected:
+    bool onToken(const JsonToken& token) override;
+
+private:
+    JsonField* fields;
+    uint8_t count;
+    uint8_t remaining;
+};
+
+// Key of the document's first child, e.g. the user ID a limitToFirst(1) query returned
+class JsonFirstKey : public JsonScanner {
+public:
+    JsonFirstKey(char* out, size_t size) : out(out), size(size), found(false) { out[0] = '\0'; }
+    bool hasKey() const { return found; }
+
+protected:
+    bool onToken(const JsonToken& token) override;
+
+private:
+    char* out;
+    size_t size;
+    bool found;
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include "JsonWriter.h"
+
+JsonWriter::JsonWriter(char* buffer, size_t capacity)
+    : buffer(buffer), capacity(capacity) {
+    reset();
+}
+
+void JsonWriter::reset() {
+    used = 0;
+    depth = 0;
+    firstInLevel = 0;
+    overflow = capacity == 0;
+    if (capacity > 0) {
+        buffer[0] = '\0';
+    }
+}
+
+// Keep one byte for the terminator
+void JsonWriter::put(char c) {
+    if (overflow || used + 1 >= capacity) {
+        overflow = true;
+        return;
+    }
+    buffer[used++] = c;
+    buffer[used] = '\0';
+}
+
+void JsonWriter::putRaw(const char* text, size_t length) {
+    if (overflow || used + length >= capacity) {
+        overflow = true;
+        return;
+    }
+    memcpy(buffer + used, text, length);
+    used += length;
+    buffer[used] = '\0';
+}
+
+void JsonWriter::putString(const char* text) {
+    static const char hexDigits[] = "0123456789abcdef";
+
+    put('"');
+    for (const char* p = text; *p != '\0'; p++) {
+        char c = *p;
+        if (c == '"' || c == '\\') {
+            put('\\');
+            put(c);
+        } else if ((uint8_t)c < 0x20) {
+            char escaped[6] = { '\\', 'u', '0', '0', hexDigits[(c >> 4) & 0x0F], hexDigits[c & 0x0F] };
+            putRaw(escaped, sizeof(escaped));
+        } else {
+            put(c);
+        }
+    }
+    put('"');
+}
+
+void JsonWriter::putUnsigned(unsigned long long value) {
+    char digits[20];
+    uint8_t count = 0;
+    do {
+        digits[count++] = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) {
+        put(digits[--count]);
+    }
+}
+
+void JsonWriter::putKey(const char* key) {
+    if (depth == 0) {
+        overflow = true;  // Members only exist inside an object
+        return;
+    }
+    uint8_t bit = 1 << (depth - 1);
+    if (firstInLevel & bit) {
+        firstInLevel &= ~bit;
+    } else {
+        put(',');
+    }
+    if (key != nullptr) {
+        putString(key);
+        put(':');
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    return beginObject(nullptr);
+}
+
+JsonWriter& JsonWriter::beginObject(const char* key) {
+    if (depth >= JSON_WRITER_MAX_DEPTH) {
+        overflow = true;
+        return *this;
+    }
+    if (depth > 0) {
+        putKey(key);
+    }
+    put('{');
+    depth++;
+    firstInLevel |= 1 << (depth - 1);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    if (depth == 0) {
+        overflow = true;
+        return *this;
+    }
+    put('}');
+    depth--;
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, bool value) {
+    putKey(key);
+    if (value) {
+        putRaw("true", 4);
+    } else {
+        putRaw("false", 5);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, int value) {
+    return field(key, (long long)value);
+}
+
+JsonWriter& JsonWriter::field(const char* key, long long value) {
+    putKey(key);
+    if (value < 0) {
+        put('-');
+        putUnsigned((unsigned long long)(-(value + 1)) + 1);
+    } else {
+        putUnsigned((unsigned long long)value);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, unsigned long long value) {
+    putKey(key);
+    putUnsigned(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, const char* value) {
+    putKey(key);
+    putString(value != nullptr ? value : "");
+    return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, float value) {
+    putKey(key);
+    if (!(value > -1e15f && value < 1e15f)) {
+        putRaw("null", 4);  // NaN, infinity or too large for the fixed-point digits
+        return *this;
+    }
+    if (value < 0) {
+        put('-');
+        value = -value;
+    }
+    unsigned long long hundredths = (unsigned long long)(value * 100.0f + 0.5f);
+    putUnsigned(hundredths / 100);
+    put('.');
+    put('0' + (hundredths / 10) % 10);
+    put('0' + hundredths % 10);
+    return *this;
+}
+
+JsonWriter& JsonWriter::serverTimestamp(const char* key) {
+    putKey(key);
+    putRaw("{\".sv\":\"timestamp\"}", 19);
+    return *this;
+}
+
+JsonWriter& JsonWriter::nullField(const char* key) {
+    putKey(key);
+    putRaw("null", 4);
+    return *this;
+}
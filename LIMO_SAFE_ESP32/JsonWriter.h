@@ -0,0 +1,59 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+
+#define JSON_WRITER_MAX_DEPTH 8
+
+// Streaming JSON into a caller-owned buffer: no heap, no String temporaries.
+// On overflow the writer stops and ok() turns false; the buffer stays terminated.
+class JsonWriter {
+public:
+    JsonWriter(char* buffer, size_t capacity);
+
+    void reset();
+
+    JsonWriter& beginObject();
+    JsonWriter& beginObject(const char* key);
+    JsonWriter& endObject();
+
+    JsonWriter& field(const char* key, bool value);
+    JsonWriter& field(const char* key, int value);
+    JsonWriter& field(const char* key, long long value);
+    JsonWriter& field(const char* key, unsigned long long value);
+    JsonWriter& field(const char* key, const char* value);
+    JsonWriter& field(const char* key, float value);      // Two decimals; null if out of range
+    JsonWriter& serverTimestamp(const char* key);   // {".sv":"timestamp"}
+    JsonWriter& nullField(const char* key);         // In a PATCH, deletes the key
+
+    const char* data() const { return buffer; }
+    size_t length() const { return used; }
+    bool ok() const { return !overflow && depth == 0; }
+
+private:
+    char* buffer;
+    size_t capacity;
+    size_t used;
+    uint8_t depth;
+    uint8_t firstInLevel;    // Bit per depth: no member written yet
+    bool overflow;
+
+    void put(char c);
+    void putRaw(const char* text, size_t length);
+    void putString(const char* text);
+    void putUnsigned(unsigned long long value);
+    void putKey(const char* key);
+};
+
+// Writer with its own storage; size is fixed at compile time
+template <size_t N>
+class StaticJsonWriter : public JsonWriter {
+public:
+    StaticJsonWriter() : JsonWriter(storage, N) {}
+    static constexpr size_t capacity() { return N; }
+
+private:
+    char storage[N];
+};
+
+#endif
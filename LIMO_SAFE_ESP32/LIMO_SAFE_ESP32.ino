@@ -16,6 +16,18 @@
 #include "UserManager.h" // User authentication and management
 #include "RGBLed.h" // RGB LED status indicator
 #include "FingerprintSensor.h" // Fingerprint reader for biometric authentication
+#include "TelemetryCadence.h" // Activity-driven status update rates
+#include "DeviceStreams.h" // RTDB event streams for commands and credentials
+#include "NetworkTask.h" // Firebase traffic on core 0
+#include "ConnectionHealth.h" // Connectivity derived from real request outcomes
+#include "AuthorizedUsers.h" // Local tag -> user table for OTP checks
+#include "TotpVerifier.h" // On-device OTP check against provisioned TOTP secrets
+#include "AttemptLimiter.h" // Local OTP attempt limits and lockouts
+#include "LogRollup.h" // Day-sharded logs folded into summaries
+#include "RegistrationQueue.h" // Registration and role writes deferred past the unlock
+#include "EventLogger.h" // Queued, batched device log uploads
+#include "MqttTransport.h" // Log and status uploads over MQTT when a broker is set
+#include "TimeBase.h" // Monotonic clock rebased to epoch after NTP
 #include "secrets.h" // Confidential credentials and API keys
 
 void setup() {
@@ -23,7 +35,17 @@ void setup() {
     Serial.begin(115200); // Start serial communication at 115200 baud
     Serial.println("\n🚀 Starting LIMO SAFE Morse System..."); // Print startup message
     
+    initTimeBase(); // Count this boot for monotonic event timestamps
+    initEventLogger(); // Restore log events queued before a reset
+    initRegistrationQueue(); // Restore registration writes queued before a reset
     setupNanoCommunication(); // Initialize communication with Arduino Nano
+    loadCadenceConfig(); // Load per-device status rates from flash
+    loadHealthConfig(); // Load connection probe settings from flash
+    loadLogRetention(); // Load how long raw logs and summaries are kept
+    OTPVerifier::loadIndexConfig(); // Whether OTPs are looked up in the device's OTP index
+    AuthorizedUsers::load(); // Restore authorised users from flash
+    TotpVerifier::load(); // Restore sealed TOTP secrets from flash
+    AttemptLimiter::load(); // Restore OTP lockouts from RTC memory or flash
     initRGB(); // Initialize RGB LED
     initializeFingerprint(); // Initialize fingerprint sensor
     //deleteAllFingerprints(); // Commented functionality to wipe fingerprint database
@@ -58,70 +80,49 @@ void setup() {
         delay(3000);
         //ESP.restart(); // Commented automatic restart after Firebase failure
     }
+    initMqttTransport(); // Broker session for log and status uploads, if configured
 
     // Log successful WiFi connection to Firebase
-    if (Firebase.ready()) {
-        FirebaseJson logEntry; // Create JSON object for log entry
-        logEntry.set("timestamp", isTimeSynchronized()); // Add timestamp to log
-        logEntry.set("event", "wifi_connected"); // Log event type
-        logEntry.set("ssid", WiFi.SSID()); // Include connected WiFi network name
-
-        String logPath = String("devices/") + deviceId + "/logs"; // Create path to device logs
-        if (Firebase.RTDB.pushJSON(&fbdo, logPath.c_str(), &logEntry)) {
-            Serial.println("✅ WiFi connection logged.");
-        } else {
-            Serial.println("❌ Failed to log WiFi connection.");
-            //Serial.println(fbdo.errorReason().c_str()); // Print error reason
-        }
+    if (WiFi.isConnected()) {
+        EventRecord wifiEvent = makeEvent(EVT_WIFI_CONNECTED);
+        SET_EVENT_TEXT(wifiEvent.detail, WiFi.SSID()); // Include connected WiFi network name
+        logEvent(wifiEvent); // Uploaded by the network task with the next batch
     }
+    syncCadenceConfigFromFirebase(); // Apply cloud cadence override if configured
+    syncHealthConfigFromFirebase(); // Apply cloud probe settings if configured
+    syncLogRetentionFromFirebase(); // Apply cloud log retention if configured
+    OTPVerifier::syncIndexConfigFromFirebase(); // Apply the cloud OTP index flag if configured
+    sendCadenceToNano(); // Nano heartbeat follows the same rates (Nano is up by now)
+    beginDeviceStreams(); // Subscribe to fingerprint commands and WiFi credentials
     updateDeviceStatus(true, false, false); // Update device status in Firebase
+    startNetworkTask(); // From here on only the network task talks to Firebase
 
     Serial.println("✅ System initialization complete!");
 }
 
-unsigned long lastFirebaseCheck = 0; // Timestamp of last Firebase check
-const unsigned long FIREBASE_CHECK_INTERVAL = 5000; // Check Firebase every 5 seconds (increased from 2s)
-bool lastKnownFirebaseStatus = false; // Track last Firebase status
+unsigned long lastLedStatusUpdate = 0; // Timestamp of last connectivity LED update
+const unsigned long LED_STATUS_INTERVAL = 5000; // Refresh connectivity LED every 5 seconds
 
 void loop() {
     // Always process inputs and core functionality regardless of connectivity
     // These operations should never be blocked by connectivity issues
     handleFingerprint();
     handleNanoData();
+    checkOnlineStatus(); // The link can change while the Nano is quiet
+    
+    // Completions and commands from the network task on core 0
+    handleNetworkResults();
+    checkPendingOTP();
+    AttemptLimiter::service();
     
     // Non-blocking WiFi status check
     bool wifiConnected = checkWiFiConnection();
     
-    // Only periodically check Firebase connectivity to reduce overhead
+    // Firebase checks, streams and uploads run on the network task; just mirror its state
     unsigned long currentMillis = millis();
-    if (currentMillis - lastFirebaseCheck >= FIREBASE_CHECK_INTERVAL) {
-        lastFirebaseCheck = currentMillis;
-        
-        // Only check Firebase if WiFi is connected
-        if (wifiConnected) {
-            // Use non-blocking Firebase check
-            lastKnownFirebaseStatus = checkFirebaseConnection();
-            
-            // Update LED status based on connectivity
-            if (wifiConnected && lastKnownFirebaseStatus) {
-                setLEDStatus(STATUS_ONLINE);
-            } else if (wifiConnected && !lastKnownFirebaseStatus) {
-                setLEDStatus(STATUS_OFFLINE);
-            } else {
-                setLEDStatus(STATUS_OFFLINE);
-            }
-            
-            // Only try Firebase operations if we believe we're connected
-            // These should be fast timeouts to prevent blocking
-            if (lastKnownFirebaseStatus) {
-                checkPeriodicWiFiCredentials();
-                processFirebaseQueue();
-            }
-        } else {
-            // No WiFi connection
-            setLEDStatus(STATUS_OFFLINE);
-            lastKnownFirebaseStatus = false;
-        }
+    if (currentMillis - lastLedStatusUpdate >= LED_STATUS_INTERVAL) {
+        lastLedStatusUpdate = currentMillis;
+        setLEDStatus(wifiConnected && isFirebaseReady() ? STATUS_ONLINE : STATUS_OFFLINE);
     }
     
     // Every 10 loops, allow a very small delay to prevent watchdog issues
@@ -0,0 +1,590 @@
+#include "LogRollup.h"
+#include "DevicePaths.h"
+#include "DevicePayloads.h"
+#include "TimeBase.h"
+#include "RtdbRest.h"
+#include "RtdbCache.h"
+#include "JsonScanner.h"
+#include "ConnectionHealth.h"
+#include <Preferences.h>
+
+// Preferences namespace and keys for the per-device retention
+#define LOG_NAMESPACE "logs"
+#define LOG_PREF_RAW_DAYS "rawDays"
+#define LOG_PREF_SUMMARY_DAYS "summaryDays"
+
+#define MS_PER_DAY 86400000ULL
+#define DAY_FORMAT_MAX 36   // "%04d-%02u-%02u" with each field at its widest
+
+LogRetention logRetention = {
+    LOG_RAW_DAYS,
+    LOG_SUMMARY_DAYS
+};
+
+static bool isValidRetention(const LogRetention& retention) {
+    return retention.rawDays >= 1 && retention.summaryDays >= retention.rawDays;
+}
+
+void loadLogRetention() {
+    Preferences logPrefs;
+    if (logPrefs.begin(LOG_NAMESPACE, true)) {
+        LogRetention stored;
+        stored.rawDays = logPrefs.getUShort(LOG_PREF_RAW_DAYS, LOG_RAW_DAYS);
+        stored.summaryDays = logPrefs.getUShort(LOG_PREF_SUMMARY_DAYS, LOG_SUMMARY_DAYS);
+        logPrefs.end();
+
+        if (isValidRetention(stored)) {
+            logRetention = stored;
+        } else {
+            Serial.println(F("⚠️ Stored log retention invalid, using defaults"));
+        }
+    }
+}
+
+bool saveLogRetention(const LogRetention& retention) {
+    if (!isValidRetention(retention)) {
+        Serial.println(F("❌ Rejected invalid log retention"));
+        return false;
+    }
+
+    Preferences logPrefs;
+    if (!logPrefs.begin(LOG_NAMESPACE, false)) {
+        Serial.println(F("❌ Failed to access preferences for log retention"));
+        return false;
+    }
+    logPrefs.putUShort(LOG_PREF_RAW_DAYS, retention.rawDays);
+    logPrefs.putUShort(LOG_PREF_SUMMARY_DAYS, retention.summaryDays);
+    logPrefs.end();
+
+    logRetention = retention;
+    return true;
+}
+
+// Pull devices/<id>/config/logs once at boot; only written back when it differs
+bool syncLogRetentionFromFirebase() {
+    char rawDays[8];
+    char summaryDays[8];
+    JsonField fields[] = {
+        { "rawDays", rawDays, sizeof(rawDays) },
+        { "summaryDays", summaryDays, sizeof(summaryDays) }
+    };
+    JsonFieldExtractor extractor(fields, 2);
+    unsigned long started = millis();
+    int status = rtdbScan(devicePaths.logConfig, nullptr, extractor);
+    recordHttpOutcome(status, status == 200, started);
+    if (status != 200 || (!fields[0].found && !fields[1].found)) {
+        return false; // No override configured for this device
+    }
+
+    LogRetention remote = logRetention;
+    if (fields[0].found) remote.rawDays = atoi(rawDays);
+    if (fields[1].found) remote.summaryDays = atoi(summaryDays);
+
+    if (remote.rawDays == logRetention.rawDays && remote.summaryDays == logRetention.summaryDays) {
+        return true;
+    }
+
+    if (!saveLogRetention(remote)) {
+        return false;
+    }
+
+    Serial.println(F("✅ Log retention updated from Firebase"));
+    return true;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date, and back
+static long daysFromCivil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long)doe - 719468;
+}
+
+static void civilFromDays(long z, int& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = (int)(yoe + era * 400) + (m <= 2);
+}
+
+// Years 0..9999 give "yyyy-mm-dd"; anything else is cut to LOG_DAY_LEN
+static void formatDay(long day, char out[LOG_DAY_LEN]) {
+    int y;
+    unsigned m, d;
+    civilFromDays(day, y, m, d);
+    char text[DAY_FORMAT_MAX];
+    snprintf(text, sizeof(text), "%04d-%02u-%02u", y, m, d);
+    memcpy(out, text, LOG_DAY_LEN - 1);
+    out[LOG_DAY_LEN - 1] = '\0';
+}
+
+void formatLogDay(unsigned long long epochMs, char out[LOG_DAY_LEN]) {
+    formatDay((long)(epochMs / MS_PER_DAY), out);
+}
+
+// "yyyy-mm-dd" to a day number; false for anything else (undated, push IDs)
+static bool parseLogDay(const char* key, long& day) {
+    if (strlen(key) != LOG_DAY_LEN - 1 || key[4] != '-' || key[7] != '-') {
+        return false;
+    }
+    for (int i = 0; i < LOG_DAY_LEN - 1; i++) {
+        if (i != 4 && i != 7 && !isdigit((unsigned char)key[i])) {
+            return false;
+        }
+    }
+    int y = atoi(key);
+    unsigned m = atoi(key + 5);
+    unsigned d = atoi(key + 8);
+    if (m < 1 || m > 12 || d < 1 || d > 31) {
+        return false;
+    }
+    day = daysFromCivil(y, m, d);
+    return true;
+}
+
+static uint16_t addCount(uint16_t count, uint32_t more) {
+    uint32_t sum = count + more;
+    return sum > 0xFFFF ? 0xFFFF : sum;
+}
+
+static void mergeTime(unsigned long long& first, unsigned long long& last,
+                      unsigned long long otherFirst, unsigned long long otherLast) {
+    if (otherFirst != 0 && (first == 0 || otherFirst < first)) {
+        first = otherFirst;
+    }
+    if (otherLast > last) {
+        last = otherLast;
+    }
+}
+
+static void mergeSummary(LogSummary& into, const LogSummary& from) {
+    into.records += from.records;
+    for (uint8_t type = 0; type < EVT_COUNT; type++) {
+        into.counts[type] = addCount(into.counts[type], from.counts[type]);
+    }
+    into.other = addCount(into.other, from.other);
+    mergeTime(into.first, into.last, from.first, from.last);
+    into.tamperEpisodes = addCount(into.tamperEpisodes, from.tamperEpisodes);
+    mergeTime(into.tamperFirst, into.tamperLast, from.tamperFirst, from.tamperLast);
+}
+
+// Shallow listing of logs: the oldest shard past raw retention, plus what else waits
+class ShardLister : public JsonScanner {
+public:
+    explicit ShardLister(long lastFoldDay) : lastFoldDay(lastFoldDay) {}
+
+    char oldest[LOG_DAY_LEN] = "";
+    uint16_t waiting = 0;           // Dated shards past retention
+    bool undated = false;
+    bool legacy = false;            // Flat records from before sharding
+
+protected:
+    bool onToken(const JsonToken& token) override {
+        if (token.depth != 1) {
+            return true;
+        }
+        long day;
+        if (token.key[0] == '-') {
+            legacy = true;
+        } else if (strcmp(token.key, LOG_UNDATED_SHARD) == 0) {
+            undated = true;
+        } else if (parseLogDay(token.key, day) && day <= lastFoldDay) {
+            waiting++;
+            if (oldest[0] == '\0' || day < oldestDay) {
+                oldestDay = day;
+                strcpy(oldest, token.key);
+            }
+        }
+        return true;
+    }
+
+private:
+    long lastFoldDay;
+    long oldestDay = 0;
+};
+
+// Shallow listing of logSummaries: days past summary retention
+class ExpiredSummaryLister : public JsonScanner {
+public:
+    explicit ExpiredSummaryLister(long lastExpiredDay) : lastExpiredDay(lastExpiredDay) {}
+
+    char days[LOG_PRUNE_PER_PASS][LOG_DAY_LEN];
+    uint8_t count = 0;
+
+protected:
+    bool onToken(const JsonToken& token) override {
+        long day;
+        if (token.depth == 1 && parseLogDay(token.key, day) && day <= lastExpiredDay) {
+            strcpy(days[count], token.key);
+            return ++count < LOG_PRUNE_PER_PASS;
+        }
+        return true;
+    }
+
+private:
+    long lastExpiredDay;
+};
+
+// A stored summary, read back so a late shard adds to it instead of replacing it
+class SummaryReader : public JsonScanner {
+public:
+    explicit SummaryReader(LogSummary& summary) : summary(summary) {}
+
+protected:
+    bool onToken(const JsonToken& token) override {
+        if (token.type != JSON_NUMBER) {
+            return true;
+        }
+        unsigned long long value = strtoull(token.text, nullptr, 10);
+        const char* parent = keyAt(1);
+        if (token.depth == 1) {
+            if (strcmp(token.key, "records") == 0) summary.records = value;
+            else if (strcmp(token.key, "first") == 0) summary.first = value;
+            else if (strcmp(token.key, "last") == 0) summary.last = value;
+            else if (strcmp(token.key, "other") == 0) summary.other = addCount(0, value);
+        } else if (token.depth == 2 && strcmp(parent, "events") == 0) {
+            EventType type = eventTypeFromName(token.key);
+            if (type < EVT_COUNT) {
+                summary.counts[type] = addCount(0, value);
+            } else {
+                summary.other = addCount(summary.other, value);
+            }
+        } else if (token.depth == 2 && strcmp(parent, "tamper") == 0) {
+            if (strcmp(token.key, "episodes") == 0) summary.tamperEpisodes = addCount(0, value);
+            else if (strcmp(token.key, "first") == 0) summary.tamperFirst = value;
+            else if (strcmp(token.key, "last") == 0) summary.tamperLast = value;
+        }
+        return true;
+    }
+
+private:
+    LogSummary& summary;
+};
+
+enum FoldMode : uint8_t {
+    FOLD_SHARD,     // Every record of a day shard
+    FOLD_FLAT,      // A page of flat records of one day, in key order
+    FOLD_UNDATED    // A page of undated records of one day past raw retention
+};
+
+// Folds raw records into a summary as they stream past. For a page the keys
+// are kept so the records can be deleted, and all of them are of one day:
+// flat records are dated by their push IDs, undated ones by their timestamps.
+class RecordFolder : public JsonScanner {
+public:
+    RecordFolder(LogSummary& summary, FoldMode mode, long lastFoldDay = 0)
+        : summary(summary), mode(mode), lastFoldDay(lastFoldDay) {}
+
+    char keys[LOG_LEGACY_PAGE][21];
+    uint8_t keyCount = 0;
+    long pageDay = -1;              // -1 with keys taken: undated records without a timestamp
+    bool more = false;              // Records due for folding left for a later page
+
+    // Deleted keys are relative to logs
+    const char* keyPrefix() const {
+        return mode == FOLD_UNDATED ? LOG_UNDATED_SHARD "/" : "";
+    }
+
+    // Count the last record once the scan is over
+    void flush() {
+        if (!open) {
+            return;
+        }
+        open = false;
+        if (mode == FOLD_UNDATED && !takeUndated()) {
+            return;
+        }
+
+        EventType type = eventTypeFromName(name);
+        summary.records++;
+        if (type < EVT_COUNT) {
+            summary.counts[type] = addCount(summary.counts[type], 1);
+        } else {
+            summary.other = addCount(summary.other, 1);
+        }
+        mergeTime(summary.first, summary.last, timestamp, timestamp);
+
+        // A tamper episode starts when the enclosure stops being secure
+        if (type == EVT_SECURITY && secure >= 0) {
+            if (secure == 0 && !insecure) {
+                summary.tamperEpisodes = addCount(summary.tamperEpisodes, 1);
+                mergeTime(summary.tamperFirst, summary.tamperLast, timestamp, timestamp);
+            } else if (secure == 0) {
+                mergeTime(summary.tamperFirst, summary.tamperLast, 0, timestamp);
+            }
+            insecure = secure == 0;
+        }
+    }
+
+protected:
+    bool onToken(const JsonToken& token) override {
+        if (token.depth == 1 && token.type == JSON_OBJECT) {
+            flush();
+            if (mode == FOLD_FLAT && !takeFlatKey(token.key)) {
+                return false;
+            }
+            if (mode == FOLD_UNDATED) {
+                if (keyCount == LOG_LEGACY_PAGE) {
+                    more = true;
+                    return false;
+                }
+                if (strlen(token.key) >= sizeof(recordKey)) {
+                    return true;  // Not a push ID, not one of ours
+                }
+                strcpy(recordKey, token.key);
+            }
+            open = true;
+            name[0] = '\0';
+            timestamp = 0;
+            secure = -1;
+        } else if (token.depth == 2 && open) {
+            if (strcmp(token.key, "event") == 0 && token.type == JSON_STRING) {
+                strncpy(name, token.text, sizeof(name) - 1);
+                name[sizeof(name) - 1] = '\0';
+            } else if (strcmp(token.key, "timestamp") == 0 && token.type == JSON_NUMBER) {
+                timestamp = strtoull(token.text, nullptr, 10);
+            } else if (strcmp(token.key, "secure") == 0 && token.type == JSON_BOOL) {
+                secure = token.text[0] == 't' ? 1 : 0;
+            }
+        }
+        return true;
+    }
+
+private:
+    // Stop at a full page or at the first record of the next day
+    bool takeFlatKey(const char* key) {
+        unsigned long long timeMs;
+        if (keyCount == LOG_LEGACY_PAGE || strlen(key) != 20 || !pushIdTime(key, timeMs)) {
+            return false;
+        }
+        long day = (long)(timeMs / MS_PER_DAY);
+        if (keyCount > 0 && day != pageDay) {
+            return false;
+        }
+        pageDay = day;
+        strcpy(keys[keyCount++], key);
+        return true;
+    }
+
+    // The record's own timestamp dates it; its day is kept raw as long as a dated shard
+    bool takeUndated() {
+        long day = timestamp != 0 ? (long)(timestamp / MS_PER_DAY) : -1;
+        if (day > lastFoldDay) {
+            return false;
+        }
+        if (keyCount > 0 && day != pageDay) {
+            more = true;
+            return false;
+        }
+        pageDay = day;
+        strcpy(keys[keyCount++], recordKey);
+        return true;
+    }
+
+    LogSummary& summary;
+    FoldMode mode;
+    long lastFoldDay;
+    bool open = false;
+    char recordKey[21];
+    bool insecure = false;
+    char name[JSON_SCAN_VALUE_LEN + 1];
+    unsigned long long timestamp = 0;
+    int8_t secure = -1;
+};
+
+static int scanRecorded(const char* path, const char* query, JsonScanner& scanner) {
+    unsigned long started = millis();
+    int status = rtdbScan(path, query, scanner);
+    recordHttpOutcome(status, status == 200, started);
+    return status;
+}
+
+// Add folded records to the day's stored summary and drop them, in one multi-path PATCH
+static bool writeFold(const char* day, const LogSummary& folded, const RecordFolder* page) {
+    char summaryPath[CHILD_PATH_LEN];
+    if (!formatChildPath(summaryPath, sizeof(summaryPath), devicePaths.logSummaries, day)) {
+        return false;
+    }
+    LogSummary summary = {};
+    SummaryReader reader(summary);
+    if (scanRecorded(summaryPath, nullptr, reader) != 200) {
+        return false;
+    }
+    mergeSummary(summary, folded);
+
+    static LogFoldPayload payload;
+    char key[LOG_DAY_LEN + 24];
+    payload.reset();
+    payload.beginObject();
+    snprintf(key, sizeof(key), "logSummaries/%s", day);
+    writeLogSummary(payload, key, summary);
+    if (page != nullptr) {
+        for (uint8_t i = 0; i < page->keyCount; i++) {
+            snprintf(key, sizeof(key), "logs/%s%s", page->keyPrefix(), page->keys[i]);
+            payload.nullField(key);
+        }
+    } else {
+        snprintf(key, sizeof(key), "logs/%s", day);
+        payload.nullField(key);
+    }
+    payload.endObject();
+    if (!payload.ok()) {
+        Serial.println(F("❌ Payload overflow, write skipped"));
+        return false;
+    }
+
+    // Patched at the device root for atomicity; only the log nodes are affected
+    unsigned long started = millis();
+    int status = rtdbPatch(devicePaths.root, payload.data(), payload.length());
+    RtdbCache::invalidate(devicePaths.logs);
+    RtdbCache::invalidate(devicePaths.logSummaries);
+    bool ok = status >= 200 && status < 300;
+    recordHttpOutcome(status, ok, started);
+    return ok;
+}
+
+static bool foldShard(const char* day) {
+    char shardPath[CHILD_PATH_LEN];
+    if (!formatChildPath(shardPath, sizeof(shardPath), devicePaths.logs, day)) {
+        return false;
+    }
+    LogSummary folded = {};
+    RecordFolder folder(folded, FOLD_SHARD);
+    if (scanRecorded(shardPath, nullptr, folder) != 200) {
+        return false;
+    }
+    folder.flush();
+
+    if (!writeFold(day, folded, nullptr)) {
+        return false;
+    }
+    Serial.print(F("🗜️ Log shard folded: "));
+    Serial.print(day);
+    Serial.print(F(", records: "));
+    Serial.println(folded.records);
+    return true;
+}
+
+// Flat push-ID keys sort before the digit-led day shards
+static bool foldFlatPage() {
+    char query[96];
+    snprintf(query, sizeof(query), "&orderBy=%%22%%24key%%22&endAt=%%22-%%7E%%22&limitToFirst=%d", LOG_LEGACY_PAGE);
+    LogSummary folded = {};
+    RecordFolder folder(folded, FOLD_FLAT);
+    if (scanRecorded(devicePaths.logs, query, folder) != 200) {
+        return false;
+    }
+    folder.flush();
+    if (folder.keyCount == 0) {
+        return false;
+    }
+
+    char day[LOG_DAY_LEN];
+    formatDay(folder.pageDay, day);
+    if (!writeFold(day, folded, &folder)) {
+        return false;
+    }
+    Serial.print(F("🗜️ Flat log records folded into "));
+    Serial.print(day);
+    Serial.print(F(": "));
+    Serial.println(folder.keyCount);
+    return true;
+}
+
+// Undated records past raw retention, a page of one day per call; false when
+// none is due yet. Records without a timestamp go to logSummaries/undated.
+static bool foldUndatedPage(long lastFoldDay, bool& more) {
+    char shardPath[CHILD_PATH_LEN];
+    if (!formatChildPath(shardPath, sizeof(shardPath), devicePaths.logs, LOG_UNDATED_SHARD)) {
+        return false;
+    }
+    LogSummary folded = {};
+    RecordFolder folder(folded, FOLD_UNDATED, lastFoldDay);
+    if (scanRecorded(shardPath, nullptr, folder) != 200) {
+        return false;
+    }
+    folder.flush();
+    more = folder.more;
+    if (folder.keyCount == 0) {
+        return false;
+    }
+
+    char day[LOG_DAY_LEN];
+    if (folder.pageDay < 0) {
+        strcpy(day, LOG_UNDATED_SHARD);
+    } else {
+        formatDay(folder.pageDay, day);
+    }
+    if (writeFold(day, folded, &folder)) {
+        Serial.print(F("🗜️ Undated log records folded into "));
+        Serial.print(day);
+        Serial.print(F(": "));
+        Serial.println(folder.keyCount);
+    }
+    return true;
+}
+
+static void pruneSummaries(long today) {
+    ExpiredSummaryLister lister(today - logRetention.summaryDays);
+    if (scanRecorded(devicePaths.logSummaries, "&shallow=true", lister) != 200 || lister.count == 0) {
+        return;
+    }
+
+    LogPrunePayload payload;
+    payload.beginObject();
+    for (uint8_t i = 0; i < lister.count; i++) {
+        payload.nullField(lister.days[i]);
+    }
+    payload.endObject();
+    if (rtdbUpdate(devicePaths.logSummaries, payload)) {
+        Serial.print(F("🗑️ Expired log summaries deleted: "));
+        Serial.println(lister.count);
+    }
+}
+
+// One unit of work; true when more is waiting
+static bool rollupPass() {
+    long today = (long)(epochMillis() / MS_PER_DAY);
+    long lastFoldDay = today - logRetention.rawDays;
+    ShardLister lister(lastFoldDay);
+    if (scanRecorded(devicePaths.logs, "&shallow=true", lister) != 200) {
+        return false;
+    }
+
+    if (lister.legacy) {
+        foldFlatPage();
+        return true;
+    }
+    bool more = false;
+    if (lister.undated && foldUndatedPage(lastFoldDay, more)) {
+        return more || lister.waiting > 0;
+    }
+    if (lister.waiting > 0) {
+        foldShard(lister.oldest);
+        return lister.waiting > 1;
+    }
+
+    // Nothing to fold: the rare pass that also looks at old summaries
+    pruneSummaries(today);
+    return false;
+}
+
+void serviceLogRollup() {
+    static unsigned long lastPass = 0;
+    static unsigned long interval = LOG_ROLLUP_FIRST_DELAY_MS;
+
+    // Day keys need the clock; queued records could still belong to the shard being folded
+    if (millis() - lastPass < interval || !isEpochValid() || pendingEventCount() > 0) {
+        return;
+    }
+
+    lastPass = millis();
+    interval = rollupPass() ? LOG_ROLLUP_BUSY_MS : LOG_ROLLUP_INTERVAL_MS;
+}
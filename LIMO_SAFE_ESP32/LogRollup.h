@@ -0,0 +1,58 @@
+#ifndef LOG_ROLLUP_H
+#define LOG_ROLLUP_H
+
+#include <Arduino.h>
+#include "EventLogger.h"
+
+// Events are written under devices/<id>/logs/<yyyy-mm-dd>/<pushId>, one shard
+// per UTC day. Shards older than the raw retention are folded, one per pass,
+// into devices/<id>/logSummaries/<yyyy-mm-dd> (counts per event type, first
+// and last times, tamper episodes) and deleted; summaries older than their own
+// retention are deleted too. Every read is shallow or of a single shard, so
+// the work never depends on how much history the device has.
+//
+// Records uploaded before the clock was set go to logs/undated. They carry the
+// server's timestamp, so they are kept as long as a shard of that day and
+// then folded into its summary a page at a time. Flat records from before
+// sharding are folded into the summary of their day a page at a time too.
+#define LOG_RAW_DAYS 7                      // Days kept as raw records, today included
+#define LOG_SUMMARY_DAYS 365                // Days kept as summaries
+#define LOG_ROLLUP_INTERVAL_MS 3600000UL    // Between passes once nothing is left to fold
+#define LOG_ROLLUP_BUSY_MS 30000UL          // Between passes while shards are waiting
+#define LOG_ROLLUP_FIRST_DELAY_MS 300000UL  // After boot, leave the link to real traffic
+#define LOG_LEGACY_PAGE 16                  // Flat or undated records folded per pass
+#define LOG_PRUNE_PER_PASS 8                // Summaries deleted per pass
+#define LOG_DAY_LEN 11                      // "yyyy-mm-dd"
+#define LOG_UNDATED_SHARD "undated"
+
+struct LogRetention {
+    uint16_t rawDays;
+    uint16_t summaryDays;
+};
+
+extern LogRetention logRetention;
+
+// Retention, overridable per device (NVS or Firebase config/logs)
+void loadLogRetention();
+bool saveLogRetention(const LogRetention& retention);
+bool syncLogRetentionFromFirebase();
+
+// Shard key of the UTC day containing epochMs
+void formatLogDay(unsigned long long epochMs, char out[LOG_DAY_LEN]);
+
+// What a summary holds for one day; counts saturate rather than wrap
+struct LogSummary {
+    uint32_t records;
+    uint16_t counts[EVT_COUNT];
+    uint16_t other;                         // Names this firmware doesn't know
+    unsigned long long first;               // 0 = no timestamped record
+    unsigned long long last;
+    uint16_t tamperEpisodes;                // Secure -> not secure transitions
+    unsigned long long tamperFirst;
+    unsigned long long tamperLast;
+};
+
+// Fold one shard (or a page of flat records) per call - network task
+void serviceLogRollup();
+
+#endif
@@ -0,0 +1,192 @@
+#include "MqttTransport.h"
+#include "FirebaseHandler.h"
+#include "RequestDeadline.h"
+#include "RtdbCache.h"
+#include "secrets.h"
+#include <Preferences.h>
+#include <mqtt_client.h>
+#include <esp_crt_bundle.h>
+
+// Optional in secrets.h; without a broker every write goes over RTDB REST
+#ifndef MQTT_BROKER_URI
+#define MQTT_BROKER_URI ""
+#endif
+#ifndef MQTT_PASSWORD
+#define MQTT_PASSWORD ""
+#endif
+
+static esp_mqtt_client_handle_t client = nullptr;
+static volatile bool sessionUp = false;
+static volatile int lastAckedId = -1;
+static volatile int inFlightId = -1;    // QoS 1 message esp-mqtt still holds and retransmits
+static char brokerUri[MQTT_URI_LEN];
+static char clientId[DEVICE_ID_MAX_LEN + 8];
+static MqttStats stats = {};
+
+// Runs on the esp-mqtt task
+static void onMqttEvent(void*, esp_event_base_t, int32_t eventId, void* data) {
+    esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)data;
+    switch ((esp_mqtt_event_id_t)eventId) {
+        case MQTT_EVENT_CONNECTED:
+            sessionUp = true;
+            stats.connects++;
+            break;
+        case MQTT_EVENT_DISCONNECTED:
+            sessionUp = false;
+            break;
+        case MQTT_EVENT_PUBLISHED:
+            lastAckedId = event->msg_id;
+            if (event->msg_id == inFlightId) {
+                inFlightId = -1;
+            }
+            break;
+        case MQTT_EVENT_DELETED:
+            // Expired from the outbox unacknowledged; the records are still queued
+            if (event->msg_id == inFlightId) {
+                inFlightId = -1;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// devices/<id>/<node> -> limo/<id>/<node>; nothing outside the device node is published
+static bool formatTopic(char* out, size_t size, const char* path) {
+    size_t rootLength = strlen(devicePaths.root);
+    if (strncmp(path, devicePaths.root, rootLength) != 0 || path[rootLength] != '/') {
+        return false;
+    }
+    int length = snprintf(out, size, MQTT_TOPIC_PREFIX "%s%s", deviceId.c_str(), path + rootLength);
+    return length > 0 && length < (int)size;
+}
+
+class MqttTransport : public DeviceTransport {
+public:
+    const char* name() const override { return "mqtt"; }
+    bool isUp() override { return client != nullptr && sessionUp; }
+
+    bool update(const char* path, const JsonWriter& payload, TransportQos qos) override {
+        return payload.ok() && publish(path, payload.data(), payload.length(), qos);
+    }
+
+    bool carriesCbor() const override { return true; }
+
+    // The bridge tells the encodings apart by the first byte: '{' is never a CBOR map
+    bool updateCbor(const char* path, const CborWriter& payload, TransportQos qos) override {
+        return payload.ok() && publish(path, (const char*)payload.data(), payload.length(), qos);
+    }
+
+private:
+    bool publish(const char* path, const char* data, size_t length, TransportQos qos) {
+        char topic[MQTT_TOPIC_LEN];
+        if (!isUp() || !formatTopic(topic, sizeof(topic), path)) {
+            return false;
+        }
+
+        int level = qos == TRANSPORT_RELIABLE ? 1 : 0;
+        if (level == 1 && inFlightId >= 0) {
+            // esp-mqtt keeps retransmitting the last batch until the broker has it;
+            // publishing the records again beside it would only double the traffic
+            return false;
+        }
+        int msgId = esp_mqtt_client_publish(client, topic, data, (int)length, level, 0);
+        if (msgId < 0) {
+            return false;
+        }
+        stats.published++;
+        RtdbCache::invalidate(path);  // The bridge writes it into RTDB
+        if (level == 0) {
+            return true;
+        }
+
+        // The PUBACK may already have been handled by the time we get here
+        inFlightId = msgId;
+        if (lastAckedId == msgId) {
+            inFlightId = -1;
+        }
+
+        // Records stay queued until the broker has them. After a timeout they are
+        // published again once this message is settled; the record keys are fixed,
+        // so a batch that did arrive late is merely rewritten with the same data.
+        unsigned long deadline = millis() + requestTimeoutMs();
+        while (inFlightId == msgId) {
+            if ((long)(deadline - millis()) <= 0 || !sessionUp) {
+                stats.timeouts++;
+                return false;
+            }
+            delay(1);
+        }
+        if (lastAckedId != msgId) {
+            return false;  // Deleted from the outbox
+        }
+        stats.acked++;
+        return true;
+    }
+};
+
+static MqttTransport mqtt;
+
+DeviceTransport& mqttTransport() {
+    return mqtt;
+}
+
+const MqttStats& getMqttStats() {
+    return stats;
+}
+
+bool saveMqttBrokerUri(const char* uri) {
+    if (strlen(uri) >= MQTT_URI_LEN) {
+        Serial.println(F("❌ MQTT broker URI too long"));
+        return false;
+    }
+
+    Preferences transportPrefs;
+    if (!transportPrefs.begin(MQTT_NAMESPACE, false)) {
+        Serial.println(F("❌ Failed to access preferences for the MQTT broker"));
+        return false;
+    }
+    transportPrefs.putString(MQTT_PREF_URI, uri);
+    transportPrefs.end();
+    return true;
+}
+
+void initMqttTransport() {
+    if (client != nullptr) {
+        return;
+    }
+
+    String uri = MQTT_BROKER_URI;
+    Preferences transportPrefs;
+    if (transportPrefs.begin(MQTT_NAMESPACE, true)) {
+        uri = transportPrefs.getString(MQTT_PREF_URI, uri);
+        transportPrefs.end();
+    }
+    if (uri.isEmpty() || uri.length() >= MQTT_URI_LEN || deviceId.isEmpty()) {
+        return;  // RTDB only
+    }
+    strcpy(brokerUri, uri.c_str());
+    snprintf(clientId, sizeof(clientId), "limo-%s", deviceId.c_str());
+
+    esp_mqtt_client_config_t config = {};
+    config.broker.address.uri = brokerUri;
+    config.broker.verification.crt_bundle_attach = esp_crt_bundle_attach;
+    config.credentials.client_id = clientId;
+    config.credentials.username = clientId + 5;  // The device ID; the broker ACL limits it to limo/<id>/#
+    config.credentials.authentication.password = strlen(MQTT_PASSWORD) > 0 ? MQTT_PASSWORD : nullptr;
+    config.session.keepalive = MQTT_KEEPALIVE_S;
+    config.session.disable_clean_session = true;
+
+    client = esp_mqtt_client_init(&config);
+    if (client == nullptr) {
+        Serial.println(F("❌ MQTT client could not be created"));
+        return;
+    }
+    esp_mqtt_client_register_event(client, MQTT_EVENT_ANY, onMqttEvent, nullptr);
+    if (esp_mqtt_client_start(client) != ESP_OK) {
+        Serial.println(F("❌ MQTT client did not start"));
+        return;
+    }
+    Serial.print(F("📨 MQTT transport started: "));
+    Serial.println(brokerUri);
+}
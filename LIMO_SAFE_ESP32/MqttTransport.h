@@ -0,0 +1,43 @@
+#ifndef MQTT_TRANSPORT_H
+#define MQTT_TRANSPORT_H
+
+#include <Arduino.h>
+#include "DeviceTransport.h"
+#include "DevicePaths.h"
+
+// MQTT backend of DeviceTransport on the ESP-IDF client (esp-mqtt), which
+// keeps the TLS session up and reconnects on its own. A write to
+// devices/<id>/<node> is published to limo/<id>/<node>; the payload is the
+// JSON object a PATCH would carry, or for logs and status their CBOR schema,
+// so per message only a few bytes of MQTT framing and the topic go on the wire
+// besides the data itself. The session is persistent (clean
+// session off, fixed client ID), so QoS 1 messages in flight survive a
+// reconnect. The device logs in with its device ID as the username; the
+// broker must only let it publish under limo/<that id>/ (tools/mqtt_bridge.py).
+// One QoS 1 message is in flight at a time: after a timeout esp-mqtt keeps
+// retransmitting it, and nothing new is published until it is acked or expires.
+#define MQTT_NAMESPACE "transport"
+#define MQTT_PREF_URI "mqttUri"
+#define MQTT_URI_LEN 96
+#define MQTT_TOPIC_PREFIX "limo/"
+#define MQTT_TOPIC_LEN (DEVICE_PATH_LEN + 8)
+#define MQTT_KEEPALIVE_S 60
+
+struct MqttStats {
+    uint32_t connects;
+    uint32_t published;
+    uint32_t acked;       // QoS 1 messages the broker confirmed
+    uint32_t timeouts;    // QoS 1 messages left to the outbox; sent again once settled
+};
+
+// Start the broker session when a URI is configured: NVS transport/mqttUri,
+// else MQTT_BROKER_URI from secrets.h. Call after setupFirebase().
+void initMqttTransport();
+
+// "" turns MQTT off; applied by the next initMqttTransport()
+bool saveMqttBrokerUri(const char* uri);
+
+DeviceTransport& mqttTransport();
+const MqttStats& getMqttStats();
+
+#endif
@@ -3,6 +3,13 @@
 #include "WiFiSetup.h"
 #include "RGBLed.h"
 #include "FingerprintSensor.h"                                            
+#include "TelemetryCadence.h"
+#include "NetworkTask.h"
+#include "EventLogger.h"
+#include "UploadScheduler.h"
+#include "TotpVerifier.h"
+#include "AttemptLimiter.h"
+#include "RequestDeadline.h"
 
 //#define NanoSerial Serial
 HardwareSerial NanoSerial(1); // UART2 for Nano communication
@@ -10,31 +17,23 @@ HardwareSerial NanoSerial(1); // UART2 for Nano communication
 // Define global variables to track previous states
 bool prevSafeClosed = false;
 bool prevMotionDetected = false;
+bool prevOnline = false;
+bool nanoStateKnown = false;  // Set by the first status frame; until then there is nothing to report
 unsigned long lastStatusUpdateTime = 0;
 
-// Constants defined using F() macro to store in flash
-const unsigned long STATUS_UPDATE_INTERVAL = 1000;
-
-// Define event types
-#define EVENT_LOCKED      1
-#define EVENT_UNLOCKED    2
-#define EVENT_SECURED     3
-#define EVENT_COMPROMISED 4
-
-// Queue for pending log entries to prevent blocking
-#define MAX_LOG_QUEUE 10  // Increased size to handle separate events
-struct LogEntry {
-    bool isValid;
-    uint8_t eventType;     // Use event type constants
-    unsigned long timestamp;
-};
-LogEntry logQueue[MAX_LOG_QUEUE];
-uint8_t logQueueHead = 0;
-uint8_t logQueueTail = 0;
-
 // Flag for pending status update
 bool pendingStatusUpdate = false;
 bool pendingStatusValues[3]; // online, locked, secure
+uint32_t pendingStatusSeq = 0; // Bumped on every new status so the uploader never clears a newer one
+
+// The status is set on core 1 and uploaded by the network task on core 0
+portMUX_TYPE nanoStatusMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Set while an OTP is with the network task, so a second code is not queued behind it
+bool otpVerificationPending = false;
+char pendingOtpTag[2] = "";  // Tag of that code, for the attempt limiter
+int16_t pendingOtpCheck = 0;  // Number of that check; answers to older ones are dropped
+unsigned long pendingOtpDeadline = 0;
 
 // Track Firebase connection attempts
 unsigned long lastFirebaseConnectionAttempt = 0;
@@ -44,38 +43,40 @@ void setupNanoCommunication() {
     //NanoSerial.begin(115200);
     NanoSerial.begin(SERIAL2_BAUD, SERIAL_8N1, SERIAL2_RX, SERIAL2_TX);
     Serial.println(F("✅ Nano UART Initialized"));
-    
-    // Initialize log queue
-    for (int i = 0; i < MAX_LOG_QUEUE; i++) {
-        logQueue[i].isValid = false;
-    }
-}
-
-// Check if log queue is full
-bool isLogQueueFull() {
-    return (logQueueTail + 1) % MAX_LOG_QUEUE == logQueueHead;
 }
 
-// Check if log queue is empty
-bool isLogQueueEmpty() {
-    return logQueueHead == logQueueTail;
+// State changes go out immediately; otherwise the cadence backs off while idle
+static void queueStatusUpdate(bool online, bool stateChanged) {
+    bool locked = prevSafeClosed;
+    bool secure = !prevMotionDetected;
+    unsigned long currentTime = millis();
+    if (stateChanged) {
+        resetStatusBackoff();
+    }
+    if (stateChanged || currentTime - lastStatusUpdateTime >= statusIntervalFor(locked, secure)) {
+        lastStatusUpdateTime = currentTime;
+        noteStatusQueued(locked, secure);
+        
+        // Queue status update instead of immediately updating
+        portENTER_CRITICAL(&nanoStatusMux);
+        pendingStatusUpdate = true;
+        pendingStatusValues[0] = online;
+        pendingStatusValues[1] = locked;
+        pendingStatusValues[2] = secure;
+        pendingStatusSeq++;
+        portEXIT_CRITICAL(&nanoStatusMux);
+    }
 }
 
-// Add an event to the log queue
-bool queueLogEvent(uint8_t eventType) {
-    // If full, overwrite oldest entry
-    if (isLogQueueFull()) {
-        // Move head forward, effectively discarding oldest entry
-        logQueueHead = (logQueueHead + 1) % MAX_LOG_QUEUE;
-        Serial.println(F("⚠️ Log queue full! Overwriting oldest entry."));
+void checkOnlineStatus() {
+    if (!nanoStateKnown) {
+        return;
+    }
+    bool online = isFirebaseReady();
+    if (online != prevOnline) {
+        prevOnline = online;
+        queueStatusUpdate(online, true);
     }
-    
-    logQueue[logQueueTail].isValid = true;
-    logQueue[logQueueTail].eventType = eventType;
-    logQueue[logQueueTail].timestamp = isTimeSynchronized(); // Get proper timestamp
-    
-    logQueueTail = (logQueueTail + 1) % MAX_LOG_QUEUE;
-    return true;
 }
 
 void handleNanoData() {
@@ -157,45 +158,38 @@ void handleNanoData() {
         }
     }
     
+    // Define current device status
+    bool online = isFirebaseReady();  // Device is online only if Firebase is ready
+    bool stateChanged = (isSafeClosed != prevSafeClosed) ||
+                        (motionDetected != prevMotionDetected) ||
+                        (online != prevOnline);
+    
     // Log state transitions separately
     // Lock state transitions
     if (isSafeClosed && !prevSafeClosed) {
-        queueLogEvent(EVENT_LOCKED);
+        logFlagEvent(EVT_LOCK, true);
         Serial.println(F("Event logged: LOCKED"));
     } else if (!isSafeClosed && prevSafeClosed) {
-        queueLogEvent(EVENT_UNLOCKED);
+        logFlagEvent(EVT_LOCK, false);
         Serial.println(F("Event logged: UNLOCKED"));
     }
     
     // Security state transitions
     if (!motionDetected && prevMotionDetected) {
-        queueLogEvent(EVENT_SECURED);
+        logFlagEvent(EVT_SECURITY, true);
         Serial.println(F("Event logged: SECURED"));
     } else if (motionDetected && !prevMotionDetected) {
-        queueLogEvent(EVENT_COMPROMISED);
+        logFlagEvent(EVT_SECURITY, false);
         Serial.println(F("Event logged: COMPROMISED"));
     }
     
     // Update previous states immediately so we don't queue duplicates
     prevSafeClosed = isSafeClosed;
     prevMotionDetected = motionDetected;
+    prevOnline = online;
+    nanoStateKnown = true;
     
-    // Define current device status
-    bool online = isFirebaseReady();  // Device is online only if Firebase is ready
-    bool locked = isSafeClosed;
-    bool secure = !motionDetected;
-    
-    // Handle periodic status updates separately from event logging
-    unsigned long currentTime = millis();
-    if (currentTime - lastStatusUpdateTime >= STATUS_UPDATE_INTERVAL) {
-        lastStatusUpdateTime = currentTime;
-        
-        // Queue status update instead of immediately updating
-        pendingStatusUpdate = true;
-        pendingStatusValues[0] = online;
-        pendingStatusValues[1] = locked;
-        pendingStatusValues[2] = secure;
-    }
+    queueStatusUpdate(online, stateChanged);
 }
 
 // Process OTP command received from Nano
@@ -205,29 +199,146 @@ void processNanoCommand(const String& command) {
         Serial.print(F("🔑 Received OTP code from Nano: "));
         Serial.println(command);
         
-        // Verify OTP code using Firebase
-        if (verifyOTP(command)) {
-            // Send validation response back to Nano
-            sendCommandToNano("UNLOCK");
-            setLEDStatus(STATUS_UNLOCKED);
-            delay(2000);
-            Serial.println(F("✅ OTP verified successfully, sent confirmation to Nano"));
-
+        if (otpVerificationPending) {
+            Serial.println(F("⚠️ OTP verification already in progress, code ignored"));
+            return;
+        }
+        
+        // Locked-out tags are refused before any network I/O
+        char userTag[2] = { command[0], '\0' };
+        unsigned long retryInMs;
+        if (!AttemptLimiter::allow(userTag, retryInMs)) {
+            sendCommandToNano("OTP_INVALID");
+            setLEDStatus(STATUS_OTP_ERROR);
+            Serial.print(F("🔒 Too many failed OTP attempts, retry in "));
+            Serial.print((retryInMs + 999) / 1000);
+            Serial.println(F(" s"));
+            return;
+        }
+        
+        // A provisioned TOTP secret answers without the network
+        char userId[AUTH_USER_ID_LEN];
+        TotpResult local = TotpVerifier::verify(userTag, command.c_str() + 1, userId);
+        if (local != TOTP_UNAVAILABLE) {
+            EventRecord event = makeEvent(local == TOTP_VALID ? EVT_OTP_VERIFIED : EVT_OTP_VERIFICATION_FAILED);
+            if (local == TOTP_VALID) {
+                SET_EVENT_TEXT(event.userId, userId);
+            }
+            SET_EVENT_TEXT(event.tag, userTag);
+            SET_EVENT_TEXT(event.detail, "totp");
+            
+            strcpy(pendingOtpTag, userTag);
+            onOTPVerificationResult(local == TOTP_VALID ? OTP_AUTHORIZED : OTP_REJECTED);
+            logEvent(event);  // Stamped before the unlock, queued after it
+            return;
+        }
+        
+        // Hand the code to the network task; the answer arrives in onOTPVerificationResult()
+        NetRequest request = {};
+        request.type = NET_VERIFY_OTP;
+        strncpy(request.text, command.c_str(), sizeof(request.text) - 1);
+        request.deadlineMs = millis() + OTP_DEADLINE_MS;  // Time spent queued counts too
+        request.value = pendingOtpCheck + 1;
+        
+        if (postNetRequest(request)) {
+            otpVerificationPending = true;
+            strcpy(pendingOtpTag, userTag);
+            pendingOtpCheck = request.value;
+            pendingOtpDeadline = request.deadlineMs;
         } else {
-            // Send invalid response back to Nano
             sendCommandToNano("OTP_INVALID");
-            Serial.println(F("❌ Invalid OTP code, sent rejection to Nano"));
-
+            Serial.println(F("❌ Network busy, sent rejection to Nano"));
         }
     } else {
         Serial.println(F("❌ Received invalid command format from Nano"));
     }
 }
 
+// Completion of NET_VERIFY_OTP, called from loop() on core 1
+void onOTPNetworkResult(const NetResult& result) {
+    if (!otpVerificationPending || result.ref != pendingOtpCheck) {
+        Serial.println(F("⚠️ Late OTP result ignored"));
+        return;
+    }
+    onOTPVerificationResult((OtpOutcome)result.value);
+}
+
+// A lost result must not hold the keypad forever - call every loop()
+void checkPendingOTP() {
+    if (otpVerificationPending && (long)(millis() - (pendingOtpDeadline + NET_OTP_RESULT_SLACK_MS)) >= 0) {
+        onOTPVerificationResult(OTP_UNAVAILABLE);
+    }
+}
+
+void onOTPVerificationResult(OtpOutcome outcome) {
+    otpVerificationPending = false;
+    bool verified = outcome == OTP_AUTHORIZED;
+    
+    // Answer the Nano first; the limiter may write to flash
+    if (verified) {
+        sendCommandToNano("UNLOCK");
+        setLEDStatus(STATUS_UNLOCKED);
+    } else {
+        sendCommandToNano("OTP_INVALID");
+        setLEDStatus(STATUS_OTP_ERROR);
+    }
+    
+    // A check that never got a verdict is not a failed guess
+    if (outcome != OTP_UNAVAILABLE) {
+        AttemptLimiter::recordResult(pendingOtpTag, verified);
+    }
+    
+    if (verified) {
+        delay(2000);
+        Serial.println(F("✅ OTP verified successfully, sent confirmation to Nano"));
+    } else if (outcome == OTP_UNAVAILABLE) {
+        Serial.println(F("⌛ OTP could not be checked in time, sent rejection to Nano"));
+    } else {
+        Serial.println(F("❌ Invalid OTP code, sent rejection to Nano"));
+    }
+}
+
+// Status class for the upload scheduler; only the newest status is ever sent
+bool hasPendingStatus() {
+    portENTER_CRITICAL(&nanoStatusMux);
+    bool pending = pendingStatusUpdate;
+    portEXIT_CRITICAL(&nanoStatusMux);
+    return pending;
+}
+
+UploadResult uploadPendingStatus() {
+    // Snapshot the pending status so core 1 can keep updating it during the request
+    bool statusPending;
+    bool statusValues[3];
+    uint32_t statusSeq;
+    portENTER_CRITICAL(&nanoStatusMux);
+    statusPending = pendingStatusUpdate;
+    statusValues[0] = pendingStatusValues[0];
+    statusValues[1] = pendingStatusValues[1];
+    statusValues[2] = pendingStatusValues[2];
+    statusSeq = pendingStatusSeq;
+    portEXIT_CRITICAL(&nanoStatusMux);
+    
+    if (!statusPending) {
+        return UPLOAD_IDLE;
+    }
+    
+    if (!updateDeviceStatus(statusValues[0], statusValues[1], statusValues[2])) {
+        return UPLOAD_FAILED;
+    }
+    
+    // Keep the flag if a newer status arrived while we were uploading
+    portENTER_CRITICAL(&nanoStatusMux);
+    if (pendingStatusSeq == statusSeq) {
+        pendingStatusUpdate = false;
+    }
+    portEXIT_CRITICAL(&nanoStatusMux);
+    return UPLOAD_OK;
+}
+
 // Process any pending Firebase operations
-// Modified processFirebaseQueue() function with proper Firebase readiness checks
+// Runs on the network task; pacing and ordering are left to the upload scheduler
 void processFirebaseQueue() {
-    static unsigned long lastFirebaseOpTime = 0;
     static unsigned long lastFirebaseRetryTime = 0;
     static unsigned long lastReportTime = 0;
     static bool firebaseErrorLogged = false;
@@ -236,11 +347,6 @@ void processFirebaseQueue() {
     // Define report interval for limiting status messages
     const unsigned long REPORT_INTERVAL = 30000; // Only report every 30 seconds
     
-    // Add a small delay between Firebase operations to prevent overwhelming
-    if (currentTime - lastFirebaseOpTime < 200) {
-        return;
-    }
-    
     // Skip ALL operations if Firebase is not ready, but retry connection periodically
     if (!isFirebaseReady()) {
         if (currentTime - lastFirebaseRetryTime >= FIREBASE_RECONNECT_INTERVAL) {
@@ -263,108 +369,22 @@ void processFirebaseQueue() {
         firebaseErrorLogged = false;
     }
     
-    // Process pending status update first (higher priority)
-    if (pendingStatusUpdate) {
-        // Double-check Firebase is ready right before the operation
-        if (isFirebaseReady()) {
-            bool updateResult = updateDeviceStatus(pendingStatusValues[0], pendingStatusValues[1], pendingStatusValues[2]);
-            
-            if (updateResult) {
-                pendingStatusUpdate = false;
-                lastFirebaseOpTime = currentTime;
-            } else {
-                // Only report status update failures periodically to avoid flooding serial output
-                if (currentTime - lastReportTime >= REPORT_INTERVAL) {
-                    Serial.println(F("⚠️ Status updates pending"));
-                    lastReportTime = currentTime;
-                }
-                
-                lastFirebaseOpTime = currentTime;
-            }
-        } else {
-            // Firebase became disconnected between checks
-            if (currentTime - lastReportTime >= REPORT_INTERVAL) {
-                Serial.println(F("⚠️ Firebase disconnected - status update deferred"));
-                lastReportTime = currentTime;
-            }
-        }
-        return; // Process one operation per call to avoid blocking
-    }
+    processUploads();
     
-    // Process log queue if not empty and no status update is pending
-    if (!isLogQueueEmpty()) {
-        // Double-check Firebase is ready right before operation
-        if (isFirebaseReady()) {
-            LogEntry &entry = logQueue[logQueueHead];
-            
-            if (entry.isValid) {
-                // Construct Firebase path - use existing logs node
-                char logsPath[64];
-                snprintf(logsPath, sizeof(logsPath), "%s%s/logs", DEVICE_PATH, deviceId);
-                Serial.println(logsPath);
-                // Use static FirebaseJson to avoid repeated allocations
-                static FirebaseJson logJson;
-                logJson.clear();
-                logJson.set("timestamp", isTimeSynchronized()); // Get proper timestamp
-                
-                // Set appropriate fields based on event type
-                switch(entry.eventType) {
-                    case EVENT_LOCKED:
-                        logJson.set("locked", true);
-                        logJson.set("event", "lock");
-                        break;
-                    case EVENT_UNLOCKED:
-                        logJson.set("locked", false);
-                        logJson.set("event", "lock");
-                        break;
-                    case EVENT_SECURED:
-                        logJson.set("secure", true);
-                        logJson.set("event", "security");
-                        break;
-                    case EVENT_COMPROMISED:
-                        logJson.set("secure", false);
-                        logJson.set("event", "security");
-                        break;
-                }
-                
-                if (Firebase.RTDB.pushJSON(&fbdo, logsPath, &logJson)) {
-                    Serial.println(F("✅ Log entry added to Firebase"));
-                    
-                    // Mark as processed and move head
-                    entry.isValid = false;
-                    logQueueHead = (logQueueHead + 1) % MAX_LOG_QUEUE;
-                    lastFirebaseOpTime = currentTime;
-                } else {
-                    // Don't print detailed error messages to avoid blocking
-                    // Just report queue size periodically to indicate backlog
-                    if (currentTime - lastReportTime >= REPORT_INTERVAL) {
-                        uint8_t queueSize = (logQueueTail >= logQueueHead) ? 
-                            (logQueueTail - logQueueHead) : 
-                            (MAX_LOG_QUEUE - logQueueHead + logQueueTail);
-                        
-                        Serial.print(F("⚠️ Log entries queued: "));
-                        Serial.println(queueSize);
-                        lastReportTime = currentTime;
-                    }
-                    
-                    // Will retry on next call
-                    lastFirebaseOpTime = currentTime;
-                }
-            }
-        } else {
-            // Firebase became disconnected between checks
-            if (currentTime - lastReportTime >= REPORT_INTERVAL) {
-                Serial.println(F("⚠️ Firebase disconnected - log entry deferred"));
-                lastReportTime = currentTime;
-            }
-        }
+    // Just report the backlog periodically to avoid flooding serial output
+    if (pendingEventCount() > 0 && currentTime - lastReportTime >= REPORT_INTERVAL) {
+        Serial.print(F("⚠️ Log entries queued: "));
+        Serial.print(pendingEventCount());
+        Serial.print(F(", upload rate/s: "));
+        Serial.println(currentUploadRate());
+        lastReportTime = currentTime;
     }
 }
 
 void logStateChange(bool isClosed, bool isSecure) {
     // Log both state types
-    queueLogEvent(isClosed ? EVENT_LOCKED : EVENT_UNLOCKED);
-    queueLogEvent(isSecure ? EVENT_SECURED : EVENT_COMPROMISED);
+    logFlagEvent(EVT_LOCK, isClosed);
+    logFlagEvent(EVT_SECURITY, isSecure);
 }
 
 void sendCommandToNano(const char* command) {
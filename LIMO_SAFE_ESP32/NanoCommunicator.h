@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <Firebase_ESP_Client.h>
 #include "FirebaseHandler.h"
+#include "NetworkTask.h"
 
 // **Ensure these values are defined**
 #define SERIAL2_RX 16    // ESP32's RX pin connected to Nano's TX
@@ -13,9 +14,13 @@
 // Function declarations
 void setupNanoCommunication();
 void handleNanoData();
+void checkOnlineStatus(); // Queue a status update when the link came up or went down between Nano frames
 void logStateChange(bool isClosed, bool isSecure);
 void processFirebaseQueue();
 void sendCommandToNano(const char* command);
 void processNanoCommand(const String& command);
+void onOTPVerificationResult(OtpOutcome outcome);
+void onOTPNetworkResult(const NetResult& result);  // Drops answers to checks already written off
+void checkPendingOTP(); // Give up on a network OTP check past its deadline
 
 #endif
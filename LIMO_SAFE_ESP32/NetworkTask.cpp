@@ -0,0 +1,196 @@
+#include "NetworkTask.h"
+#include "FirebaseHandler.h"
+#include "NanoCommunicator.h"
+#include "FingerprintSensor.h"
+#include "DeviceStreams.h"
+#include "WiFiSetup.h"
+#include "TimeBase.h"
+#include "TotpVerifier.h"
+#include "LogRollup.h"
+#include "RtdbFlow.h"
+#include <WiFi.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+// Timing for the network task loop
+const unsigned long NET_IDLE_WAIT_MS = 20;                // Max wait for a request before servicing
+const unsigned long FIREBASE_CHECK_INTERVAL = 5000;       // Connection check every 5 seconds
+
+QueueHandle_t netRequestQueue = NULL;
+QueueHandle_t netResultQueue = NULL;
+TaskHandle_t netTaskHandle = NULL;
+
+// The OTP check being run; postOtpAuthorized() answers it from inside verifyOTP()
+static NetRequest currentOtp;
+
+// Core 1 writes the check off once it is past its deadline, so keep trying
+// until then rather than leave the keypad without an answer
+static void postOtpOutcome(OtpOutcome outcome) {
+    NetResult result = {};
+    result.type = NET_RESULT_OTP;
+    result.value = outcome;
+    result.flag = outcome == OTP_AUTHORIZED;
+    result.ref = currentOtp.value;
+    while (!postNetResult(result)) {
+        if ((long)(millis() - (currentOtp.deadlineMs + NET_OTP_RESULT_SLACK_MS)) >= 0) {
+            Serial.println(F("❌ OTP result dropped, the keypad has been answered"));
+            return;
+        }
+    }
+}
+
+static void postOtpAuthorized() {
+    postOtpOutcome(OTP_AUTHORIZED);
+}
+
+// Execute one request from core 1 (always on the network task)
+static void processNetRequest(const NetRequest& request) {
+    switch (request.type) {
+        case NET_VERIFY_OTP: {
+            currentOtp = request;
+            // An accepted code is answered from inside verifyOTP(), ahead of its writes
+            OtpOutcome outcome = verifyOTP(String(request.text), request.deadlineMs, postOtpAuthorized);
+            if (outcome != OTP_AUTHORIZED) {
+                postOtpOutcome(outcome);
+            }
+            break;
+        }
+        case NET_WIFI_STATUS:
+            updateFirebaseWiFiStatus(request.flag);
+            break;
+        case NET_FP_AUTH_LOG:
+            logAuthenticationEvent(request.flag, request.value);
+            break;
+        case NET_FP_ENROLL_RESULT:
+            updateFingerprintStatus(String(request.text), request.value, request.flag);
+            break;
+        case NET_FP_DELETE_RESULT:
+            syncFingerprintDeletion(request);
+            break;
+        case NET_FP_RESET_RESULT:
+            logFingerprintReset(String(request.text), request.flag);
+            break;
+    }
+}
+
+// Periodic cloud work that used to run inline in loop()
+static void serviceNetwork() {
+    static unsigned long lastFirebaseCheck = 0;
+    static bool lastKnownFirebaseStatus = false;
+
+    unsigned long currentMillis = millis();
+    bool wifiConnected = WiFi.isConnected();
+
+    if (currentMillis - lastFirebaseCheck >= FIREBASE_CHECK_INTERVAL) {
+        lastFirebaseCheck = currentMillis;
+        lastKnownFirebaseStatus = wifiConnected && checkFirebaseConnection();
+    }
+
+    // Follow SNTP corrections; no network access
+    serviceTimeBase();
+    
+    // Refresh the readiness flag that core 1 reads through isFirebaseReady()
+    isFirebaseReady();
+
+    if (!wifiConnected || !lastKnownFirebaseStatus) {
+        return;
+    }
+
+    handleDeviceStreams();
+    checkPeriodicWiFiCredentials();
+    serviceRtdbFlows();  // One step of the multi-request flows
+    TotpVerifier::serviceSync();
+    checkForCommands();
+    processFirebaseQueue();
+    serviceLogRollup();
+}
+
+static void networkTask(void*) {
+    Serial.print(F("🌐 Network task running on core "));
+    Serial.println(xPortGetCoreID());
+
+    for (;;) {
+        NetRequest request;
+
+        // Firebase client waits follow the RTT estimate
+        applyFirebaseTimeouts();
+
+        // User-facing requests first, then background work between them
+        if (xQueueReceive(netRequestQueue, &request, pdMS_TO_TICKS(NET_IDLE_WAIT_MS)) == pdTRUE) {
+            processNetRequest(request);
+        }
+        serviceNetwork();
+    }
+}
+
+void startNetworkTask() {
+    if (netTaskHandle != NULL) {
+        return;
+    }
+
+    netRequestQueue = xQueueCreate(NET_REQUEST_QUEUE_LENGTH, sizeof(NetRequest));
+    netResultQueue = xQueueCreate(NET_RESULT_QUEUE_LENGTH, sizeof(NetResult));
+    if (netRequestQueue == NULL || netResultQueue == NULL) {
+        Serial.println(F("❌ Failed to create network queues"));
+        return;
+    }
+
+    BaseType_t created = xTaskCreatePinnedToCore(
+        networkTask, "network", NET_TASK_STACK_SIZE, NULL,
+        NET_TASK_PRIORITY, &netTaskHandle, NET_TASK_CORE);
+
+    if (created != pdPASS) {
+        Serial.println(F("❌ Failed to start network task"));
+        netTaskHandle = NULL;
+    }
+}
+
+bool isNetworkTaskRunning() {
+    return netTaskHandle != NULL;
+}
+
+bool isNetworkTaskContext() {
+    return netTaskHandle != NULL && xTaskGetCurrentTaskHandle() == netTaskHandle;
+}
+
+// Never blocks the caller; a full queue drops the request
+bool postNetRequest(const NetRequest& request) {
+    if (netRequestQueue == NULL || xQueueSend(netRequestQueue, &request, 0) != pdTRUE) {
+        Serial.println(F("⚠️ Network request queue full"));
+        return false;
+    }
+    return true;
+}
+
+bool postNetResult(const NetResult& result) {
+    if (netResultQueue == NULL) {
+        return false;
+    }
+
+    // Results are few and small; wait briefly rather than lose an OTP outcome
+    if (xQueueSend(netResultQueue, &result, pdMS_TO_TICKS(100)) != pdTRUE) {
+        Serial.println(F("⚠️ Network result queue full"));
+        return false;
+    }
+    return true;
+}
+
+// Dispatch completions on core 1 - call every loop()
+void handleNetworkResults() {
+    if (netResultQueue == NULL) {
+        return;
+    }
+
+    NetResult result;
+    while (xQueueReceive(netResultQueue, &result, 0) == pdTRUE) {
+        switch (result.type) {
+            case NET_RESULT_OTP:
+                onOTPNetworkResult(result);
+                break;
+            case NET_EVENT_FP_COMMAND:
+                onFingerprintCommand(result);
+                break;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef NETWORK_TASK_H
+#define NETWORK_TASK_H
+
+#include <Arduino.h>
+
+// The network task runs on core 0 and owns the Firebase client (fbdo, streams,
+// upload queue). loop() on core 1 posts NetRequests and receives NetResults.
+#define NET_TASK_CORE 0
+#define NET_TASK_STACK_SIZE 16384
+#define NET_TASK_PRIORITY 1
+#define NET_REQUEST_QUEUE_LENGTH 8
+#define NET_RESULT_QUEUE_LENGTH 8
+
+#define NET_TEXT_LEN 48   // OTP codes and Firebase user IDs (28 chars)
+#define NET_MAX_IDS 16    // Fingerprint IDs carried by one request/result
+
+// Past an OTP check's deadline by this much, core 1 stops waiting for the answer
+#define NET_OTP_RESULT_SLACK_MS 1000UL
+
+// Work posted from core 1 to the network task
+enum NetRequestType : uint8_t {
+    NET_VERIFY_OTP,          // text = received OTP, value = check number, deadlineMs = when the answer is due
+    NET_WIFI_STATUS,         // flag = connected
+    NET_FP_AUTH_LOG,         // flag = success, value = fingerprint ID
+    NET_FP_ENROLL_RESULT,    // text = userId, value = fingerprint ID (-1 = no slot), flag = success
+    NET_FP_DELETE_RESULT,    // text = userId, value = FingerprintCommand, flag = user had fingerprints, ids = deleted, count/successCount
+    NET_FP_RESET_RESULT      // text = userId, flag = success
+};
+
+// Completions and events posted from the network task to core 1
+enum NetResultType : uint8_t {
+    NET_RESULT_OTP,          // value = OtpOutcome, flag = authorised, ref = check number
+    NET_EVENT_FP_COMMAND     // value = FingerprintCommand, text = userId, ids, flag = user has fingerprints
+};
+
+// Fingerprint commands read from devices/<id>/fingerprint
+enum FingerprintCommand : uint8_t {
+    FP_CMD_ENROLL,
+    FP_CMD_DELETE_USER,
+    FP_CMD_DELETE_IDS,
+    FP_CMD_RESET
+};
+
+struct NetRequest {
+    NetRequestType type;
+    bool flag;
+    int16_t value;
+    int16_t count;
+    int16_t successCount;
+    uint8_t idCount;
+    int16_t ids[NET_MAX_IDS];
+    char text[NET_TEXT_LEN];
+    unsigned long deadlineMs;  // millis(); 0 = none
+};
+
+struct NetResult {
+    NetResultType type;
+    bool flag;
+    int16_t value;
+    int16_t ref;
+    uint8_t idCount;
+    int16_t ids[NET_MAX_IDS];
+    char text[NET_TEXT_LEN];
+};
+
+void startNetworkTask();
+bool isNetworkTaskRunning();
+bool isNetworkTaskContext();
+
+// Core 1 side
+bool postNetRequest(const NetRequest& request);
+void handleNetworkResults();
+
+// Network task side
+bool postNetResult(const NetResult& result);
+
+#endif
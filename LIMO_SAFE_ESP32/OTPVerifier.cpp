@@ -1,7 +1,21 @@
 #include "OTPVerifier.h"
 #include "FirebaseHandler.h"
+#include "DevicePaths.h"
 #include "UserManager.h"
 #include "RGBLed.h"
+#include "WiFiSetup.h"
+#include "RtdbRest.h"
+#include "JsonScanner.h"
+#include "ConnectionHealth.h"
+#include "NetworkTask.h"
+#include <mbedtls/md.h>
+#include <Preferences.h>
+
+// Preferences namespace and key for the per-device index flag
+#define OTP_NAMESPACE "otp"
+#define OTP_PREF_INDEXED "indexed"
+
+static bool otpIndexEnabled = false;
 
 bool OTPVerifier::validateFormat(const String& receivedOTP, String& userTag, String& actualOTP) {
     // Early return for invalid length
@@ -16,69 +30,192 @@ bool OTPVerifier::validateFormat(const String& receivedOTP, String& userTag, Str
     return true;
 }
 
-bool OTPVerifier::verifyOTPCode(FirebaseData& fbdo, const String& userTag, const String& inputOTP, String& userId, String& storedOTP) {
-    // Pre-check connectivity to fail fast
-    if (WiFi.status() != WL_CONNECTED || !Firebase.ready()) {
-        Serial.println(F("❌ Network not ready for OTP verification"));
+bool OTPVerifier::findUserIdByTag(const String& userTag, String& userId) {
+    return UserManager::findUserIdByTag(userTag, userId);
+}
+
+bool OTPVerifier::verifyOTPForUser(const String& userId, const String& inputOTP, String& storedOTP) {
+    // Use static buffer for path to avoid String concatenation
+    char otpPath[64];
+    snprintf(otpPath, sizeof(otpPath), "users/%s/otp", userId.c_str());
+    
+    // Over the REST connection, so the read honours the caller's deadline
+    char code[NET_TEXT_LEN];
+    JsonField field = { "code", code, sizeof(code) };
+    JsonFieldExtractor extractor(&field, 1);
+    unsigned long started = millis();
+    int status = rtdbScan(otpPath, nullptr, extractor);
+    recordHttpOutcome(status, status == 200, started);
+    if (status != 200 || !field.found) {
+        Serial.print(F("❌ Error fetching OTP: "));
+        Serial.println(status);
         return false;
     }
     
-    // Build query once
-    QueryFilter query;
-    query.orderBy("tag");
-    query.equalTo(userTag);
-    query.limitToFirst(1);  // Only need one result
+    storedOTP = code;
     
-    // Fetch user with optimized error handling
-    if (!Firebase.RTDB.getJSON(&fbdo, "users", &query)) {
-        Serial.print(F("❌ Firebase Query Failed: "));
-        Serial.println(fbdo.errorReason());
+    // Compare OTP efficiently
+    if (inputOTP.equals(storedOTP)) {
+        Serial.println(F("✅ OTP Verified Successfully!"));
+        return true;
+    }
+    
+    Serial.println(F("❌ OTP Mismatch!"));
+    return false;
+}
+
+void OTPVerifier::hashOTP(const String& deviceId, const String& otp, char out[65]) {
+    String input = deviceId + ":" + otp;
+    unsigned char digest[32];
+    
+    mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+               (const unsigned char*)input.c_str(), input.length(), digest);
+    
+    static const char hexDigits[] = "0123456789abcdef";
+    for (int i = 0; i < 32; i++) {
+        out[i * 2] = hexDigits[digest[i] >> 4];
+        out[i * 2 + 1] = hexDigits[digest[i] & 0x0F];
+    }
+    out[64] = '\0';
+}
+
+// Compare without an early exit so timing doesn't leak how much of the hash matched
+static bool hashEquals(const char* expected, const String& actual) {
+    if (actual.length() != 64) {
+        return false;
+    }
+    uint8_t diff = 0;
+    for (int i = 0; i < 64; i++) {
+        diff |= expected[i] ^ tolower(actual.charAt(i));
+    }
+    return diff == 0;
+}
+
+void OTPVerifier::loadIndexConfig() {
+    Preferences otpPrefs;
+    if (otpPrefs.begin(OTP_NAMESPACE, true)) {
+        otpIndexEnabled = otpPrefs.getBool(OTP_PREF_INDEXED, false);
+        otpPrefs.end();
+    }
+}
+
+bool OTPVerifier::saveIndexConfig(bool indexed) {
+    Preferences otpPrefs;
+    if (!otpPrefs.begin(OTP_NAMESPACE, false)) {
+        Serial.println(F("❌ Failed to access preferences for the OTP index flag"));
         return false;
     }
+    otpPrefs.putBool(OTP_PREF_INDEXED, indexed);
+    otpPrefs.end();
     
-    // Process JSON response more efficiently
-    FirebaseJson& json = fbdo.jsonObject();
-    size_t len = json.iteratorBegin();
+    otpIndexEnabled = indexed;
+    return true;
+}
+
+// Pull devices/<id>/config/otp once at boot; only written back when it differs
+bool OTPVerifier::syncIndexConfigFromFirebase() {
+    char indexed[8];
+    JsonField field = { "indexed", indexed, sizeof(indexed) };
+    JsonFieldExtractor extractor(&field, 1);
+    unsigned long started = millis();
+    int status = rtdbScan(devicePaths.otpConfig, nullptr, extractor);
+    recordHttpOutcome(status, status == 200, started);
+    if (status != 200 || !field.found) {
+        return false; // No override configured for this device
+    }
     
-    if (len == 0) {
-        Serial.println(F("❌ No user found for this tag"));
-        json.iteratorEnd(); // Clean up iterator
+    bool remote = strcmp(indexed, "true") == 0;
+    if (remote == otpIndexEnabled) {
+        return true;
+    }
+    if (!saveIndexConfig(remote)) {
         return false;
     }
     
-    // Extract user ID in one step
-    String key;
-    String value;
-    int type = 0;
-    json.iteratorGet(0, type, key, value);
-    json.iteratorEnd(); // Clean up iterator immediately
+    Serial.println(remote ? F("✅ OTP index enabled from Firebase") : F("✅ OTP index disabled from Firebase"));
+    return true;
+}
+
+bool OTPVerifier::indexEnabled() {
+    return otpIndexEnabled;
+}
+
+OTPIndexResult OTPVerifier::verifyIndexedOTP(const String& deviceId, const String& userTag, const String& inputOTP, String& userId) {
+    char indexPath[CHILD_PATH_LEN];
+    if (!formatChildPath(indexPath, sizeof(indexPath), devicePaths.otpIndex, userTag.c_str())) {
+        return OTP_INDEX_MISSING;
+    }
     
-    userId = key;
+    // One small read replaces the users query and the OTP fetch; the three
+    // fields are copied out as the body streams in
+    char uid[NET_TEXT_LEN];
+    char hash[65];
+    char expiresAt[24];
+    JsonField fields[] = {
+        { "uid", uid, sizeof(uid) },
+        { "hash", hash, sizeof(hash) },
+        { "expiresAt", expiresAt, sizeof(expiresAt) }
+    };
+    JsonFieldExtractor extractor(fields, 3);
+    unsigned long started = millis();
+    int status = rtdbScan(indexPath, nullptr, extractor);
+    recordHttpOutcome(status, status == 200, started);
+    if (status != 200) {
+        return OTP_INDEX_MISSING;
+    }
     
-    // Use static buffer for path to avoid String concatenation
-    char otpPath[64];
-    snprintf(otpPath, sizeof(otpPath), "users/%s/otp/code", userId.c_str());
+    if (!fields[0].found || !fields[1].found || uid[0] == '\0') {
+        return OTP_INDEX_MISSING;
+    }
+    userId = uid;
     
-    if (!Firebase.RTDB.getString(&fbdo, otpPath)) {
-        Serial.print(F("❌ Error fetching OTP: "));
-        Serial.println(fbdo.errorReason());
-        return false;
+    // Expiry is only enforced once the clock is valid
+    unsigned long long now = isTimeSynchronized();
+    if (fields[2].found && now > 0 && now > (unsigned long long)atof(expiresAt)) {
+        Serial.println(F("❌ OTP expired"));
+        return OTP_INDEX_REJECTED;
     }
     
-    storedOTP = fbdo.stringData();
+    char expected[65];
+    hashOTP(deviceId, inputOTP, expected);
+    if (!hashEquals(expected, String(hash))) {
+        Serial.println(F("❌ OTP Mismatch!"));
+        return OTP_INDEX_REJECTED;
+    }
     
-    // Compare OTP efficiently
-    if (inputOTP.equals(storedOTP)) {
-        Serial.println(F("✅ OTP Verified Successfully!"));
-        
-        // Delete the used OTP
-        if (Firebase.RTDB.deleteNode(&fbdo, otpPath)) {
-            Serial.println(F("🗑️ OTP Deleted"));
-        }
-        
-        return true;
+    Serial.println(F("✅ OTP Verified Successfully!"));
+    return OTP_INDEX_VALID;
+}
+
+void OTPVerifier::consumeOTP(FirebaseData& fbdo, const String& userTag, const String& userId, bool indexed) {
+    char otpPath[USER_PATH_LEN];
+    bool formatted = indexed
+        ? formatChildPath(otpPath, sizeof(otpPath), devicePaths.otpIndex, userTag.c_str())
+        : snprintf(otpPath, sizeof(otpPath), "users/%s/otp/code", userId.c_str()) < (int)sizeof(otpPath);
+    if (!formatted) {
+        return;
     }
     
-    Serial.println(F("❌ OTP Mismatch!"));
-    return false;
+    // Requests run one at a time on the network task, so no other code is
+    // checked before this delete has gone out
+    unsigned long started = millis();
+    bool ok = Firebase.RTDB.deleteNode(&fbdo, otpPath);
+    recordFirebaseOutcome(fbdo, ok, started);
+    if (ok) {
+        Serial.println(F("🗑️ OTP Deleted"));
+    }
+}
+
+bool OTPVerifier::verifyOTPCode(const String& userTag, const String& inputOTP, String& userId, String& storedOTP) {
+    // Pre-check connectivity to fail fast
+    if (WiFi.status() != WL_CONNECTED || !Firebase.ready()) {
+        Serial.println(F("❌ Network not ready for OTP verification"));
+        return false;
+    }
+    
+    if (!findUserIdByTag(userTag, userId)) {
+        return false;
+    }
+    
+    return verifyOTPForUser(userId, inputOTP, storedOTP);
 }
\ No newline at end of file
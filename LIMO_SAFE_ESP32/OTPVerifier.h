@@ -5,13 +5,43 @@
 #include <Firebase_ESP_Client.h>
 #include "UserManager.h"
 
+// Outcome of a lookup in devices/<id>/otpIndex/<tag>
+enum OTPIndexResult {
+    OTP_INDEX_MISSING,    // No index entry; use the users query instead
+    OTP_INDEX_VALID,
+    OTP_INDEX_REJECTED    // Entry found but the code is wrong or expired
+};
+
 class OTPVerifier {
 public:
     // Validates OTP format and extracts user tag and actual OTP
     static bool validateFormat(const String& receivedOTP, String& userTag, String& actualOTP);
     
+    // Looks up the user ID owning a tag (users query)
+    static bool findUserIdByTag(const String& userTag, String& userId);
+    
+    // Checks the OTP stored for a known user; consumeOTP() deletes it
+    static bool verifyOTPForUser(const String& userId, const String& inputOTP, String& storedOTP);
+    
+    // Whether devices/<id>/otpIndex is read at all. Off until config/otp has
+    // {"indexed": true}, set once the app writes index entries for this device
+    static void loadIndexConfig();
+    static bool saveIndexConfig(bool indexed);
+    static bool syncIndexConfigFromFirebase();
+    static bool indexEnabled();
+    
+    // Verifies against the device-scoped index {uid, hash, expiresAt} with a single read;
+    // the entry stays until consumeOTP()
+    static OTPIndexResult verifyIndexedOTP(const String& deviceId, const String& userTag, const String& inputOTP, String& userId);
+    
+    // Single use: delete the index entry or the user's stored code once the unlock is out
+    static void consumeOTP(FirebaseData& fbdo, const String& userTag, const String& userId, bool indexed);
+    
+    // Hex SHA-256 of "<deviceId>:<otp>", the value the app stores in the index
+    static void hashOTP(const String& deviceId, const String& otp, char out[65]);
+    
     // Verifies OTP code against Firebase
-    static bool verifyOTPCode(FirebaseData& fbdo, const String& deviceId, const String& receivedOTP, String& userTag, String& userId);
+    static bool verifyOTPCode(const String& deviceId, const String& receivedOTP, String& userTag, String& userId);
 };
 
 #endif
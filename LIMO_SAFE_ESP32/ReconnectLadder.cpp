@@ -0,0 +1,119 @@
+#include "ReconnectLadder.h"
+#include "FirebaseHandler.h"
+#include "ConnectionHealth.h"
+#include "RtdbRest.h"
+#include "WiFiSetup.h"
+#include "secrets.h"
+#include <WiFi.h>
+
+#define RECONNECT_WIFI_WAIT_MS 3000UL   // Bounded wait for WiFi to reassociate
+
+static const char* const TIER_NAMES[RECONNECT_TIER_COUNT] = {
+    "retry", "socket", "wifi", "full", "credentials"
+};
+
+static ReconnectTier nextTier = RECONNECT_RETRY;
+static ReconnectTierStats tierStats[RECONNECT_TIER_COUNT];
+
+static bool waitForWiFi(unsigned long timeoutMs) {
+    unsigned long started = millis();
+    while (!WiFi.isConnected() && millis() - started < timeoutMs) {
+        delay(50);
+    }
+    return WiFi.isConnected();
+}
+
+static void fallBackToDefaultCredentials() {
+    String savedSSID, savedPass;
+
+    // Load current WiFi credentials
+    Preferences wifiPrefs;
+    if (wifiPrefs.begin("wifi", false)) {
+        savedSSID = wifiPrefs.getString("ssid", "");
+        savedPass = wifiPrefs.getString("pass", "");
+        wifiPrefs.end();
+    }
+
+    // Check if we're already using default credentials
+    if (savedSSID == WIFI_SSID && savedPass == WIFI_PASSWORD) {
+        Serial.println(F("Already using default credentials, trying full network reset"));
+        WiFi.disconnect(true);
+        delay(1000);
+        WiFi.reconnect();
+    } else {
+        Serial.println(F("Attempting to connect with default credentials"));
+        updateWiFiCredentials(WIFI_SSID, WIFI_PASSWORD);
+    }
+}
+
+// Do the work of one tier; the probe afterwards decides whether it helped
+static void runTier(ReconnectTier tier) {
+    switch (tier) {
+        case RECONNECT_RETRY:
+            break;
+        case RECONNECT_SOCKET:
+            fbdo.stopWiFiClient();
+            rtdbRestStop();
+            break;
+        case RECONNECT_WIFI:
+            WiFi.reconnect();
+            waitForWiFi(RECONNECT_WIFI_WAIT_MS);
+            break;
+        case RECONNECT_FULL:
+            Firebase.reset(&config);
+            Firebase.begin(&config, &auth);
+            Firebase.reconnectWiFi(true);
+            break;
+        case RECONNECT_CREDENTIALS:
+            fallBackToDefaultCredentials();
+            break;
+        default:
+            break;
+    }
+}
+
+bool attemptFirebaseReconnect() {
+    ReconnectTier tier = nextTier;
+    ReconnectTierStats& stat = tierStats[tier];
+    stat.attempts++;
+
+    Serial.print(F("🔄 Firebase reconnect, tier: "));
+    Serial.println(TIER_NAMES[tier]);
+
+    unsigned long started = millis();
+    runTier(tier);
+    bool recovered = WiFi.isConnected() && probeFirebaseConnection();
+    stat.lastDurationMs = millis() - started;
+
+    if (recovered) {
+        stat.successes++;
+        stat.totalSuccessMs += stat.lastDurationMs;
+        nextTier = RECONNECT_RETRY;
+
+        Serial.print(F("✅ Firebase recovered at tier "));
+        Serial.print(TIER_NAMES[tier]);
+        Serial.print(F(" in ms: "));
+        Serial.println(stat.lastDurationMs);
+        return true;
+    }
+
+    // Escalate; after the last resort start over from the cheapest step
+    nextTier = (ReconnectTier)((tier + 1) % RECONNECT_TIER_COUNT);
+    return false;
+}
+
+void resetReconnectLadder() {
+    nextTier = RECONNECT_RETRY;
+}
+
+ReconnectTier currentReconnectTier() {
+    return nextTier;
+}
+
+const char* reconnectTierName(ReconnectTier tier) {
+    return tier < RECONNECT_TIER_COUNT ? TIER_NAMES[tier] : "unknown";
+}
+
+const ReconnectTierStats& getReconnectStats(ReconnectTier tier) {
+    return tierStats[tier < RECONNECT_TIER_COUNT ? tier : RECONNECT_RETRY];
+}
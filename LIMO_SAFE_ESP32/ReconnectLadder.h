@@ -0,0 +1,34 @@
+#ifndef RECONNECT_LADDER_H
+#define RECONNECT_LADDER_H
+
+#include <Arduino.h>
+
+// Recovery steps, cheapest first. Each failed attempt moves one step up;
+// any success drops back to RECONNECT_RETRY.
+enum ReconnectTier : uint8_t {
+    RECONNECT_RETRY,        // Probe on the existing client, socket and token
+    RECONNECT_SOCKET,       // Drop the socket; next request reconnects with the same token
+    RECONNECT_WIFI,         // Reassociate WiFi, keep the Firebase client
+    RECONNECT_FULL,         // Firebase.reset() + begin(): new TLS context and token setup
+    RECONNECT_CREDENTIALS,  // Last resort: fall back to the default WiFi credentials
+    RECONNECT_TIER_COUNT
+};
+
+struct ReconnectTierStats {
+    uint32_t attempts;
+    uint32_t successes;
+    uint32_t lastDurationMs;     // Time from the attempt to a confirmed probe
+    uint32_t totalSuccessMs;     // Sum over successes, for the average
+};
+
+// Run the next step of the ladder (network task); true once Firebase answers again
+bool attemptFirebaseReconnect();
+
+// Called when the connection is seen healthy again without a ladder step
+void resetReconnectLadder();
+
+ReconnectTier currentReconnectTier();
+const char* reconnectTierName(ReconnectTier tier);
+const ReconnectTierStats& getReconnectStats(ReconnectTier tier);
+
+#endif
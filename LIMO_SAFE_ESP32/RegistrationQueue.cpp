@@ -0,0 +1,134 @@
+#include "RegistrationQueue.h"
+#include "FirebaseHandler.h"
+#include "UserManager.h"
+#include "DevicePaths.h"
+#include "RtdbCache.h"
+#include "EventLogger.h"
+#include <esp_attr.h>
+
+#define REGISTRATION_QUEUE_MAGIC 0x52475131  // "RGQ1", bump when the layout changes
+
+struct RegistrationQueue {
+    uint32_t magic;
+    uint8_t count;
+    PendingRegistration entries[REGISTRATION_QUEUE_SIZE];  // Oldest first
+};
+
+RTC_NOINIT_ATTR static RegistrationQueue registrationQueue;
+
+void initRegistrationQueue() {
+    if (registrationQueue.magic != REGISTRATION_QUEUE_MAGIC || registrationQueue.count > REGISTRATION_QUEUE_SIZE) {
+        memset(&registrationQueue, 0, sizeof(registrationQueue));
+        registrationQueue.magic = REGISTRATION_QUEUE_MAGIC;
+    } else if (registrationQueue.count > 0) {
+        Serial.print(F("📋 Restored queued registrations: "));
+        Serial.println(registrationQueue.count);
+    }
+}
+
+bool queueRegistration(const char* userTag, const char* userId, bool registerToDevice, bool firstUser) {
+    PendingRegistration* entry = nullptr;
+    for (uint8_t i = 0; i < registrationQueue.count; i++) {
+        if (strcmp(registrationQueue.entries[i].tag, userTag) == 0) {
+            entry = &registrationQueue.entries[i];
+            break;
+        }
+    }
+
+    if (entry == nullptr) {
+        if (registrationQueue.count == REGISTRATION_QUEUE_SIZE) {
+            Serial.println(F("⚠️ Registration queue full"));
+            return false;
+        }
+        entry = &registrationQueue.entries[registrationQueue.count++];
+        memset(entry, 0, sizeof(*entry));
+    } else {
+        // Same tag again: the newer user ID wins, a pending first-user write stays
+        registerToDevice = registerToDevice || entry->registerToDevice;
+        firstUser = firstUser || entry->firstUser;
+    }
+
+    strncpy(entry->tag, userTag, AUTH_TAG_LEN - 1);
+    strncpy(entry->userId, userId, AUTH_USER_ID_LEN - 1);
+    entry->registerToDevice = registerToDevice;
+    entry->firstUser = firstUser;
+    return true;
+}
+
+bool hasPendingDeviceRegistration(const char* userTag) {
+    for (uint8_t i = 0; i < registrationQueue.count; i++) {
+        const PendingRegistration& entry = registrationQueue.entries[i];
+        if (entry.registerToDevice && (userTag == nullptr || strcmp(entry.tag, userTag) == 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool hasPendingRegistrations() {
+    return registrationQueue.count > 0;
+}
+
+static void popRegistration() {
+    registrationQueue.count--;
+    memmove(&registrationQueue.entries[0], &registrationQueue.entries[1],
+            registrationQueue.count * sizeof(PendingRegistration));
+}
+
+// Keep the stored role; write the default only when the read says there is none
+static bool settleRole(const PendingRegistration& entry) {
+    char rolePath[USER_PATH_LEN];
+    if (!formatUserDevicePath(rolePath, sizeof(rolePath), entry.userId, "role")) {
+        return true;  // Unusable ID, nothing will ever succeed
+    }
+
+    // The body is a JSON string such as "admin", or null
+    const String* roleBody = RtdbCache::get(rolePath, CACHE_TTL_ROLE_MS);
+    if (roleBody == nullptr) {
+        return false;  // A failed read must not overwrite a stored role
+    }
+
+    String userRole;
+    if (roleBody->startsWith("\"") && roleBody->length() > 2) {
+        userRole = roleBody->substring(1, roleBody->length() - 1);
+        Serial.print(F("ℹ️ Preserving existing user role: "));
+        Serial.println(userRole);
+    } else {
+        userRole = entry.firstUser ? "admin" : "user";
+        Serial.print(F("ℹ️ Setting role for new user: "));
+        Serial.println(userRole);
+        if (!UserManager::updateUserDeviceRegistration(fbdo, entry.userId, userRole)) {
+            return false;
+        }
+    }
+
+    AuthorizedUsers::setRole(entry.tag, AuthorizedUsers::parseRole(userRole));
+    return true;
+}
+
+// One step of the oldest entry per call; a failed step is retried on a later call
+UploadResult uploadPendingRegistration() {
+    if (registrationQueue.count == 0) {
+        return UPLOAD_IDLE;
+    }
+    PendingRegistration& entry = registrationQueue.entries[0];
+
+    if (entry.registerToDevice) {
+        if (!UserManager::registerUserToDevice(fbdo, entry.userId, entry.tag)) {
+            // Logged once; the write keeps being retried
+            if (entry.attempts++ == 0) {
+                logEvent(EVT_FIRST_USER_REGISTRATION_FAILED, entry.userId, entry.tag);
+            }
+            return UPLOAD_FAILED;
+        }
+        entry.registerToDevice = false;
+        return UPLOAD_OK;
+    }
+
+    if (!settleRole(entry)) {
+        entry.attempts++;
+        return UPLOAD_FAILED;
+    }
+    popRegistration();
+    return UPLOAD_OK;
+}
@@ -0,0 +1,38 @@
+#ifndef REGISTRATION_QUEUE_H
+#define REGISTRATION_QUEUE_H
+
+#include <Arduino.h>
+#include "UploadScheduler.h"
+#include "AuthorizedUsers.h"
+
+// Cloud bookkeeping that follows an accepted OTP: the registeredUsers entry of
+// a first user and the user's role for this device. The unlock goes out as
+// soon as the OTP is accepted; these writes wait here, in RTC memory so a soft
+// reset doesn't lose them, and go out through the upload scheduler.
+//
+// Network task only.
+#define REGISTRATION_QUEUE_SIZE 4
+
+struct PendingRegistration {
+    char tag[AUTH_TAG_LEN];
+    char userId[AUTH_USER_ID_LEN];
+    bool registerToDevice;      // First user: add the tag to registeredUsers
+    bool firstUser;             // Role to write when none is stored: admin, else user
+    uint8_t attempts;
+};
+
+// Restore entries that survived a soft reset (call once in setup)
+void initRegistrationQueue();
+
+// False when the queue is full; the entry for a tag already queued is merged
+bool queueRegistration(const char* userTag, const char* userId, bool registerToDevice, bool firstUser);
+
+// True while a first user's registeredUsers entry is still queued, i.e. the
+// cloud node may lag behind; with a tag, only when the entry is for that tag
+bool hasPendingDeviceRegistration(const char* userTag = nullptr);
+
+// Upload class hooks
+bool hasPendingRegistrations();
+UploadResult uploadPendingRegistration();
+
+#endif
@@ -0,0 +1,102 @@
+#include "RequestDeadline.h"
+
+static RttEstimate rtt = { 0, 0, RTT_INITIAL_RTO_MS, 0, 0, 0 };
+
+// Innermost open scope
+static bool deadlineActive = false;
+static unsigned long deadline = 0;
+static bool unanswered = false;
+
+static uint32_t clampRto(uint32_t rto) {
+    return constrain(rto, RTT_MIN_RTO_MS, RTT_MAX_RTO_MS);
+}
+
+void recordRttSample(uint32_t rttMs) {
+    if (rtt.samples == 0) {
+        rtt.srttMs = rttMs;
+        rtt.rttVarMs = rttMs / 2;
+    } else {
+        // Gains of 1/4 and 1/8, as in TCP
+        uint32_t error = rttMs > rtt.srttMs ? rttMs - rtt.srttMs : rtt.srttMs - rttMs;
+        rtt.rttVarMs = rtt.rttVarMs - rtt.rttVarMs / 4 + error / 4;
+        rtt.srttMs = rtt.srttMs - rtt.srttMs / 8 + rttMs / 8;
+    }
+    rtt.samples++;
+    rtt.rtoMs = clampRto(rtt.srttMs + 4 * rtt.rttVarMs);
+}
+
+void recordRttTimeout() {
+    rtt.timeouts++;
+    rtt.rtoMs = clampRto(rtt.rtoMs * 2);  // Until the next sample
+}
+
+const RttEstimate& getRttEstimate() {
+    return rtt;
+}
+
+static uint32_t capByDeadline(uint32_t timeout, bool* byDeadline) {
+    if (byDeadline != nullptr) {
+        *byDeadline = false;
+    }
+    if (!deadlineActive) {
+        return timeout;
+    }
+    long left = (long)(deadline - millis());
+    if (left <= 0) {
+        if (byDeadline != nullptr) {
+            *byDeadline = true;
+        }
+        return 0;
+    }
+    if ((uint32_t)left < timeout) {
+        if (byDeadline != nullptr) {
+            *byDeadline = true;
+        }
+        return left;
+    }
+    return timeout;
+}
+
+uint32_t requestTimeoutMs(bool* byDeadline) {
+    return capByDeadline(rtt.rtoMs, byDeadline);
+}
+
+uint32_t connectTimeoutMs() {
+    return capByDeadline(RTT_CONNECT_TIMEOUT_MS, nullptr);
+}
+
+void noteRequestUnanswered() {
+    unanswered = true;
+    if (deadlineActive && (long)(deadline - millis()) <= 0) {
+        rtt.deadlineMisses++;
+    }
+}
+
+DeadlineScope::DeadlineScope(unsigned long deadlineMs)
+    : open(true), previousActive(deadlineActive), previousDeadline(deadline), previousInterrupted(unanswered) {
+    if (deadlineMs != 0 && (!deadlineActive || (long)(deadlineMs - deadline) < 0)) {
+        deadlineActive = true;
+        deadline = deadlineMs;
+    }
+    unanswered = false;
+}
+
+DeadlineScope::~DeadlineScope() {
+    release();
+}
+
+void DeadlineScope::release() {
+    if (!open) {
+        return;
+    }
+    open = false;
+    bool mine = unanswered;
+    deadlineActive = previousActive;
+    deadline = previousDeadline;
+    unanswered = previousInterrupted || mine;  // The outer scope saw it too
+    previousInterrupted = mine;                // Kept for interrupted()
+}
+
+bool DeadlineScope::interrupted() const {
+    return open ? unanswered : previousInterrupted;
+}
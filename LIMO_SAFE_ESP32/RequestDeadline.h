@@ -0,0 +1,61 @@
+#ifndef REQUEST_DEADLINE_H
+#define REQUEST_DEADLINE_H
+
+#include <Arduino.h>
+
+// How long one request may wait comes from a smoothed RTT estimate (RFC 6298:
+// SRTT + 4 * RTTVAR, doubled after each timeout), capped by the deadline of
+// the user-facing operation it belongs to. An operation opens a DeadlineScope
+// and every request made inside it, however deeply nested, stops waiting when
+// the budget is spent. Network task only.
+#define RTT_INITIAL_RTO_MS 3000UL      // Before the first sample
+#define RTT_MIN_RTO_MS 500UL
+#define RTT_MAX_RTO_MS 10000UL         // The old fixed timeout
+#define RTT_CONNECT_TIMEOUT_MS 5000UL  // TCP connect plus TLS handshake, not an RTT
+#define OTP_DEADLINE_MS 1500UL         // From the code being entered to the answer
+
+struct RttEstimate {
+    uint32_t srttMs;
+    uint32_t rttVarMs;
+    uint32_t rtoMs;
+    uint32_t samples;
+    uint32_t timeouts;          // Waits that ran out the RTO
+    uint32_t deadlineMisses;    // Requests refused or cut short by a deadline
+};
+
+// Time from a request going out to its status line; samples from requests
+// that timed out are never taken
+void recordRttSample(uint32_t rttMs);
+void recordRttTimeout();
+const RttEstimate& getRttEstimate();
+
+// How long the next request may wait for its answer: the RTO, or what is left
+// of the deadline when that is shorter (byDeadline is then set). 0 = spent.
+uint32_t requestTimeoutMs(bool* byDeadline = nullptr);
+
+// Connect plus handshake budget, likewise capped by the deadline
+uint32_t connectTimeoutMs();
+
+// A request under the current scope got no answer (refused, timed out or dropped)
+void noteRequestUnanswered();
+
+// The tightest of the enclosing deadlines applies; 0 adds none
+class DeadlineScope {
+public:
+    explicit DeadlineScope(unsigned long deadlineMs);
+    ~DeadlineScope();
+
+    // Close early, e.g. once the user has their answer
+    void release();
+
+    // A request under this scope went unanswered, so a negative result is not a verdict
+    bool interrupted() const;
+
+private:
+    bool open;
+    bool previousActive;
+    unsigned long previousDeadline;
+    bool previousInterrupted;
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "RtdbCache.h"
+#include "RtdbRest.h"
+#include "ConnectionHealth.h"
+
+struct CacheEntry {
+    char path[RTDB_CACHE_PATH_LEN];   // Empty = free
+    String body;
+    unsigned long storedAt;           // Last download
+    unsigned long lastUsed;
+    uint32_t version;
+};
+
+static CacheEntry entries[RTDB_CACHE_MAX_ENTRIES];
+static RtdbCacheStats cacheStats = {};
+static uint32_t nextVersion = 1;
+
+// A body larger than the whole budget is handed out from here and not kept
+static String uncachedBody;
+
+static size_t entryBytes(const CacheEntry& entry) {
+    return strlen(entry.path) + entry.body.length();
+}
+
+static int findEntry(const char* path) {
+    for (int i = 0; i < RTDB_CACHE_MAX_ENTRIES; i++) {
+        if (entries[i].path[0] != '\0' && strcmp(entries[i].path, path) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void eraseEntry(CacheEntry& entry) {
+    cacheStats.bytes -= entryBytes(entry);
+    cacheStats.entries--;
+    entry.path[0] = '\0';
+    entry.body = String();
+}
+
+// Evict least recently used entries until bytes more fit; returns a free slot
+static int makeRoom(size_t bytes) {
+    while (true) {
+        int freeSlot = -1;
+        int oldest = -1;
+        for (int i = 0; i < RTDB_CACHE_MAX_ENTRIES; i++) {
+            if (entries[i].path[0] == '\0') {
+                if (freeSlot < 0) {
+                    freeSlot = i;
+                }
+            } else if (oldest < 0 || (long)(entries[i].lastUsed - entries[oldest].lastUsed) < 0) {
+                oldest = i;
+            }
+        }
+        if (freeSlot >= 0 && cacheStats.bytes + bytes <= RTDB_CACHE_BUDGET_BYTES) {
+            return freeSlot;
+        }
+        eraseEntry(entries[oldest]);
+        cacheStats.evictions++;
+    }
+}
+
+static const String* store(const char* path, const String& body, uint32_t* version) {
+    unsigned long now = millis();
+    int index = findEntry(path);
+    uint32_t bodyVersion = nextVersion;
+
+    if (index >= 0) {
+        if (entries[index].body == body) {
+            bodyVersion = entries[index].version;  // Same content, parsed copies stay current
+        }
+        eraseEntry(entries[index]);
+    }
+    if (bodyVersion == nextVersion) {
+        nextVersion++;
+    }
+    if (version != nullptr) {
+        *version = bodyVersion;
+    }
+
+    size_t bytes = strlen(path) + body.length();
+    if (bytes > RTDB_CACHE_BUDGET_BYTES) {
+        uncachedBody = body;
+        return &uncachedBody;
+    }
+
+    CacheEntry& entry = entries[makeRoom(bytes)];
+    strncpy(entry.path, path, RTDB_CACHE_PATH_LEN - 1);
+    entry.path[RTDB_CACHE_PATH_LEN - 1] = '\0';
+    entry.body = body;
+    entry.storedAt = now;
+    entry.lastUsed = now;
+    entry.version = bodyVersion;
+    cacheStats.bytes += bytes;
+    cacheStats.entries++;
+    return &entry.body;
+}
+
+const String* RtdbCache::get(const char* path, unsigned long ttlMs, uint32_t* version) {
+    unsigned long now = millis();
+    int index = findEntry(path);
+    if (index >= 0 && now - entries[index].storedAt < ttlMs) {
+        CacheEntry& entry = entries[index];
+        cacheStats.hits++;
+        entry.lastUsed = now;
+        if (version != nullptr) {
+            *version = entry.version;
+        }
+        return &entry.body;
+    }
+
+    char etag[RTDB_ETAG_LEN] = "";
+    String body;
+    unsigned long started = millis();
+    int status = rtdbGet(path, etag, sizeof(etag), body);
+    bool ok = status == 200;
+    recordHttpOutcome(status, ok, started);
+
+    if (!ok) {
+        cacheStats.failures++;
+        return nullptr;
+    }
+
+    cacheStats.misses++;
+    return store(path, body, version);
+}
+
+const String* RtdbCache::peek(const char* path) {
+    int index = findEntry(path);
+    if (index < 0) {
+        return nullptr;
+    }
+    entries[index].lastUsed = millis();
+    return &entries[index].body;
+}
+
+uint32_t RtdbCache::put(const char* path, const String& body) {
+    uint32_t version;
+    store(path, body, &version);
+    return version;
+}
+
+// True when inner is outer or a child of it
+static bool isWithin(const char* inner, const char* outer) {
+    size_t length = strlen(outer);
+    return strncmp(inner, outer, length) == 0 && (inner[length] == '\0' || inner[length] == '/');
+}
+
+void RtdbCache::invalidate(const char* path) {
+    for (int i = 0; i < RTDB_CACHE_MAX_ENTRIES; i++) {
+        CacheEntry& entry = entries[i];
+        if (entry.path[0] != '\0' && (isWithin(entry.path, path) || isWithin(path, entry.path))) {
+            eraseEntry(entry);
+            cacheStats.invalidations++;
+        }
+    }
+}
+
+void RtdbCache::clear() {
+    for (int i = 0; i < RTDB_CACHE_MAX_ENTRIES; i++) {
+        if (entries[i].path[0] != '\0') {
+            eraseEntry(entries[i]);
+        }
+    }
+}
+
+const RtdbCacheStats& RtdbCache::stats() {
+    return cacheStats;
+}
@@ -0,0 +1,54 @@
+#ifndef RTDB_CACHE_H
+#define RTDB_CACHE_H
+
+#include <Arduino.h>
+#include "DevicePaths.h"
+
+// Read-through cache of RTDB node bodies, keyed by path. Each read names its
+// own TTL; an expired entry is downloaded again, and keeps its version when
+// the body is unchanged. Entries are evicted least recently used once their
+// bodies exceed the byte budget.
+//
+// Our own writes invalidate by path: an entry goes when it lies under the
+// written path or contains it. rtdbUpdate() does this itself; writes through
+// the Firebase client call invalidate() next to the write.
+//
+// Network task only.
+#define RTDB_CACHE_MAX_ENTRIES 12
+#define RTDB_CACHE_BUDGET_BYTES 8192     // Bodies plus paths
+#define RTDB_CACHE_PATH_LEN USER_PATH_LEN
+
+// TTLs of the shared reads; the streams and our writes invalidate earlier
+#define CACHE_TTL_REGISTRATION_MS 30000UL   // devices/<id>/registeredUsers
+#define CACHE_TTL_ROLE_MS 600000UL          // users/<uid>/registeredDevices/<id>/role
+
+struct RtdbCacheStats {
+    uint32_t hits;          // Served without a request
+    uint32_t misses;        // Body downloaded
+    uint32_t failures;
+    uint32_t evictions;
+    uint32_t invalidations;
+    size_t bytes;
+    uint8_t entries;
+};
+
+class RtdbCache {
+public:
+    // The node's JSON body ("null" when it does not exist), or nullptr when it
+    // could not be read. The pointer is valid until the next RtdbCache call.
+    // version changes whenever a different body is stored for the path.
+    static const String* get(const char* path, unsigned long ttlMs, uint32_t* version = nullptr);
+
+    // The stored body whatever its age, without a request; nullptr when none
+    static const String* peek(const char* path);
+
+    // Store a body that arrived another way (e.g. from a stream); returns its version
+    static uint32_t put(const char* path, const String& body);
+
+    static void invalidate(const char* path);
+    static void clear();
+
+    static const RtdbCacheStats& stats();
+};
+
+#endif
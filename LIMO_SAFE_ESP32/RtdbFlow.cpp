@@ -0,0 +1,91 @@
+#include "RtdbFlow.h"
+#include "RequestDeadline.h"
+#include "FirebaseHandler.h"
+
+struct FlowSlot {
+    RtdbFlow::Handle handle;
+    unsigned long deadlineMs;
+    const char* name;
+};
+
+static FlowSlot slots[RTDB_FLOW_SLOTS];
+static uint8_t nextSlot = 0;
+
+static bool isReady(const FlowSlot& slot) {
+    const RtdbFlow::promise_type& promise = slot.handle.promise();
+    return !promise.sleeping || (long)(millis() - promise.wakeAtMs) >= 0;
+}
+
+// Run the awaited step, then the flow's own code up to its next co_await
+static void stepFlow(FlowSlot& slot) {
+    RtdbFlow::promise_type& promise = slot.handle.promise();
+    promise.sleeping = false;
+    {
+        DeadlineScope budget(slot.deadlineMs);
+        applyFirebaseTimeouts();  // The Firebase client honours the flow's deadline too
+        if (promise.step != nullptr) {
+            FlowStep* step = promise.step;
+            promise.step = nullptr;
+            step->run();
+        }
+        slot.handle.resume();
+    }
+    applyFirebaseTimeouts();
+
+    if (slot.handle.done()) {
+        slot.handle.destroy();
+        slot.handle = nullptr;
+    }
+}
+
+bool spawnFlow(RtdbFlow flow, unsigned long deadlineMs, const char* name) {
+    RtdbFlow::Handle handle = flow.release();
+    if (!handle) {
+        Serial.print(F("❌ No memory to start "));
+        Serial.println(name);
+        return false;
+    }
+
+    FlowSlot started = { handle, deadlineMs, name };
+    for (uint8_t i = 0; i < RTDB_FLOW_SLOTS; i++) {
+        if (!slots[i].handle) {
+            slots[i] = started;
+            stepFlow(slots[i]);
+            return true;
+        }
+    }
+
+    // No slot: the flow's work still has to happen, so it happens now
+    Serial.print(F("⚠️ Flow slots full, running "));
+    Serial.print(name);
+    Serial.println(F(" inline"));
+    while (started.handle) {
+        if (!isReady(started)) {
+            delay(1);
+            continue;
+        }
+        stepFlow(started);
+    }
+    return true;
+}
+
+void serviceRtdbFlows() {
+    for (uint8_t i = 0; i < RTDB_FLOW_SLOTS; i++) {
+        FlowSlot& slot = slots[(nextSlot + i) % RTDB_FLOW_SLOTS];
+        if (slot.handle && isReady(slot)) {
+            nextSlot = (nextSlot + i + 1) % RTDB_FLOW_SLOTS;  // Round robin
+            stepFlow(slot);
+            return;
+        }
+    }
+}
+
+uint8_t runningFlows() {
+    uint8_t running = 0;
+    for (uint8_t i = 0; i < RTDB_FLOW_SLOTS; i++) {
+        if (slots[i].handle) {
+            running++;
+        }
+    }
+    return running;
+}
@@ -0,0 +1,131 @@
+#ifndef RTDB_FLOW_H
+#define RTDB_FLOW_H
+
+#include <Arduino.h>
+#include <coroutine>
+#include <new>
+#include <type_traits>
+
+// Multi-request RTDB flows written as C++20 coroutines. A flow co_awaits each
+// request with flowCall(); the network task's executor runs one step per pass
+// of its loop and resumes the flow with the result. Flows therefore interleave
+// with each other and with the user-facing requests served between passes,
+// while each reads top to bottom instead of as a state machine.
+//
+// A step is an ordinary blocking call, bounded by RequestDeadline: it runs
+// under the flow's own deadline, so a flow that overruns sees its requests
+// refused and winds down. Network task only.
+#define RTDB_FLOW_SLOTS 4
+
+// Something the executor runs before resuming the flow that awaits it
+class FlowStep {
+public:
+    virtual void run() = 0;
+};
+
+class RtdbFlow {
+public:
+    struct promise_type {
+        FlowStep* step = nullptr;       // Run before the next resume
+        unsigned long wakeAtMs = 0;     // With sleeping, not resumed before this
+        bool sleeping = false;
+
+        RtdbFlow get_return_object() {
+            return RtdbFlow(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        // Frames come from the heap; running out yields an empty flow instead of aborting
+        static RtdbFlow get_return_object_on_allocation_failure() { return RtdbFlow(nullptr); }
+        void* operator new(size_t size) noexcept { return ::operator new(size, std::nothrow); }
+        void operator delete(void* frame) noexcept { ::operator delete(frame); }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { abort(); }
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    RtdbFlow(RtdbFlow&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    RtdbFlow(const RtdbFlow&) = delete;
+    RtdbFlow& operator=(const RtdbFlow&) = delete;
+    ~RtdbFlow() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    // Hand the frame over to the executor
+    Handle release() {
+        Handle released = handle;
+        handle = nullptr;
+        return released;
+    }
+
+private:
+    explicit RtdbFlow(Handle handle) : handle(handle) {}
+    Handle handle;
+};
+
+// co_await flowCall([&] { return rtdbUpdate(path, payload); }) runs the call
+// on the flow's next turn and resumes with its result
+template <typename Fn>
+class FlowCall : public FlowStep {
+public:
+    using Result = decltype(std::declval<Fn&>()());
+
+    explicit FlowCall(Fn fn) : fn(fn) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(RtdbFlow::Handle flow) noexcept { flow.promise().step = this; }
+    Result await_resume() {
+        if constexpr (!std::is_void_v<Result>) {
+            return result;
+        }
+    }
+
+    void run() override {
+        if constexpr (std::is_void_v<Result>) {
+            fn();
+        } else {
+            result = fn();
+        }
+    }
+
+private:
+    Fn fn;
+    std::conditional_t<std::is_void_v<Result>, bool, Result> result{};
+};
+
+template <typename Fn>
+FlowCall<Fn> flowCall(Fn fn) {
+    return FlowCall<Fn>(fn);
+}
+
+// co_await flowSleep(ms) gives the network task back for at least ms
+struct FlowSleep {
+    unsigned long ms;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(RtdbFlow::Handle flow) noexcept {
+        flow.promise().wakeAtMs = millis() + ms;
+        flow.promise().sleeping = true;
+    }
+    void await_resume() const noexcept {}
+};
+
+inline FlowSleep flowSleep(unsigned long ms) {
+    return FlowSleep{ ms };
+}
+
+// Start a flow; it runs up to its first co_await here. deadlineMs (a millis()
+// value, 0 = none) bounds every step. With every slot taken the flow is run
+// to completion on the spot. Returns false when it could not be started.
+bool spawnFlow(RtdbFlow flow, unsigned long deadlineMs, const char* name);
+
+// One step of the next ready flow; called once per network task pass
+void serviceRtdbFlows();
+
+// Flows not yet finished
+uint8_t runningFlows();
+
+#endif
@@ -0,0 +1,374 @@
+#include "RtdbRest.h"
+#include "ConnectionHealth.h"
+#include "RtdbCache.h"
+#include "JsonScanner.h"
+#include "RequestDeadline.h"
+#include "secrets.h"
+#include <WiFiClientSecure.h>
+
+#define RTDB_REST_PORT 443
+
+static WiFiClientSecure restClient;
+static bool restClientConfigured = false;
+
+static bool ensureConnected() {
+    if (restClient.connected()) {
+        return true;
+    }
+
+    uint32_t timeout = connectTimeoutMs();
+    if (timeout == 0) {
+        return false;
+    }
+    if (!restClientConfigured) {
+        // Same trust model as the Firebase client, which runs without a CA bundle
+        restClient.setInsecure();
+        restClientConfigured = true;
+    }
+    restClient.setHandshakeTimeout((timeout + 999) / 1000);
+    restClient.stop();
+    return restClient.connect(FIREBASE_HOST, RTDB_REST_PORT, timeout) != 0;
+}
+
+static int unanswered(int error) {
+    noteRequestUnanswered();
+    return error;
+}
+
+// Connect when needed and work out when to stop waiting for the answer;
+// returns 0, or the error to hand back without sending anything
+static int beginRequest(unsigned long& deadline, bool& byDeadline) {
+    if (requestTimeoutMs() == 0) {
+        return unanswered(RTDB_REST_ERROR_DEADLINE);
+    }
+    if (!ensureConnected()) {
+        return unanswered(requestTimeoutMs() == 0 ? RTDB_REST_ERROR_DEADLINE : RTDB_REST_ERROR_CONNECT);
+    }
+    uint32_t timeout = requestTimeoutMs(&byDeadline);
+    if (timeout == 0) {
+        return unanswered(RTDB_REST_ERROR_DEADLINE);
+    }
+    deadline = millis() + timeout;
+    return 0;
+}
+
+// The answer did not arrive in full: the connection dropped, the deadline cut
+// the wait short, or the RTO ran out. The connection has been closed, so a
+// late answer can't be read as the next one's.
+static int waitFailed(unsigned long deadline, bool byDeadline) {
+    if ((long)(deadline - millis()) > 0) {
+        return unanswered(RTDB_REST_ERROR_RESPONSE);
+    }
+    if (byDeadline) {
+        return unanswered(RTDB_REST_ERROR_DEADLINE);
+    }
+    recordRttTimeout();
+    return unanswered(RTDB_REST_ERROR_TIMEOUT);
+}
+
+// NUL-terminated copy cut to fit out
+static void copyText(char* out, size_t size, const char* text) {
+    size_t length = strnlen(text, size - 1);
+    memcpy(out, text, length);
+    out[length] = '\0';
+}
+
+// Read one header line without allocating; returns false on timeout
+static bool readLine(char* line, size_t size, unsigned long deadline) {
+    size_t length = 0;
+    while ((long)(deadline - millis()) > 0) {
+        if (!restClient.available()) {
+            if (!restClient.connected()) {
+                return false;
+            }
+            delay(1);
+            continue;
+        }
+        char c = restClient.read();
+        if (c == '\n') {
+            line[length] = '\0';
+            return true;
+        }
+        if (c != '\r' && length < size - 1) {
+            line[length++] = c;
+        }
+    }
+    return false;
+}
+
+// Status line and the headers we care about
+struct ResponseHead {
+    int status;
+    long contentLength;
+    bool keepAlive;
+    bool chunked;
+};
+
+// Returns false when the connection dropped before the headers ended
+static bool readResponseHead(ResponseHead& head, char* etag, size_t etagSize, unsigned long deadline) {
+    char line[128];
+    head.status = 0;
+    head.contentLength = 0;
+    head.keepAlive = true;
+    head.chunked = false;
+
+    // Status line: HTTP/1.1 204 No Content
+    if (!readLine(line, sizeof(line), deadline)) {
+        return false;
+    }
+    const char* space = strchr(line, ' ');
+    head.status = space != nullptr ? atoi(space + 1) : 0;
+    if (head.status <= 0) {
+        return false;
+    }
+
+    while (true) {
+        if (!readLine(line, sizeof(line), deadline)) {
+            return false;
+        }
+        if (line[0] == '\0') {
+            return true;  // End of headers
+        }
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            head.contentLength = atol(line + 15);
+        } else if (strncasecmp(line, "Connection:", 11) == 0 && strstr(line + 11, "close") != nullptr) {
+            head.keepAlive = false;
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strstr(line + 18, "chunked") != nullptr) {
+            head.chunked = true;
+        } else if (etag != nullptr && strncasecmp(line, "ETag:", 5) == 0) {
+            const char* value = line + 5;
+            while (*value == ' ') {
+                value++;
+            }
+            copyText(etag, etagSize, value);
+        }
+    }
+}
+
+// Where body bytes go: appended to a String, fed to a scanner, or discarded
+struct BodySink {
+    String* text;
+    JsonScanner* scanner;
+};
+
+// Pass up to length body bytes to the sink; a scanner that stopped only
+// skips the rest, which still has to be drained from the connection
+static bool readBody(long length, const BodySink& sink, unsigned long deadline) {
+    uint8_t scratch[64];
+    while (length > 0 && (long)(deadline - millis()) > 0) {
+        int available = restClient.available();
+        if (available <= 0) {
+            if (!restClient.connected()) {
+                return false;
+            }
+            delay(1);
+            continue;
+        }
+        size_t chunk = min((long)sizeof(scratch), min((long)available, length));
+        int n = restClient.read(scratch, chunk);
+        if (n > 0 && sink.text != nullptr) {
+            sink.text->concat((const char*)scratch, n);
+        } else if (n > 0 && sink.scanner != nullptr) {
+            sink.scanner->feed((const char*)scratch, n);
+        }
+        length -= n;
+    }
+    return length <= 0;
+}
+
+// Body framed by Content-Length or chunked encoding; text bodies over maxLength
+// are dropped, scanned bodies have no limit
+static bool readResponseBody(const ResponseHead& head, BodySink sink, size_t maxLength, unsigned long deadline) {
+    if (!head.chunked) {
+        if (sink.text != nullptr && (size_t)head.contentLength > maxLength) {
+            sink.text = nullptr;
+        }
+        if (sink.text != nullptr) {
+            sink.text->reserve(head.contentLength);
+        }
+        return readBody(head.contentLength, sink, deadline);
+    }
+
+    char line[24];
+    while (readLine(line, sizeof(line), deadline)) {
+        long size = strtol(line, nullptr, 16);
+        if (size < 0) {
+            return false;
+        }
+        if (size == 0) {
+            return readLine(line, sizeof(line), deadline);  // Blank line after the last chunk
+        }
+        if (sink.text != nullptr && sink.text->length() + (size_t)size > maxLength) {
+            return false;  // Too large; the caller drops the connection
+        }
+        if (!readBody(size, sink, deadline) || !readLine(line, sizeof(line), deadline)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// Send a request and read the head of its answer; returns 0, or the error to
+// hand back. A kept-alive connection the server has meanwhile closed fails
+// as soon as it is used, before any answer; that request is sent once more
+// on a new connection. All requests here are idempotent (GET, PATCH).
+static int exchange(const char* header, int headerLength, const char* body, size_t length,
+                    ResponseHead& head, char* etag, size_t etagSize,
+                    unsigned long& deadline, bool& byDeadline) {
+    head.status = 0;
+    for (uint8_t attempt = 0; ; attempt++) {
+        bool reused = restClient.connected();
+        int refused = beginRequest(deadline, byDeadline);
+        if (refused != 0) {
+            return refused;
+        }
+
+        unsigned long sent = millis();
+        bool written = restClient.write((const uint8_t*)header, headerLength) == (size_t)headerLength &&
+                       (length == 0 || restClient.write((const uint8_t*)body, length) == length);
+        if (written && readResponseHead(head, etag, etagSize, deadline)) {
+            recordRttSample(millis() - sent);
+            return 0;
+        }
+        restClient.stop();
+
+        if (reused && attempt == 0 && head.status == 0 && (long)(deadline - millis()) > 0) {
+            continue;  // Stale connection: no answer came back, so send it again
+        }
+        return waitFailed(deadline, byDeadline);
+    }
+}
+
+int rtdbPatch(const char* path, const char* body, size_t length) {
+    // print=silent answers 204 with no body
+    char header[320];
+    int headerLength = snprintf(header, sizeof(header),
+        "PATCH /%s.json?auth=%s&print=silent HTTP/1.1\r\n"
+        "Host: %s\r\n"
+        "Connection: keep-alive\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: %u\r\n\r\n",
+        path, FIREBASE_AUTH, FIREBASE_HOST, (unsigned)length);
+    if (headerLength <= 0 || headerLength >= (int)sizeof(header)) {
+        return RTDB_REST_ERROR_RESPONSE;
+    }
+
+    ResponseHead head;
+    unsigned long deadline = 0;
+    bool byDeadline = false;
+    int failed = exchange(header, headerLength, body, length, head, nullptr, 0, deadline, byDeadline);
+    if (failed != 0) {
+        return head.status > 0 ? head.status : failed;  // The status line alone is the answer
+    }
+
+    if (!readResponseBody(head, BodySink{}, 0, deadline) || !head.keepAlive) {
+        restClient.stop();
+    }
+    return head.status;
+}
+
+int rtdbGet(const char* path, char* etag, size_t etagSize, String& body) {
+    char header[384];
+    int headerLength = snprintf(header, sizeof(header),
+        "GET /%s.json?auth=%s HTTP/1.1\r\n"
+        "Host: %s\r\n"
+        "Connection: keep-alive\r\n"
+        "X-Firebase-ETag: true\r\n\r\n",
+        path, FIREBASE_AUTH, FIREBASE_HOST);
+    if (headerLength <= 0 || headerLength >= (int)sizeof(header)) {
+        return RTDB_REST_ERROR_RESPONSE;
+    }
+
+    ResponseHead head;
+    char receivedTag[RTDB_ETAG_LEN] = "";
+    unsigned long deadline = 0;
+    bool byDeadline = false;
+    int failed = exchange(header, headerLength, nullptr, 0, head, receivedTag, sizeof(receivedTag),
+                          deadline, byDeadline);
+    if (failed != 0) {
+        return failed;
+    }
+
+    String received;
+    BodySink sink = {};
+    if (head.status == 200) {
+        sink.text = &received;
+    }
+    bool complete = readResponseBody(head, sink, RTDB_GET_MAX_BODY, deadline);
+    if (!complete || !head.keepAlive) {
+        restClient.stop();
+    }
+    if (!complete) {
+        return waitFailed(deadline, byDeadline);
+    }
+
+    if (head.status == 200) {
+        if (!head.chunked && head.contentLength > RTDB_GET_MAX_BODY) {
+            return unanswered(RTDB_REST_ERROR_RESPONSE);  // Drained, not kept
+        }
+        body = received;
+        copyText(etag, etagSize, receivedTag);
+    }
+    return head.status;
+}
+
+int rtdbScan(const char* path, const char* query, JsonScanner& scanner) {
+    char header[512];
+    int headerLength = snprintf(header, sizeof(header),
+        "GET /%s.json?auth=%s%s HTTP/1.1\r\n"
+        "Host: %s\r\n"
+        "Connection: keep-alive\r\n\r\n",
+        path, FIREBASE_AUTH, query != nullptr ? query : "", FIREBASE_HOST);
+    if (headerLength <= 0 || headerLength >= (int)sizeof(header)) {
+        return RTDB_REST_ERROR_RESPONSE;
+    }
+
+    ResponseHead head;
+    unsigned long deadline = 0;
+    bool byDeadline = false;
+    int failed = exchange(header, headerLength, nullptr, 0, head, nullptr, 0, deadline, byDeadline);
+    if (failed != 0) {
+        return failed;
+    }
+
+    scanner.reset();
+    BodySink sink = {};
+    if (head.status == 200) {
+        sink.scanner = &scanner;
+    }
+    bool complete = readResponseBody(head, sink, 0, deadline);
+    if (!complete || !head.keepAlive) {
+        restClient.stop();
+    }
+    if (!complete) {
+        return waitFailed(deadline, byDeadline);
+    }
+    if (head.status == 200 && !scanner.finish()) {
+        return unanswered(RTDB_REST_ERROR_RESPONSE);  // Malformed
+    }
+    return head.status;
+}
+
+bool rtdbUpdate(const char* path, const JsonWriter& payload, int* status) {
+    if (status != nullptr) {
+        *status = 0;
+    }
+    if (!payload.ok()) {
+        Serial.println(F("❌ Payload overflow, write skipped"));
+        return false;
+    }
+
+    unsigned long started = millis();
+    int result = rtdbPatch(path, payload.data(), payload.length());
+    RtdbCache::invalidate(path);  // Even a failed write may have landed
+    bool ok = result >= 200 && result < 300;
+    recordHttpOutcome(result, ok, started);
+    if (status != nullptr) {
+        *status = result;
+    }
+    return ok;
+}
+
+void rtdbRestStop() {
+    restClient.stop();
+}
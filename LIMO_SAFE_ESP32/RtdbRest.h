@@ -0,0 +1,41 @@
+#ifndef RTDB_REST_H
+#define RTDB_REST_H
+
+#include <Arduino.h>
+#include "JsonWriter.h"
+#include "JsonScanner.h"
+
+#define RTDB_ETAG_LEN 48            // RTDB sends a 28-char base64 SHA-1
+#define RTDB_GET_MAX_BODY 16384     // Larger bodies are refused rather than buffered
+
+// Raw RTDB REST requests over one kept-alive TLS connection. Payloads go out
+// as the bytes a JsonWriter produced; no FirebaseJson is involved. Each wait
+// is bounded by the RTT-derived timeout and the caller's DeadlineScope (see
+// RequestDeadline.h); a request that went unanswered returns one of these.
+#define RTDB_REST_ERROR_CONNECT -1
+#define RTDB_REST_ERROR_TIMEOUT -2      // The RTO ran out
+#define RTDB_REST_ERROR_RESPONSE -3     // Dropped, cut short or malformed
+#define RTDB_REST_ERROR_DEADLINE -4     // Refused or cut short by the caller's deadline
+
+// PATCH <path>.json with a JSON object; returns the HTTP status, or a negative
+// value when the request never got an answer. Network task only.
+int rtdbPatch(const char* path, const char* body, size_t length);
+
+// GET <path>.json asking for the node's ETag. 200 replaces body and etag;
+// anything else leaves both as they were. Network task only.
+int rtdbGet(const char* path, char* etag, size_t etagSize, String& body);
+
+// GET <path>.json and feed the body to scanner as it arrives, so memory stays
+// fixed whatever the size of the node. query is appended to the URL as is
+// ("&orderBy=..."). Returns the HTTP status, or a negative value when there
+// was no answer or the body was cut short or malformed. Network task only.
+int rtdbScan(const char* path, const char* query, JsonScanner& scanner);
+
+// PATCH and record the outcome with the connection health tracker; status, if
+// given, receives what rtdbPatch() returned
+bool rtdbUpdate(const char* path, const JsonWriter& payload, int* status = nullptr);
+
+// Drop the connection; the next request opens a new one
+void rtdbRestStop();
+
+#endif
@@ -0,0 +1,142 @@
+#include "TelemetryCadence.h"
+#include "FirebaseHandler.h"
+#include "DevicePaths.h"
+#include "NanoCommunicator.h"
+#include <Preferences.h>
+
+// Preferences namespace and keys for the per-device cadence
+#define CADENCE_NAMESPACE "cadence"
+#define CADENCE_PREF_IDLE "idle"
+#define CADENCE_PREF_ACTIVE "active"
+#define CADENCE_PREF_INCIDENT "incident"
+
+CadenceConfig cadenceConfig = {
+    CADENCE_IDLE_INTERVAL,
+    CADENCE_ACTIVE_INTERVAL,
+    CADENCE_INCIDENT_INTERVAL
+};
+
+// Current idle interval, doubles after every queued update until it reaches idleMs
+static unsigned long backoffInterval = CADENCE_ACTIVE_INTERVAL;
+
+static bool isValidCadence(const CadenceConfig& cfg) {
+    return cfg.incidentMs >= CADENCE_MIN_INTERVAL &&
+           cfg.activeMs >= cfg.incidentMs &&
+           cfg.idleMs >= cfg.activeMs &&
+           cfg.idleMs <= CADENCE_MAX_INTERVAL;
+}
+
+void loadCadenceConfig() {
+    Preferences cadencePrefs;
+    if (cadencePrefs.begin(CADENCE_NAMESPACE, true)) {
+        CadenceConfig stored;
+        stored.idleMs = cadencePrefs.getUInt(CADENCE_PREF_IDLE, CADENCE_IDLE_INTERVAL);
+        stored.activeMs = cadencePrefs.getUInt(CADENCE_PREF_ACTIVE, CADENCE_ACTIVE_INTERVAL);
+        stored.incidentMs = cadencePrefs.getUInt(CADENCE_PREF_INCIDENT, CADENCE_INCIDENT_INTERVAL);
+        cadencePrefs.end();
+
+        if (isValidCadence(stored)) {
+            cadenceConfig = stored;
+        } else {
+            Serial.println(F("⚠️ Stored cadence invalid, using defaults"));
+        }
+    }
+
+    backoffInterval = cadenceConfig.activeMs;
+
+    Serial.print(F("⏱️ Status cadence (idle/active/incident ms): "));
+    Serial.print(cadenceConfig.idleMs);
+    Serial.print(F("/"));
+    Serial.print(cadenceConfig.activeMs);
+    Serial.print(F("/"));
+    Serial.println(cadenceConfig.incidentMs);
+}
+
+bool saveCadenceConfig(const CadenceConfig& cfg) {
+    if (!isValidCadence(cfg)) {
+        Serial.println(F("❌ Rejected invalid cadence configuration"));
+        return false;
+    }
+
+    Preferences cadencePrefs;
+    if (!cadencePrefs.begin(CADENCE_NAMESPACE, false)) {
+        Serial.println(F("❌ Failed to access preferences for cadence"));
+        return false;
+    }
+    cadencePrefs.putUInt(CADENCE_PREF_IDLE, cfg.idleMs);
+    cadencePrefs.putUInt(CADENCE_PREF_ACTIVE, cfg.activeMs);
+    cadencePrefs.putUInt(CADENCE_PREF_INCIDENT, cfg.incidentMs);
+    cadencePrefs.end();
+
+    cadenceConfig = cfg;
+    backoffInterval = cadenceConfig.activeMs;
+    return true;
+}
+
+// Pull devices/<id>/config/telemetry once at boot; only written back when it differs
+bool syncCadenceConfigFromFirebase() {
+    if (!isFirebaseReady()) {
+        return false;
+    }
+
+    if (!Firebase.RTDB.getJSON(&fbdo, devicePaths.cadenceConfig)) {
+        return false; // No override configured for this device
+    }
+
+    FirebaseJson* json = fbdo.jsonObjectPtr();
+    if (json == nullptr) {
+        return false;
+    }
+
+    CadenceConfig remote = cadenceConfig;
+    FirebaseJsonData data;
+    if (json->get(data, "idleMs") && data.success) remote.idleMs = data.intValue;
+    if (json->get(data, "activeMs") && data.success) remote.activeMs = data.intValue;
+    if (json->get(data, "incidentMs") && data.success) remote.incidentMs = data.intValue;
+
+    if (remote.idleMs == cadenceConfig.idleMs &&
+        remote.activeMs == cadenceConfig.activeMs &&
+        remote.incidentMs == cadenceConfig.incidentMs) {
+        return true;
+    }
+
+    if (!saveCadenceConfig(remote)) {
+        return false;
+    }
+
+    Serial.println(F("✅ Status cadence updated from Firebase"));
+    return true;
+}
+
+void sendCadenceToNano() {
+    char command[48];  // Room for any uint32_t; isValidCadence() keeps the real line under 32
+    snprintf(command, sizeof(command), "CADENCE:%lu,%lu,%lu",
+             (unsigned long)cadenceConfig.idleMs,
+             (unsigned long)cadenceConfig.activeMs,
+             (unsigned long)cadenceConfig.incidentMs);
+    sendCommandToNano(command);
+}
+
+unsigned long statusIntervalFor(bool isLocked, bool isSecure) {
+    if (!isSecure) {
+        return cadenceConfig.incidentMs;
+    }
+    if (!isLocked) {
+        return cadenceConfig.activeMs;
+    }
+    return backoffInterval;
+}
+
+void noteStatusQueued(bool isLocked, bool isSecure) {
+    if (!isSecure || !isLocked) {
+        backoffInterval = cadenceConfig.activeMs;
+        return;
+    }
+
+    // Locked and secure: back off toward the idle rate
+    backoffInterval = min(backoffInterval * 2, (unsigned long)cadenceConfig.idleMs);
+}
+
+void resetStatusBackoff() {
+    backoffInterval = cadenceConfig.activeMs;
+}
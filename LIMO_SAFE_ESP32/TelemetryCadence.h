@@ -0,0 +1,34 @@
+#ifndef TELEMETRY_CADENCE_H
+#define TELEMETRY_CADENCE_H
+
+#include <Arduino.h>
+
+// Default status intervals in milliseconds, overridable per device (NVS or Firebase).
+// Keep the defaults and limits equal to LIMO_SAFE_Nano/TelemetryCadence.h, which
+// runs on them until sendCadenceToNano() reaches it.
+#define CADENCE_IDLE_INTERVAL     30000UL  // Locked and secure, fully backed off
+#define CADENCE_ACTIVE_INTERVAL   2000UL   // Door open or recent state change
+#define CADENCE_INCIDENT_INTERVAL 1000UL   // Tamper active
+#define CADENCE_MIN_INTERVAL      100UL    // Lowest accepted interval
+#define CADENCE_MAX_INTERVAL      600000UL // Highest; six digits keep "CADENCE:" within the Nano's 32-byte RX buffer
+
+struct CadenceConfig {
+    uint32_t idleMs;
+    uint32_t activeMs;
+    uint32_t incidentMs;
+};
+
+extern CadenceConfig cadenceConfig;
+
+// Configuration
+void loadCadenceConfig();
+bool saveCadenceConfig(const CadenceConfig& cfg);
+bool syncCadenceConfigFromFirebase();
+void sendCadenceToNano();
+
+// Status update scheduling
+unsigned long statusIntervalFor(bool isLocked, bool isSecure);
+void noteStatusQueued(bool isLocked, bool isSecure);
+void resetStatusBackoff();
+
+#endif
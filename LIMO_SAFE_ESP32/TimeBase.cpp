@@ -0,0 +1,113 @@
+#include "TimeBase.h"
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+
+// Anything earlier than this means SNTP has not set the clock yet
+#define TIME_BASE_MIN_EPOCH_SEC 1609459200LL   // 2021-01-01
+#define TIME_BASE_MAGIC 0x54494D31             // "TIM1"
+
+struct BootOffset {
+    uint16_t bootId;
+    bool valid;
+    int64_t offsetUs;       // epoch us = monotonic us + offsetUs
+};
+
+struct TimeBaseState {
+    uint32_t magic;
+    uint16_t bootId;
+    BootOffset boots[TIME_BASE_BOOT_HISTORY];   // Slot bootId % history
+};
+
+RTC_NOINIT_ATTR static TimeBaseState timeState;
+
+// Double-buffered so readers on either core never see a half-written 64-bit offset
+static int64_t offsetSlots[2];
+static volatile uint8_t activeSlot = 0;
+static volatile bool epochValid = false;
+
+static unsigned long lastRefresh = 0;
+
+void initTimeBase() {
+    if (timeState.magic != TIME_BASE_MAGIC) {
+        memset(&timeState, 0, sizeof(timeState));
+        timeState.magic = TIME_BASE_MAGIC;
+    }
+    timeState.bootId++;
+
+    BootOffset& slot = timeState.boots[timeState.bootId % TIME_BASE_BOOT_HISTORY];
+    slot.bootId = timeState.bootId;
+    slot.valid = false;
+    slot.offsetUs = 0;
+}
+
+uint16_t currentBootId() {
+    return timeState.bootId;
+}
+
+int64_t monotonicMicros() {
+    return esp_timer_get_time();
+}
+
+bool refreshTimeBase() {
+    lastRefresh = millis();
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t mono = esp_timer_get_time();
+
+    if (tv.tv_sec < TIME_BASE_MIN_EPOCH_SEC) {
+        return epochValid;
+    }
+
+    int64_t offset = (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec - mono;
+
+    uint8_t next = activeSlot ^ 1;
+    offsetSlots[next] = offset;
+    activeSlot = next;
+
+    BootOffset& slot = timeState.boots[timeState.bootId % TIME_BASE_BOOT_HISTORY];
+    slot.offsetUs = offset;
+    slot.valid = true;
+
+    if (!epochValid) {
+        epochValid = true;
+        Serial.println(F("🕒 Time base locked to epoch"));
+    }
+    return true;
+}
+
+// Periodic refresh (network task); cheap, no network access
+void serviceTimeBase() {
+    if (millis() - lastRefresh >= TIME_REFRESH_INTERVAL_MS || !epochValid) {
+        refreshTimeBase();
+    }
+}
+
+bool isEpochValid() {
+    return epochValid;
+}
+
+unsigned long long epochMillis() {
+    if (!epochValid) {
+        return 0;
+    }
+    return (esp_timer_get_time() + offsetSlots[activeSlot]) / 1000;
+}
+
+bool monotonicToEpochMillis(uint16_t bootId, int64_t monoUs, unsigned long long& epochMs) {
+    if (bootId == timeState.bootId) {
+        if (!epochValid) {
+            return false;
+        }
+        epochMs = (monoUs + offsetSlots[activeSlot]) / 1000;
+        return true;
+    }
+
+    const BootOffset& slot = timeState.boots[bootId % TIME_BASE_BOOT_HISTORY];
+    if (slot.bootId != bootId || !slot.valid) {
+        return false;
+    }
+    epochMs = (monoUs + slot.offsetUs) / 1000;
+    return true;
+}
@@ -0,0 +1,28 @@
+#ifndef TIME_BASE_H
+#define TIME_BASE_H
+
+#include <Arduino.h>
+
+// Monotonic clock (esp_timer, microseconds since boot) plus a cached offset to
+// epoch once NTP has set the system clock. Events are stamped with the
+// monotonic clock and rebased when they are uploaded.
+#define TIME_REFRESH_INTERVAL_MS 60000UL  // Re-read the system clock to follow SNTP corrections
+#define TIME_BASE_BOOT_HISTORY 4          // Boots whose epoch offset is remembered across resets
+
+// Bump the boot counter kept in RTC memory (call first in setup)
+void initTimeBase();
+uint16_t currentBootId();
+
+int64_t monotonicMicros();
+
+// Read the system clock and update the cached offset; true once it is valid
+bool refreshTimeBase();
+void serviceTimeBase();
+
+bool isEpochValid();
+unsigned long long epochMillis();   // 0 until the clock has been synced
+
+// Convert a (boot, monotonic) stamp to epoch ms; false if that boot never synced
+bool monotonicToEpochMillis(uint16_t bootId, int64_t monoUs, unsigned long long& epochMs);
+
+#endif
@@ -0,0 +1,529 @@
+#include "TotpVerifier.h"
+#include "FirebaseHandler.h"
+#include "DevicePaths.h"
+#include "JsonWriter.h"
+#include "RtdbRest.h"
+#include "TimeBase.h"
+#include <Preferences.h>
+#include <mbedtls/md.h>
+#include <esp_system.h>
+#include <stddef.h>
+
+// Preferences namespace and keys for the sealed table
+#define TOTP_NAMESPACE "totp"
+#define TOTP_PREF_VERSION "ver"
+#define TOTP_PREF_SALT "salt"
+#define TOTP_PREF_COUNT "count"
+#define TOTP_PREF_TABLE "table"
+#define TOTP_PREF_REPLAY "replay"
+#define TOTP_TABLE_VERSION 1
+
+#define TOTP_SALT_LEN 16
+#define TOTP_NONCE_LEN 8
+#define TOTP_MAC_LEN 16
+#define TOTP_KEY_LEN 32
+
+static const char TOTP_SYMBOLS[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+static const uint32_t TOTP_CODE_SPACE = 36UL * 36UL * 36UL * 36UL;
+
+// One user's secret, sealed: XORed with an HMAC keystream and authenticated
+// together with everything before the MAC
+struct TotpEntry {
+    char tag[AUTH_TAG_LEN];
+    char userId[AUTH_USER_ID_LEN];
+    TotpAlgorithm algorithm;
+    uint8_t secretLength;
+    uint16_t period;
+    uint8_t nonce[TOTP_NONCE_LEN];
+    uint8_t sealed[TOTP_SECRET_MAX_LEN];
+    uint8_t mac[TOTP_MAC_LEN];
+};
+
+// Last accepted time step per tag, saved to NVS on every accepted code so a
+// code works once, across resets and power cycles too
+struct TotpReplayState {
+    char tags[TOTP_MAX_USERS][AUTH_TAG_LEN];
+    uint64_t steps[TOTP_MAX_USERS];
+};
+
+static TotpReplayState replayState;
+
+// Written by the network task only; verify() on core 1 copies entries under totpMux
+static TotpEntry entries[TOTP_MAX_USERS];
+static uint8_t entryCount = 0;
+static portMUX_TYPE totpMux = portMUX_INITIALIZER_UNLOCKED;
+
+// The sealing key is derived at boot and only kept in RAM: an HMAC of a random
+// per-device salt, keyed with the factory MAC in eFuse. This keeps secrets out
+// of a plain NVS dump; against someone holding the board only flash encryption helps.
+static uint8_t sealingKey[TOTP_KEY_LEN];
+static bool keyReady = false;
+
+static volatile bool syncRequested = true;  // First sync once the network task runs
+static unsigned long lastSyncTime = 0;
+
+static int indexOfTag(const char* userTag) {
+    for (int i = 0; i < entryCount; i++) {
+        if (strcmp(entries[i].tag, userTag) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool deriveSealingKey(Preferences& totpPrefs) {
+    uint8_t salt[TOTP_SALT_LEN];
+    if (totpPrefs.getBytes(TOTP_PREF_SALT, salt, sizeof(salt)) != sizeof(salt)) {
+        esp_fill_random(salt, sizeof(salt));
+        if (totpPrefs.putBytes(TOTP_PREF_SALT, salt, sizeof(salt)) != sizeof(salt)) {
+            return false;
+        }
+    }
+
+    uint8_t mac[6];
+    esp_efuse_mac_get_default(mac);
+    return mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), mac, sizeof(mac),
+                           salt, sizeof(salt), sealingKey) == 0;
+}
+
+// Keystream for one nonce; secrets are at most one SHA-256 block long
+static void sealingStream(const uint8_t nonce[TOTP_NONCE_LEN], uint8_t out[32]) {
+    uint8_t input[1 + TOTP_NONCE_LEN] = { 'E' };
+    memcpy(input + 1, nonce, TOTP_NONCE_LEN);
+    mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), sealingKey, sizeof(sealingKey),
+                    input, sizeof(input), out);
+}
+
+static void sealingMac(const TotpEntry& entry, uint8_t out[32]) {
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    mbedtls_md_setup(&ctx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 1);
+    mbedtls_md_hmac_starts(&ctx, sealingKey, sizeof(sealingKey));
+
+    const uint8_t label = 'M';
+    mbedtls_md_hmac_update(&ctx, &label, 1);
+    mbedtls_md_hmac_update(&ctx, (const uint8_t*)&entry, offsetof(TotpEntry, mac));
+    mbedtls_md_hmac_finish(&ctx, out);
+    mbedtls_md_free(&ctx);
+}
+
+static bool openSecret(const TotpEntry& entry, uint8_t secret[TOTP_SECRET_MAX_LEN]) {
+    uint8_t mac[32];
+    sealingMac(entry, mac);
+    uint8_t diff = 0;
+    for (int i = 0; i < TOTP_MAC_LEN; i++) {
+        diff |= mac[i] ^ entry.mac[i];
+    }
+    if (diff != 0 || entry.secretLength > TOTP_SECRET_MAX_LEN) {
+        return false;
+    }
+
+    uint8_t stream[32];
+    sealingStream(entry.nonce, stream);
+    for (int i = 0; i < entry.secretLength; i++) {
+        secret[i] = entry.sealed[i] ^ stream[i];
+    }
+    memset(stream, 0, sizeof(stream));
+    return true;
+}
+
+static bool saveTable() {
+    Preferences totpPrefs;
+    if (!totpPrefs.begin(TOTP_NAMESPACE, false)) {
+        Serial.println(F("❌ Failed to access preferences for TOTP secrets"));
+        return false;
+    }
+    totpPrefs.putUChar(TOTP_PREF_VERSION, TOTP_TABLE_VERSION);
+    totpPrefs.putUChar(TOTP_PREF_COUNT, entryCount);
+    totpPrefs.putBytes(TOTP_PREF_TABLE, entries, sizeof(TotpEntry) * entryCount);
+    totpPrefs.end();
+    return true;
+}
+
+static uint64_t lastAcceptedStep(const char* userTag) {
+    for (int i = 0; i < TOTP_MAX_USERS; i++) {
+        if (strcmp(replayState.tags[i], userTag) == 0) {
+            return replayState.steps[i];
+        }
+    }
+    return 0;
+}
+
+// Called under totpMux
+static void recordAcceptedStep(const char* userTag, uint64_t step) {
+    int slot = -1;
+    for (int i = 0; i < TOTP_MAX_USERS; i++) {
+        if (strcmp(replayState.tags[i], userTag) == 0) {
+            slot = i;
+            break;
+        }
+        if (slot < 0 && replayState.tags[i][0] == '\0') {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        slot = 0; // More tags than users; losing one entry only re-opens its current window
+    }
+    strncpy(replayState.tags[slot], userTag, AUTH_TAG_LEN - 1);
+    replayState.tags[slot][AUTH_TAG_LEN - 1] = '\0';
+    replayState.steps[slot] = step;
+}
+
+static void saveReplayState() {
+    TotpReplayState copy;
+    portENTER_CRITICAL(&totpMux);
+    copy = replayState;
+    portEXIT_CRITICAL(&totpMux);
+
+    Preferences totpPrefs;
+    if (!totpPrefs.begin(TOTP_NAMESPACE, false) ||
+        totpPrefs.putBytes(TOTP_PREF_REPLAY, &copy, sizeof(copy)) != sizeof(copy)) {
+        Serial.println(F("⚠️ Failed to save used TOTP steps"));
+    }
+    totpPrefs.end();
+}
+
+void TotpVerifier::load() {
+    memset(&replayState, 0, sizeof(replayState));
+
+    Preferences totpPrefs;
+    if (!totpPrefs.begin(TOTP_NAMESPACE, false)) {
+        return;
+    }
+
+    keyReady = deriveSealingKey(totpPrefs);
+    if (totpPrefs.getUChar(TOTP_PREF_VERSION, 0) == TOTP_TABLE_VERSION) {
+        uint8_t storedCount = totpPrefs.getUChar(TOTP_PREF_COUNT, 0);
+        if (storedCount <= TOTP_MAX_USERS &&
+            totpPrefs.getBytes(TOTP_PREF_TABLE, entries, sizeof(entries)) == sizeof(TotpEntry) * storedCount) {
+            entryCount = storedCount;
+        }
+        if (totpPrefs.getBytes(TOTP_PREF_REPLAY, &replayState, sizeof(replayState)) != sizeof(replayState)) {
+            memset(&replayState, 0, sizeof(replayState));
+        }
+    }
+    totpPrefs.end();
+
+    Serial.print(F("🔐 TOTP secrets stored: "));
+    Serial.println(entryCount);
+}
+
+size_t TotpVerifier::count() {
+    return entryCount;
+}
+
+bool TotpVerifier::generateCode(const uint8_t* secret, size_t length, TotpAlgorithm algorithm,
+                                uint64_t timeStep, char out[TOTP_CODE_LEN + 1]) {
+    const mbedtls_md_info_t* info =
+        mbedtls_md_info_from_type(algorithm == TOTP_SHA256 ? MBEDTLS_MD_SHA256 : MBEDTLS_MD_SHA1);
+    if (info == nullptr) {
+        return false;
+    }
+
+    uint8_t message[8];
+    for (int i = 7; i >= 0; i--) {
+        message[i] = timeStep & 0xFF;
+        timeStep >>= 8;
+    }
+
+    uint8_t digest[32];
+    if (mbedtls_md_hmac(info, secret, length, message, sizeof(message), digest) != 0) {
+        return false;
+    }
+
+    // RFC 4226 dynamic truncation, then base 36 instead of decimal digits
+    uint8_t offset = digest[mbedtls_md_get_size(info) - 1] & 0x0F;
+    uint32_t value = ((uint32_t)(digest[offset] & 0x7F) << 24) | ((uint32_t)digest[offset + 1] << 16) |
+                     ((uint32_t)digest[offset + 2] << 8) | digest[offset + 3];
+    memset(digest, 0, sizeof(digest));
+
+    value %= TOTP_CODE_SPACE;
+    for (int i = TOTP_CODE_LEN - 1; i >= 0; i--) {
+        out[i] = TOTP_SYMBOLS[value % 36];
+        value /= 36;
+    }
+    out[TOTP_CODE_LEN] = '\0';
+    return true;
+}
+
+TotpResult TotpVerifier::verify(const char* userTag, const char* code, char userId[AUTH_USER_ID_LEN]) {
+    TotpEntry entry;
+    bool found = false;
+    portENTER_CRITICAL(&totpMux);
+    int index = indexOfTag(userTag);
+    if (index >= 0) {
+        entry = entries[index];
+        found = true;
+    }
+    portEXIT_CRITICAL(&totpMux);
+
+    if (!found || !keyReady) {
+        return TOTP_UNAVAILABLE;
+    }
+    if (!isEpochValid()) {
+        Serial.println(F("⚠️ Clock not synced, TOTP check left to the cloud"));
+        return TOTP_UNAVAILABLE;
+    }
+    if (strlen(code) != TOTP_CODE_LEN) {
+        return TOTP_REJECTED;
+    }
+
+    uint8_t secret[TOTP_SECRET_MAX_LEN];
+    if (!openSecret(entry, secret)) {
+        Serial.println(F("❌ Stored TOTP secret failed its integrity check"));
+        return TOTP_UNAVAILABLE;
+    }
+
+    uint64_t currentStep = epochMillis() / 1000 / entry.period;
+    portENTER_CRITICAL(&totpMux);
+    uint64_t lastStep = lastAcceptedStep(userTag);
+    portEXIT_CRITICAL(&totpMux);
+
+    // Every step in the window is computed, so the time taken doesn't tell which one matched
+    bool matched = false;
+    bool replayed = false;
+    uint64_t matchedStep = 0;
+    for (int skew = -TOTP_SKEW_STEPS; skew <= TOTP_SKEW_STEPS; skew++) {
+        uint64_t step = currentStep + skew;
+        char expected[TOTP_CODE_LEN + 1];
+        if (!generateCode(secret, entry.secretLength, entry.algorithm, step, expected)) {
+            continue;
+        }
+        uint8_t diff = 0;
+        for (int i = 0; i < TOTP_CODE_LEN; i++) {
+            diff |= expected[i] ^ toupper(code[i]);
+        }
+        if (diff == 0) {
+            if (step > lastStep) {
+                matched = true;
+                matchedStep = step;
+            } else {
+                replayed = true;
+            }
+        }
+    }
+    memset(secret, 0, sizeof(secret));
+
+    if (!matched) {
+        Serial.println(replayed ? F("❌ TOTP code already used") : F("❌ TOTP code mismatch"));
+        return TOTP_REJECTED;
+    }
+
+    portENTER_CRITICAL(&totpMux);
+    recordAcceptedStep(userTag, matchedStep);
+    portEXIT_CRITICAL(&totpMux);
+    saveReplayState();
+
+    strncpy(userId, entry.userId, AUTH_USER_ID_LEN - 1);
+    userId[AUTH_USER_ID_LEN - 1] = '\0';
+    return TOTP_VALID;
+}
+
+bool TotpVerifier::provision(const char* userTag, const char* userId, const uint8_t* secret, size_t length,
+                             TotpAlgorithm algorithm, uint16_t period) {
+    if (!keyReady || strlen(userTag) == 0 || strlen(userTag) >= AUTH_TAG_LEN ||
+        strlen(userId) == 0 || strlen(userId) >= AUTH_USER_ID_LEN ||
+        length < TOTP_SECRET_MIN_LEN || length > TOTP_SECRET_MAX_LEN || period == 0) {
+        Serial.println(F("⚠️ Ignoring malformed TOTP secret"));
+        return false;
+    }
+
+    TotpEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.tag, userTag, AUTH_TAG_LEN - 1);
+    strncpy(entry.userId, userId, AUTH_USER_ID_LEN - 1);
+    entry.algorithm = algorithm;
+    entry.secretLength = (uint8_t)length;
+    entry.period = period;
+    esp_fill_random(entry.nonce, sizeof(entry.nonce));
+
+    uint8_t stream[32];
+    sealingStream(entry.nonce, stream);
+    for (size_t i = 0; i < length; i++) {
+        entry.sealed[i] = secret[i] ^ stream[i];
+    }
+    memset(stream, 0, sizeof(stream));
+
+    uint8_t mac[32];
+    sealingMac(entry, mac);
+    memcpy(entry.mac, mac, TOTP_MAC_LEN);
+
+    portENTER_CRITICAL(&totpMux);
+    int index = indexOfTag(userTag);
+    if (index < 0 && entryCount < TOTP_MAX_USERS) {
+        index = entryCount++;
+    }
+    if (index >= 0) {
+        entries[index] = entry;
+    }
+    portEXIT_CRITICAL(&totpMux);
+
+    if (index < 0) {
+        Serial.println(F("⚠️ TOTP table full, secret not stored"));
+        return false;
+    }
+    return saveTable();
+}
+
+bool TotpVerifier::remove(const char* userTag) {
+    portENTER_CRITICAL(&totpMux);
+    int index = indexOfTag(userTag);
+    if (index >= 0) {
+        entries[index] = entries[--entryCount];
+        memset(&entries[entryCount], 0, sizeof(TotpEntry));
+    }
+    portEXIT_CRITICAL(&totpMux);
+
+    return index >= 0 && saveTable();
+}
+
+void TotpVerifier::requestSync() {
+    syncRequested = true;
+}
+
+// RFC 4648 base32 as authenticator apps show it; case, spaces, dashes and padding ignored
+static int decodeBase32(const char* text, uint8_t* out, size_t capacity) {
+    uint32_t buffer = 0;
+    int bits = 0;
+    size_t length = 0;
+
+    for (const char* p = text; *p != '\0'; p++) {
+        char c = toupper(*p);
+        if (c == '=' || c == ' ' || c == '-') {
+            continue;
+        }
+
+        int value;
+        if (c >= 'A' && c <= 'Z') {
+            value = c - 'A';
+        } else if (c >= '2' && c <= '7') {
+            value = c - '2' + 26;
+        } else {
+            return -1;
+        }
+
+        buffer = (buffer << 5) | value;
+        bits += 5;
+        if (bits >= 8) {
+            if (length >= capacity) {
+                return -1;
+            }
+            bits -= 8;
+            out[length++] = (buffer >> bits) & 0xFF;
+        }
+    }
+    return (int)length;
+}
+
+// Clear the provisioning request and publish the outcome in one PATCH of devices/<id>
+static void acknowledgeProvisioning(const char* userTag, bool stored) {
+    char provisionKey[40];
+    char usersKey[40];
+    snprintf(provisionKey, sizeof(provisionKey), "totpProvision/%s", userTag);
+    snprintf(usersKey, sizeof(usersKey), "totpUsers/%s", userTag);
+
+    StaticJsonWriter<128> payload;
+    payload.beginObject();
+    payload.nullField(provisionKey);
+    if (stored) {
+        payload.serverTimestamp(usersKey);
+    }
+    payload.endObject();
+    rtdbUpdate(devicePaths.root, payload);
+}
+
+static void fetchProvisionedSecrets() {
+    if (!Firebase.RTDB.getJSON(&fbdo, devicePaths.totpProvision)) {
+        return; // Nothing waiting
+    }
+
+    FirebaseJson* json = fbdo.jsonObjectPtr();
+    if (json == nullptr) {
+        return;
+    }
+
+    // Collect the tags first; reading values resets the iterator
+    char tags[TOTP_MAX_USERS][AUTH_TAG_LEN];
+    uint8_t tagCount = 0;
+    size_t len = json->iteratorBegin();
+    for (size_t i = 0; i < len && tagCount < TOTP_MAX_USERS; i++) {
+        FirebaseJson::IteratorValue value = json->valueAt(i);
+        if (value.depth == 0 && value.key.length() > 0 && value.key.length() < AUTH_TAG_LEN) {
+            strncpy(tags[tagCount], value.key.c_str(), AUTH_TAG_LEN - 1);
+            tags[tagCount][AUTH_TAG_LEN - 1] = '\0';
+            tagCount++;
+        }
+    }
+    json->iteratorEnd();
+
+    for (uint8_t i = 0; i < tagCount; i++) {
+        const AuthorizedUser* user = AuthorizedUsers::find(tags[i]);
+        if (user == nullptr) {
+            continue; // Wait until the tag is registered to this device
+        }
+
+        char key[AUTH_TAG_LEN + 16];
+        FirebaseJsonData secretData, algorithmData, periodData;
+        snprintf(key, sizeof(key), "%s/secret", tags[i]);
+        json->get(secretData, key);
+        snprintf(key, sizeof(key), "%s/algorithm", tags[i]);
+        json->get(algorithmData, key);
+        snprintf(key, sizeof(key), "%s/period", tags[i]);
+        json->get(periodData, key);
+
+        uint8_t secret[TOTP_SECRET_MAX_LEN];
+        int length = secretData.success ? decodeBase32(secretData.stringValue.c_str(), secret, sizeof(secret)) : -1;
+        TotpAlgorithm algorithm = (algorithmData.success && algorithmData.stringValue == "SHA256") ? TOTP_SHA256 : TOTP_SHA1;
+        int period = periodData.success ? periodData.intValue : TOTP_DEFAULT_PERIOD;
+
+        bool stored = length > 0 && period > 0 && period <= 300 &&
+                      TotpVerifier::provision(tags[i], user->userId, secret, length, algorithm, (uint16_t)period);
+        memset(secret, 0, sizeof(secret));
+
+        acknowledgeProvisioning(tags[i], stored);
+        Serial.print(stored ? F("🔐 TOTP secret stored for tag ") : F("❌ Rejected TOTP secret for tag "));
+        Serial.println(tags[i]);
+    }
+}
+
+// A secret only stays while its tag is registered to the same user
+static void pruneDeregistered() {
+    if (!AuthorizedUsers::isSynced()) {
+        return;
+    }
+
+    for (int i = entryCount - 1; i >= 0; i--) {
+        const AuthorizedUser* user = AuthorizedUsers::find(entries[i].tag);
+        if (user != nullptr && strcmp(user->userId, entries[i].userId) == 0) {
+            continue;
+        }
+
+        char userTag[AUTH_TAG_LEN];
+        strncpy(userTag, entries[i].tag, AUTH_TAG_LEN - 1);
+        userTag[AUTH_TAG_LEN - 1] = '\0';
+        TotpVerifier::remove(userTag);
+
+        char usersKey[40];
+        snprintf(usersKey, sizeof(usersKey), "totpUsers/%s", userTag);
+        StaticJsonWriter<64> payload;
+        payload.beginObject().nullField(usersKey).endObject();
+        rtdbUpdate(devicePaths.root, payload);
+
+        Serial.print(F("🗑️ TOTP secret removed for tag "));
+        Serial.println(userTag);
+    }
+}
+
+void TotpVerifier::serviceSync() {
+    if (!syncRequested && millis() - lastSyncTime < TOTP_SYNC_INTERVAL_MS) {
+        return;
+    }
+    if (!keyReady || !devicePathsReady() || !isFirebaseReady()) {
+        return;
+    }
+
+    syncRequested = false;
+    lastSyncTime = millis();
+    pruneDeregistered();
+    fetchProvisionedSecrets();
+}
@@ -0,0 +1,67 @@
+#ifndef TOTP_VERIFIER_H
+#define TOTP_VERIFIER_H
+
+#include <Arduino.h>
+#include "AuthorizedUsers.h"
+
+// On-device OTP check. The app derives the code from a TOTP secret that the
+// device also holds, so an unlock needs no cloud round trip; the cloud only
+// receives the audit event.
+//
+// A code is the user tag followed by TOTP_CODE_LEN symbols. The symbols are
+// the RFC 6238 value (HMAC-SHA1 or HMAC-SHA256 over floor(unixTime / period),
+// with RFC 4226 dynamic truncation) taken mod 36^4 and written in base 36
+// with "0-9A-Z", most significant symbol first. The code stays Morse-friendly
+// and has the same length as the cloud codes.
+//
+// Secrets are provisioned at devices/<id>/totpProvision/<tag> =
+//   {"secret": "<base32>", "algorithm": "SHA1" | "SHA256", "period": 30}
+// The device seals each secret into NVS, deletes the cloud copy and sets
+// devices/<id>/totpUsers/<tag> to the provisioning time.
+
+#define TOTP_MAX_USERS AUTH_MAX_USERS
+#define TOTP_SECRET_MIN_LEN 10          // 80 bits, the usual authenticator minimum
+#define TOTP_SECRET_MAX_LEN 32
+#define TOTP_CODE_LEN 4
+#define TOTP_DEFAULT_PERIOD 30
+#define TOTP_SKEW_STEPS 1               // Also accept the previous and the next period
+#define TOTP_SYNC_INTERVAL_MS 600000UL  // Look for newly provisioned secrets every 10 minutes
+
+enum TotpAlgorithm : uint8_t {
+    TOTP_SHA1,
+    TOTP_SHA256
+};
+
+enum TotpResult {
+    TOTP_UNAVAILABLE,   // No secret for this tag or no valid clock: use the cloud check
+    TOTP_VALID,
+    TOTP_REJECTED
+};
+
+class TotpVerifier {
+public:
+    // Restore sealed secrets from NVS (call once in setup)
+    static void load();
+    static size_t count();
+
+    // Core 1: check a code against the tag's secret; userId is filled in on success.
+    // A code is accepted once, and never for an earlier time step than the last one;
+    // the last accepted step per tag is kept in NVS, so this holds across power cycles.
+    static TotpResult verify(const char* userTag, const char* code, char userId[AUTH_USER_ID_LEN]);
+
+    // Network task: seal and store a secret, replacing any previous one for the tag
+    static bool provision(const char* userTag, const char* userId, const uint8_t* secret, size_t length,
+                          TotpAlgorithm algorithm, uint16_t period);
+    static bool remove(const char* userTag);
+
+    // Network task: fetch pending secrets and drop secrets of deregistered users,
+    // when requested (registered users changed) or every TOTP_SYNC_INTERVAL_MS
+    static void requestSync();
+    static void serviceSync();
+
+    // The code for one time step; false if the algorithm is unavailable
+    static bool generateCode(const uint8_t* secret, size_t length, TotpAlgorithm algorithm,
+                             uint64_t timeStep, char out[TOTP_CODE_LEN + 1]);
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "UploadScheduler.h"
+#include "EventLogger.h"
+#include "RegistrationQueue.h"
+#include "DevicePaths.h"
+#include "ConnectionHealth.h"
+#include "TimeBase.h"
+#include "DevicePayloads.h"
+#include "DeviceTransport.h"
+#include <esp_system.h>
+
+// Diagnostics are latest-wins: a newer snapshot replaces one that never went out
+static bool diagnosticsPending = false;
+static unsigned long lastDiagnosticsMs = 0;
+
+static UploadResult uploadSecurityEvents() { return processEventQueue(UPLOAD_SECURITY); }
+static UploadResult uploadAuditEvents() { return processEventQueue(UPLOAD_AUDIT); }
+static bool hasSecurityEvents() { return pendingEventCount(UPLOAD_SECURITY) > 0; }
+static bool hasAuditEvents() { return pendingEventCount(UPLOAD_AUDIT) > 0; }
+static bool hasDiagnostics() { return diagnosticsPending; }
+static UploadResult uploadDiagnostics();
+
+struct UploadHandler {
+    const char* name;
+    bool (*hasPending)();
+    UploadResult (*upload)();
+};
+
+// Indexed by UploadClass
+static const UploadHandler UPLOAD_HANDLERS[UPLOAD_CLASS_COUNT] = {
+    { "security",    hasSecurityEvents, uploadSecurityEvents },
+    { "audit",       hasAuditEvents,    uploadAuditEvents },
+    { "registration", hasPendingRegistrations, uploadPendingRegistration },
+    { "status",      hasPendingStatus,  uploadPendingStatus },
+    { "diagnostics", hasDiagnostics,    uploadDiagnostics }
+};
+
+static UploadClassStats uploadStats[UPLOAD_CLASS_COUNT];
+
+// Token bucket
+static float uploadRate = UPLOAD_RATE_INITIAL;
+static float uploadTokens = UPLOAD_BUCKET_CAPACITY;
+static unsigned long lastRefillMs = 0;
+
+static void refillTokens(unsigned long now) {
+    if (lastRefillMs == 0) {
+        lastRefillMs = now;
+        return;
+    }
+    uploadTokens += uploadRate * (now - lastRefillMs) / 1000.0f;
+    if (uploadTokens > UPLOAD_BUCKET_CAPACITY) {
+        uploadTokens = UPLOAD_BUCKET_CAPACITY;
+    }
+    lastRefillMs = now;
+}
+
+static void setUploadRate(float rate) {
+    if (rate < UPLOAD_RATE_MIN) rate = UPLOAD_RATE_MIN;
+    if (rate > UPLOAD_RATE_MAX) rate = UPLOAD_RATE_MAX;
+    uploadRate = rate;
+}
+
+// AIMD on the outcome: creep up while RTDB answers quickly, back off on slow answers,
+// halve on failures and drop to the floor when the server says it is overloaded
+static void adaptUploadRate(UploadResult result, unsigned long latencyMs) {
+    if (result == UPLOAD_OK) {
+        if (latencyMs <= UPLOAD_LATENCY_TARGET_MS) {
+            setUploadRate(uploadRate + UPLOAD_RATE_STEP);
+        } else {
+            setUploadRate(uploadRate * 0.8f);
+        }
+        return;
+    }
+
+    int httpCode = getConnectionStats().lastHttpCode;
+    if (httpCode == 429 || httpCode == 503) {
+        setUploadRate(UPLOAD_RATE_MIN);
+        uploadTokens = 0;
+    } else {
+        setUploadRate(uploadRate * 0.5f);
+    }
+}
+
+static bool hasPendingUploadsAbove(UploadClass uploadClass) {
+    for (uint8_t cls = 0; cls < uploadClass; cls++) {
+        if (UPLOAD_HANDLERS[cls].hasPending()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Security may borrow one request against the bucket; the rest need a full token,
+// and diagnostics only go out with headroom and nothing else waiting
+static bool mayUpload(UploadClass uploadClass) {
+    switch (uploadClass) {
+        case UPLOAD_SECURITY:
+            return uploadTokens >= 0.0f;
+        case UPLOAD_DIAGNOSTICS:
+            return uploadTokens >= UPLOAD_BUCKET_CAPACITY / 2 && !hasPendingUploadsAbove(uploadClass);
+        default:
+            return uploadTokens >= 1.0f;
+    }
+}
+
+static void queueDiagnostics(unsigned long now) {
+    if (now - lastDiagnosticsMs < UPLOAD_DIAGNOSTICS_INTERVAL && lastDiagnosticsMs != 0) {
+        return;
+    }
+    lastDiagnosticsMs = now;
+    if (diagnosticsPending) {
+        uploadStats[UPLOAD_DIAGNOSTICS].dropped++;
+    }
+    diagnosticsPending = true;
+}
+
+static UploadResult uploadDiagnostics() {
+    const ConnectionStats& health = getConnectionStats();
+    DiagnosticsSnapshot snapshot;
+    snapshot.latencyMs = health.smoothedLatencyMs;
+    snapshot.successes = health.successes;
+    snapshot.failures = health.failures;
+    snapshot.probes = health.probes;
+    snapshot.lastHttpCode = health.lastHttpCode;
+    snapshot.uploadRate = uploadRate;
+    snapshot.droppedSecurity = droppedEventCount(UPLOAD_SECURITY);
+    snapshot.droppedAudit = droppedEventCount(UPLOAD_AUDIT);
+    snapshot.droppedDiagnostics = uploadStats[UPLOAD_DIAGNOSTICS].dropped;
+    snapshot.freeHeap = esp_get_free_heap_size();
+    snapshot.uptimeSec = (uint32_t)(monotonicMicros() / 1000000LL);
+
+    static DiagnosticsPayload payload;
+    if (!writeDiagnosticsPayload(payload, snapshot) ||
+        !uploadTransport().update(devicePaths.diagnostics, payload, TRANSPORT_LATEST)) {
+        return UPLOAD_FAILED;
+    }
+    diagnosticsPending = false;
+    return UPLOAD_OK;
+}
+
+void processUploads() {
+    unsigned long now = millis();
+    refillTokens(now);
+    queueDiagnostics(now);
+
+    for (uint8_t cls = 0; cls < UPLOAD_CLASS_COUNT; cls++) {
+        const UploadHandler& handler = UPLOAD_HANDLERS[cls];
+        if (!handler.hasPending()) {
+            continue;
+        }
+
+        // Strict priority: if the top class with work can't go, nothing below it may
+        if (!mayUpload((UploadClass)cls)) {
+            return;
+        }
+
+        unsigned long started = millis();
+        UploadResult result = handler.upload();
+        if (result == UPLOAD_IDLE) {
+            continue;  // Deferred, give the next class a chance
+        }
+
+        uploadTokens -= 1.0f;
+        adaptUploadRate(result, millis() - started);
+        if (result == UPLOAD_OK) {
+            uploadStats[cls].sent++;
+        } else {
+            uploadStats[cls].failed++;
+        }
+        return;  // One request per call keeps the network task responsive
+    }
+}
+
+float currentUploadRate() {
+    return uploadRate;
+}
+
+const UploadClassStats& getUploadStats(UploadClass uploadClass) {
+    static UploadClassStats empty;
+    if (uploadClass >= UPLOAD_CLASS_COUNT) {
+        return empty;
+    }
+    if (uploadClass == UPLOAD_SECURITY || uploadClass == UPLOAD_AUDIT) {
+        uploadStats[uploadClass].dropped = droppedEventCount(uploadClass);
+    }
+    return uploadStats[uploadClass];
+}
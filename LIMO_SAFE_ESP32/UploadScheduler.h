@@ -0,0 +1,47 @@
+#ifndef UPLOAD_SCHEDULER_H
+#define UPLOAD_SCHEDULER_H
+
+#include <Arduino.h>
+
+// Upload classes in priority order; lower values always go first
+enum UploadClass : uint8_t {
+    UPLOAD_SECURITY,     // Tamper, lock and access events - never shed
+    UPLOAD_AUDIT,        // Enrollment, deletion and other bookkeeping events
+    UPLOAD_REGISTRATION, // First-user registration and role writes after an unlock
+    UPLOAD_STATUS,       // Latest device status, newer values replace older ones
+    UPLOAD_DIAGNOSTICS,  // Health snapshot, shed first under backpressure
+    UPLOAD_CLASS_COUNT
+};
+
+enum UploadResult : uint8_t {
+    UPLOAD_IDLE,         // Nothing sent (empty or deferred)
+    UPLOAD_OK,
+    UPLOAD_FAILED
+};
+
+// Token-bucket pacing, adapted to what RTDB reports back
+#define UPLOAD_BUCKET_CAPACITY    4.0f     // Burst size in requests
+#define UPLOAD_RATE_INITIAL       2.0f     // Requests per second
+#define UPLOAD_RATE_MIN           0.2f
+#define UPLOAD_RATE_MAX           8.0f
+#define UPLOAD_RATE_STEP          0.25f    // Additive increase per fast success
+#define UPLOAD_LATENCY_TARGET_MS  800UL    // Slower successes count as congestion
+#define UPLOAD_DIAGNOSTICS_INTERVAL 300000UL // Snapshot every 5 minutes
+
+struct UploadClassStats {
+    uint32_t sent;
+    uint32_t failed;
+    uint32_t dropped;     // Shed by the scheduler or overwritten in a full queue
+};
+
+// Run at most one upload, highest class first (network task)
+void processUploads();
+
+float currentUploadRate();
+const UploadClassStats& getUploadStats(UploadClass uploadClass);
+
+// Status class, implemented by NanoCommunicator
+bool hasPendingStatus();
+UploadResult uploadPendingStatus();
+
+#endif
@@ -1,43 +1,31 @@
 #include "UserManager.h"
 #include "FirebaseHandler.h"
+#include "DevicePaths.h"
+#include "RtdbCache.h"
+#include "RtdbRest.h"
+#include "JsonScanner.h"
+#include "ConnectionHealth.h"
 
-bool UserManager::isFirstTimeUser(FirebaseData& fbdo, const String& deviceId) {
-    String regPath = String(DEVICE_PATH) + deviceId + REGISTERED_USERS_NODE;
-    
-    if (!Firebase.RTDB.getJSON(&fbdo, regPath.c_str())) {
-        // Path doesn't exist - this means no users are registered yet
-        // Check for specific error messages that indicate path absence
-        String errorReason = fbdo.errorReason();
-        if (errorReason == "path not found" || errorReason == "path not exist") {
-            Serial.println("ℹ️ No registered users found - first time setup");
-            return true;
-        } else {
-            // Some other error occurred
-            Serial.print("❌ Firebase error: ");
-            Serial.println(errorReason);
-            return true; // Assume first time if we can't verify otherwise
-        }
+bool UserManager::isFirstTimeUser(bool* verified) {
+    if (verified != nullptr) {
+        *verified = false;
     }
-    
-    // Path exists, check if there are any registered users
-    FirebaseJson* regJson = fbdo.jsonObjectPtr();
-    if (regJson == nullptr) {
-        Serial.println("ℹ️ No JSON data - first time setup");
-        return true;
+    const String* body = RtdbCache::get(devicePaths.registeredUsers, CACHE_TTL_REGISTRATION_MS);
+    if (body == nullptr) {
+        Serial.println("❌ Failed to read registered users");
+        return false; // Never hand out first-user rights on a failed read
     }
     
-    size_t count = 0;
-    String key, value;
-    int type = 0;
-    
-    size_t len = regJson->iteratorBegin();
-    for (size_t i = 0; i < len; i++) {
-        regJson->iteratorGet(i, type, key, value);
-        if (value.length() > 0) {
-            count++;
-        }
+    // Count non-empty children without building a DOM; a missing node reads as null
+    JsonChildCounter counter(true);
+    if (!counter.scan(*body)) {
+        Serial.println("❌ Malformed registered users");
+        return false; // Never hand out first-user rights on a bad read
+    }
+    if (verified != nullptr) {
+        *verified = true;
     }
-    regJson->iteratorEnd();
+    int count = counter.children();
     
     // If no users found, it's first time setup
     if (count == 0) {
@@ -51,49 +39,60 @@ bool UserManager::isFirstTimeUser(FirebaseData& fbdo, const String& deviceId) {
     return false;
 }
 
-bool UserManager::verifyUserTag(FirebaseData& fbdo, const String& userTag, const String& deviceId, bool isFirstUser, String& foundUserId) {
+bool UserManager::verifyUserTag(const String& userTag, String& foundUserId) {
     Serial.print("📡 Querying Firebase for user tag: ");
     Serial.println(userTag);
 
-    QueryFilter query;
-    query.orderBy("tag");  
-    query.equalTo(userTag);  
-    query.limitToFirst(1);  
-
-    if (!Firebase.RTDB.getJSON(&fbdo, "users", &query)) {  
-        Serial.print("❌ Firebase Query Failed: ");
-        Serial.println(fbdo.errorReason());
+    if (!findUserIdByTag(userTag, foundUserId)) {
         return false;
     }
 
-    FirebaseJson json = fbdo.jsonObject();
-    FirebaseJsonData jsonData;
-    size_t len = json.iteratorBegin();
+    Serial.print("✅ Found User ID: ");
+    Serial.println(foundUserId);
+    
+    return true;
+}
 
-    if (len == 0) {
-        Serial.println("❌ No user found with this tag.");
+bool UserManager::findUserIdByTag(const String& userTag, String& userId) {
+    // orderBy="tag"&equalTo="<tag>"&limitToFirst=1, the tag percent-encoded
+    char query[96];
+    int length = snprintf(query, sizeof(query), "&orderBy=%%22tag%%22&equalTo=%%22");
+    for (size_t i = 0; i < userTag.length() && length < (int)sizeof(query) - 24; i++) {
+        length += snprintf(query + length, sizeof(query) - length, "%%%02X", (uint8_t)userTag.charAt(i));
+    }
+    snprintf(query + length, sizeof(query) - length, "%%22&limitToFirst=1");
+    
+    // Only the first key matters; the user record itself is skipped as it streams past
+    char key[JSON_SCAN_KEY_LEN];
+    JsonFirstKey firstKey(key, sizeof(key));
+    unsigned long started = millis();
+    int status = rtdbScan("users", query, firstKey);
+    recordHttpOutcome(status, status == 200, started);
+    if (status != 200) {
+        Serial.print(F("❌ Firebase Query Failed: "));
+        Serial.println(status);
         return false;
     }
-
-    // 🔹 Extract user ID
-    String key, value;
-    int type = 0;
-    json.iteratorGet(0, type, key, value);
-    json.iteratorEnd();
-
-    foundUserId = key;  // ✅ Assign user ID
-    Serial.print("✅ Found User ID: ");
-    Serial.println(foundUserId);
     
+    if (!firstKey.hasKey()) {
+        Serial.println(F("❌ No user found for this tag"));
+        return false;
+    }
+    userId = key;
     return true;
 }
 
-bool UserManager::registerUserToDevice(FirebaseData& fbdo, const String& deviceId, const String& userId, const String& userTag, bool isFirstUser) {
+bool UserManager::registerUserToDevice(FirebaseData& fbdo, const String& userId, const String& userTag) {
     // Make sure we're using only the userTag, not the full OTP
-    String path = String(DEVICE_PATH) + deviceId + REGISTERED_USERS_NODE + "/" + userTag;
+    char path[CHILD_PATH_LEN];
+    if (!formatChildPath(path, sizeof(path), devicePaths.registeredUsers, userTag.c_str())) {
+        return false;
+    }
     
     // Set the user ID as the value
-    if (!Firebase.RTDB.setString(&fbdo, path.c_str(), userId)) {
+    bool ok = Firebase.RTDB.setString(&fbdo, path, userId);
+    RtdbCache::invalidate(path);
+    if (!ok) {
         Serial.println("❌ Failed to register user to device");
         return false;
     }
@@ -102,12 +101,16 @@ bool UserManager::registerUserToDevice(FirebaseData& fbdo, const String& deviceI
     return true;
 }
 
-bool UserManager::updateUserDeviceRegistration(FirebaseData& fbdo, const String& userId, const String& deviceId, const String& userRole) {
-    String userPath = String(USERS_PATH) + userId;
-    String deviceRolePath = userPath + "/registeredDevices/" + deviceId + "/role";
+bool UserManager::updateUserDeviceRegistration(FirebaseData& fbdo, const String& userId, const String& userRole) {
+    char deviceRolePath[USER_PATH_LEN];
+    if (!formatUserDevicePath(deviceRolePath, sizeof(deviceRolePath), userId.c_str(), "role")) {
+        return false;
+    }
     
     // Set the role for this device directly using the new structure
-    if (!Firebase.RTDB.setString(&fbdo, deviceRolePath.c_str(), userRole)) {
+    bool ok = Firebase.RTDB.setString(&fbdo, deviceRolePath, userRole);
+    RtdbCache::invalidate(deviceRolePath);
+    if (!ok) {
         Serial.print("❌ Failed to update user's device registration: ");
         Serial.println(fbdo.errorReason());
         return false;
@@ -7,17 +7,21 @@
 
 class UserManager {
 public:
-    // Check if this is the first user registration for the device
-    static bool isFirstTimeUser(FirebaseData& fbdo, const String& deviceId);
+    // Check if this is the first user registration for the device. Any read that
+    // fails answers false and clears *verified, so callers can tell "no" from "unknown".
+    static bool isFirstTimeUser(bool* verified = nullptr);
     
     // Verify user tag exists and get user ID
-    static bool verifyUserTag(FirebaseData& fbdo, const String& userTag, const String& deviceId, bool isFirstUser, String& foundUserId);
+    static bool verifyUserTag(const String& userTag, String& foundUserId);
+    
+    // Query users by tag, streaming the answer; false when none matched or the read failed
+    static bool findUserIdByTag(const String& userTag, String& userId);
     
     // Register user to device, handles duplicate registrations
-    static bool registerUserToDevice(FirebaseData& fbdo, const String& deviceId, const String& userId, const String& userTag, bool isFirstUser);
+    static bool registerUserToDevice(FirebaseData& fbdo, const String& userId, const String& userTag);
     
     // Update user's registered devices list, maintains array of devices
-    static bool updateUserDeviceRegistration(FirebaseData& fbdo, const String& userId, const String& deviceId, const String& userRole);
+    static bool updateUserDeviceRegistration(FirebaseData& fbdo, const String& userId, const String& userRole);
 };
 
 #endif
@@ -1,14 +1,15 @@
 #include "WiFiSetup.h"
 #include "secrets.h"
 #include "FirebaseHandler.h"
+#include "DevicePaths.h"
 #include "RGBLed.h"
+#include "NetworkTask.h"
+#include "TimeBase.h"
 #include <WiFi.h>
 #include <Preferences.h>
 
 // External declarations for Firebase variables
 extern FirebaseData fbdo;
-extern const char* const DEVICE_PATH;
-extern const char* const WIFI_NODE;
 extern String deviceId;
 
 // Constants for configuration
@@ -34,7 +35,6 @@ const long GMT_OFFSET_SEC = 0;
 const int DAYLIGHT_OFFSET_SEC = 0;
 
 // Forward declarations for helper functions
-bool updateFirebaseWiFiStatus(bool connected);
 void loadWiFiCredentials(String &ssid, String &password, int &failedAttempts);
 void saveWiFiCredentials(const String &ssid, const String &password);
 void saveFailedAttempts(int failedAttempts);
@@ -302,6 +302,14 @@ void saveFailedAttempts(int failedAttempts) {
 }
 
 bool updateFirebaseWiFiStatus(bool connected) {
+    // WiFi events fire on the event task; hand the write to the network task
+    if (isNetworkTaskRunning() && !isNetworkTaskContext()) {
+        NetRequest request = {};
+        request.type = NET_WIFI_STATUS;
+        request.flag = connected;
+        return postNetRequest(request);
+    }
+    
     // Don't attempt Firebase operations if not ready
     if (!Firebase.ready()) {
         Serial.println("⚠️ Firebase not ready, WiFi status update skipped");
@@ -311,9 +319,7 @@ bool updateFirebaseWiFiStatus(bool connected) {
         Serial.println("❌ ERROR: Device ID is missing, cannot update Firebase!");
         return false;
     }    
-    // Construct the path and attempt to update
-    String path = String(DEVICE_PATH) + deviceId + WIFI_NODE + "/connected";
-    bool success = Firebase.RTDB.setBool(&fbdo, path.c_str(), connected);
+    bool success = Firebase.RTDB.setBool(&fbdo, devicePaths.wifiConnected, connected);
     
     if (success) {
         Serial.print("✅ Updated WiFi connection status to '");
@@ -343,11 +349,11 @@ void performTimeSync() {
         configTime(GMT_OFFSET_SEC, DAYLIGHT_OFFSET_SEC, NTP_SERVERS[i]);
 
         unsigned long startAttemptTime = millis();
-        while (!isTimeSynchronized() && millis() - startAttemptTime < 10000) {
+        while (!refreshTimeBase() && millis() - startAttemptTime < 10000) {
             delay(100);
         }
 
-        if (isTimeSynchronized()) {
+        if (isEpochValid()) {
             syncSuccessful = true;
             break;
         }
@@ -357,11 +363,8 @@ void performTimeSync() {
         Serial.println("✅ Time Synchronization Successful!");
         
         // Print current time (previously in printCurrentTime)
-        struct timeval tv;
-        gettimeofday(&tv, NULL);
-        unsigned long long epochMilliseconds = (tv.tv_sec * 1000LL) + (tv.tv_usec / 1000);
         Serial.print("Current Time (ms): ");
-        Serial.println(epochMilliseconds);
+        Serial.println(epochMillis());
     } else {
         Serial.println("❌ Time Synchronization Failed");
         
@@ -384,17 +387,7 @@ void performTimeSync() {
     }
 }
 
+// Epoch ms from the cached time base (one add), or 0 until NTP has synced
 unsigned long long isTimeSynchronized() {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-
-    // Convert to milliseconds
-    unsigned long long epochMilliseconds = (tv.tv_sec * 1000LL) + (tv.tv_usec / 1000);
-
-    // Convert seconds to check year validity
-    struct tm timeinfo;
-    localtime_r(&tv.tv_sec, &timeinfo);
-
-    // Return 0 if time is not valid (before 2021), or the timestamp if valid
-    return (timeinfo.tm_year > (2021 - 1900)) ? epochMilliseconds : 0;
+    return epochMillis();
 }
@@ -20,4 +20,7 @@ void clearFlashStorage(bool skipRestart = false);
 void performTimeSync();
 unsigned long long isTimeSynchronized();
 
+// Firebase WiFi status (posted to the network task once it is running)
+bool updateFirebaseWiFiStatus(bool connected);
+
 #endif
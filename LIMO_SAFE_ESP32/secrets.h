@@ -11,4 +11,9 @@
 // Your Database Secret (NOT the Web API Key)
 #define FIREBASE_AUTH "dJSuL4IFz5260Gx5FNP33dT5JVX2CWWLlAZtxro5"
 
+// Optional MQTT broker for log and status uploads (tools/mqtt_bridge.py writes them into RTDB)
+// #define MQTT_BROKER_URI "mqtts://broker.example.com:8883"
+// The device logs in with its device ID as the username; this is its broker password
+// #define MQTT_PASSWORD ""
+
 #endif
@@ -1,6 +1,7 @@
 #include <Arduino.h>
 #include "ESPCommunication.h"
 #include "LockControl.h"
+#include "TelemetryCadence.h"
 #include <SoftwareSerial.h>
 
 SoftwareSerial espSerial(2, 3); // RX: 2 (Nano receive), TX: 3 (Nano transmit)
@@ -79,6 +80,21 @@ void processESPCommand(const char* command) {
         Serial.println(F("❌ Invalid OTP code! Access denied."));
         return;
     }
+
+    // Per-device status cadence from the ESP32: "CADENCE:<idle>,<active>,<incident>"
+    if (strncmp(command, "CADENCE:", 8) == 0) {
+        char* next = NULL;
+        unsigned long idleMs = strtoul(command + 8, &next, 10);
+        unsigned long activeMs = (next && *next == ',') ? strtoul(next + 1, &next, 10) : 0;
+        unsigned long incidentMs = (next && *next == ',') ? strtoul(next + 1, &next, 10) : 0;
+
+        if (setCadenceIntervals(idleMs, activeMs, incidentMs)) {
+            Serial.println(F("✅ Status cadence updated"));
+        } else {
+            Serial.println(F("⚠️ Rejected invalid cadence"));
+        }
+        return;
+    }
     
     // Process direct unlock command 
     if (strcmp(command, "UNLOCK") == 0) {
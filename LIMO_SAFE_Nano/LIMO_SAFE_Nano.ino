@@ -4,6 +4,7 @@
 #include "ESPCommunication.h"
 #include "LockControl.h"
 #include "LightSensor.h"
+#include "TelemetryCadence.h"
 
 // Global state variables
 bool safeClosed = true;
@@ -13,7 +14,6 @@ unsigned long lastLedBlinkTime = 0;
 bool ledState = false;
 
 // Timing constants
-#define STATUS_UPDATE_INTERVAL 1000    // Send status every 1 second
 #define COMMAND_CHECK_INTERVAL 50      // Check commands every 50ms
 #define LED_BLINK_INTERVAL_NORMAL 1000 // Normal blink interval in ms
 #define LED_BLINK_INTERVAL_ALERT 250   // Fast blink interval for alerts
@@ -28,6 +28,7 @@ void setup() {
     bool accelOk = initializeAccelerometer();
     initializeESPCommunication();
     initializeLock();
+    initTelemetryCadence(); // Status heartbeat backs off while the safe is idle
     setupLightSensor(); // Initialize light sensor for Morse code reception
 
     if (!accelOk) {
@@ -67,12 +68,14 @@ void loop() {
         // State changed, update immediately
         safeClosed = newSafeClosed;
         tamperDetected = newTamperDetected;
+        resetCadenceBackoff();
         sendStatusToESP(safeClosed, tamperDetected);
         lastStatusTime = currentMillis;
     }
-    // Periodic status update
-    else if (currentMillis - lastStatusTime >= STATUS_UPDATE_INTERVAL) {
+    // Periodic status update, fast while open or tampered and slow when idle
+    else if (currentMillis - lastStatusTime >= currentStatusInterval(safeClosed, tamperDetected)) {
         sendStatusToESP(safeClosed, tamperDetected);
+        onStatusSent(safeClosed, tamperDetected);
         lastStatusTime = currentMillis;
     }
     
@@ -0,0 +1,55 @@
+#include "TelemetryCadence.h"
+
+// Active intervals (defaults until the ESP32 sends its per-device configuration)
+static unsigned long idleInterval = CADENCE_IDLE_INTERVAL;
+static unsigned long activeInterval = CADENCE_ACTIVE_INTERVAL;
+static unsigned long incidentInterval = CADENCE_INCIDENT_INTERVAL;
+
+// Current idle interval, doubles after every heartbeat until it reaches idleInterval
+static unsigned long backoffInterval = CADENCE_ACTIVE_INTERVAL;
+
+void initTelemetryCadence() {
+    idleInterval = CADENCE_IDLE_INTERVAL;
+    activeInterval = CADENCE_ACTIVE_INTERVAL;
+    incidentInterval = CADENCE_INCIDENT_INTERVAL;
+    backoffInterval = activeInterval;
+}
+
+bool setCadenceIntervals(unsigned long idleMs, unsigned long activeMs, unsigned long incidentMs) {
+    // Reject values that would flood the UART or invert the tiers
+    if (incidentMs < CADENCE_MIN_INTERVAL || activeMs < incidentMs || idleMs < activeMs ||
+        idleMs > CADENCE_MAX_INTERVAL) {
+        return false;
+    }
+
+    idleInterval = idleMs;
+    activeInterval = activeMs;
+    incidentInterval = incidentMs;
+    backoffInterval = activeInterval;
+    return true;
+}
+
+void resetCadenceBackoff() {
+    backoffInterval = activeInterval;
+}
+
+unsigned long currentStatusInterval(bool isSafeClosed, bool tamperDetected) {
+    if (tamperDetected) {
+        return incidentInterval;
+    }
+    if (!isSafeClosed) {
+        return activeInterval;
+    }
+    return backoffInterval;
+}
+
+void onStatusSent(bool isSafeClosed, bool tamperDetected) {
+    if (tamperDetected || !isSafeClosed) {
+        // Stay at the fast rate and restart the backoff once the safe settles
+        backoffInterval = activeInterval;
+        return;
+    }
+
+    // Closed and secure: back off toward the idle rate
+    backoffInterval = min(backoffInterval * 2, idleInterval);
+}
@@ -0,0 +1,20 @@
+#ifndef TELEMETRY_CADENCE_H
+#define TELEMETRY_CADENCE_H
+
+#include <Arduino.h>
+
+// Default status intervals in milliseconds (the ESP32 can override them with "CADENCE:").
+// Keep the defaults and limits equal to LIMO_SAFE_ESP32/TelemetryCadence.h.
+#define CADENCE_IDLE_INTERVAL     30000UL  // Closed and secure, fully backed off
+#define CADENCE_ACTIVE_INTERVAL   2000UL   // Door open or recent state change
+#define CADENCE_INCIDENT_INTERVAL 1000UL   // Tamper active
+#define CADENCE_MIN_INTERVAL      100UL    // Lower bound accepted from the ESP32
+#define CADENCE_MAX_INTERVAL      600000UL // Upper bound; the command must fit the 32-byte RX buffer
+
+void initTelemetryCadence();
+bool setCadenceIntervals(unsigned long idleMs, unsigned long activeMs, unsigned long incidentMs);
+void resetCadenceBackoff(); // Call on every state change
+unsigned long currentStatusInterval(bool isSafeClosed, bool tamperDetected);
+void onStatusSent(bool isSafeClosed, bool tamperDetected); // Advances the idle backoff
+
+#endif // TELEMETRY_CADENCE_H
@@ -0,0 +1,234 @@
+// Times the firmware's Firebase flows against tools/rtdb_emulator.py.
+//
+//   make run                         builds, starts the emulator, runs once
+//   ./build/bench --rounds 20 -v     against an emulator that is already up
+//
+// Each flow reports wall time, the requests and new connections the device
+// made (new connections stand in for TLS handshakes), and what the emulator
+// saw. Add latency with the emulator's --latency-ms to approximate a real link.
+//
+//   make run-mqtt                    the same with log and status uploads over
+//                                    MQTT (LIMO_MQTT_BROKER=host:port, served
+//                                    by tools/mqtt_bridge.py --listen)
+#include <Arduino.h>
+#include <WiFi.h>
+#include <chrono>
+#include "HostShim.h"
+#include "FirebaseHandler.h"
+#include "FingerprintSensor.h"
+#include "NanoCommunicator.h"
+#include "OTPVerifier.h"
+#include "EventLogger.h"
+#include "TimeBase.h"
+#include "RtdbCache.h"
+#include "RequestDeadline.h"
+#include "RtdbFlow.h"
+#include "MqttTransport.h"
+
+static const char* const BENCH_USER_ID = "benchUser";
+static const char* const BENCH_USER_TAG = "A";
+
+// One request to the emulator's own endpoints, outside the device counters
+static std::string emulatorRequest(const char* method, const char* path, const std::string& body = "") {
+    WiFiClient client;
+    if (!client.connect(hostRtdbHost(), hostRtdbPort())) {
+        fprintf(stderr, "cannot reach the RTDB emulator at %s:%u\n", hostRtdbHost(), hostRtdbPort());
+        exit(1);
+    }
+    std::string head = std::string(method) + " " + path + " HTTP/1.1\r\nHost: emulator\r\n" +
+                       "Connection: close\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    client.write((const uint8_t*)head.data(), head.size());
+    client.write((const uint8_t*)body.data(), body.size());
+
+    std::string response;
+    unsigned long deadline = millis() + 5000;
+    while (client.connected() && (long)(deadline - millis()) > 0) {
+        uint8_t buffer[512];
+        int n = client.read(buffer, sizeof(buffer));
+        if (n > 0) response.append((const char*)buffer, n);
+        else delay(1);
+    }
+    size_t bodyStart = response.find("\r\n\r\n");
+    return bodyStart == std::string::npos ? "" : response.substr(bodyStart + 4);
+}
+
+struct FlowResult {
+    double totalMs = 0;
+    double worstMs = 0;
+    uint32_t connects = 0;
+    uint32_t bytesSent = 0;
+    uint32_t bytesReceived = 0;
+    int serverRequests = 0;
+    double serverMs = 0;
+    int rounds = 0;
+    int failures = 0;
+};
+
+// Run one flow and add its cost to the result
+template <typename Flow>
+static void measure(FlowResult& result, Flow flow) {
+    emulatorRequest("POST", "/.stats/reset");
+    hostResetFirebaseCounters();
+
+    auto started = std::chrono::steady_clock::now();
+    bool ok = flow();
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+    const HostFirebaseCounters& counters = hostFirebaseCounters();
+    HostJson stats;
+    HostJson::parse(emulatorRequest("GET", "/.stats"), stats);
+    HostJson* serverRequests = stats.member("requests");
+    HostJson* serverMs = stats.member("serverMs");
+
+    result.rounds++;
+    result.failures += ok ? 0 : 1;
+    result.totalMs += elapsedMs;
+    result.worstMs = std::max(result.worstMs, elapsedMs);
+    result.connects += counters.connects;
+    result.bytesSent += counters.bytesSent;
+    result.bytesReceived += counters.bytesReceived;
+    result.serverRequests += serverRequests != nullptr ? (int)serverRequests->number : 0;
+    result.serverMs += serverMs != nullptr ? serverMs->number : 0;
+}
+
+static void report(const char* name, const FlowResult& result) {
+    double rounds = result.rounds > 0 ? result.rounds : 1;
+    printf("%-22s %6d %9.2f %9.2f %8.1f %8.1f %9.0f %9.0f %9.2f %6d\n", name, result.rounds,
+           result.totalMs / rounds, result.worstMs, result.serverRequests / rounds, result.connects / rounds,
+           result.bytesSent / rounds, result.bytesReceived / rounds, result.serverMs / rounds, result.failures);
+}
+
+// Time from verifyOTP() being called to its authorised callback, i.e. the unlock
+static std::chrono::steady_clock::time_point otpStarted;
+static double unlockTotalMs = 0;
+static double unlockWorstMs = 0;
+static int unlocks = 0;
+
+static void onOtpAuthorized() {
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - otpStarted).count();
+    unlockTotalMs += elapsedMs;
+    unlockWorstMs = std::max(unlockWorstMs, elapsedMs);
+    unlocks++;
+}
+
+// Fresh database holding one user whose tag resolves through the OTP index
+static void seedDatabase(const String& code) {
+    char hash[65];
+    OTPVerifier::hashOTP(deviceId, code, hash);
+
+    std::string seed =
+        "{\"devices\":{\"" + std::string(deviceId.c_str()) + "\":{\"id\":\"" + deviceId.c_str() + "\","
+        "\"registeredUsers\":{\"" + BENCH_USER_TAG + "\":\"" + BENCH_USER_ID + "\"},"
+        "\"otpIndex\":{\"" + BENCH_USER_TAG + "\":{\"uid\":\"" + BENCH_USER_ID + "\",\"hash\":\"" + hash + "\"}}}},"
+        "\"users\":{\"" + BENCH_USER_ID + "\":{\"tag\":\"" + BENCH_USER_TAG + "\",\"role\":\"admin\","
+        "\"registeredDevices\":{\"" + deviceId.c_str() + "\":{\"role\":\"admin\"}}}}}";
+    emulatorRequest("PUT", "/.json", seed);
+}
+
+int main(int argc, char** argv) {
+    int rounds = 10;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else {
+            fprintf(stderr, "usage: %s [--rounds N] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+    hostSetSerialEnabled(verbose);
+
+    initTimeBase();
+    initEventLogger();
+    refreshTimeBase();  // The host clock is already synced, as after performTimeSync()
+    emulatorRequest("PUT", "/.json", "null");
+
+    FlowResult setup;
+    measure(setup, [] { return setupFirebase(); });
+    if (setup.failures > 0) {
+        fprintf(stderr, "setupFirebase() failed against %s:%u\n", hostRtdbHost(), hostRtdbPort());
+        return 1;
+    }
+
+    OTPVerifier::saveIndexConfig(true);  // seedDatabase() writes the OTP index
+
+    const char* broker = getenv("LIMO_MQTT_BROKER");
+    if (broker != nullptr) {
+        std::string uri = std::string("mqtt://") + broker;
+        saveMqttBrokerUri(uri.c_str());
+        initMqttTransport();
+        unsigned long deadline = millis() + 3000;
+        while (!mqttTransport().isUp() && (long)(deadline - millis()) > 0) {
+            delay(10);
+        }
+        if (!mqttTransport().isUp()) {
+            fprintf(stderr, "no MQTT session with %s\n", broker);
+            return 1;
+        }
+    }
+
+    FlowResult otp, enroll, queue, status;
+    for (int round = 0; round < rounds; round++) {
+        char code[16];  // Tag and four digits, like a keypad entry
+        snprintf(code, sizeof(code), "%s%04d", BENCH_USER_TAG, 1000 + round % 9000);
+        seedDatabase(code);
+        measure(otp, [&] {
+            otpStarted = std::chrono::steady_clock::now();
+            return verifyOTP(code, 0, onOtpAuthorized) == OTP_AUTHORIZED;
+        });
+
+        measure(enroll, [&] {
+            updateFingerprintStatus(BENCH_USER_ID, round + 1, true);
+            while (runningFlows() > 0) {
+                serviceRtdbFlows();  // The network task would serve requests in between
+            }
+            return true;
+        });
+
+        // A burst like a door cycle
+        logFlagEvent(EVT_LOCK, false);
+        logFlagEvent(EVT_SECURITY, true);
+        logFlagEvent(EVT_LOCK, true);
+        logEvent(EVT_FP_AUTH_SUCCESS, BENCH_USER_ID, BENCH_USER_TAG);
+        measure(queue, [] {
+            // Drain like the network task would, giving up after a few seconds
+            unsigned long deadline = millis() + 5000;
+            while (pendingEventCount() > 0 && (long)(deadline - millis()) > 0) {
+                processFirebaseQueue();
+                delay(1);
+            }
+            return pendingEventCount() == 0;
+        });
+
+        measure(status, [] { return updateDeviceStatus(true, false, false); });
+    }
+
+    printf("%-22s %6s %9s %9s %8s %8s %9s %9s %9s %6s\n", "flow", "rounds", "avg ms", "max ms", "req",
+           "conn", "tx B", "rx B", "server ms", "fail");
+    report("setupFirebase", setup);
+    report("verifyOTP", otp);
+    report("updateFingerprint", enroll);
+    report("processFirebaseQueue", queue);
+    report("updateDeviceStatus", status);
+
+    printf("\nverifyOTP unlock: %d of %d rounds, avg %.2f ms, max %.2f ms\n", unlocks, otp.rounds,
+           unlocks > 0 ? unlockTotalMs / unlocks : 0.0, unlockWorstMs);
+
+    const MqttStats& mqtt = getMqttStats();
+    printf("Uploads over %s: %u published, %u acked, %u timeouts, %u connects\n", uploadTransport().name(),
+           (unsigned)mqtt.published, (unsigned)mqtt.acked, (unsigned)mqtt.timeouts, (unsigned)mqtt.connects);
+
+    const RttEstimate& rtt = getRttEstimate();
+    printf("RTT: srtt %u ms, rttvar %u ms, rto %u ms over %u samples, %u timeouts, %u deadline misses\n",
+           (unsigned)rtt.srttMs, (unsigned)rtt.rttVarMs, (unsigned)rtt.rtoMs, (unsigned)rtt.samples,
+           (unsigned)rtt.timeouts, (unsigned)rtt.deadlineMisses);
+
+    const RtdbCacheStats& cache = RtdbCache::stats();
+    printf("\nRtdbCache: %u hits, %u misses, %u failures, %u evictions, %u invalidations, "
+           "%u entries / %u B\n", (unsigned)cache.hits, (unsigned)cache.misses,
+           (unsigned)cache.failures, (unsigned)cache.evictions, (unsigned)cache.invalidations,
+           (unsigned)cache.entries, (unsigned)cache.bytes);
+    return 0;
+}
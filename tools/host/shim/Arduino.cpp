@@ -0,0 +1,226 @@
+#include "Arduino.h"
+#include "HostShim.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include <stdarg.h>
+#include <chrono>
+#include <random>
+#include <thread>
+
+HardwareSerial Serial(0);
+EspClass ESP;
+
+static bool serialEnabled = getenv("LIMO_HOST_QUIET") == nullptr;
+static const auto startTime = std::chrono::steady_clock::now();
+static std::mt19937 rng(std::random_device{}());
+
+// --- String ---
+
+static std::string formatInteger(unsigned long long value, bool negative, unsigned char base) {
+    static const char digits[] = "0123456789abcdef";
+    if (base < 2 || base > 16) base = 10;
+    std::string out;
+    do {
+        out.insert(out.begin(), digits[value % base]);
+        value /= base;
+    } while (value > 0);
+    if (negative) out.insert(out.begin(), '-');
+    return out;
+}
+
+static std::string formatSigned(long long value, unsigned char base) {
+    if (value < 0 && base == 10) {
+        return formatInteger((unsigned long long)(-(value + 1)) + 1, true, base);
+    }
+    return formatInteger((unsigned long long)value, false, base);
+}
+
+String::String(int v, unsigned char base) : s(formatSigned(v, base)) {}
+String::String(unsigned int v, unsigned char base) : s(formatInteger(v, false, base)) {}
+String::String(long v, unsigned char base) : s(formatSigned(v, base)) {}
+String::String(unsigned long v, unsigned char base) : s(formatInteger(v, false, base)) {}
+String::String(unsigned char v, unsigned char base) : s(formatInteger(v, false, base)) {}
+String::String(long long v, unsigned char base) : s(formatSigned(v, base)) {}
+String::String(unsigned long long v, unsigned char base) : s(formatInteger(v, false, base)) {}
+String::String(float v, unsigned int decimals) : String((double)v, decimals) {}
+String::String(double v, unsigned int decimals) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, v);
+    s = buffer;
+}
+
+String String::substring(unsigned int from) const {
+    return from >= s.size() ? String() : String(s.substr(from));
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= s.size()) return String();
+    return String(s.substr(from, std::min<size_t>(to, s.size()) - from));
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t at = s.find(c, from);
+    return at == std::string::npos ? -1 : (int)at;
+}
+
+int String::indexOf(const String& text, unsigned int from) const {
+    size_t at = s.find(text.s, from);
+    return at == std::string::npos ? -1 : (int)at;
+}
+
+int String::lastIndexOf(char c) const {
+    size_t at = s.rfind(c);
+    return at == std::string::npos ? -1 : (int)at;
+}
+
+bool String::startsWith(const String& prefix) const {
+    return s.compare(0, prefix.s.size(), prefix.s) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return s.size() >= suffix.s.size() && s.compare(s.size() - suffix.s.size(), suffix.s.size(), suffix.s) == 0;
+}
+
+void String::replace(const String& from, const String& to) {
+    if (from.s.empty()) return;
+    size_t at = 0;
+    while ((at = s.find(from.s, at)) != std::string::npos) {
+        s.replace(at, from.s.size(), to.s);
+        at += to.s.size();
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index < s.size()) s.erase(index, count);
+}
+
+void String::toUpperCase() { for (char& c : s) c = toupper((unsigned char)c); }
+void String::toLowerCase() { for (char& c : s) c = tolower((unsigned char)c); }
+
+void String::trim() {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    size_t end = s.find_last_not_of(" \t\r\n");
+    s = start == std::string::npos ? std::string() : s.substr(start, end - start + 1);
+}
+
+long String::toInt() const { return strtol(s.c_str(), nullptr, 10); }
+float String::toFloat() const { return strtof(s.c_str(), nullptr); }
+
+bool String::equalsIgnoreCase(const String& other) const {
+    return s.size() == other.s.size() && strcasecmp(s.c_str(), other.s.c_str()) == 0;
+}
+
+void String::toCharArray(char* buffer, unsigned int size) const {
+    if (size == 0) return;
+    strncpy(buffer, s.c_str(), size - 1);
+    buffer[size - 1] = '\0';
+}
+
+String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+String operator+(const String& a, const char* b) { return String(a.s + (b ? b : "")); }
+String operator+(const char* a, const String& b) { return String(std::string(a ? a : "") + b.s); }
+String operator+(const String& a, char b) { return String(a.s + b); }
+String operator+(const String& a, int b) { return a + String(b); }
+String operator+(const String& a, unsigned int b) { return a + String(b); }
+String operator+(const String& a, long b) { return a + String(b); }
+String operator+(const String& a, unsigned long b) { return a + String(b); }
+
+// --- Print / Stream / Serial ---
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return length > 0 ? write((const uint8_t*)buffer, std::min<size_t>(length, sizeof(buffer) - 1)) : 0;
+}
+
+size_t Stream::readBytes(uint8_t* buffer, size_t length) {
+    size_t count = 0;
+    unsigned long started = millis();
+    while (count < length && millis() - started < timeoutMs) {
+        int c = read();
+        if (c < 0) { delay(1); continue; }
+        buffer[count++] = (uint8_t)c;
+    }
+    return count;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (port == 0 && serialEnabled) {
+        fwrite(buffer, 1, size, stdout);
+    }
+    return size;
+}
+
+void hostSetSerialEnabled(bool enabled) {
+    fflush(stdout);
+    serialEnabled = enabled;
+}
+
+// --- Time, randomness, GPIO ---
+
+unsigned long millis() {
+    return (unsigned long)(esp_timer_get_time() / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)esp_timer_get_time();
+}
+
+int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(unsigned int us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+void yield() { std::this_thread::yield(); }
+
+long random(long howBig) { return howBig <= 0 ? 0 : (long)(rng() % howBig); }
+long random(long howSmall, long howBig) { return howBig <= howSmall ? howSmall : howSmall + random(howBig - howSmall); }
+void randomSeed(unsigned long seed) { rng.seed(seed); }
+
+uint32_t esp_random() { return rng(); }
+void esp_fill_random(void* buffer, size_t length) {
+    uint8_t* bytes = (uint8_t*)buffer;
+    for (size_t i = 0; i < length; i++) bytes[i] = (uint8_t)rng();
+}
+esp_reset_reason_t esp_reset_reason() { return ESP_RST_POWERON; }
+esp_err_t esp_efuse_mac_get_default(uint8_t* mac) { const uint8_t host[6] = {0x02, 0, 0, 0x4c, 0x53, 1}; memcpy(mac, host, 6); return ESP_OK; }
+uint32_t esp_get_free_heap_size() { return 200 * 1024; }
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return LOW; }
+int analogRead(uint8_t) { return 0; }
+void analogWrite(uint8_t, int) {}
+
+// The host clock is already correct, so there is nothing to configure
+void configTime(long, int, const char*, const char*, const char*) {}
+
+String IPAddress::toString() const {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return String(buffer);
+}
+
+void EspClass::restart() {
+    fflush(stdout);
+    fprintf(stderr, "ESP.restart() called on the host, exiting\n");
+    exit(3);
+}
+
+uint32_t EspClass::getFreeHeap() { return esp_get_free_heap_size(); }
@@ -0,0 +1,193 @@
+// Host build of the Arduino core subset the LIMO SAFE firmware uses.
+// Serial goes to stdout; time comes from the host clock.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+#define F(x) (x)
+#define HEX 16
+#define DEC 10
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+#define INPUT 0
+#define INPUT_PULLUP 2
+#define INPUT_PULLDOWN 3
+#define LED_BUILTIN 13
+#define SERIAL_8N1 0
+#define IRAM_ATTR
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+class String {
+public:
+    String() {}
+    String(const char* c) : s(c ? c : "") {}
+    String(const std::string& x) : s(x) {}
+    String(char c) : s(1, c) {}
+    String(int v, unsigned char base = 10);
+    String(unsigned int v, unsigned char base = 10);
+    String(long v, unsigned char base = 10);
+    String(unsigned long v, unsigned char base = 10);
+    String(unsigned char v, unsigned char base = 10);
+    String(long long v, unsigned char base = 10);
+    String(unsigned long long v, unsigned char base = 10);
+    String(float v, unsigned int decimals = 2);
+    String(double v, unsigned int decimals = 2);
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return s.size(); }
+    bool isEmpty() const { return s.empty(); }
+    char charAt(unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    char operator[](unsigned int i) const { return charAt(i); }
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& text, unsigned int from = 0) const;
+    int lastIndexOf(char c) const;
+    bool startsWith(const String& prefix) const;
+    bool endsWith(const String& suffix) const;
+    void replace(const String& from, const String& to);
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+    void toUpperCase();
+    void toLowerCase();
+    void trim();
+    long toInt() const;
+    float toFloat() const;
+    bool equals(const String& other) const { return s == other.s; }
+    bool equalsIgnoreCase(const String& other) const;
+    bool reserve(unsigned int n) { s.reserve(n); return true; }
+    bool concat(const String& other) { s += other.s; return true; }
+    bool concat(const char* cstr, unsigned int length) { s.append(cstr, length); return true; }
+    void toCharArray(char* buffer, unsigned int size) const;
+
+    String& operator+=(const String& other) { s += other.s; return *this; }
+    String& operator+=(const char* other) { s += other ? other : ""; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    String& operator+=(int v) { return *this += String(v); }
+    String& operator+=(unsigned int v) { return *this += String(v); }
+    String& operator+=(long v) { return *this += String(v); }
+    String& operator+=(unsigned long v) { return *this += String(v); }
+    bool operator==(const String& other) const { return s == other.s; }
+    bool operator==(const char* other) const { return s == (other ? other : ""); }
+    bool operator!=(const String& other) const { return s != other.s; }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return s < other.s; }
+
+    std::string s;
+};
+
+String operator+(const String& a, const String& b);
+String operator+(const String& a, const char* b);
+String operator+(const char* a, const String& b);
+String operator+(const String& a, char b);
+String operator+(const String& a, int b);
+String operator+(const String& a, unsigned int b);
+String operator+(const String& a, long b);
+String operator+(const String& a, unsigned long b);
+
+class IPAddress {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+    String toString() const;
+
+private:
+    uint8_t octets[4] = {0, 0, 0, 0};
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v, int base = DEC) { return print(String((long)v, base)); }
+    size_t print(unsigned int v, int base = DEC) { return print(String((unsigned long)v, base)); }
+    size_t print(long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(long long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned long long v, int base = DEC) { return print(String(v, base)); }
+    size_t print(unsigned char v, int base = DEC) { return print(String((unsigned long)v, base)); }
+    size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+    size_t print(const IPAddress& address) { return print(address.toString()); }
+
+    template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(const T& v, int format) { size_t n = print(v, format); return n + println(); }
+    size_t println() { return write("\r\n"); }
+    size_t printf(const char* format, ...);
+    virtual void flush() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    size_t readBytes(uint8_t* buffer, size_t length);
+    size_t readBytes(char* buffer, size_t length) { return readBytes((uint8_t*)buffer, length); }
+    void setTimeout(unsigned long ms) { timeoutMs = ms; }
+
+protected:
+    unsigned long timeoutMs = 1000;
+};
+
+// Serial on the host: console output, no input. UARTs other than 0 stay silent.
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(int port) : port(port) {}
+    void begin(unsigned long, uint32_t = 0, int8_t = -1, int8_t = -1) {}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+private:
+    int port;
+};
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+void pinMode(uint8_t, uint8_t);
+void digitalWrite(uint8_t, uint8_t);
+int digitalRead(uint8_t);
+int analogRead(uint8_t);
+void analogWrite(uint8_t, int);
+void configTime(long gmtOffset, int daylightOffset, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+template <class T, class L, class H>
+T constrain(T x, L low, H high) { return x < low ? low : (x > high ? high : x); }
+
+class EspClass {
+public:
+    void restart();
+    uint32_t getFreeHeap();
+};
+extern EspClass ESP;
+
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
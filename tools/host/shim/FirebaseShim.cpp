@@ -0,0 +1,744 @@
+#include "Firebase_ESP_Client.h"
+#include "WiFiClientSecure.h"
+#include "HostShim.h"
+#include "secrets.h"
+
+Firebase_ESP_Client Firebase;
+
+#define HOST_HTTP_TIMEOUT_MS 10000UL
+
+// --- HostJson ---
+
+HostJson* HostJson::member(const std::string& key) {
+    for (auto& entry : members) {
+        if (entry.first == key) return &entry.second;
+    }
+    return nullptr;
+}
+
+HostJson& HostJson::ensureMember(const std::string& key) {
+    if (kind != Object) {
+        *this = HostJson();
+        kind = Object;
+    }
+    HostJson* existing = member(key);
+    if (existing != nullptr) return *existing;
+    members.emplace_back(key, HostJson());
+    return members.back().second;
+}
+
+bool HostJson::removeMember(const std::string& key) {
+    for (auto it = members.begin(); it != members.end(); ++it) {
+        if (it->first == key) {
+            members.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void serializeString(const std::string& text, std::string& out) {
+    out += '"';
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += (char)c;
+                }
+        }
+    }
+    out += '"';
+}
+
+static void serializeValue(const HostJson& value, std::string& out) {
+    switch (value.kind) {
+        case HostJson::Null: out += "null"; break;
+        case HostJson::Bool: out += value.boolean ? "true" : "false"; break;
+        case HostJson::Number: {
+            char buffer[32];
+            if (value.integral) {
+                snprintf(buffer, sizeof(buffer), "%lld", (long long)value.number);
+            } else {
+                snprintf(buffer, sizeof(buffer), "%.17g", value.number);
+            }
+            out += buffer;
+            break;
+        }
+        case HostJson::Text: serializeString(value.text, out); break;
+        case HostJson::Object: {
+            out += '{';
+            bool first = true;
+            for (const auto& entry : value.members) {
+                if (!first) out += ',';
+                first = false;
+                serializeString(entry.first, out);
+                out += ':';
+                serializeValue(entry.second, out);
+            }
+            out += '}';
+            break;
+        }
+        case HostJson::Array: {
+            out += '[';
+            for (size_t i = 0; i < value.items.size(); i++) {
+                if (i > 0) out += ',';
+                serializeValue(value.items[i], out);
+            }
+            out += ']';
+            break;
+        }
+    }
+}
+
+std::string HostJson::serialize() const {
+    std::string out;
+    serializeValue(*this, out);
+    return out;
+}
+
+namespace {
+
+struct Parser {
+    const std::string& text;
+    size_t at = 0;
+
+    explicit Parser(const std::string& source) : text(source) {}
+
+    void skipSpace() {
+        while (at < text.size() && isspace((unsigned char)text[at])) at++;
+    }
+
+    bool literal(const char* word) {
+        size_t length = strlen(word);
+        if (text.compare(at, length, word) != 0) return false;
+        at += length;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        if (at >= text.size() || text[at] != '"') return false;
+        at++;
+        while (at < text.size() && text[at] != '"') {
+            char c = text[at++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (at >= text.size()) return false;
+            char escape = text[at++];
+            switch (escape) {
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    if (at + 4 > text.size()) return false;
+                    unsigned code = strtoul(text.substr(at, 4).c_str(), nullptr, 16);
+                    at += 4;
+                    // UTF-8 encode the BMP code point; surrogate pairs are not needed here
+                    if (code < 0x80) {
+                        out += (char)code;
+                    } else if (code < 0x800) {
+                        out += (char)(0xC0 | (code >> 6));
+                        out += (char)(0x80 | (code & 0x3F));
+                    } else {
+                        out += (char)(0xE0 | (code >> 12));
+                        out += (char)(0x80 | ((code >> 6) & 0x3F));
+                        out += (char)(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default: out += escape; break;
+            }
+        }
+        if (at >= text.size()) return false;
+        at++;
+        return true;
+    }
+
+    bool parseValue(HostJson& out) {
+        skipSpace();
+        if (at >= text.size()) return false;
+        char c = text[at];
+        if (c == '{') {
+            at++;
+            out.kind = HostJson::Object;
+            skipSpace();
+            if (at < text.size() && text[at] == '}') { at++; return true; }
+            while (true) {
+                skipSpace();
+                std::string key;
+                if (!parseString(key)) return false;
+                skipSpace();
+                if (at >= text.size() || text[at++] != ':') return false;
+                HostJson child;
+                if (!parseValue(child)) return false;
+                out.members.emplace_back(key, child);
+                skipSpace();
+                if (at < text.size() && text[at] == ',') { at++; continue; }
+                if (at < text.size() && text[at] == '}') { at++; return true; }
+                return false;
+            }
+        }
+        if (c == '[') {
+            at++;
+            out.kind = HostJson::Array;
+            skipSpace();
+            if (at < text.size() && text[at] == ']') { at++; return true; }
+            while (true) {
+                HostJson child;
+                if (!parseValue(child)) return false;
+                out.items.push_back(child);
+                skipSpace();
+                if (at < text.size() && text[at] == ',') { at++; continue; }
+                if (at < text.size() && text[at] == ']') { at++; return true; }
+                return false;
+            }
+        }
+        if (c == '"') {
+            out.kind = HostJson::Text;
+            return parseString(out.text);
+        }
+        if (literal("true")) { out.kind = HostJson::Bool; out.boolean = true; return true; }
+        if (literal("false")) { out.kind = HostJson::Bool; out.boolean = false; return true; }
+        if (literal("null")) { out.kind = HostJson::Null; return true; }
+
+        size_t start = at;
+        while (at < text.size() && strchr("+-0123456789.eE", text[at]) != nullptr) at++;
+        if (start == at) return false;
+        std::string number = text.substr(start, at - start);
+        out.kind = HostJson::Number;
+        out.number = strtod(number.c_str(), nullptr);
+        out.integral = number.find_first_of(".eE") == std::string::npos;
+        return true;
+    }
+};
+
+}  // namespace
+
+bool HostJson::parse(const std::string& source, HostJson& out) {
+    Parser parser(source);
+    out = HostJson();
+    if (!parser.parseValue(out)) return false;
+    parser.skipSpace();
+    return parser.at == source.size();
+}
+
+// --- FirebaseJsonData / FirebaseJson ---
+
+void FirebaseJsonData::assign(const HostJson* value) {
+    *this = FirebaseJsonData();
+    if (value == nullptr) return;
+    success = true;
+    switch (value->kind) {
+        case HostJson::Null: type = "null"; stringValue = "null"; break;
+        case HostJson::Bool:
+            type = "boolean";
+            boolValue = value->boolean;
+            intValue = value->boolean ? 1 : 0;
+            doubleValue = intValue;
+            stringValue = value->boolean ? "true" : "false";
+            break;
+        case HostJson::Number:
+            type = value->integral ? "int" : "double";
+            doubleValue = value->number;
+            intValue = (int)value->number;
+            boolValue = value->number != 0;
+            stringValue = String(value->serialize());
+            break;
+        case HostJson::Text: type = "string"; stringValue = String(value->text); break;
+        case HostJson::Object: type = "object"; stringValue = String(value->serialize()); break;
+        case HostJson::Array: type = "array"; stringValue = String(value->serialize()); break;
+    }
+}
+
+static std::vector<std::string> splitPath(const String& path) {
+    std::vector<std::string> segments;
+    std::string current;
+    for (char c : path.s) {
+        if (c == '/') {
+            if (!current.empty()) segments.push_back(current);
+            current.clear();
+        } else {
+            current += c;
+        }
+    }
+    if (!current.empty()) segments.push_back(current);
+    return segments;
+}
+
+HostJson& FirebaseJson::node(const String& path) {
+    HostJson* at = &root;
+    for (const std::string& segment : splitPath(path)) {
+        at = &at->ensureMember(segment);
+    }
+    return *at;
+}
+
+FirebaseJson& FirebaseJson::set(const String& path, const String& value) {
+    HostJson& target = node(path);
+    target = HostJson();
+    target.kind = HostJson::Text;
+    target.text = value.s;
+    return *this;
+}
+
+FirebaseJson& FirebaseJson::set(const String& path, bool value) {
+    HostJson& target = node(path);
+    target = HostJson();
+    target.kind = HostJson::Bool;
+    target.boolean = value;
+    return *this;
+}
+
+FirebaseJson& FirebaseJson::setNumber(const String& path, double value, bool integral) {
+    HostJson& target = node(path);
+    target = HostJson();
+    target.kind = HostJson::Number;
+    target.number = value;
+    target.integral = integral;
+    return *this;
+}
+
+FirebaseJson& FirebaseJson::set(const String& path, const FirebaseJson& value) {
+    node(path) = value.root;
+    return *this;
+}
+
+bool FirebaseJson::get(FirebaseJsonData& result, const String& path, bool) {
+    HostJson* at = &root;
+    for (const std::string& segment : splitPath(path)) {
+        if (at->kind == HostJson::Array) {
+            size_t index = strtoul(segment.c_str(), nullptr, 10);
+            at = index < at->items.size() ? &at->items[index] : nullptr;
+        } else {
+            at = at->kind == HostJson::Object ? at->member(segment) : nullptr;
+        }
+        if (at == nullptr) break;
+    }
+    result.assign(at);
+    return result.success;
+}
+
+bool FirebaseJson::remove(const String& path) {
+    std::vector<std::string> segments = splitPath(path);
+    if (segments.empty()) return false;
+    HostJson* at = &root;
+    for (size_t i = 0; i + 1 < segments.size() && at != nullptr; i++) {
+        at = at->member(segments[i]);
+    }
+    return at != nullptr && at->removeMember(segments.back());
+}
+
+static int iteratorType(const HostJson& value) {
+    switch (value.kind) {
+        case HostJson::Object: return FirebaseJson::JSON_OBJECT;
+        case HostJson::Array: return FirebaseJson::JSON_ARRAY;
+        case HostJson::Text: return FirebaseJson::JSON_STRING;
+        case HostJson::Number: return value.integral ? FirebaseJson::JSON_INT : FirebaseJson::JSON_DOUBLE;
+        case HostJson::Bool: return FirebaseJson::JSON_BOOL;
+        default: return FirebaseJson::JSON_NULL;
+    }
+}
+
+// Like the library, list every node depth-first; strings keep their quotes
+static void flatten(const HostJson& value, int depth, std::vector<FirebaseJson::IteratorValue>& out) {
+    if (value.kind == HostJson::Object) {
+        for (const auto& entry : value.members) {
+            FirebaseJson::IteratorValue item;
+            item.type = iteratorType(entry.second);
+            item.depth = depth;
+            item.key = String(entry.first);
+            item.value = String(entry.second.serialize());
+            out.push_back(item);
+            flatten(entry.second, depth + 1, out);
+        }
+    } else if (value.kind == HostJson::Array) {
+        for (size_t i = 0; i < value.items.size(); i++) {
+            FirebaseJson::IteratorValue item;
+            item.type = iteratorType(value.items[i]);
+            item.depth = depth;
+            item.value = String(value.items[i].serialize());
+            out.push_back(item);
+            flatten(value.items[i], depth + 1, out);
+        }
+    }
+}
+
+size_t FirebaseJson::iteratorBegin(const char* data) {
+    if (data != nullptr) setJsonData(String(data));
+    iterator.clear();
+    flatten(root, 0, iterator);
+    return iterator.size();
+}
+
+void FirebaseJson::iteratorGet(size_t index, int& type, String& key, String& value) {
+    IteratorValue item = valueAt(index);
+    type = item.type;
+    key = item.key;
+    value = item.value;
+}
+
+FirebaseJson::IteratorValue FirebaseJson::valueAt(size_t index) {
+    return index < iterator.size() ? iterator[index] : IteratorValue();
+}
+
+bool FirebaseJson::setJsonData(const String& data) {
+    HostJson parsed;
+    if (!HostJson::parse(data.s, parsed)) return false;
+    root = parsed;
+    return true;
+}
+
+bool FirebaseJsonArray::setJsonArrayData(const String& data) {
+    HostJson parsed;
+    if (!HostJson::parse(data.s, parsed) || parsed.kind != HostJson::Array) return false;
+    root = parsed;
+    return true;
+}
+
+FirebaseJsonArray& FirebaseJsonArray::add(int value) {
+    HostJson item;
+    item.kind = HostJson::Number;
+    item.number = value;
+    item.integral = true;
+    root.items.push_back(item);
+    return *this;
+}
+
+FirebaseJsonArray& FirebaseJsonArray::add(const String& value) {
+    HostJson item;
+    item.kind = HostJson::Text;
+    item.text = value.s;
+    root.items.push_back(item);
+    return *this;
+}
+
+bool FirebaseJsonArray::get(FirebaseJsonData& result, int index) {
+    result.assign(index >= 0 && (size_t)index < root.items.size() ? &root.items[index] : nullptr);
+    return result.success;
+}
+
+// --- FirebaseData: HTTP/1.1 to the emulator ---
+
+static std::string encodePath(const char* path) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string out;
+    for (const char* p = path; *p != '\0'; p++) {
+        unsigned char c = *p;
+        if (isalnum(c) || strchr("/-_.~:", c) != nullptr) {
+            out += (char)c;
+        } else {
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 0x0F];
+        }
+    }
+    while (!out.empty() && out[0] == '/') out.erase(0, 1);
+    while (!out.empty() && out.back() == '/') out.pop_back();
+    return out;
+}
+
+static std::string encodeQuery(const std::map<std::string, std::string>& params) {
+    std::string out;
+    for (const auto& param : params) {
+        out += "&" + param.first + "=" + encodePath(param.second.c_str());
+    }
+    return out;
+}
+
+static bool readLine(WiFiClient& client, std::string& line, unsigned long deadline) {
+    line.clear();
+    while ((long)(deadline - millis()) > 0) {
+        int c = client.read();
+        if (c < 0) {
+            if (!client.connected()) return false;
+            delay(1);
+            continue;
+        }
+        if (c == '\n') {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            return true;
+        }
+        line += (char)c;
+    }
+    return false;
+}
+
+void FirebaseData::stopWiFiClient() {
+    if (client) client->stop();
+    streaming = false;
+}
+
+bool FirebaseData::request(const char* method, const char* path, const std::string& query,
+                           const std::string& payload, bool stream) {
+    status = 0;
+    error = "";
+    body.clear();
+    etag = "";
+
+    if (!WiFi.isConnected()) {
+        status = -4;
+        error = "not connected";
+        return false;
+    }
+
+    std::string head = std::string(method) + " /" + encodePath(path) + ".json?auth=" + FIREBASE_AUTH + query +
+                       " HTTP/1.1\r\nHost: " + hostRtdbHost() + "\r\nConnection: keep-alive\r\n" +
+                       "X-Firebase-ETag: true\r\n";
+    if (stream) head += "Accept: text/event-stream\r\n";
+    if (!payload.empty()) head += "Content-Type: application/json\r\n";
+    head += "Content-Length: " + std::to_string(payload.size()) + "\r\n\r\n";
+
+    // A kept-alive socket may have been closed by the server; retry once on a new one
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (!client) client.reset(new WiFiClientSecure());
+        if (!client->connected() && !client->connect(hostRtdbHost(), hostRtdbPort())) {
+            status = -1;
+            error = "connection refused";
+            return false;
+        }
+        size_t sent = client->write((const uint8_t*)head.data(), head.size());
+        sent += client->write((const uint8_t*)payload.data(), payload.size());
+        if (sent == head.size() + payload.size()) break;
+        client->stop();
+        if (attempt == 1) {
+            status = -2;
+            error = "send failed";
+            return false;
+        }
+    }
+
+    unsigned long deadline = millis() + HOST_HTTP_TIMEOUT_MS;
+    std::string line;
+    if (!readLine(*client, line, deadline)) {
+        client->stop();
+        status = -3;
+        error = "read Timeout";
+        return false;
+    }
+    size_t space = line.find(' ');
+    status = space == std::string::npos ? 0 : atoi(line.c_str() + space + 1);
+
+    long contentLength = -1;
+    bool closeAfter = false;
+    while (readLine(*client, line, deadline) && !line.empty()) {
+        if (strncasecmp(line.c_str(), "Content-Length:", 15) == 0) contentLength = atol(line.c_str() + 15);
+        if (strncasecmp(line.c_str(), "ETag:", 5) == 0) etag = String(line.substr(5 + line.find_first_not_of(' ', 5) - 5).c_str());
+        if (strncasecmp(line.c_str(), "Connection:", 11) == 0 && line.find("close") != std::string::npos) closeAfter = true;
+    }
+
+    if (stream) {
+        streaming = status == 200;
+        if (!streaming) error = "stream rejected";
+        return streaming;
+    }
+
+    while (contentLength > 0 && (long)(deadline - millis()) > 0) {
+        uint8_t buffer[512];
+        int n = client->read(buffer, std::min<long>(sizeof(buffer), contentLength));
+        if (n <= 0) {
+            if (!client->connected()) break;
+            delay(1);
+            continue;
+        }
+        body.append((const char*)buffer, n);
+        contentLength -= n;
+    }
+    if (closeAfter || contentLength > 0) client->stop();
+
+    if (status < 200 || status >= 300) {
+        error = status == 412 ? "precondition failed (ETag does not match)" : "bad request";
+        if (status == 429) error = "too many requests";
+        if (status >= 500) error = "internal server error";
+        return false;
+    }
+    setResult(body);
+    return true;
+}
+
+void FirebaseData::setResult(const std::string& text) {
+    value = HostJson();
+    json.clear();
+    array.clear();
+    if (!text.empty() && !HostJson::parse(text, value)) {
+        value = HostJson();
+    }
+    if (value.kind == HostJson::Object) json.root = value;
+    if (value.kind == HostJson::Array) array.root = value;
+}
+
+String FirebaseData::dataType() {
+    switch (value.kind) {
+        case HostJson::Object: return "json";
+        case HostJson::Array: return "array";
+        case HostJson::Text: return "string";
+        case HostJson::Number: return value.integral ? "int" : "double";
+        case HostJson::Bool: return "boolean";
+        default: return "null";
+    }
+}
+
+String FirebaseData::stringData() {
+    return value.kind == HostJson::Text ? String(value.text) : String(value.serialize());
+}
+
+int FirebaseData::intData() {
+    return value.kind == HostJson::Number ? (int)value.number : 0;
+}
+
+bool FirebaseData::boolData() {
+    return value.kind == HostJson::Bool ? value.boolean : false;
+}
+
+// Parse one complete server-sent event out of the buffer, if there is one
+bool FirebaseData::pollStream() {
+    uint8_t buffer[512];
+    int n;
+    while (client && (n = client->read(buffer, sizeof(buffer))) > 0) {
+        streamBuffer.append((const char*)buffer, n);
+    }
+
+    size_t end = streamBuffer.find("\n\n");
+    if (end == std::string::npos) return false;
+    std::string block = streamBuffer.substr(0, end);
+    streamBuffer.erase(0, end + 2);
+
+    std::string kind, data;
+    size_t at = 0;
+    while (at < block.size()) {
+        size_t eol = block.find('\n', at);
+        std::string line = block.substr(at, eol == std::string::npos ? std::string::npos : eol - at);
+        at = eol == std::string::npos ? block.size() : eol + 1;
+        if (line.compare(0, 7, "event: ") == 0) kind = line.substr(7);
+        if (line.compare(0, 6, "data: ") == 0) data = line.substr(6);
+    }
+    if (kind != "put" && kind != "patch") return false;  // keep-alive and the like
+
+    HostJson message;
+    if (!HostJson::parse(data, message) || message.kind != HostJson::Object) return false;
+    HostJson* messagePath = message.member("path");
+    HostJson* messageData = message.member("data");
+    event = String(kind);
+    path = messagePath != nullptr ? String(messagePath->text) : String("/");
+    setResult(messageData != nullptr ? messageData->serialize() : "null");
+    return true;
+}
+
+// --- RTDB ---
+
+static bool readValue(FirebaseData* fbdo, const char* path, const std::string& query, HostJson::Kind expected) {
+    if (!fbdo->request("GET", path, query, "")) return false;
+    if (fbdo->value.kind == HostJson::Null) {
+        fbdo->error = "path not exist";
+        return false;
+    }
+    if (expected != HostJson::Null && fbdo->value.kind != expected) {
+        fbdo->error = "data type mismatch";
+        return false;
+    }
+    return true;
+}
+
+bool FB_RTDB::getJSON(FirebaseData* fbdo, const char* path) {
+    return readValue(fbdo, path, "", HostJson::Object);
+}
+
+bool FB_RTDB::getJSON(FirebaseData* fbdo, const char* path, QueryFilter* query) {
+    return readValue(fbdo, path, query != nullptr ? encodeQuery(query->params) : "", HostJson::Object);
+}
+
+bool FB_RTDB::getString(FirebaseData* fbdo, const char* path) {
+    return readValue(fbdo, path, "", HostJson::Text);
+}
+
+bool FB_RTDB::getInt(FirebaseData* fbdo, const char* path) {
+    return readValue(fbdo, path, "", HostJson::Number);
+}
+
+bool FB_RTDB::getBool(FirebaseData* fbdo, const char* path) {
+    return readValue(fbdo, path, "", HostJson::Bool);
+}
+
+bool FB_RTDB::getArray(FirebaseData* fbdo, const char* path) {
+    return readValue(fbdo, path, "", HostJson::Array);
+}
+
+bool FB_RTDB::getShallowData(FirebaseData* fbdo, const char* path) {
+    return fbdo->request("GET", path, "&shallow=true", "");
+}
+
+bool FB_RTDB::setJSON(FirebaseData* fbdo, const char* path, FirebaseJson* json) {
+    return fbdo->request("PUT", path, "", json->root.serialize());
+}
+
+bool FB_RTDB::setString(FirebaseData* fbdo, const char* path, const String& value) {
+    HostJson text;
+    text.kind = HostJson::Text;
+    text.text = value.s;
+    return fbdo->request("PUT", path, "", text.serialize());
+}
+
+bool FB_RTDB::setBool(FirebaseData* fbdo, const char* path, bool value) {
+    return fbdo->request("PUT", path, "", value ? "true" : "false");
+}
+
+bool FB_RTDB::setInt(FirebaseData* fbdo, const char* path, int value) {
+    return fbdo->request("PUT", path, "", std::to_string(value));
+}
+
+bool FB_RTDB::setArray(FirebaseData* fbdo, const char* path, FirebaseJsonArray* array) {
+    return fbdo->request("PUT", path, "", array->root.serialize());
+}
+
+bool FB_RTDB::pushJSON(FirebaseData* fbdo, const char* path, FirebaseJson* json) {
+    return fbdo->request("POST", path, "", json->root.serialize());
+}
+
+bool FB_RTDB::updateNode(FirebaseData* fbdo, const char* path, FirebaseJson* json) {
+    return fbdo->request("PATCH", path, "", json->root.serialize());
+}
+
+bool FB_RTDB::updateNodeSilent(FirebaseData* fbdo, const char* path, FirebaseJson* json) {
+    return fbdo->request("PATCH", path, "&print=silent", json->root.serialize());
+}
+
+bool FB_RTDB::deleteNode(FirebaseData* fbdo, const char* path) {
+    return fbdo->request("DELETE", path, "", "");
+}
+
+bool FB_RTDB::beginStream(FirebaseData* fbdo, const char* path) {
+    // Streams hold their socket open, so they always get their own connection
+    fbdo->stopWiFiClient();
+    fbdo->streamBuffer.clear();
+    fbdo->streamRoot = path;
+    return fbdo->request("GET", path, "", "", true);
+}
+
+bool FB_RTDB::readStream(FirebaseData* fbdo) {
+    if (!fbdo->streaming) {
+        fbdo->error = "stream not started";
+        return false;
+    }
+    if (!fbdo->client || !fbdo->client->connected()) {
+        // Like the library, reconnect the stream transparently
+        if (!beginStream(fbdo, fbdo->streamRoot.c_str())) return false;
+    }
+    if (fbdo->pollStream()) fbdo->streamFresh = true;
+    return true;
+}
+
+bool FB_RTDB::endStream(FirebaseData* fbdo) {
+    fbdo->stopWiFiClient();
+    return true;
+}
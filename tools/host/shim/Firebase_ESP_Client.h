@@ -0,0 +1,213 @@
+#pragma once
+// Host version of the Firebase_ESP_Client surface the firmware uses. RTDB
+// calls become plain HTTP/1.1 requests to the local RTDB emulator over one
+// kept-alive connection per FirebaseData, which mirrors how the library
+// reuses its TLS session on the device.
+#include "Arduino.h"
+#include "WiFi.h"
+#include <map>
+#include <memory>
+
+// Minimal JSON value for FirebaseJson and friends
+struct HostJson {
+    enum Kind { Null, Bool, Number, Text, Object, Array };
+    Kind kind = Null;
+    bool boolean = false;
+    double number = 0;
+    bool integral = false;
+    std::string text;
+    std::vector<std::pair<std::string, HostJson>> members;
+    std::vector<HostJson> items;
+
+    HostJson* member(const std::string& key);
+    HostJson& ensureMember(const std::string& key);
+    bool removeMember(const std::string& key);
+    std::string serialize() const;
+    static bool parse(const std::string& text, HostJson& out);
+};
+
+class FirebaseJsonData {
+public:
+    bool success = false;
+    String type;          // "object", "array", "string", "int", "double", "boolean", "null"
+    String stringValue;
+    int intValue = 0;
+    bool boolValue = false;
+    double doubleValue = 0;
+    String to_string() const { return stringValue; }
+    void assign(const HostJson* value);
+};
+
+class FirebaseJson {
+public:
+    enum { JSON_UNDEFINED = 0, JSON_OBJECT = 1, JSON_ARRAY = 2, JSON_STRING = 3, JSON_INT = 4,
+           JSON_FLOAT = 5, JSON_DOUBLE = 6, JSON_BOOL = 7, JSON_NULL = 8 };
+    struct IteratorValue { int type = 0; int depth = 0; String key; String value; };
+
+    FirebaseJson() { root.kind = HostJson::Object; }
+
+    FirebaseJson& set(const String& path, const String& value);
+    FirebaseJson& set(const String& path, const char* value) { return set(path, String(value)); }
+    FirebaseJson& set(const String& path, bool value);
+    FirebaseJson& set(const String& path, int value) { return setNumber(path, value, true); }
+    FirebaseJson& set(const String& path, unsigned int value) { return setNumber(path, value, true); }
+    FirebaseJson& set(const String& path, long value) { return setNumber(path, value, true); }
+    FirebaseJson& set(const String& path, unsigned long value) { return setNumber(path, value, true); }
+    FirebaseJson& set(const String& path, long long value) { return setNumber(path, (double)value, true); }
+    FirebaseJson& set(const String& path, unsigned long long value) { return setNumber(path, (double)value, true); }
+    FirebaseJson& set(const String& path, float value) { return setNumber(path, value, false); }
+    FirebaseJson& set(const String& path, double value) { return setNumber(path, value, false); }
+    FirebaseJson& set(const String& path, const FirebaseJson& value);
+    FirebaseJson& add(const String& key, const String& value) { return set(key, value); }
+
+    bool get(FirebaseJsonData& result, const String& path, bool pretty = false);
+    bool remove(const String& path);
+    void clear() { root = HostJson(); root.kind = HostJson::Object; iterator.clear(); }
+
+    size_t iteratorBegin(const char* data = nullptr);
+    void iteratorGet(size_t index, int& type, String& key, String& value);
+    IteratorValue valueAt(size_t index);
+    void iteratorEnd() { iterator.clear(); }
+
+    bool setJsonData(const String& data);
+    void toString(String& out, bool = false) const { out = String(root.serialize()); }
+    String raw() const { return String(root.serialize()); }
+
+    HostJson root;
+
+private:
+    std::vector<IteratorValue> iterator;
+    FirebaseJson& setNumber(const String& path, double value, bool integral);
+    HostJson& node(const String& path);
+};
+
+class FirebaseJsonArray {
+public:
+    FirebaseJsonArray() { root.kind = HostJson::Array; }
+    FirebaseJsonArray& add(int value);
+    FirebaseJsonArray& add(const String& value);
+    bool get(FirebaseJsonData& result, int index);
+    bool setJsonArrayData(const String& data);
+    size_t size() const { return root.items.size(); }
+    void clear() { root.items.clear(); }
+    String raw() const { return String(root.serialize()); }
+
+    HostJson root;
+};
+
+class QueryFilter {
+public:
+    void orderBy(const String& key) { params["orderBy"] = "\"" + std::string(key.c_str()) + "\""; }
+    void equalTo(const String& value) { params["equalTo"] = "\"" + std::string(value.c_str()) + "\""; }
+    void equalTo(int value) { params["equalTo"] = std::to_string(value); }
+    void limitToFirst(int count) { params["limitToFirst"] = std::to_string(count); }
+    void limitToLast(int count) { params["limitToLast"] = std::to_string(count); }
+    void startAt(const String& value) { params["startAt"] = "\"" + std::string(value.c_str()) + "\""; }
+    void endAt(const String& value) { params["endAt"] = "\"" + std::string(value.c_str()) + "\""; }
+    void clear() { params.clear(); }
+
+    std::map<std::string, std::string> params;
+};
+
+struct TokenInfo { int status; int type; };
+enum { token_status_uninitialized, token_status_on_initialize, token_status_on_signing,
+       token_status_on_request, token_status_on_refresh, token_status_ready, token_status_error };
+
+struct FirebaseConfig {
+    String database_url;
+    struct { struct { String legacy_token; } tokens; } signer;
+    struct {
+        unsigned long socketConnection = 10000, serverResponse = 10000, rtdbKeepAlive = 45000,
+                      rtdbStreamReconnect = 1000, rtdbStreamError = 3000, sslHandshake = 10000,
+                      wifiReconnect = 10000;
+    } timeout;
+    void (*token_status_callback)(TokenInfo) = nullptr;
+    int tcp_data_sending_retry = 1;
+};
+struct FirebaseAuth {};
+
+class FirebaseData {
+public:
+    void setBSSLBufferSize(uint16_t, uint16_t) {}
+    void setResponseSize(uint16_t) {}
+    void keepAlive(int, int, int) {}
+    void stopWiFiClient();
+
+    String errorReason() { return error; }
+    int httpCode() { return status; }
+    String stringData();
+    int intData();
+    bool boolData();
+    FirebaseJson& jsonObject() { return json; }
+    FirebaseJson* jsonObjectPtr() { return &json; }
+    FirebaseJsonArray& jsonArray() { return array; }
+    String dataType();
+    String dataPath() { return path; }
+    String eventType() { return event; }
+    String streamPath() { return streamRoot; }
+    String ETag() { return etag; }
+    String payload() { return String(body); }
+    bool streamAvailable() { bool fresh = streamFresh; streamFresh = false; return fresh; }
+    bool streamTimeout() { return false; }
+    bool httpConnected() { return client && client->connected(); }
+
+    // Internal state of the shim
+    bool request(const char* method, const char* path, const std::string& query,
+                 const std::string& body, bool stream = false);
+    bool pollStream();
+    void setResult(const std::string& text);
+
+    std::unique_ptr<WiFiClient> client;
+    int status = 0;
+    String error;
+    std::string body;
+    String etag;
+    HostJson value;
+    FirebaseJson json;
+    FirebaseJsonArray array;
+    String path;
+    String event;
+    String streamRoot;
+    bool streaming = false;
+    bool streamFresh = false;
+    std::string streamBuffer;
+};
+typedef FirebaseData FirebaseStream;
+
+struct FB_RTDB {
+    bool getJSON(FirebaseData* fbdo, const char* path);
+    bool getJSON(FirebaseData* fbdo, const char* path, QueryFilter* query);
+    bool getString(FirebaseData* fbdo, const char* path);
+    bool getInt(FirebaseData* fbdo, const char* path);
+    bool getBool(FirebaseData* fbdo, const char* path);
+    bool getArray(FirebaseData* fbdo, const char* path);
+    bool getShallowData(FirebaseData* fbdo, const char* path);
+    bool setJSON(FirebaseData* fbdo, const char* path, FirebaseJson* json);
+    bool setString(FirebaseData* fbdo, const char* path, const String& value);
+    bool setBool(FirebaseData* fbdo, const char* path, bool value);
+    bool setInt(FirebaseData* fbdo, const char* path, int value);
+    bool setArray(FirebaseData* fbdo, const char* path, FirebaseJsonArray* array);
+    bool pushJSON(FirebaseData* fbdo, const char* path, FirebaseJson* json);
+    bool updateNode(FirebaseData* fbdo, const char* path, FirebaseJson* json);
+    bool updateNodeSilent(FirebaseData* fbdo, const char* path, FirebaseJson* json);
+    bool deleteNode(FirebaseData* fbdo, const char* path);
+    bool beginStream(FirebaseData* fbdo, const char* path);
+    bool readStream(FirebaseData* fbdo);
+    bool endStream(FirebaseData* fbdo);
+    void setReadTimeout(FirebaseData*, int) {}
+    void setwriteSizeLimit(FirebaseData*, const String&) {}
+};
+
+class Firebase_ESP_Client {
+public:
+    FB_RTDB RTDB;
+    void begin(FirebaseConfig* config, FirebaseAuth*) { started = config != nullptr; }
+    void reset(FirebaseConfig*) { started = false; }
+    bool ready() { return started && WiFi.isConnected(); }
+    void reconnectWiFi(bool) {}
+    void reconnectNetwork(bool) {}
+
+private:
+    bool started = false;
+};
+extern Firebase_ESP_Client Firebase;
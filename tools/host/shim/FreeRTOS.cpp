@@ -0,0 +1,87 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string.h>
+#include <string>
+#include <thread>
+
+static std::recursive_mutex criticalMutex;
+
+void portENTER_CRITICAL(portMUX_TYPE*) { criticalMutex.lock(); }
+void portEXIT_CRITICAL(portMUX_TYPE*) { criticalMutex.unlock(); }
+BaseType_t xPortGetCoreID() { return 1; }
+
+struct HostQueue {
+    size_t length;
+    size_t itemSize;
+    std::deque<std::string> items;
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    HostQueue* queue = new HostQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+static auto waitUntil(TickType_t wait) {
+    return std::chrono::steady_clock::now() +
+           std::chrono::milliseconds(wait == portMAX_DELAY ? 24L * 3600 * 1000 : wait);
+}
+
+BaseType_t xQueueSend(QueueHandle_t handle, const void* item, TickType_t wait) {
+    HostQueue* queue = (HostQueue*)handle;
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!queue->changed.wait_until(lock, waitUntil(wait), [&] { return queue->items.size() < queue->length; })) {
+        return pdFALSE;
+    }
+    queue->items.emplace_back((const char*)item, queue->itemSize);
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void* item, TickType_t wait) {
+    HostQueue* queue = (HostQueue*)handle;
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!queue->changed.wait_until(lock, waitUntil(wait), [&] { return !queue->items.empty(); })) {
+        return pdFALSE;
+    }
+    memcpy(item, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t handle) {
+    HostQueue* queue = (HostQueue*)handle;
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->items.size();
+}
+
+struct HostTask {
+    const char* name;
+};
+static thread_local HostTask* currentTask = nullptr;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t, void* param,
+                                   UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+    HostTask* task = new HostTask{name};
+    std::thread worker([task, function, param] {
+        currentTask = task;
+        function(param);
+    });
+    worker.detach();
+    if (handle != nullptr) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return currentTask; }
+void vTaskDelay(TickType_t ticks) { std::this_thread::sleep_for(std::chrono::milliseconds(ticks)); }
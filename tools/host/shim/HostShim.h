@@ -0,0 +1,25 @@
+#pragma once
+// Host-only controls for the benchmark and anything else driving the shim
+#include <stdint.h>
+
+// Where WiFiClientSecure and the Firebase client connect (default 127.0.0.1:9000,
+// or LIMO_RTDB_EMULATOR=host:port)
+void hostSetRtdbEndpoint(const char* host, uint16_t port);
+const char* hostRtdbHost();
+uint16_t hostRtdbPort();
+
+// Serial output on/off (LIMO_HOST_QUIET=1 starts quiet)
+void hostSetSerialEnabled(bool enabled);
+
+// Device traffic over WiFiClientSecure and the MQTT shim since the last reset;
+// request counts come from the emulator's /.stats
+struct HostFirebaseCounters {
+    uint32_t connects;       // New TCP connections, i.e. would-be TLS handshakes
+    uint32_t bytesSent;
+    uint32_t bytesReceived;
+};
+const HostFirebaseCounters& hostFirebaseCounters();
+void hostResetFirebaseCounters();
+
+// A device connection opened outside WiFiClientSecure (the MQTT shim)
+void hostCountDeviceConnect();
@@ -0,0 +1,258 @@
+#include "mqtt_client.h"
+#include "WiFi.h"
+#include "HostShim.h"
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+
+#define HOST_MQTT_PACKET_TIMEOUT_MS 5000
+#define HOST_MQTT_RECONNECT_MS 1000
+
+// MQTT 3.1.1 control packet types (high nibble of the fixed header)
+#define MQTT_CONNECT 0x10
+#define MQTT_CONNACK 0x20
+#define MQTT_PUBLISH 0x30
+#define MQTT_PUBACK 0x40
+#define MQTT_PINGREQ 0xC0
+#define MQTT_PINGRESP 0xD0
+
+// Socket counted as device traffic, like WiFiClientSecure's
+class MqttSocket : public WiFiClient {
+public:
+    int open(const char* host, uint16_t port) {
+        hostCountDeviceConnect();
+        int connected = WiFiClient::connect(host, port);
+        counted = true;
+        return connected;
+    }
+
+    bool readExact(uint8_t* buffer, size_t size, int timeoutMs) {
+        size_t count = 0;
+        while (count < size) {
+            if (!available() && !fill(timeoutMs)) return false;
+            count += (size_t)read(buffer + count, size - count);
+        }
+        return true;
+    }
+
+    int descriptor() const { return fd; }
+};
+
+struct esp_mqtt_client {
+    std::string host;
+    uint16_t port = 1883;
+    std::string clientId;
+    std::string username;
+    std::string password;
+    int keepaliveS = 120;
+    bool cleanSession = true;
+
+    esp_event_handler_t handler = nullptr;
+    void* handlerArg = nullptr;
+
+    std::mutex lock;      // Socket and session state
+    MqttSocket socket;
+    bool connected = false;
+    uint16_t nextMsgId = 1;
+    std::vector<int> unacked;   // QoS 1 messages sent and not yet acknowledged
+    unsigned long lastSentMs = 0;
+};
+
+static void fireEvent(esp_mqtt_client* client, esp_mqtt_event_id_t id, int msgId = 0, bool sessionPresent = false) {
+    if (client->handler == nullptr) return;
+    esp_mqtt_event_t event = { id, client, msgId, sessionPresent };
+    client->handler(client->handlerArg, "MQTT_EVENTS", id, &event);
+}
+
+static void putLength(std::vector<uint8_t>& out, size_t length) {
+    do {
+        uint8_t digit = length % 128;
+        length /= 128;
+        out.push_back(length > 0 ? (uint8_t)(digit | 0x80) : digit);
+    } while (length > 0);
+}
+
+static void putString(std::vector<uint8_t>& out, const std::string& text) {
+    out.push_back((uint8_t)(text.size() >> 8));
+    out.push_back((uint8_t)text.size());
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+static bool sendPacket(esp_mqtt_client* client, uint8_t header, const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> packet;
+    packet.push_back(header);
+    putLength(packet, body.size());
+    packet.insert(packet.end(), body.begin(), body.end());
+    if (client->socket.write(packet.data(), packet.size()) != packet.size()) return false;
+    client->lastSentMs = millis();
+    return true;
+}
+
+// Fixed header and body of the next packet; false on timeout or a closed socket
+static bool readPacket(esp_mqtt_client* client, uint8_t& header, std::vector<uint8_t>& body) {
+    if (!client->socket.readExact(&header, 1, HOST_MQTT_PACKET_TIMEOUT_MS)) return false;
+    size_t length = 0;
+    for (int shift = 0; shift < 28; shift += 7) {
+        uint8_t digit;
+        if (!client->socket.readExact(&digit, 1, HOST_MQTT_PACKET_TIMEOUT_MS)) return false;
+        length |= (size_t)(digit & 0x7F) << shift;
+        if ((digit & 0x80) == 0) break;
+    }
+    body.resize(length);
+    return length == 0 || client->socket.readExact(body.data(), length, HOST_MQTT_PACKET_TIMEOUT_MS);
+}
+
+// There is no outbox to retransmit from: what the broker has not acknowledged
+// is reported deleted, as esp-mqtt does when a message expires
+static void dropSession(esp_mqtt_client* client) {
+    client->socket.stop();
+    if (client->connected) {
+        client->connected = false;
+        fireEvent(client, MQTT_EVENT_DISCONNECTED);
+    }
+    for (int msgId : client->unacked) {
+        fireEvent(client, MQTT_EVENT_DELETED, msgId);
+    }
+    client->unacked.clear();
+}
+
+// CONNECT and wait for CONNACK; called with the lock held
+static bool openSession(esp_mqtt_client* client) {
+    if (!client->socket.open(client->host.c_str(), client->port)) return false;
+
+    std::vector<uint8_t> body;
+    putString(body, "MQTT");
+    body.push_back(4);  // 3.1.1
+    uint8_t flags = client->cleanSession ? 0x02 : 0x00;
+    if (!client->username.empty()) flags |= 0x80;
+    if (!client->password.empty()) flags |= 0x40;
+    body.push_back(flags);
+    body.push_back((uint8_t)(client->keepaliveS >> 8));
+    body.push_back((uint8_t)client->keepaliveS);
+    putString(body, client->clientId);
+    if (!client->username.empty()) putString(body, client->username);
+    if (!client->password.empty()) putString(body, client->password);
+
+    uint8_t header;
+    std::vector<uint8_t> ack;
+    if (!sendPacket(client, MQTT_CONNECT, body) || !readPacket(client, header, ack) ||
+        (header & 0xF0) != MQTT_CONNACK || ack.size() != 2 || ack[1] != 0) {
+        client->socket.stop();
+        return false;
+    }
+    client->connected = true;
+    fireEvent(client, MQTT_EVENT_CONNECTED, 0, (ack[0] & 0x01) != 0);
+    return true;
+}
+
+// The esp-mqtt task: reconnect, answer the broker, keep the session alive
+static void runClient(esp_mqtt_client* client) {
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> guard(client->lock);
+            if (!client->connected && !openSession(client)) {
+                fireEvent(client, MQTT_EVENT_ERROR);
+            }
+        }
+        int fd;
+        {
+            std::lock_guard<std::mutex> guard(client->lock);
+            fd = client->connected ? client->socket.descriptor() : -1;
+        }
+        if (fd < 0) {
+            delay(HOST_MQTT_RECONNECT_MS);
+            continue;
+        }
+
+        pollfd waitFor = { fd, POLLIN, 0 };
+        poll(&waitFor, 1, 100);
+
+        std::lock_guard<std::mutex> guard(client->lock);
+        if (!client->connected) continue;
+        while (client->socket.available()) {
+            uint8_t header;
+            std::vector<uint8_t> body;
+            if (!readPacket(client, header, body)) {
+                dropSession(client);
+                break;
+            }
+            if ((header & 0xF0) == MQTT_PUBACK && body.size() >= 2) {
+                int msgId = (body[0] << 8) | body[1];
+                client->unacked.erase(std::remove(client->unacked.begin(), client->unacked.end(), msgId),
+                                      client->unacked.end());
+                fireEvent(client, MQTT_EVENT_PUBLISHED, msgId);
+            }
+        }
+        if (client->connected && !client->socket.connected()) {
+            dropSession(client);
+        }
+        if (client->connected && millis() - client->lastSentMs >= (unsigned long)client->keepaliveS * 500UL) {
+            if (!sendPacket(client, MQTT_PINGREQ, {})) dropSession(client);
+        }
+    }
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config) {
+    if (config->broker.address.uri == nullptr) return nullptr;
+
+    // mqtt://host[:port]; mqtts:// is accepted but the host link stays plain TCP
+    std::string uri = config->broker.address.uri;
+    size_t scheme = uri.find("://");
+    if (scheme == std::string::npos) return nullptr;
+    std::string authority = uri.substr(scheme + 3);
+    authority = authority.substr(0, authority.find('/'));
+
+    esp_mqtt_client* client = new esp_mqtt_client();
+    size_t colon = authority.rfind(':');
+    client->host = authority.substr(0, colon);
+    if (colon != std::string::npos) client->port = (uint16_t)atoi(authority.c_str() + colon + 1);
+    if (config->credentials.client_id != nullptr) client->clientId = config->credentials.client_id;
+    if (config->credentials.username != nullptr) client->username = config->credentials.username;
+    if (config->credentials.authentication.password != nullptr) {
+        client->password = config->credentials.authentication.password;
+    }
+    if (config->session.keepalive > 0) client->keepaliveS = config->session.keepalive;
+    client->cleanSession = !config->session.disable_clean_session;
+    return client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t,
+                                         esp_event_handler_t handler, void* arg) {
+    client->handler = handler;
+    client->handlerArg = arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+    std::thread(runClient, client).detach();
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic, const char* data,
+                            int length, int qos, int retain) {
+    std::lock_guard<std::mutex> guard(client->lock);
+    if (!client->connected) return -1;
+
+    int msgId = 0;
+    std::vector<uint8_t> body;
+    putString(body, topic);
+    if (qos > 0) {
+        msgId = client->nextMsgId;
+        client->nextMsgId = client->nextMsgId == 0xFFFF ? 1 : client->nextMsgId + 1;
+        body.push_back((uint8_t)(msgId >> 8));
+        body.push_back((uint8_t)msgId);
+    }
+    if (length <= 0) length = (int)strlen(data);
+    body.insert(body.end(), data, data + length);
+
+    uint8_t header = MQTT_PUBLISH | (qos > 0 ? 0x02 : 0x00) | (retain ? 0x01 : 0x00);
+    if (!sendPacket(client, header, body)) {
+        dropSession(client);
+        return -1;
+    }
+    if (qos > 0) client->unacked.push_back(msgId);
+    return msgId;
+}
@@ -0,0 +1,66 @@
+#include "Preferences.h"
+#include <map>
+#include <mutex>
+
+static std::map<std::string, std::map<std::string, std::string>> store;
+static std::mutex storeMutex;
+
+bool Preferences::begin(const char* ns, bool, const char*) {
+    name = ns ? ns : "";
+    opened = true;
+    return true;
+}
+
+void Preferences::end() {
+    opened = false;
+}
+
+bool Preferences::clear() {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    store[name].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return store[name].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return store[name].count(key) > 0;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    return putBytes(key, value.c_str(), value.length());
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    auto& space = store[name];
+    auto it = space.find(key);
+    return it == space.end() ? defaultValue : String(it->second);
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t length) {
+    if (!opened) return 0;
+    std::lock_guard<std::mutex> lock(storeMutex);
+    store[name][key] = std::string((const char*)value, length);
+    return length;
+}
+
+size_t Preferences::getBytes(const char* key, void* buffer, size_t length) {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    auto& space = store[name];
+    auto it = space.find(key);
+    if (it == space.end() || it->second.size() > length) return 0;
+    memcpy(buffer, it->second.data(), it->second.size());
+    return it->second.size();
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    auto& space = store[name];
+    auto it = space.find(key);
+    return it == space.end() ? 0 : it->second.size();
+}
@@ -0,0 +1,161 @@
+#include "WiFi.h"
+#include "WiFiClientSecure.h"
+#include "HostShim.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+WiFiClass WiFi;
+
+static std::string rtdbHost = "127.0.0.1";
+static uint16_t rtdbPort = 9000;
+static HostFirebaseCounters counters;
+
+static struct EndpointFromEnvironment {
+    EndpointFromEnvironment() {
+        const char* value = getenv("LIMO_RTDB_EMULATOR");
+        if (value == nullptr) return;
+        std::string endpoint(value);
+        size_t colon = endpoint.rfind(':');
+        if (colon == std::string::npos) {
+            rtdbHost = endpoint;
+        } else {
+            rtdbHost = endpoint.substr(0, colon);
+            rtdbPort = (uint16_t)atoi(endpoint.c_str() + colon + 1);
+        }
+    }
+} endpointFromEnvironment;
+
+void hostSetRtdbEndpoint(const char* host, uint16_t port) {
+    rtdbHost = host;
+    rtdbPort = port;
+}
+
+const char* hostRtdbHost() { return rtdbHost.c_str(); }
+uint16_t hostRtdbPort() { return rtdbPort; }
+
+const HostFirebaseCounters& hostFirebaseCounters() { return counters; }
+void hostResetFirebaseCounters() { counters = HostFirebaseCounters(); }
+void hostCountDeviceConnect() { counters.connects++; }
+
+int WiFiClient::connect(const char* host, uint16_t port) {
+    stop();
+    if (!WiFi.isConnected()) return 0;
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &result) != 0) return 0;
+
+    for (addrinfo* candidate = result; candidate != nullptr; candidate = candidate->ai_next) {
+        fd = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+        if (fd < 0) continue;
+        if (::connect(fd, candidate->ai_addr, candidate->ai_addrlen) == 0) break;
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if (fd < 0) return 0;
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    pendingStart = pendingEnd = 0;
+    return 1;
+}
+
+int WiFiClientSecure::connect(const char*, uint16_t) {
+    counters.connects++;
+    int connected = WiFiClient::connect(hostRtdbHost(), hostRtdbPort());
+    counted = true;
+    return connected;
+}
+
+void WiFiClient::stop() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    pendingStart = pendingEnd = 0;
+}
+
+// Pull whatever the socket has into the local buffer; timeoutMs < 0 blocks
+bool WiFiClient::fill(int timeoutMs) {
+    if (fd < 0) return false;
+    if (pendingStart < pendingEnd) return true;
+
+    pollfd waitFor = { fd, POLLIN, 0 };
+    if (poll(&waitFor, 1, timeoutMs) <= 0) return false;
+
+    ssize_t received = recv(fd, pending, sizeof(pending), 0);
+    if (received <= 0) {
+        stop();
+        return false;
+    }
+    pendingStart = 0;
+    pendingEnd = (size_t)received;
+    if (counted) counters.bytesReceived += (uint32_t)received;
+    return true;
+}
+
+uint8_t WiFiClient::connected() {
+    if (fd < 0) return 0;
+    if (pendingStart < pendingEnd) return 1;
+
+    // A readable socket with nothing to read has been closed by the peer
+    char probe;
+    ssize_t peeked = recv(fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (peeked == 0 || (peeked < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        stop();
+        return 0;
+    }
+    return 1;
+}
+
+int WiFiClient::available() {
+    if (pendingStart == pendingEnd) fill(0);
+    return (int)(pendingEnd - pendingStart);
+}
+
+int WiFiClient::read() {
+    if (!available()) return -1;
+    return pending[pendingStart++];
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size) {
+    size_t count = 0;
+    while (count < size && available()) {
+        size_t chunk = std::min(size - count, pendingEnd - pendingStart);
+        memcpy(buffer + count, pending + pendingStart, chunk);
+        pendingStart += chunk;
+        count += chunk;
+    }
+    return (int)count;
+}
+
+int WiFiClient::peek() {
+    if (!available()) return -1;
+    return pending[pendingStart];
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size) {
+    size_t sent = 0;
+    while (fd >= 0 && sent < size) {
+        ssize_t n = send(fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            stop();
+            break;
+        }
+        sent += (size_t)n;
+    }
+    if (counted) counters.bytesSent += (uint32_t)sent;
+    return sent;
+}
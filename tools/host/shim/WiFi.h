@@ -0,0 +1,66 @@
+#pragma once
+// Host WiFi: always associated; WiFiClient is a plain POSIX TCP socket
+#include "Arduino.h"
+#include <time.h>
+#include <sys/time.h>
+
+typedef enum {
+    WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL = 1, WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4, WL_CONNECTION_LOST = 5, WL_DISCONNECTED = 6
+} wl_status_t;
+typedef enum { ARDUINO_EVENT_WIFI_STA_DISCONNECTED, ARDUINO_EVENT_WIFI_STA_GOT_IP } arduino_event_id_t;
+typedef arduino_event_id_t WiFiEvent_t;
+#define WIFI_STA 1
+
+class WiFiClient : public Stream {
+public:
+    WiFiClient() {}
+    ~WiFiClient() override { stop(); }
+    WiFiClient(const WiFiClient&) = delete;
+    WiFiClient& operator=(const WiFiClient&) = delete;
+
+    virtual int connect(const char* host, uint16_t port);
+    virtual int connect(const char* host, uint16_t port, int32_t) { return connect(host, port); }
+    virtual uint8_t connected();
+    virtual void stop();
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size);
+    int peek() override;
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    void setNoDelay(bool) {}
+
+protected:
+    int fd = -1;
+    bool counted = false;   // Device traffic to the emulator, reported in HostFirebaseCounters
+    bool fill(int timeoutMs);
+    uint8_t pending[1024];
+    size_t pendingStart = 0;
+    size_t pendingEnd = 0;
+};
+
+class WiFiClass {
+public:
+    wl_status_t status() { return connectedFlag ? WL_CONNECTED : WL_DISCONNECTED; }
+    bool isConnected() { return connectedFlag; }
+    void mode(int) {}
+    void begin(const char* ssid, const char*) { currentSsid = ssid ? ssid : ""; connectedFlag = true; }
+    bool disconnect(bool = false) { connectedFlag = false; return true; }
+    bool reconnect() { connectedFlag = true; return true; }
+    void setSleep(bool) {}
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+    String SSID() { return currentSsid; }
+    void macAddress(uint8_t* mac) { const uint8_t host[6] = {0x02, 0x00, 0x00, 0x4c, 0x53, 0x01}; memcpy(mac, host, 6); }
+    int8_t RSSI() { return -40; }
+    void onEvent(void (*)(WiFiEvent_t)) {}
+
+    // Host only: simulate a dropped association
+    void setConnected(bool connected) { connectedFlag = connected; }
+
+private:
+    bool connectedFlag = true;
+    String currentSsid = "host";
+};
+extern WiFiClass WiFi;
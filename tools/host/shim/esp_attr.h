@@ -0,0 +1,5 @@
+#pragma once
+// RTC memory does not exist on the host; these become ordinary statics
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+#define DRAM_ATTR
@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+typedef enum {
+    ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_SW, ESP_RST_PANIC, ESP_RST_INT_WDT,
+    ESP_RST_TASK_WDT, ESP_RST_WDT, ESP_RST_DEEPSLEEP, ESP_RST_BROWNOUT
+} esp_reset_reason_t;
+
+esp_reset_reason_t esp_reset_reason();
+esp_err_t esp_efuse_mac_get_default(uint8_t* mac);
+uint32_t esp_random();
+void esp_fill_random(void* buffer, size_t length);
+uint32_t esp_get_free_heap_size();
@@ -0,0 +1,27 @@
+#pragma once
+// FreeRTOS on top of std::thread. portMUX critical sections share one
+// recursive mutex, which is coarser than the ESP32 spinlocks but equivalent.
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void* QueueHandle_t;
+typedef void* TaskHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdMS_TO_TICKS(x) ((TickType_t)(x))
+#define portMAX_DELAY 0xffffffffu
+#define portTICK_PERIOD_MS 1
+
+typedef struct { int unused; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void portENTER_CRITICAL(portMUX_TYPE* mux);
+void portEXIT_CRITICAL(portMUX_TYPE* mux);
+BaseType_t xPortGetCoreID();
@@ -0,0 +1,33 @@
+#pragma once
+// SHA-1 and SHA-256 with their HMACs, matching the mbedtls_md calls the firmware makes
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum { MBEDTLS_MD_NONE = 0, MBEDTLS_MD_SHA1 = 4, MBEDTLS_MD_SHA256 = 6 } mbedtls_md_type_t;
+typedef struct mbedtls_md_info_t mbedtls_md_info_t;
+
+typedef struct {
+    const mbedtls_md_info_t* info;
+    uint32_t state[8];
+    uint64_t bitCount;
+    uint8_t block[64];
+    size_t blockUsed;
+    uint8_t hmacOuterKey[64];
+    int hmac;
+} mbedtls_md_context_t;
+
+const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type);
+unsigned char mbedtls_md_get_size(const mbedtls_md_info_t* info);
+int mbedtls_md(const mbedtls_md_info_t* info, const unsigned char* input, size_t length, unsigned char* output);
+
+void mbedtls_md_init(mbedtls_md_context_t* ctx);
+void mbedtls_md_free(mbedtls_md_context_t* ctx);
+int mbedtls_md_setup(mbedtls_md_context_t* ctx, const mbedtls_md_info_t* info, int hmac);
+int mbedtls_md_starts(mbedtls_md_context_t* ctx);
+int mbedtls_md_update(mbedtls_md_context_t* ctx, const unsigned char* input, size_t length);
+int mbedtls_md_finish(mbedtls_md_context_t* ctx, unsigned char* output);
+int mbedtls_md_hmac_starts(mbedtls_md_context_t* ctx, const unsigned char* key, size_t keyLength);
+int mbedtls_md_hmac_update(mbedtls_md_context_t* ctx, const unsigned char* input, size_t length);
+int mbedtls_md_hmac_finish(mbedtls_md_context_t* ctx, unsigned char* output);
+int mbedtls_md_hmac(const mbedtls_md_info_t* info, const unsigned char* key, size_t keyLength,
+                    const unsigned char* input, size_t length, unsigned char* output);
@@ -0,0 +1,196 @@
+#include "mbedtls/md.h"
+#include <string.h>
+
+// The info pointer is just a tag for the algorithm
+struct mbedtls_md_info_t { int type; unsigned char size; };
+static const mbedtls_md_info_t sha1Info = { MBEDTLS_MD_SHA1, 20 };
+static const mbedtls_md_info_t sha256Info = { MBEDTLS_MD_SHA256, 32 };
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+static uint32_t rotl(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+static void sha1Transform(mbedtls_md_context_t* ctx, const uint8_t* block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+               (uint32_t)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3], e = ctx->state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) { f = (b & c) | (~b & d); k = 0x5a827999; }
+        else if (i < 40) { f = b ^ c ^ d; k = 0x6ed9eba1; }
+        else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8f1bbcdc; }
+        else { f = b ^ c ^ d; k = 0xca62c1d6; }
+        uint32_t t = rotl(a, 5) + f + e + k + w[i];
+        e = d; d = c; c = rotl(b, 30); b = a; a = t;
+    }
+    ctx->state[0] += a; ctx->state[1] += b; ctx->state[2] += c; ctx->state[3] += d; ctx->state[4] += e;
+}
+
+static void sha256Transform(mbedtls_md_context_t* ctx, const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 |
+               (uint32_t)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3];
+    uint32_t e = ctx->state[4], f = ctx->state[5], g = ctx->state[6], h = ctx->state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+    ctx->state[0] += a; ctx->state[1] += b; ctx->state[2] += c; ctx->state[3] += d;
+    ctx->state[4] += e; ctx->state[5] += f; ctx->state[6] += g; ctx->state[7] += h;
+}
+
+static void transform(mbedtls_md_context_t* ctx, const uint8_t* block) {
+    if (ctx->info->type == MBEDTLS_MD_SHA1) {
+        sha1Transform(ctx, block);
+    } else {
+        sha256Transform(ctx, block);
+    }
+}
+
+const mbedtls_md_info_t* mbedtls_md_info_from_type(mbedtls_md_type_t type) {
+    if (type == MBEDTLS_MD_SHA1) return &sha1Info;
+    return type == MBEDTLS_MD_SHA256 ? &sha256Info : nullptr;
+}
+
+unsigned char mbedtls_md_get_size(const mbedtls_md_info_t* info) {
+    return info != nullptr ? info->size : 0;
+}
+
+void mbedtls_md_init(mbedtls_md_context_t* ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_md_free(mbedtls_md_context_t* ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_md_setup(mbedtls_md_context_t* ctx, const mbedtls_md_info_t* info, int hmac) {
+    if (info == nullptr) return -1;
+    ctx->info = info;
+    ctx->hmac = hmac;
+    return 0;
+}
+
+int mbedtls_md_starts(mbedtls_md_context_t* ctx) {
+    static const uint32_t sha1Initial[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+    static const uint32_t sha256Initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    if (ctx->info->type == MBEDTLS_MD_SHA1) {
+        memcpy(ctx->state, sha1Initial, sizeof(sha1Initial));
+    } else {
+        memcpy(ctx->state, sha256Initial, sizeof(sha256Initial));
+    }
+    ctx->bitCount = 0;
+    ctx->blockUsed = 0;
+    return 0;
+}
+
+int mbedtls_md_update(mbedtls_md_context_t* ctx, const unsigned char* input, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        ctx->block[ctx->blockUsed++] = input[i];
+        if (ctx->blockUsed == 64) {
+            transform(ctx, ctx->block);
+            ctx->blockUsed = 0;
+        }
+    }
+    ctx->bitCount += (uint64_t)length * 8;
+    return 0;
+}
+
+int mbedtls_md_finish(mbedtls_md_context_t* ctx, unsigned char* output) {
+    uint64_t bits = ctx->bitCount;
+    uint8_t pad = 0x80;
+    mbedtls_md_update(ctx, &pad, 1);
+    pad = 0;
+    while (ctx->blockUsed != 56) {
+        mbedtls_md_update(ctx, &pad, 1);
+    }
+    uint8_t length[8];
+    for (int i = 0; i < 8; i++) length[i] = (uint8_t)(bits >> (56 - 8 * i));
+    mbedtls_md_update(ctx, length, 8);
+    for (int i = 0; i < ctx->info->size / 4; i++) {
+        output[i * 4] = ctx->state[i] >> 24;
+        output[i * 4 + 1] = ctx->state[i] >> 16;
+        output[i * 4 + 2] = ctx->state[i] >> 8;
+        output[i * 4 + 3] = ctx->state[i];
+    }
+    return 0;
+}
+
+int mbedtls_md(const mbedtls_md_info_t* info, const unsigned char* input, size_t length, unsigned char* output) {
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    if (mbedtls_md_setup(&ctx, info, 0) != 0) return -1;
+    mbedtls_md_starts(&ctx);
+    mbedtls_md_update(&ctx, input, length);
+    return mbedtls_md_finish(&ctx, output);
+}
+
+int mbedtls_md_hmac_starts(mbedtls_md_context_t* ctx, const unsigned char* key, size_t keyLength) {
+    uint8_t block[64] = {0};
+    if (keyLength > 64) {
+        mbedtls_md(ctx->info, key, keyLength, block);
+    } else {
+        memcpy(block, key, keyLength);
+    }
+    uint8_t inner[64];
+    for (int i = 0; i < 64; i++) {
+        inner[i] = block[i] ^ 0x36;
+        ctx->hmacOuterKey[i] = block[i] ^ 0x5c;
+    }
+    mbedtls_md_starts(ctx);
+    return mbedtls_md_update(ctx, inner, 64);
+}
+
+int mbedtls_md_hmac_update(mbedtls_md_context_t* ctx, const unsigned char* input, size_t length) {
+    return mbedtls_md_update(ctx, input, length);
+}
+
+int mbedtls_md_hmac_finish(mbedtls_md_context_t* ctx, unsigned char* output) {
+    uint8_t innerDigest[32];
+    mbedtls_md_finish(ctx, innerDigest);
+    mbedtls_md_starts(ctx);
+    mbedtls_md_update(ctx, ctx->hmacOuterKey, 64);
+    mbedtls_md_update(ctx, innerDigest, ctx->info->size);
+    return mbedtls_md_finish(ctx, output);
+}
+
+int mbedtls_md_hmac(const mbedtls_md_info_t* info, const unsigned char* key, size_t keyLength,
+                    const unsigned char* input, size_t length, unsigned char* output) {
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+    if (mbedtls_md_setup(&ctx, info, 1) != 0) return -1;
+    mbedtls_md_hmac_starts(&ctx, key, keyLength);
+    mbedtls_md_hmac_update(&ctx, input, length);
+    return mbedtls_md_hmac_finish(&ctx, output);
+}
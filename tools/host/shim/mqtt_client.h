@@ -0,0 +1,57 @@
+#pragma once
+// Host esp-mqtt: the IDF 5 client API over a plain MQTT 3.1.1 socket (MqttShim.cpp).
+// Like the real client, a background thread keeps the session up and delivers
+// the events; unlike it, there is no outbox, so QoS 1 messages lost with a
+// connection are not re-sent after the reconnect but reported MQTT_EVENT_DELETED.
+#include "esp_system.h"
+
+typedef const char* esp_event_base_t;
+
+typedef enum {
+    MQTT_EVENT_ANY = -1,
+    MQTT_EVENT_ERROR = 0,
+    MQTT_EVENT_CONNECTED,
+    MQTT_EVENT_DISCONNECTED,
+    MQTT_EVENT_SUBSCRIBED,
+    MQTT_EVENT_UNSUBSCRIBED,
+    MQTT_EVENT_PUBLISHED,
+    MQTT_EVENT_DATA,
+    MQTT_EVENT_BEFORE_CONNECT,
+    MQTT_EVENT_DELETED
+} esp_mqtt_event_id_t;
+
+struct esp_mqtt_client;
+typedef struct esp_mqtt_client* esp_mqtt_client_handle_t;
+
+typedef struct {
+    esp_mqtt_event_id_t event_id;
+    esp_mqtt_client_handle_t client;
+    int msg_id;
+    bool session_present;
+} esp_mqtt_event_t;
+typedef esp_mqtt_event_t* esp_mqtt_event_handle_t;
+
+typedef struct {
+    struct {
+        struct { const char* uri; } address;
+        struct { esp_err_t (*crt_bundle_attach)(void*); } verification;
+    } broker;
+    struct {
+        const char* username;
+        const char* client_id;
+        struct { const char* password; } authentication;
+    } credentials;
+    struct {
+        int keepalive;
+        bool disable_clean_session;
+    } session;
+} esp_mqtt_client_config_t;
+
+typedef void (*esp_event_handler_t)(void* arg, esp_event_base_t base, int32_t eventId, void* data);
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config);
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t handler, void* arg);
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client);
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic, const char* data,
+                            int length, int qos, int retain);
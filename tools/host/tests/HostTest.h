@@ -0,0 +1,27 @@
+#pragma once
+// Minimal checks for the host unit tests: TEST(name) { CHECK(...); }. Each
+// file registers its tests statically; main.cpp runs them all.
+#include <stdio.h>
+#include <string.h>
+
+struct HostTestCase {
+    const char* name;
+    void (*run)();
+    HostTestCase* next;
+};
+
+struct HostTestRegistration {
+    HostTestRegistration(HostTestCase& test);
+};
+
+void hostCheck(bool ok, const char* expression, const char* file, int line);
+void hostCheckText(const char* actual, const char* expected, const char* expression, const char* file, int line);
+
+#define TEST(name)                                                      \
+    static void name();                                                 \
+    static HostTestCase name##Case = { #name, name, nullptr };         \
+    static HostTestRegistration name##Registration(name##Case);        \
+    static void name()
+
+#define CHECK(expression) hostCheck((expression), #expression, __FILE__, __LINE__)
+#define CHECK_TEXT(actual, expected) hostCheckText((actual), (expected), #actual, __FILE__, __LINE__)
@@ -0,0 +1,232 @@
+#include "HostTest.h"
+#include "JsonScanner.h"
+#include <string>
+
+// Tokens as "depth key type text", ';'-separated; "!" marks a truncated value
+class TokenRecorder : public JsonScanner {
+public:
+    std::string tokens;
+    int stopAfter = -1;
+
+protected:
+    bool onToken(const JsonToken& token) override {
+        static const char* const TYPES[] = { "object", "array", "string", "number", "bool", "null" };
+        if (!tokens.empty()) {
+            tokens += ";";
+        }
+        tokens += std::to_string(token.depth) + " " + token.key + " " + TYPES[token.type];
+        if (token.text[0] != '\0') {
+            tokens += " ";
+            tokens += token.text;
+        }
+        if (token.truncated) {
+            tokens += "!";
+        }
+        return stopAfter < 0 || --stopAfter > 0;
+    }
+};
+
+static bool scanText(TokenRecorder& recorder, const char* json) {
+    return recorder.scan(json, strlen(json));
+}
+
+static bool accepts(const char* json) {
+    TokenRecorder recorder;
+    return scanText(recorder, json);
+}
+
+static std::string nested(int levels, const char* open, const char* inner, const char* close) {
+    std::string json;
+    for (int i = 0; i < levels; i++) json += open;
+    json += inner;
+    for (int i = 0; i < levels; i++) json += close;
+    return json;
+}
+
+TEST(scannerReportsEveryValue) {
+    TokenRecorder recorder;
+    CHECK(scanText(recorder, " {\"a\": \"x\", \"b\": [1, -2.5e3, true], \"c\": {\"d\": null}} "));
+    CHECK_TEXT(recorder.tokens.c_str(),
+               "0  object;1 a string x;1 b array;2 0 number 1;2 1 number -2.5e3;2 2 bool true;"
+               "1 c object;2 d null null");
+}
+
+TEST(scannerAcceptsBareValues) {
+    TokenRecorder recorder;
+    CHECK(scanText(recorder, "12"));
+    CHECK_TEXT(recorder.tokens.c_str(), "0  number 12");
+    CHECK(accepts("null"));
+    CHECK(accepts("\"text\""));
+    CHECK(accepts("{}"));
+    CHECK(accepts("[]"));
+}
+
+TEST(scannerUnescapesStrings) {
+    TokenRecorder recorder;
+    CHECK(scanText(recorder, "[\"q\\\"b\\\\s\\/\", \"\\t\\n\", \"\\u0041\\u00e9\\u20AC\"]"));
+    CHECK_TEXT(recorder.tokens.c_str(), "0  array;1 0 string q\"b\\s/;1 1 string \t\n;1 2 string A\xC3\xA9\xE2\x82\xAC");
+}
+
+TEST(scannerUnescapesKeys) {
+    TokenRecorder recorder;
+    CHECK(scanText(recorder, "{\"a\\u0062\": 1}"));
+    CHECK_TEXT(recorder.tokens.c_str(), "0  object;1 ab number 1");
+}
+
+TEST(scannerReplacesUnpairedSurrogates) {
+    TokenRecorder recorder;
+    CHECK(scanText(recorder, "\"\\uD83D\\uDE00\""));
+    CHECK_TEXT(recorder.tokens.c_str(), "0  string ??");
+}
+
+TEST(scannerRejectsMalformedInput) {
+    CHECK(!accepts(""));
+    CHECK(!accepts("{\"a\" 1}"));
+    CHECK(!accepts("{\"a\": 1,}"));
+    CHECK(!accepts("[1,]"));
+    CHECK(!accepts("{a: 1}"));
+    CHECK(!accepts("{\"a\": tru}"));
+    CHECK(!accepts("{\"a\": nul}"));
+    CHECK(!accepts("[1 2]"));
+    CHECK(!accepts("{\"a\": 1]"));
+    CHECK(!accepts("[1}"));
+    CHECK(!accepts("{} {}"));
+    CHECK(!accepts("{}x"));
+    CHECK(!accepts("\"bad \\x escape\""));
+    CHECK(!accepts("\"bad \\u12G4 escape\""));
+    CHECK(!accepts("\"raw \n newline\""));
+}
+
+TEST(scannerRejectsMalformedNumbers) {
+    CHECK(!accepts("[1x]"));
+    CHECK(!accepts("[-]"));
+    CHECK(!accepts("[01]"));
+    CHECK(!accepts("[1.]"));
+    CHECK(!accepts("[.5]"));
+    CHECK(!accepts("[1e]"));
+    CHECK(!accepts("[1e+]"));
+    CHECK(!accepts("[--1]"));
+    CHECK(accepts("[0, -0, 0.5, 10, 1E9, 2e-3, 1.25e+2]"));
+}
+
+TEST(scannerRejectsTruncatedInput) {
+    const char* json = "{\"a\": {\"b\": [1, \"two\", true]}, \"c\": \"\\u00e9\"}";
+    CHECK(accepts(json));
+    // Every proper prefix is an incomplete document
+    for (size_t length = 0; length < strlen(json); length++) {
+        TokenRecorder recorder;
+        recorder.feed(json, length);
+        if (recorder.finish()) {
+            printf("  prefix of %zu bytes accepted\n", length);
+            CHECK(false);
+        }
+    }
+}
+
+TEST(scannerGivesTheSameTokensWhateverTheChunks) {
+    const char* json = "{\"key\": \"va\\u006Cue\", \"list\": [12345, false, {\"x\": null}]}";
+    TokenRecorder whole;
+    CHECK(scanText(whole, json));
+    for (size_t split = 1; split < strlen(json); split++) {
+        TokenRecorder chunked;
+        CHECK(chunked.feed(json, split));
+        CHECK(chunked.feed(json + split, strlen(json) - split));
+        CHECK(chunked.finish());
+        CHECK(chunked.tokens == whole.tokens);
+    }
+}
+
+TEST(scannerFlagsTruncatedValues) {
+    std::string longText(JSON_SCAN_VALUE_LEN + 8, 'a');
+    std::string longNumber(JSON_SCAN_VALUE_LEN + 8, '7');
+    TokenRecorder recorder;
+    std::string json = "[\"" + longText + "\", " + longNumber + "]";
+    CHECK(scanText(recorder, json.c_str()));
+    std::string expected = "0  array;1 0 string " + longText.substr(0, JSON_SCAN_VALUE_LEN) + "!;" +
+                           "1 1 number " + longNumber.substr(0, JSON_SCAN_VALUE_LEN) + "!";
+    CHECK(recorder.tokens == expected);
+}
+
+TEST(scannerLimitsNesting) {
+    CHECK(accepts(nested(JSON_SCAN_MAX_NESTING, "[", "1", "]").c_str()));
+    CHECK(!accepts(nested(JSON_SCAN_MAX_NESTING + 1, "[", "1", "]").c_str()));
+    CHECK(accepts(nested(JSON_SCAN_MAX_NESTING, "{\"k\":", "1", "}").c_str()));
+    CHECK(!accepts(nested(JSON_SCAN_MAX_NESTING + 1, "{\"k\":", "1", "}").c_str()));
+    // Far deeper than the limit, unbalanced: rejected without reading on
+    CHECK(!accepts(std::string(4096, '[').c_str()));
+}
+
+TEST(scannerKeepsKeysOnlyForTheFirstLevels) {
+    std::string json = nested(JSON_SCAN_MAX_DEPTH + 2, "{\"k\":", "7", "}");
+    TokenRecorder recorder;
+    CHECK(scanText(recorder, json.c_str()));
+    // The value sits below the kept levels, so it has no key or path of its own
+    std::string last = recorder.tokens.substr(recorder.tokens.rfind(';') + 1);
+    CHECK(last == std::to_string(JSON_SCAN_MAX_DEPTH + 2) + "  number 7");
+}
+
+TEST(scannerStopsWhenAsked) {
+    TokenRecorder recorder;
+    recorder.stopAfter = 2;
+    CHECK(scanText(recorder, "[1, 2, 3]"));
+    CHECK(recorder.stopped());
+    CHECK_TEXT(recorder.tokens.c_str(), "0  array;1 0 number 1");
+}
+
+TEST(extractorCopiesFieldsByPath) {
+    char uid[16];
+    char hash[8];
+    char first[8];
+    JsonField fields[] = {
+        { "uid", uid, sizeof(uid) },
+        { "meta/hash", hash, sizeof(hash) },
+        { "ids/1", first, sizeof(first) }
+    };
+    JsonFieldExtractor extractor(fields, 3);
+    String json = "{\"meta\": {\"hash\": \"abc\"}, \"ids\": [4, 5], \"uid\": \"user1\"}";
+    CHECK(extractor.scan(json));
+    CHECK(extractor.allFound());
+    CHECK_TEXT(uid, "user1");
+    CHECK_TEXT(hash, "abc");
+    CHECK_TEXT(first, "5");
+}
+
+TEST(extractorTreatsCutShortValuesAsMissing) {
+    char small[4];
+    char large[JSON_SCAN_VALUE_LEN + 16];
+    JsonField fields[] = {
+        { "a", small, sizeof(small) },
+        { "b", large, sizeof(large) }
+    };
+    JsonFieldExtractor extractor(fields, 2);
+    String json = String("{\"a\": \"four\", \"b\": \"") + std::string(JSON_SCAN_VALUE_LEN + 1, 'x').c_str() + "\"}";
+    CHECK(extractor.scan(json));
+    CHECK(!fields[0].found);
+    CHECK(!fields[1].found);
+    CHECK_TEXT(small, "");
+}
+
+TEST(extractorFindsNothingInMalformedInput) {
+    char uid[16];
+    JsonField field = { "uid", uid, sizeof(uid) };
+    JsonFieldExtractor extractor(&field, 1);
+    CHECK(!extractor.scan(String("{\"uid\" \"user1\"}")));
+    CHECK(!field.found);
+}
+
+TEST(childCounterSkipsNullAndEmptyChildren) {
+    JsonChildCounter all;
+    CHECK(all.scan(String("{\"a\": \"x\", \"b\": \"\", \"c\": null, \"d\": {\"e\": 1}}")));
+    CHECK(all.children() == 3);
+    JsonChildCounter nonEmpty(true);
+    CHECK(nonEmpty.scan(String("{\"a\": \"x\", \"b\": \"\", \"c\": null, \"d\": {\"e\": 1}}")));
+    CHECK(nonEmpty.children() == 2);
+}
+
+TEST(firstKeyStopsAtTheFirstChild) {
+    char key[8];
+    JsonFirstKey firstKey(key, sizeof(key));
+    CHECK(firstKey.scan(String("{\"uid123456\": {\"tag\": \"A\"}, \"other\": 1}")));
+    CHECK(firstKey.hasKey());
+    CHECK_TEXT(key, "uid1234");
+}
@@ -0,0 +1,142 @@
+#include "HostTest.h"
+#include "TotpVerifier.h"
+#include "TimeBase.h"
+
+// RFC 6238 appendix B seeds
+static const uint8_t SEED_SHA1[] = "12345678901234567890";
+static const uint8_t SEED_SHA256[] = "12345678901234567890123456789012";
+
+#define TEST_PERIOD 3600  // Long steps, so a test rarely has to wait for a boundary to pass
+
+struct RfcVector {
+    TotpAlgorithm algorithm;
+    uint64_t unixTime;
+    uint32_t truncated;     // 31-bit dynamic truncation of the HMAC
+    uint32_t rfcCode;       // The 8-digit code listed in the RFC
+};
+
+static const RfcVector RFC_VECTORS[] = {
+    { TOTP_SHA1, 59ULL, 1094287082UL, 94287082UL },
+    { TOTP_SHA1, 1111111109ULL, 907081804UL, 7081804UL },
+    { TOTP_SHA1, 1111111111ULL, 414050471UL, 14050471UL },
+    { TOTP_SHA1, 1234567890ULL, 689005924UL, 89005924UL },
+    { TOTP_SHA1, 2000000000ULL, 2069279037UL, 69279037UL },
+    { TOTP_SHA1, 20000000000ULL, 1465353130UL, 65353130UL },
+    { TOTP_SHA256, 59ULL, 746119246UL, 46119246UL },
+    { TOTP_SHA256, 1111111109ULL, 1568084774UL, 68084774UL },
+    { TOTP_SHA256, 1111111111ULL, 1167062674UL, 67062674UL },
+    { TOTP_SHA256, 1234567890ULL, 91819424UL, 91819424UL },
+    { TOTP_SHA256, 2000000000ULL, 1790698825UL, 90698825UL },
+    { TOTP_SHA256, 20000000000ULL, 777737706UL, 77737706UL }
+};
+
+// The mapping of TotpVerifier.h: value mod 36^4 in "0-9A-Z", most significant first
+static void base36(uint32_t value, char out[TOTP_CODE_LEN + 1]) {
+    static const char SYMBOLS[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    value %= 36UL * 36UL * 36UL * 36UL;
+    for (int i = TOTP_CODE_LEN - 1; i >= 0; i--) {
+        out[i] = SYMBOLS[value % 36];
+        value /= 36;
+    }
+    out[TOTP_CODE_LEN] = '\0';
+}
+
+static void setUpVerifier() {
+    refreshTimeBase();
+    TotpVerifier::load();
+}
+
+static bool provisionTest(const char* userTag) {
+    return TotpVerifier::provision(userTag, "user-of-test", SEED_SHA1, 20, TOTP_SHA1, TEST_PERIOD);
+}
+
+// The current step, at least two seconds before it ends
+static uint64_t stableStep() {
+    while ((epochMillis() / 1000) % TEST_PERIOD >= TEST_PERIOD - 2) {
+        delay(100);
+    }
+    return epochMillis() / 1000 / TEST_PERIOD;
+}
+
+static TotpResult verifyStep(const char* userTag, uint64_t step) {
+    char code[TOTP_CODE_LEN + 1];
+    char userId[AUTH_USER_ID_LEN];
+    TotpVerifier::generateCode(SEED_SHA1, 20, TOTP_SHA1, step, code);
+    return TotpVerifier::verify(userTag, code, userId);
+}
+
+TEST(generateCodeFollowsRfc6238) {
+    for (const RfcVector& vector : RFC_VECTORS) {
+        const uint8_t* seed = vector.algorithm == TOTP_SHA256 ? SEED_SHA256 : SEED_SHA1;
+        size_t length = vector.algorithm == TOTP_SHA256 ? 32 : 20;
+        char code[TOTP_CODE_LEN + 1];
+        char expected[TOTP_CODE_LEN + 1];
+        CHECK(vector.truncated % 100000000UL == vector.rfcCode);
+        CHECK(TotpVerifier::generateCode(seed, length, vector.algorithm, vector.unixTime / 30, code));
+        base36(vector.truncated, expected);
+        CHECK_TEXT(code, expected);
+    }
+}
+
+TEST(generateCodeWritesBase36) {
+    char code[TOTP_CODE_LEN + 1];
+    CHECK(TotpVerifier::generateCode(SEED_SHA1, 20, TOTP_SHA1, 59 / 30, code));
+    CHECK_TEXT(code, "IDBE");   // 1094287082 mod 36^4 = 857066 = I*36^3 + D*36^2 + B*36 + E
+    CHECK(TotpVerifier::generateCode(SEED_SHA256, 32, TOTP_SHA256, 1234567890 / 30, code));
+    CHECK_TEXT(code, "O0BK");
+}
+
+TEST(verifyAcceptsOneStepOfSkew) {
+    setUpVerifier();
+    CHECK(provisionTest("SKE"));
+    CHECK(provisionTest("SKN"));
+    CHECK(provisionTest("SKL"));
+    CHECK(provisionTest("SKF"));
+    uint64_t step = stableStep();
+    CHECK(verifyStep("SKE", step - 1) == TOTP_VALID);
+    CHECK(verifyStep("SKN", step) == TOTP_VALID);
+    CHECK(verifyStep("SKL", step + 1) == TOTP_VALID);
+    CHECK(verifyStep("SKF", step - 2) == TOTP_REJECTED);
+    CHECK(verifyStep("SKF", step + 2) == TOTP_REJECTED);
+}
+
+TEST(verifyFillsTheUserId) {
+    setUpVerifier();
+    CHECK(provisionTest("UID"));
+    char code[TOTP_CODE_LEN + 1];
+    char userId[AUTH_USER_ID_LEN] = "";
+    TotpVerifier::generateCode(SEED_SHA1, 20, TOTP_SHA1, stableStep(), code);
+    code[0] = tolower(code[0]);
+    CHECK(TotpVerifier::verify("UID", code, userId) == TOTP_VALID);
+    CHECK_TEXT(userId, "user-of-test");
+}
+
+TEST(verifyRejectsReplays) {
+    setUpVerifier();
+    CHECK(provisionTest("RPL"));
+    uint64_t step = stableStep();
+    CHECK(verifyStep("RPL", step) == TOTP_VALID);
+    CHECK(verifyStep("RPL", step) == TOTP_REJECTED);
+    CHECK(verifyStep("RPL", step - 1) == TOTP_REJECTED);
+    CHECK(verifyStep("RPL", step + 1) == TOTP_VALID);
+    CHECK(verifyStep("RPL", step + 1) == TOTP_REJECTED);
+}
+
+TEST(usedStepsSurviveAReload) {
+    setUpVerifier();
+    CHECK(provisionTest("RLD"));
+    uint64_t step = stableStep();
+    CHECK(verifyStep("RLD", step) == TOTP_VALID);
+    TotpVerifier::load();   // As after a power cycle: RAM state comes back from NVS only
+    CHECK(verifyStep("RLD", step) == TOTP_REJECTED);
+    CHECK(verifyStep("RLD", step + 1) == TOTP_VALID);
+}
+
+TEST(verifyLeavesUnknownTagsToTheCloud) {
+    setUpVerifier();
+    char userId[AUTH_USER_ID_LEN];
+    CHECK(TotpVerifier::verify("NON", "ABCD", userId) == TOTP_UNAVAILABLE);
+    CHECK(provisionTest("LEN"));
+    CHECK(TotpVerifier::verify("LEN", "ABC", userId) == TOTP_REJECTED);
+    CHECK(TotpVerifier::verify("LEN", "ABCDE", userId) == TOTP_REJECTED);
+}
@@ -0,0 +1,51 @@
+// Unit tests of firmware modules that need neither the emulator nor a board.
+//
+//   make test                        builds and runs every test in tests/
+#include <Arduino.h>
+#include "HostShim.h"
+#include "HostTest.h"
+
+static HostTestCase* firstTest = nullptr;
+static HostTestCase* lastTest = nullptr;
+static int failures = 0;
+
+HostTestRegistration::HostTestRegistration(HostTestCase& test) {
+    if (lastTest == nullptr) {
+        firstTest = &test;
+    } else {
+        lastTest->next = &test;
+    }
+    lastTest = &test;
+}
+
+void hostCheck(bool ok, const char* expression, const char* file, int line) {
+    if (!ok) {
+        printf("  %s:%d: CHECK(%s) failed\n", file, line, expression);
+        failures++;
+    }
+}
+
+void hostCheckText(const char* actual, const char* expected, const char* expression, const char* file, int line) {
+    if (strcmp(actual, expected) != 0) {
+        printf("  %s:%d: %s is \"%s\", expected \"%s\"\n", file, line, expression, actual, expected);
+        failures++;
+    }
+}
+
+int main() {
+    hostSetSerialEnabled(getenv("LIMO_TEST_VERBOSE") != nullptr);
+
+    int tests = 0;
+    int failed = 0;
+    for (HostTestCase* test = firstTest; test != nullptr; test = test->next) {
+        int before = failures;
+        test->run();
+        tests++;
+        if (failures != before) {
+            printf("FAIL %s\n", test->name);
+            failed++;
+        }
+    }
+    printf("%d tests, %d failed\n", tests, failed);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+#!/usr/bin/env python3
+"""Decoder for the LIMO SAFE compact (CBOR) schemas.
+
+The firmware sends log batches and status updates over MQTT as CBOR maps with
+small integer keys (LIMO_SAFE_ESP32/DevicePayloads.h) and numeric event codes
+(EventType in LIMO_SAFE_ESP32/EventLogger.h). expand() turns one of them back
+into the JSON object the firmware would PATCH into devices/<id>/<node> over
+RTDB REST, record keys and field names included, so a database written through
+either transport looks the same.
+
+Usage:
+  python3 tools/limo_cbor.py logs <hex>      print the RTDB JSON of a payload
+  python3 tools/limo_cbor.py status - < payload.bin
+"""
+
+import datetime
+import json
+import sys
+
+SCHEMA_VERSION = 1
+
+# EventType codes -> stored "event" names (EVENT_NAMES in EventLogger.cpp)
+EVENT_NAMES = [
+    "lock",
+    "security",
+    "wifi_connected",
+    "otp_format_invalid",
+    "otp_verification_failed",
+    "otp_verified",
+    "unauthorized_user_attempt",
+    "first_user_registration_failed",
+    "fingerprint_authentication_success",
+    "fingerprint_authentication_failed",
+    "fingerprint_enrolled",
+    "fingerprint_enrollment_failed",
+    "user_fingerprints_deleted",
+    "user_fingerprints_delete_partial",
+    "fingerprint_delete_no_fingerprints",
+    "multiple_fingerprints_deleted",
+    "all_fingerprints_deleted",
+    "otp_lockout",
+    "otp_attempts_blocked",
+]
+
+# flagKeyFor() and detailKeyFor() in EventLogger.cpp
+FLAG_KEYS = {"lock": "locked", "security": "secure", "all_fingerprints_deleted": "success"}
+DETAIL_KEYS = {
+    "wifi_connected": "ssid",
+    "otp_format_invalid": "attempted_otp",
+    "fingerprint_enrollment_failed": "reason",
+    "otp_lockout": "lockout_seconds",
+}
+
+# StatusCborKey
+STATUS_VERSION, STATUS_ONLINE, STATUS_LOCKED, STATUS_SECURE, STATUS_TIMESTAMP = range(5)
+# EventBatchCborKey
+BATCH_VERSION, BATCH_PUSH_SUFFIX, BATCH_EVENTS = range(3)
+# EventCborKey
+(EVENT_CODE, EVENT_SEQ, EVENT_TIME, EVENT_KEY_TIME, EVENT_UNDATED, EVENT_FLAG, EVENT_FINGERPRINT_ID,
+ EVENT_TOTAL, EVENT_SUCCESS, EVENT_USER_ID, EVENT_TAG, EVENT_DETAIL) = range(12)
+
+UNDATED_SHARD = "undated"
+PUSH_CHARS = "-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz"
+SERVER_TIMESTAMP = {".sv": "timestamp"}
+
+
+class SchemaError(ValueError):
+    pass
+
+
+# --- CBOR (RFC 8949): the subset CborWriter emits, plus definite lengths ---
+
+_BREAK = object()
+
+
+def _decode(data, offset):
+    if offset >= len(data):
+        raise SchemaError("truncated")
+    initial = data[offset]
+    offset += 1
+    major, info = initial >> 5, initial & 0x1F
+
+    if initial == 0xFF:
+        return _BREAK, offset
+    if major == 7:
+        simple = {20: False, 21: True, 22: None}
+        if info not in simple:
+            raise SchemaError("simple value or float 0x%02x" % initial)  # Not used by the schemas
+        return simple[info], offset
+
+    if info < 24:
+        argument = info
+    elif info in (24, 25, 26, 27):
+        size = 1 << (info - 24)
+        if offset + size > len(data):
+            raise SchemaError("truncated")
+        argument = int.from_bytes(data[offset:offset + size], "big")
+        offset += size
+    elif info == 31 and major in (2, 3, 4, 5):
+        argument = None  # Indefinite length
+    else:
+        raise SchemaError("bad head 0x%02x" % initial)
+
+    if major == 0:
+        return argument, offset
+    if major == 1:
+        return -1 - argument, offset
+    if major in (2, 3):
+        if argument is None:
+            chunks = []
+            while True:
+                chunk, offset = _decode(data, offset)
+                if chunk is _BREAK:
+                    break
+                chunks.append(chunk)
+            return (b"" if major == 2 else "").join(chunks), offset
+        if offset + argument > len(data):
+            raise SchemaError("truncated")
+        raw = bytes(data[offset:offset + argument])
+        return (raw if major == 2 else raw.decode("utf-8", "replace")), offset + argument
+    if major == 4:
+        items = []
+        while argument is None or len(items) < argument:
+            item, offset = _decode(data, offset)
+            if item is _BREAK:
+                if argument is not None:
+                    raise SchemaError("break in a definite array")
+                break
+            items.append(item)
+        return items, offset
+    if major == 5:
+        members = {}
+        while argument is None or len(members) < argument:
+            key, offset = _decode(data, offset)
+            if key is _BREAK:
+                if argument is not None:
+                    raise SchemaError("break in a definite map")
+                break
+            value, offset = _decode(data, offset)
+            members[key] = value
+        return members, offset
+    # major 6: tags are not used by the schemas; skip the tag, keep the item
+    return _decode(data, offset)
+
+
+def decode(data):
+    value, offset = _decode(data, 0)
+    if value is _BREAK or offset != len(data):
+        raise SchemaError("trailing bytes")
+    return value
+
+
+# --- Schemas ---
+
+def _check_version(message):
+    if not isinstance(message, dict):
+        raise SchemaError("not a map")
+    version = message.get(0)
+    if version != SCHEMA_VERSION:
+        raise SchemaError("schema version %r" % version)
+
+
+def push_id(time_ms, suffix, seq):
+    """makePushId() in EventLogger.cpp"""
+    chars = []
+    for _ in range(8):
+        chars.append(PUSH_CHARS[time_ms & 0x3F])
+        time_ms >>= 6
+    tail = []
+    for _ in range(8):
+        tail.append(PUSH_CHARS[seq & 0x3F])
+        seq >>= 6
+    return "".join(reversed(chars)) + suffix + "".join(reversed(tail))
+
+
+def log_day(time_ms):
+    """formatLogDay(): the UTC day"""
+    day = datetime.datetime.fromtimestamp(time_ms / 1000, tz=datetime.timezone.utc)
+    return day.strftime("%Y-%m-%d")
+
+
+def expand_event(event, suffix):
+    """(record key, record) of one event"""
+    code = event.get(EVENT_CODE)
+    if not isinstance(code, int) or not 0 <= code < len(EVENT_NAMES):
+        raise SchemaError("event code %r" % code)
+    name = EVENT_NAMES[code]
+
+    time_ms = event.get(EVENT_TIME)
+    key_time = event.get(EVENT_KEY_TIME, time_ms if time_ms is not None else 0)
+    day = UNDATED_SHARD if event.get(EVENT_UNDATED) else log_day(key_time)
+    key = "%s/%s" % (day, push_id(key_time, suffix, event.get(EVENT_SEQ, 0)))
+
+    # Same member order as writeEventPayload()
+    record = {"event": name, "timestamp": time_ms if time_ms is not None else dict(SERVER_TIMESTAMP)}
+    if EVENT_FLAG in event and name in FLAG_KEYS:
+        record[FLAG_KEYS[name]] = bool(event[EVENT_FLAG])
+    for field, stored in ((EVENT_FINGERPRINT_ID, "fingerprintId"), (EVENT_TOTAL, "total"),
+                          (EVENT_SUCCESS, "success"), (EVENT_USER_ID, "userId"), (EVENT_TAG, "tag")):
+        if field in event:
+            record[stored] = event[field]
+    if EVENT_DETAIL in event:
+        record[DETAIL_KEYS.get(name, "detail")] = event[EVENT_DETAIL]
+    return key, record
+
+
+def expand_logs(message):
+    _check_version(message)
+    suffix = message.get(BATCH_PUSH_SUFFIX)
+    if not isinstance(suffix, str) or len(suffix) != 4:
+        raise SchemaError("push ID suffix %r" % suffix)
+    patch = {}
+    for event in message.get(BATCH_EVENTS, []):
+        if not isinstance(event, dict):
+            raise SchemaError("event is not a map")
+        key, record = expand_event(event, suffix)
+        patch[key] = record
+    return patch
+
+
+def expand_status(message):
+    _check_version(message)
+    patch = {}
+    for field, stored in ((STATUS_ONLINE, "online"), (STATUS_LOCKED, "locked"),
+                          (STATUS_SECURE, "secure"), (STATUS_TIMESTAMP, "timestamp")):
+        if field in message:
+            patch[stored] = message[field]
+    return patch
+
+
+EXPANDERS = {"logs": expand_logs, "status": expand_status}
+
+
+def is_cbor(payload):
+    """A JSON PATCH body starts with '{', which no CBOR map does"""
+    return len(payload) > 0 and payload[:1] != b"{"
+
+
+def expand(node, payload):
+    """RTDB PATCH object for a CBOR payload published to limo/<id>/<node>"""
+    expander = EXPANDERS.get(node)
+    if expander is None:
+        raise SchemaError("no compact schema for %s" % node)
+    return expander(decode(payload))
+
+
+def main():
+    if len(sys.argv) != 3 or sys.argv[1] not in EXPANDERS:
+        print("usage: %s {%s} <hex>|-" % (sys.argv[0], ",".join(EXPANDERS)), file=sys.stderr)
+        return 2
+    payload = sys.stdin.buffer.read() if sys.argv[2] == "-" else bytes.fromhex(sys.argv[2])
+    try:
+        print(json.dumps(expand(sys.argv[1], payload), indent=2))
+    except SchemaError as error:
+        print("invalid payload: %s" % error, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
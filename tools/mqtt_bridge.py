@@ -0,0 +1,351 @@
+#!/usr/bin/env python3
+"""Bridge from the LIMO SAFE MQTT topics into the Realtime Database.
+
+The firmware publishes log batches, status updates and diagnostics to
+
+  limo/<device id>/<node>[/<child>...]       QoS 1 (logs) or QoS 0 (status, diagnostics)
+
+with the JSON object an RTDB multi-path PATCH of devices/<device id>/<node>
+would carry, or for logs and status their compact CBOR schema, which is
+expanded back into that JSON (tools/limo_cbor.py). This bridge PATCHes each
+message into RTDB and acknowledges a QoS 1 message only once RTDB accepted the
+write, so a record the device dropped from its queue is in the database.
+
+Two ways to run it:
+
+  --broker host:port    Subscribe to limo/+/# on a real broker (e.g. mosquitto)
+                        with a persistent session; messages not yet written
+                        stay with the broker across bridge restarts.
+  --listen port         Be the broker: a minimal MQTT 3.1.1 server for one or
+                        more devices, for local runs against tools/rtdb_emulator.py.
+                        Publish only; subscriptions are refused.
+
+Only the nodes in --nodes (default logs,status,diagnostics) are forwarded; anything else a
+client publishes is acknowledged and dropped.
+
+A device logs in with its device ID as the MQTT username and may only write
+its own node. The stand-in broker checks this itself: a publish to another
+device's topic is acknowledged and dropped. With --broker the bridge sees every
+device's messages through one subscription and cannot tell who sent them, so
+the broker must enforce it, e.g. in a mosquitto acl_file:
+
+  pattern write limo/%u/#
+  user <bridge username>
+  topic read limo/#
+
+with one password_file entry per device (username = device ID).
+
+Usage:
+  python3 tools/mqtt_bridge.py --listen 1883 --rtdb http://127.0.0.1:9000
+  python3 tools/mqtt_bridge.py --broker broker.local:8883 --tls \\
+      --username bridge --password ... --rtdb https://<db>.firebasedatabase.app --auth <secret>
+"""
+
+import argparse
+import json
+import socket
+import socketserver
+import ssl
+import struct
+import sys
+import threading
+import time
+import urllib.error
+import urllib.parse
+import urllib.request
+
+import limo_cbor
+
+CONNECT, CONNACK, PUBLISH, PUBACK = 0x10, 0x20, 0x30, 0x40
+SUBSCRIBE, SUBACK, PINGREQ, PINGRESP, DISCONNECT = 0x80, 0x90, 0xC0, 0xD0, 0xE0
+
+TOPIC_PREFIX = "limo/"
+
+
+class Forwarder:
+    """Topic -> RTDB PATCH."""
+
+    def __init__(self, rtdb, auth, nodes, verbose):
+        self.rtdb = rtdb.rstrip("/")
+        self.auth = auth
+        self.nodes = set(nodes)
+        self.verbose = verbose
+        self.lock = threading.Lock()
+        self.forwarded = 0
+        self.failed = 0
+
+    def parts_of(self, topic):
+        """[device id, node, ..] of a topic we forward, else None"""
+        if not topic.startswith(TOPIC_PREFIX):
+            return None
+        parts = topic[len(TOPIC_PREFIX):].split("/")
+        if len(parts) < 2 or not parts[0] or parts[1] not in self.nodes:
+            return None
+        if any(part in ("", ".", "..") for part in parts):
+            return None
+        return parts
+
+    def forward(self, topic, payload, sender=None):
+        """True when the message is settled: written, or not ours to write.
+        sender is the device ID the publisher logged in as, when known."""
+        parts = self.parts_of(topic)
+        if parts is None:
+            if self.verbose:
+                print("dropped %s" % topic, flush=True)
+            return True
+        if sender is not None and parts[0] != sender:
+            print("dropped %s: published by %s" % (topic, sender), file=sys.stderr, flush=True)
+            with self.lock:
+                self.failed += 1
+            return True
+        path = "devices/" + "/".join(parts)
+
+        if limo_cbor.is_cbor(payload):
+            try:
+                payload = json.dumps(limo_cbor.expand(parts[1], payload), separators=(",", ":")).encode()
+            except limo_cbor.SchemaError as error:
+                # Never becomes valid; holding it back would only block the queue
+                print("dropped %s: %s" % (topic, error), file=sys.stderr, flush=True)
+                with self.lock:
+                    self.failed += 1
+                return True
+
+        url = "%s/%s.json?print=silent" % (self.rtdb, urllib.parse.quote(path))
+        if self.auth:
+            url += "&auth=" + urllib.parse.quote(self.auth)
+        request = urllib.request.Request(url, data=payload, method="PATCH",
+                                         headers={"Content-Type": "application/json"})
+        try:
+            with urllib.request.urlopen(request, timeout=10) as response:
+                ok = 200 <= response.status < 300
+        except (urllib.error.URLError, OSError) as error:
+            ok = False
+            if self.verbose:
+                print("PATCH %s failed: %s" % (path, error), flush=True)
+
+        with self.lock:
+            if ok:
+                self.forwarded += 1
+            else:
+                self.failed += 1
+        if self.verbose and ok:
+            print("PATCH %s (%d bytes)" % (path, len(payload)), flush=True)
+        return ok
+
+
+# --- MQTT framing ---
+
+def read_exact(stream, size):
+    data = b""
+    while len(data) < size:
+        chunk = stream.recv(size - len(data))
+        if not chunk:
+            raise ConnectionError("closed")
+        data += chunk
+    return data
+
+
+def read_packet(stream):
+    header = read_exact(stream, 1)[0]
+    length, shift = 0, 0
+    while True:
+        digit = read_exact(stream, 1)[0]
+        length |= (digit & 0x7F) << shift
+        if not digit & 0x80:
+            break
+        shift += 7
+        if shift > 21:
+            raise ConnectionError("malformed length")
+    return header, read_exact(stream, length) if length else b""
+
+
+def encode_packet(header, body=b""):
+    length, encoded = len(body), bytearray()
+    while True:
+        digit = length % 128
+        length //= 128
+        encoded.append(digit | 0x80 if length else digit)
+        if not length:
+            break
+    return bytes([header]) + bytes(encoded) + body
+
+
+def encode_string(text):
+    data = text.encode()
+    return struct.pack(">H", len(data)) + data
+
+
+def read_string(body, offset):
+    (length,) = struct.unpack_from(">H", body, offset)
+    return body[offset + 2:offset + 2 + length].decode("utf-8", "replace"), offset + 2 + length
+
+
+def parse_connect(body):
+    """(client id, username or None, clean session flag) of a CONNECT"""
+    _, offset = read_string(body, 0)
+    flags = body[offset + 1]
+    client_id, offset = read_string(body, offset + 4)
+    if flags & 0x04:  # Will topic and message
+        _, offset = read_string(body, offset)
+        _, offset = read_string(body, offset)
+    username = None
+    if flags & 0x80:
+        username, offset = read_string(body, offset)
+    return client_id, username, bool(flags & 0x02)
+
+
+def device_of(client_id, username):
+    """The device ID a client may write: its username, else its "limo-<id>" client ID"""
+    if username:
+        return username
+    if client_id.startswith("limo-"):
+        return client_id[len("limo-"):]
+    return None
+
+
+def parse_publish(header, body):
+    """(topic, qos, message id or None, payload)"""
+    qos = (header >> 1) & 0x03
+    topic, offset = read_string(body, 0)
+    msg_id = None
+    if qos:
+        (msg_id,) = struct.unpack_from(">H", body, offset)
+        offset += 2
+    return topic, qos, msg_id, body[offset:]
+
+
+# --- Stand-in broker (--listen) ---
+
+class DeviceSession(socketserver.BaseRequestHandler):
+    """One device connection. Sessions are not stored: a QoS 1 message is
+    acknowledged once written and never held, so there is nothing to resume."""
+
+    def handle(self):
+        forwarder = self.server.forwarder
+        stream = self.request
+        stream.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        try:
+            header, body = read_packet(stream)
+            if header & 0xF0 != CONNECT:
+                return
+            client_id, username, clean = parse_connect(body)
+            device = device_of(client_id, username)
+            if device is None:
+                stream.sendall(encode_packet(CONNACK, bytes([0, 4])))  # Bad user name or password
+                print("%s refused: no device ID" % client_id, file=sys.stderr, flush=True)
+                return
+            stream.sendall(encode_packet(CONNACK, bytes([0, 0])))
+            if forwarder.verbose:
+                print("%s connected as %s%s" % (client_id, device, "" if clean else " (persistent)"), flush=True)
+
+            while True:
+                header, body = read_packet(stream)
+                kind = header & 0xF0
+                if kind == PUBLISH:
+                    topic, qos, msg_id, payload = parse_publish(header, body)
+                    if not forwarder.forward(topic, payload, device):
+                        return  # Unacknowledged; the device sends it again
+                    if qos == 1:
+                        stream.sendall(encode_packet(PUBACK, struct.pack(">H", msg_id)))
+                elif kind == SUBSCRIBE:
+                    (msg_id,) = struct.unpack_from(">H", body, 0)
+                    stream.sendall(encode_packet(SUBACK, struct.pack(">HB", msg_id, 0x80)))
+                elif kind == PINGREQ:
+                    stream.sendall(encode_packet(PINGRESP))
+                elif kind == DISCONNECT:
+                    return
+        except (ConnectionError, OSError, struct.error, IndexError):
+            return
+
+
+class StandInBroker(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+
+# --- Bridge client (--broker) ---
+
+def run_client(args, forwarder):
+    host, _, port = args.broker.rpartition(":")
+    port = int(port)
+    while True:
+        try:
+            stream = socket.create_connection((host, port), timeout=args.keepalive * 2)
+            if args.tls:
+                context = ssl.create_default_context(cafile=args.cafile)
+                stream = context.wrap_socket(stream, server_hostname=host)
+
+            flags = 0x00  # Clean session off: the broker keeps what we have not acknowledged
+            credentials = b""
+            if args.username:
+                flags |= 0x80
+                credentials += encode_string(args.username)
+            if args.password:
+                flags |= 0x40
+                credentials += encode_string(args.password)
+            stream.sendall(encode_packet(CONNECT, encode_string("MQTT") + bytes([4, flags]) +
+                                         struct.pack(">H", args.keepalive) +
+                                         encode_string(args.client_id) + credentials))
+            header, body = read_packet(stream)
+            if header & 0xF0 != CONNACK or len(body) != 2 or body[1] != 0:
+                raise ConnectionError("refused (%r)" % body)
+            stream.sendall(encode_packet(SUBSCRIBE | 0x02, struct.pack(">H", 1) +
+                                         encode_string(TOPIC_PREFIX + "+/#") + bytes([1])))
+            print("bridging %s -> %s" % (args.broker, args.rtdb), flush=True)
+
+            last_sent = time.monotonic()
+            stream.settimeout(args.keepalive / 2)
+            while True:
+                try:
+                    header, body = read_packet(stream)
+                except socket.timeout:
+                    header = None
+                if header is not None and header & 0xF0 == PUBLISH:
+                    topic, qos, msg_id, payload = parse_publish(header, body)
+                    if not forwarder.forward(topic, payload):  # The broker ACL checked the sender
+                        raise ConnectionError("RTDB write failed")  # Redelivered after the reconnect
+                    if qos == 1:
+                        stream.sendall(encode_packet(PUBACK, struct.pack(">H", msg_id)))
+                        last_sent = time.monotonic()
+                if time.monotonic() - last_sent >= args.keepalive / 2:
+                    stream.sendall(encode_packet(PINGREQ))
+                    last_sent = time.monotonic()
+        except (ConnectionError, OSError, struct.error, IndexError) as error:
+            print("broker link down: %s" % error, file=sys.stderr, flush=True)
+            time.sleep(args.retry_s)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    mode = parser.add_mutually_exclusive_group(required=True)
+    mode.add_argument("--listen", type=int, metavar="PORT", help="act as the broker on this port")
+    mode.add_argument("--broker", metavar="HOST:PORT", help="subscribe on this broker")
+    parser.add_argument("--host", default="127.0.0.1", help="address to listen on")
+    parser.add_argument("--rtdb", required=True, help="database URL, e.g. http://127.0.0.1:9000")
+    parser.add_argument("--auth", help="database secret, sent as ?auth=")
+    parser.add_argument("--nodes", default="logs,status,diagnostics", help="device nodes forwarded")
+    parser.add_argument("--tls", action="store_true")
+    parser.add_argument("--cafile")
+    parser.add_argument("--username")
+    parser.add_argument("--password")
+    parser.add_argument("--client-id", default="limo-rtdb-bridge")
+    parser.add_argument("--keepalive", type=int, default=60)
+    parser.add_argument("--retry-s", type=float, default=5)
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+
+    forwarder = Forwarder(args.rtdb, args.auth, args.nodes.split(","), args.verbose)
+    try:
+        if args.listen:
+            server = StandInBroker((args.host, args.listen), DeviceSession)
+            server.forwarder = forwarder
+            print("MQTT stand-in on %s:%d -> %s" % (args.host, args.listen, args.rtdb), flush=True)
+            server.serve_forever()
+        else:
+            run_client(args, forwarder)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,522 @@
+#!/usr/bin/env python3
+"""Local stand-in for the Firebase Realtime Database REST API.
+
+Covers the subset the LIMO SAFE firmware uses:
+
+  GET     /<path>.json                    read (shallow, orderBy/equalTo/startAt/endAt/limitTo*)
+  PUT     /<path>.json                    set
+  PATCH   /<path>.json                    multi-path update
+  POST    /<path>.json                    push, answers {"name": "<push id>"}
+  DELETE  /<path>.json                    delete
+  GET with Accept: text/event-stream      streaming (put/patch/keep-alive events)
+
+  X-Firebase-ETag: true                   answer with an ETag header
+  if-match: <etag>                        conditional PUT/DELETE, 412 on mismatch
+  print=silent                            204 with no body
+  {".sv": "timestamp"}                    server timestamp
+
+Fault injection, from the command line or at runtime:
+
+  POST /.control  {"latencyMs": 80, "jitterMs": 20, "failRate": 0.1,
+                   "throttleRate": 0.05, "dropRate": 0.0}
+
+  failRate answers 503, throttleRate answers 429, dropRate closes the
+  connection without a reply.
+
+Bookkeeping for benchmarks:
+
+  GET  /.stats          request counts, bytes, and server time per method
+  POST /.stats/reset    zero the counters
+
+Usage:
+  python3 tools/rtdb_emulator.py --port 9000 --seed seed.json --latency-ms 60
+"""
+
+import argparse
+import hashlib
+import json
+import random
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, unquote, urlsplit
+
+PUSH_CHARS = "-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz"
+KEEP_ALIVE_SECONDS = 30
+
+
+class Faults:
+    def __init__(self, latency_ms=0, jitter_ms=0, fail_rate=0.0, throttle_rate=0.0, drop_rate=0.0):
+        self.latency_ms = latency_ms
+        self.jitter_ms = jitter_ms
+        self.fail_rate = fail_rate
+        self.throttle_rate = throttle_rate
+        self.drop_rate = drop_rate
+
+    def update(self, values):
+        self.latency_ms = values.get("latencyMs", self.latency_ms)
+        self.jitter_ms = values.get("jitterMs", self.jitter_ms)
+        self.fail_rate = values.get("failRate", self.fail_rate)
+        self.throttle_rate = values.get("throttleRate", self.throttle_rate)
+        self.drop_rate = values.get("dropRate", self.drop_rate)
+
+    def as_dict(self):
+        return {
+            "latencyMs": self.latency_ms,
+            "jitterMs": self.jitter_ms,
+            "failRate": self.fail_rate,
+            "throttleRate": self.throttle_rate,
+            "dropRate": self.drop_rate,
+        }
+
+    def delay(self):
+        total = self.latency_ms + random.uniform(-self.jitter_ms, self.jitter_ms)
+        if total > 0:
+            time.sleep(total / 1000.0)
+
+    def outcome(self):
+        """None for a normal answer, else 'drop', 429 or 503."""
+        roll = random.random()
+        if roll < self.drop_rate:
+            return "drop"
+        roll -= self.drop_rate
+        if roll < self.throttle_rate:
+            return 429
+        roll -= self.throttle_rate
+        if roll < self.fail_rate:
+            return 503
+        return None
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.reset()
+
+    def reset(self):
+        with self.lock:
+            self.requests = 0
+            self.by_method = {}
+            self.bytes_in = 0
+            self.bytes_out = 0
+            self.server_ms = 0.0
+            self.injected = 0
+
+    def record(self, method, bytes_in, bytes_out, elapsed_ms, injected):
+        with self.lock:
+            self.requests += 1
+            self.by_method[method] = self.by_method.get(method, 0) + 1
+            self.bytes_in += bytes_in
+            self.bytes_out += bytes_out
+            self.server_ms += elapsed_ms
+            self.injected += 1 if injected else 0
+
+    def as_dict(self):
+        with self.lock:
+            return {
+                "requests": self.requests,
+                "byMethod": dict(self.by_method),
+                "bytesIn": self.bytes_in,
+                "bytesOut": self.bytes_out,
+                "serverMs": round(self.server_ms, 3),
+                "injectedFaults": self.injected,
+            }
+
+
+def split_path(path):
+    return [segment for segment in path.strip("/").split("/") if segment]
+
+
+def as_array_if_dense(value):
+    """Read-side array coercion: integer keys covering over half of 0..max come back as a list."""
+    if isinstance(value, dict):
+        value = {key: as_array_if_dense(child) for key, child in value.items()}
+        if value and all(key.isdigit() and (key == "0" or not key.startswith("0")) for key in value):
+            highest = max(int(key) for key in value)
+            if len(value) * 2 > highest + 1:
+                return [value.get(str(index)) for index in range(highest + 1)]
+    return value
+
+
+def etag_for(value):
+    return hashlib.sha1(json.dumps(value, sort_keys=True).encode()).hexdigest()
+
+
+class Database:
+    """JSON tree with RTDB write semantics and change listeners for streams."""
+
+    def __init__(self, data=None):
+        self.root = data
+        self.lock = threading.RLock()
+        self.listeners = []
+        self.last_push_ms = 0
+        self.last_push_rand = []
+
+    # --- tree helpers ---
+
+    def get(self, segments):
+        node = self.root
+        for segment in segments:
+            if not isinstance(node, dict) or segment not in node:
+                return None
+            node = node[segment]
+        return node
+
+    def _resolve_server_values(self, value):
+        if isinstance(value, dict):
+            if value.get(".sv") == "timestamp":
+                return int(time.time() * 1000)
+            return {k: self._resolve_server_values(v) for k, v in value.items()}
+        if isinstance(value, list):
+            # RTDB stores arrays as objects keyed by index
+            return {str(i): self._resolve_server_values(v) for i, v in enumerate(value) if v is not None}
+        return value
+
+    @staticmethod
+    def _prune(value):
+        if isinstance(value, dict):
+            pruned = {k: Database._prune(v) for k, v in value.items()}
+            pruned = {k: v for k, v in pruned.items() if v is not None}
+            return pruned or None
+        return value
+
+    def _set(self, segments, value):
+        value = self._prune(self._resolve_server_values(value))
+        if not segments:
+            self.root = value
+            return
+        if not isinstance(self.root, dict):
+            self.root = {}
+        node = self.root
+        for segment in segments[:-1]:
+            child = node.get(segment)
+            if not isinstance(child, dict):
+                child = {}
+                node[segment] = child
+            node = child
+        if value is None:
+            node.pop(segments[-1], None)
+        else:
+            node[segments[-1]] = value
+        self.root = self._prune(self.root)
+
+    # --- operations ---
+
+    def set(self, segments, value):
+        with self.lock:
+            self._set(segments, value)
+            self._notify("put", segments, self.get(segments))
+
+    def update(self, segments, changes):
+        with self.lock:
+            for key, value in changes.items():
+                self._set(segments + split_path(key), value)
+            resolved = {key: self.get(segments + split_path(key)) for key in changes}
+            self._notify("patch", segments, resolved)
+
+    def push(self, segments, value):
+        with self.lock:
+            name = self._push_id()
+            self._set(segments + [name], value)
+            self._notify("put", segments + [name], self.get(segments + [name]))
+            return name
+
+    def _push_id(self):
+        now = int(time.time() * 1000)
+        if now == self.last_push_ms and self.last_push_rand:
+            # Same millisecond: increment the random part so ids stay ordered
+            for i in range(len(self.last_push_rand) - 1, -1, -1):
+                if self.last_push_rand[i] < 63:
+                    self.last_push_rand[i] += 1
+                    break
+                self.last_push_rand[i] = 0
+        else:
+            self.last_push_rand = [random.randrange(64) for _ in range(12)]
+        self.last_push_ms = now
+        head = ""
+        for _ in range(8):
+            head = PUSH_CHARS[now % 64] + head
+            now //= 64
+        return head + "".join(PUSH_CHARS[i] for i in self.last_push_rand)
+
+    # --- streaming ---
+
+    def listen(self, segments):
+        listener = {"segments": segments, "events": [], "cond": threading.Condition(self.lock)}
+        with self.lock:
+            self.listeners.append(listener)
+        return listener
+
+    def unlisten(self, listener):
+        with self.lock:
+            if listener in self.listeners:
+                self.listeners.remove(listener)
+
+    def _notify(self, kind, segments, data):
+        for listener in self.listeners:
+            base = listener["segments"]
+            if segments[:len(base)] == base:
+                # Write at or below the listener: report it relative to the listener
+                relative = "/" + "/".join(segments[len(base):])
+                listener["events"].append((kind, {"path": relative, "data": data}))
+            elif base[:len(segments)] == segments:
+                # Write above the listener: resend the listener's whole value
+                listener["events"].append(("put", {"path": "/", "data": self.get(base)}))
+            else:
+                continue
+            listener["cond"].notify_all()
+
+
+def apply_query(value, params):
+    """orderBy/equalTo/startAt/endAt/limitToFirst/limitToLast on an object."""
+    if "orderBy" not in params or not isinstance(value, dict):
+        return value
+    order_by = json.loads(params["orderBy"])
+
+    def sort_key(item):
+        key, child = item
+        if order_by == "$key":
+            return (0, key)
+        target = child if order_by == "$value" else (child.get(order_by) if isinstance(child, dict) else None)
+        # RTDB order: null, false, true, numbers, strings, objects
+        if target is None:
+            return (0, 0)
+        if isinstance(target, bool):
+            return (1, int(target))
+        if isinstance(target, (int, float)):
+            return (2, target)
+        if isinstance(target, str):
+            return (3, target)
+        return (4, 0)
+
+    def ordered_value(item):
+        key, child = item
+        if order_by == "$key":
+            return key
+        if order_by == "$value":
+            return child
+        return child.get(order_by) if isinstance(child, dict) else None
+
+    items = sorted(value.items(), key=sort_key)
+    if "equalTo" in params:
+        target = json.loads(params["equalTo"])
+        items = [item for item in items if ordered_value(item) == target]
+    if "startAt" in params:
+        start = json.loads(params["startAt"])
+        items = [item for item in items if ordered_value(item) is not None and ordered_value(item) >= start]
+    if "endAt" in params:
+        end = json.loads(params["endAt"])
+        items = [item for item in items if ordered_value(item) is not None and ordered_value(item) <= end]
+    if "limitToFirst" in params:
+        items = items[:int(params["limitToFirst"])]
+    if "limitToLast" in params:
+        items = items[-int(params["limitToLast"]):]
+    return dict(items)
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    disable_nagle_algorithm = True  # headers and body go out as separate writes
+    server_version = "rtdb-emulator/1.0"
+
+    def log_message(self, fmt, *args):
+        if self.server.verbose:
+            super().log_message(fmt, *args)
+
+    # --- plumbing ---
+
+    def _read_body(self):
+        length = int(self.headers.get("Content-Length", 0) or 0)
+        return self.rfile.read(length) if length else b""
+
+    def _reply(self, status, payload=None, headers=None, silent=False):
+        # RTDB answers a missing node with the literal null; only 204 is empty
+        body = b"" if silent else json.dumps(payload, separators=(",", ":")).encode()
+        self.send_response(204 if silent and status == 200 else status)
+        self.send_header("Content-Type", "application/json; charset=utf-8")
+        self.send_header("Content-Length", str(len(body)))
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        self.end_headers()
+        if body:
+            self.wfile.write(body)
+        return len(body)
+
+    def _handle(self, method):
+        started = time.monotonic()
+        url = urlsplit(self.path)
+        params = {k: v[-1] for k, v in parse_qs(url.query).items()}
+        body = self._read_body()
+
+        if url.path.startswith("/.control") or url.path.startswith("/.stats"):
+            self._control(method, url.path, body)
+            return
+
+        faults = self.server.faults
+        faults.delay()
+        outcome = faults.outcome()
+        if outcome == "drop":
+            self.close_connection = True
+            self.server.stats.record(method, len(body), 0, (time.monotonic() - started) * 1000, True)
+            return
+        if outcome is not None:
+            sent = self._reply(outcome, {"error": "injected fault"})
+            self.server.stats.record(method, len(body), sent, (time.monotonic() - started) * 1000, True)
+            return
+
+        if not url.path.endswith(".json"):
+            sent = self._reply(404, {"error": "path must end in .json"})
+            self.server.stats.record(method, len(body), sent, (time.monotonic() - started) * 1000, False)
+            return
+
+        segments = split_path(unquote(url.path[:-len(".json")]))
+        if method == "GET" and "text/event-stream" in self.headers.get("Accept", ""):
+            self.server.stats.record("STREAM", len(body), 0, 0, False)
+            self._stream(segments)
+            return
+
+        sent = self._operation(method, segments, params, body)
+        self.server.stats.record(method, len(body), sent, (time.monotonic() - started) * 1000, False)
+
+    def _operation(self, method, segments, params, body):
+        db = self.server.db
+        silent = params.get("print") == "silent"
+        want_etag = self.headers.get("X-Firebase-ETag", "").lower() == "true"
+
+        try:
+            value = json.loads(body) if body else None
+        except ValueError:
+            return self._reply(400, {"error": "Invalid data; couldn't parse JSON object."})
+
+        with db.lock:
+            current = db.get(segments)
+            headers = {"ETag": etag_for(current)} if want_etag else {}
+
+            if_match = self.headers.get("if-match")
+            if if_match is not None and method in ("PUT", "DELETE") and if_match != etag_for(current):
+                return self._reply(412, current, {"ETag": etag_for(current)})
+
+            if method == "GET":
+                if params.get("shallow") == "true" and isinstance(current, dict):
+                    current = {key: True for key in current}
+                return self._reply(200, as_array_if_dense(apply_query(current, params)), headers)
+            if method == "PUT":
+                db.set(segments, value)
+                result = db.get(segments)
+            elif method == "PATCH":
+                if not isinstance(value, dict):
+                    return self._reply(400, {"error": "Invalid data; couldn't parse JSON object."})
+                db.update(segments, value)
+                result = value
+            elif method == "POST":
+                result = {"name": db.push(segments, value)}
+            elif method == "DELETE":
+                db.set(segments, None)
+                result = None
+            else:
+                return self._reply(405, {"error": "method not allowed"})
+
+            if want_etag:
+                headers["ETag"] = etag_for(db.get(segments))
+        return self._reply(200, result, headers, silent)
+
+    def _stream(self, segments):
+        db = self.server.db
+        listener = db.listen(segments)
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Cache-Control", "no-cache")
+        self.end_headers()
+        self.close_connection = True
+
+        def send(kind, data):
+            self.wfile.write(("event: %s\ndata: %s\n\n" % (kind, json.dumps(data, separators=(",", ":")))).encode())
+            self.wfile.flush()
+
+        try:
+            with db.lock:
+                initial = db.get(segments)
+            send("put", {"path": "/", "data": as_array_if_dense(initial)})
+            while True:
+                with db.lock:
+                    if not listener["events"]:
+                        listener["cond"].wait(KEEP_ALIVE_SECONDS)
+                    events, listener["events"] = listener["events"], []
+                if not events:
+                    send("keep-alive", None)
+                for kind, data in events:
+                    self.server.faults.delay()
+                    send(kind, {"path": data["path"], "data": as_array_if_dense(data["data"])})
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+        finally:
+            db.unlisten(listener)
+
+    def _control(self, method, path, body):
+        if path == "/.stats" and method == "GET":
+            self._reply(200, self.server.stats.as_dict())
+        elif path == "/.stats/reset" and method == "POST":
+            self.server.stats.reset()
+            self._reply(200, self.server.stats.as_dict())
+        elif path == "/.control" and method == "GET":
+            self._reply(200, self.server.faults.as_dict())
+        elif path == "/.control" and method == "POST":
+            try:
+                self.server.faults.update(json.loads(body or b"{}"))
+            except ValueError:
+                self._reply(400, {"error": "bad control payload"})
+                return
+            self._reply(200, self.server.faults.as_dict())
+        else:
+            self._reply(404, {"error": "unknown control endpoint"})
+
+    def do_GET(self):
+        self._handle("GET")
+
+    def do_PUT(self):
+        self._handle("PUT")
+
+    def do_PATCH(self):
+        self._handle("PATCH")
+
+    def do_POST(self):
+        self._handle("POST")
+
+    def do_DELETE(self):
+        self._handle("DELETE")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=9000)
+    parser.add_argument("--seed", help="JSON file with the initial database")
+    parser.add_argument("--latency-ms", type=float, default=0)
+    parser.add_argument("--jitter-ms", type=float, default=0)
+    parser.add_argument("--fail-rate", type=float, default=0.0, help="fraction answered with 503")
+    parser.add_argument("--throttle-rate", type=float, default=0.0, help="fraction answered with 429")
+    parser.add_argument("--drop-rate", type=float, default=0.0, help="fraction closed without a reply")
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+
+    data = None
+    if args.seed:
+        with open(args.seed) as seed:
+            data = json.load(seed)
+
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    server.daemon_threads = True
+    server.db = Database(data)
+    server.faults = Faults(args.latency_ms, args.jitter_ms, args.fail_rate, args.throttle_rate, args.drop_rate)
+    server.stats = Stats()
+    server.verbose = args.verbose
+
+    print("RTDB emulator on http://%s:%d" % (args.host, args.port), flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()